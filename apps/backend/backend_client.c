@@ -55,6 +55,7 @@
 #include <sys/socket.h>
 #include <sys/param.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
@@ -126,6 +127,374 @@ ce_client_descr(struct client_entry *ce,
     return retval;
 }
 
+/*
+ * Client output queues
+ * Replies and notifications are written to a client socket without blocking. What cannot
+ * be written is queued and written when the socket is writable.
+ * If more than CLICON_BACKEND_OUTQ_MAX bytes are queued, requests are not read from the
+ * client, and notifications are dropped or the client is disconnected according to
+ * CLICON_BACKEND_OUTQ_POLICY.
+ */
+
+static int ce_output_cb(int s, void *arg);
+static int read_worker_reply(int s, void *arg);
+static int read_worker_read_update(struct client_entry *ce, int read);
+static int read_worker_cancel(clixon_handle h, struct client_entry *ce);
+
+/*! Number of queued bytes not yet written to client
+ *
+ * @param[in]  ce   Client entry
+ * @retval     len  Queued bytes
+ */
+static size_t
+ce_outq_len(struct client_entry *ce)
+{
+    if (ce->ce_outq == NULL)
+        return 0;
+    return cbuf_len(ce->ce_outq) - ce->ce_outq_start;
+}
+
+/*! Write as much as possible to socket without blocking
+ *
+ * @param[in]  s    Socket, or pipe in a read worker
+ * @param[in]  buf  Data
+ * @param[in]  len  Length of data
+ * @retval     n    Bytes written, less than len if write would block
+ * @retval    -1    Error, see errno
+ */
+static ssize_t
+ce_write(int   s,
+         char *buf,
+         size_t len)
+{
+    ssize_t pos = 0;
+    ssize_t n;
+
+    while (pos < len){
+        if ((n = send(s, buf + pos, len - pos, MSG_DONTWAIT)) < 0 && errno == ENOTSOCK)
+            n = write(s, buf + pos, len - pos);
+        if (n < 0){
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            return -1;
+        }
+        pos += n;
+    }
+    return pos;
+}
+
+/*! Discard output queue of client
+ *
+ * @param[in]  ce   Client entry
+ */
+static void
+ce_outq_reset(struct client_entry *ce)
+{
+    if (ce->ce_outq && cbuf_len(ce->ce_outq)){
+        clixon_event_unreg_fd(ce->ce_s, ce_output_cb);
+        cbuf_reset(ce->ce_outq);
+    }
+    ce->ce_outq_start = 0;
+}
+
+/*! Register or unregister reading from client socket
+ *
+ * Do not read from client while a read worker serves it or if its output queue is full.
+ * Do not read reply from read worker while the output queue is full.
+ * @param[in]  h   Clixon handle
+ * @param[in]  ce  Client entry
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+int
+backend_client_read_update(clixon_handle        h,
+                           struct client_entry *ce)
+{
+    uint32_t max;
+    int      full;
+    int      read;
+
+    max = clicon_option_int(h, "CLICON_BACKEND_OUTQ_MAX");
+    full = max != 0 && ce_outq_len(ce) > max;
+    read = !ce->ce_worker && !full;
+    if (read && !ce->ce_reading){
+        if (clixon_event_reg_fd_prio(ce->ce_s, from_client, (void*)ce, "local netconf client socket",
+                                     clicon_option_bool(h, "CLICON_SOCK_PRIO")) < 0)
+            return -1;
+        ce->ce_reading = 1;
+    }
+    else if (!read && ce->ce_reading){
+        clixon_event_unreg_fd(ce->ce_s, from_client);
+        ce->ce_reading = 0;
+    }
+    if (ce->ce_worker &&
+        read_worker_read_update(ce, !full) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Client socket is writable, write from output queue
+ *
+ * @param[in]  s    Client socket
+ * @param[in]  arg  Client entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+ce_output_cb(int   s,
+             void *arg)
+{
+    struct client_entry *ce = (struct client_entry *)arg;
+    clixon_handle        h = ce->ce_handle;
+    ssize_t              n;
+
+    if ((n = ce_write(s, cbuf_get(ce->ce_outq) + ce->ce_outq_start, ce_outq_len(ce))) < 0){
+        /* Client is removed when reading EOF */
+        clixon_log(h, LOG_WARNING, "client %d write: %s", ce->ce_nr, strerror(errno));
+        ce_outq_reset(ce);
+        shutdown(s, SHUT_RDWR);
+    }
+    else {
+        clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "Send queued [%u] len: %zd", ce->ce_id, n);
+        ce->ce_outq_start += n;
+        if (ce_outq_len(ce) == 0)
+            ce_outq_reset(ce);
+    }
+    return backend_client_read_update(h, ce);
+}
+
+/*! Send framed data to client, queue what cannot be written without blocking
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  ce    Client entry
+ * @param[in]  descr Description of client for logging
+ * @param[in]  cb    Framed data
+ * @retval     0     OK, data is written or queued, or write failed and client will be removed
+ * @retval    -1     Error
+ */
+static int
+ce_send(clixon_handle        h,
+        struct client_entry *ce,
+        const char          *descr,
+        cbuf                *cb)
+{
+    int     retval = -1;
+    ssize_t n = 0;
+    cbuf   *cbq;
+
+    clixon_debug(CLIXON_DBG_MSG, "Send [%s] len: %lu", descr, cbuf_len(cb));
+    clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "Send [%s] %s", descr, cbuf_get(cb));
+    if (ce_outq_len(ce) == 0){ /* Nothing queued, try to write directly */
+        if ((n = ce_write(ce->ce_s, cbuf_get(cb), cbuf_len(cb))) < 0){
+            /* Eg EPIPE or ECONNRESET: client closes the socket, is removed when reading EOF */
+            clixon_log(h, LOG_WARNING, "client %d write: %s", ce->ce_nr, strerror(errno));
+            goto ok;
+        }
+        if (n == cbuf_len(cb))
+            goto ok;
+    }
+    if (ce->ce_outq == NULL &&
+        (ce->ce_outq = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    /* Compact queue if more than half is written */
+    if (ce->ce_outq_start > cbuf_len(ce->ce_outq)/2){
+        if ((cbq = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        if (cbuf_append_buf(cbq, cbuf_get(ce->ce_outq) + ce->ce_outq_start, ce_outq_len(ce)) < 0){
+            clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+            cbuf_free(cbq);
+            goto done;
+        }
+        cbuf_free(ce->ce_outq);
+        ce->ce_outq = cbq;
+        ce->ce_outq_start = 0;
+    }
+    if (cbuf_len(ce->ce_outq) == 0 &&
+        clixon_event_reg_fd_write(ce->ce_s, ce_output_cb, ce, "client output queue") < 0)
+        goto done;
+    if (cbuf_append_buf(ce->ce_outq, cbuf_get(cb) + n, cbuf_len(cb) - n) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        goto done;
+    }
+    if (backend_client_read_update(h, ce) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Send reply to client using chunked framing
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  ce      Client entry
+ * @param[in]  descr   Description of client for logging
+ * @param[in]  data    Reply
+ * @param[in]  datalen Length of reply
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see send_msg_reply
+ */
+static int
+ce_send_reply(clixon_handle        h,
+              struct client_entry *ce,
+              const char          *descr,
+              char                *data,
+              uint32_t             datalen)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (cbuf_append_buf(cb, data, datalen) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        goto done;
+    }
+    if (netconf_output_encap(NETCONF_SSH_CHUNKED, cb) < 0)
+        goto done;
+    if (ce_send(h, ce, descr, cb) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Send notification to client, apply CLICON_BACKEND_OUTQ_POLICY if output queue is full
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  ce    Client entry
+ * @param[in]  descr Description of client for logging
+ * @param[in]  xev   Event as XML
+ * @retval     1     Sent or queued
+ * @retval     0     Dropped or client disconnected
+ * @retval    -1     Error
+ * @see send_msg_notify_xml
+ */
+static int
+ce_send_notify(clixon_handle        h,
+               struct client_entry *ce,
+               const char          *descr,
+               cxobj               *xev)
+{
+    int       retval = -1;
+    cbuf     *cb = NULL;
+    uint32_t  max;
+    char     *policy;
+
+    max = clicon_option_int(h, "CLICON_BACKEND_OUTQ_MAX");
+    if (max && ce_outq_len(ce) > max){
+        policy = clicon_option_str(h, "CLICON_BACKEND_OUTQ_POLICY");
+        if (policy && strcmp(policy, "disconnect") == 0){
+            clixon_log(h, LOG_WARNING, "client %d output queue full, disconnecting", ce->ce_nr);
+            /* Client is removed when reading EOF */
+            ce_outq_reset(ce);
+            shutdown(ce->ce_s, SHUT_RDWR);
+            if (backend_client_read_update(h, ce) < 0)
+                goto done;
+        }
+        else{
+            clixon_debug(CLIXON_DBG_BACKEND, "client %d output queue full, dropping notification",
+                         ce->ce_nr);
+            ce->ce_out_dropped++;
+        }
+        goto fail;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (clixon_xml2cbuf(cb, xev, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    if (netconf_output_encap(NETCONF_SSH_CHUNKED, cb) < 0)
+        goto done;
+    if (ce_send(h, ce, descr, cb) < 0)
+        goto done;
+    retval = 1;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Send part of a reply to client as one NETCONF 1.1 chunk, the reply is completed in from_client_msg
+ *
+ * Used when serializing large replies in pieces, see CLICON_BACKEND_REPLY_CHUNK
+ * @param[in]  h     Clixon handle
+ * @param[in]  ce    Client entry
+ * @param[in]  cb    Part of reply, not framed
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+backend_client_reply_chunk(clixon_handle        h,
+                           struct client_entry *ce,
+                           cbuf                *cb)
+{
+    int   retval = -1;
+    cbuf *cbce = NULL;
+    cbuf *cbh = NULL;
+
+    if (cbuf_len(cb) == 0)
+        goto ok;
+    if (ce_client_descr(ce, &cbce) < 0)
+        goto done;
+    if ((cbh = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cbh, "\n#%zu\n", cbuf_len(cb));
+    if (ce_send(h, ce, cbuf_get(cbce), cbh) < 0)
+        goto done;
+    if (ce_send(h, ce, cbuf_get(cbce), cb) < 0)
+        goto done;
+    ce->ce_chunked = 1;
+ ok:
+    retval = 0;
+ done:
+    if (cbh)
+        cbuf_free(cbh);
+    if (cbce)
+        cbuf_free(cbce);
+    return retval;
+}
+
+/*! Part of a reply is sent but the rest failed, close the session
+ *
+ * An error reply cannot follow the chunks already sent, and the open elements of the
+ * partial reply are not known. The client is removed when reading EOF.
+ * In a read worker, the backend closes the session when the frame is not completed.
+ * @param[in]  h     Clixon handle
+ * @param[in]  ce    Client entry
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see backend_client_reply_chunk
+ */
+static int
+ce_reply_abort(clixon_handle        h,
+               struct client_entry *ce)
+{
+    clixon_log(h, LOG_WARNING, "client %d reply failed after part of it was sent, closing session",
+               ce->ce_nr);
+    ce->ce_chunked = 0;
+    ce_outq_reset(ce);
+    shutdown(ce->ce_s, SHUT_RDWR);
+    return backend_client_read_update(h, ce);
+}
+
 /*! Stream callback for netconf stream notification (RFC 5277)
  *
  * @param[in]  h     Clixon handle
@@ -145,6 +514,7 @@ ce_event_cb(clixon_handle h,
     int                  retval = -1;
     struct client_entry *ce = (struct client_entry *)arg;
     cbuf                *cbce = NULL;
+    int                  ret;
 
     clixon_debug(CLIXON_DBG_BACKEND, "op:%d", op);
     switch (op){
@@ -156,12 +526,10 @@ ce_event_cb(clixon_handle h,
     default:
         if (ce_client_descr(ce, &cbce) < 0)
             goto done;
-        if (send_msg_notify_xml(h, ce->ce_s, cbuf_get(cbce), event) < 0){
-            if (errno == ECONNRESET || errno == EPIPE){
-                clixon_log(h, LOG_WARNING, "client %d reset", ce->ce_nr);
-            }
+        if ((ret = ce_send_notify(h, ce, cbuf_get(cbce), event)) < 0)
+            goto done;
+        if (ret == 0)
             break;
-        }
         /* note there may be other notifications than RFC5277 streams */
         ce->ce_out_notifications++;
         netconf_monitoring_counter_inc(h, "out-notifications");
@@ -283,6 +651,10 @@ backend_monitoring_state_get(clixon_handle h,
         cprintf(cb, "<in-bad-rpcs>%u</in-bad-rpcs>", ce->ce_in_bad_rpcs);
         cprintf(cb, "<out-rpc-errors>%u</out-rpc-errors>", ce->ce_out_rpc_errors);
         cprintf(cb, "<out-notifications>%u</out-notifications>", ce->ce_out_notifications);
+        cprintf(cb, "<out-queued-bytes xmlns=\"%s\">%zu</out-queued-bytes>",
+                CLIXON_LIB_NS, ce_outq_len(ce));
+        cprintf(cb, "<out-dropped-notifications xmlns=\"%s\">%u</out-dropped-notifications>",
+                CLIXON_LIB_NS, ce->ce_out_dropped);
         cprintf(cb, "</session>");
     }
     cprintf(cb, "</sessions>");
@@ -348,6 +720,9 @@ backend_client_rm(clixon_handle        h,
     }
 
     clixon_debug(CLIXON_DBG_BACKEND, "");
+    if (ce->ce_worker &&
+        read_worker_cancel(h, ce) < 0)
+        goto done;
     /* for all streams: XXX better to do it top-level? */
     stream_ss_delete_all(h, ce_event_cb, (void*)ce);
     c0 = backend_client_list(h);
@@ -356,6 +731,7 @@ backend_client_rm(clixon_handle        h,
         if (c == ce){
             if (ce->ce_s){
                 clixon_event_unreg_fd(ce->ce_s, from_client);
+                ce_outq_reset(ce);
                 close(ce->ce_s);
                 ce->ce_s = 0;
                 if (release_all_dbs(h, ce->ce_id) < 0)
@@ -394,7 +770,7 @@ clixon_stats_datastore_get(clixon_handle h,
     /* This is the db cache */
     if ((xt = xmldb_cache_get(h, dbname)) == NULL){
         /* Trigger cache if no exist (trick to ensure cache is present) */
-        if ((ret = xmldb_get0(h, dbname, YB_MODULE, NULL, "/", 1, 0, &xn, NULL, NULL)) < 0)
+        if ((ret = xmldb_get0(h, dbname, YB_MODULE, NULL, "/", 0, 0, &xn, NULL, NULL)) < 0)
             //goto done;
             goto ok;
         if (ret == 0)
@@ -412,7 +788,7 @@ clixon_stats_datastore_get(clixon_handle h,
     retval = 0;
  done:
     if (xn)
-        xml_free(xn);
+        xmldb_get0_free(h, &xn);
     return retval;
 }
 
@@ -1419,6 +1795,13 @@ from_client_stats(clixon_handle h,
 {
     int        retval = -1;
     uint64_t   nr;
+    uint64_t   hits;
+    uint64_t   misses;
+    uint64_t   users;
+    uint64_t   keys;
+    uint64_t   index;
+    uint64_t   pos;
+    uint64_t   eval;
     char      *str;
     int        modules = 0;
     yang_stmt *yspec0;
@@ -1444,6 +1827,26 @@ from_client_stats(clixon_handle h,
     yang_stats_global(&nr);
     cprintf(cbret, "<yangnr>%" PRIu64 "</yangnr>", nr);
     cprintf(cbret, "</global>");
+    xpath_cache_stats(&nr, &hits, &misses);
+    cprintf(cbret, "<xpath-cache xmlns=\"%s\">", CLIXON_LIB_NS);
+    cprintf(cbret, "<nr>%" PRIu64 "</nr>", nr);
+    cprintf(cbret, "<hits>%" PRIu64 "</hits>", hits);
+    cprintf(cbret, "<misses>%" PRIu64 "</misses>", misses);
+    cprintf(cbret, "</xpath-cache>");
+    xpath_optimize_stats(&keys, &index, &pos, &eval);
+    cprintf(cbret, "<xpath-optimize xmlns=\"%s\">", CLIXON_LIB_NS);
+    cprintf(cbret, "<key-lookups>%" PRIu64 "</key-lookups>", keys);
+    cprintf(cbret, "<index-lookups>%" PRIu64 "</index-lookups>", index);
+    cprintf(cbret, "<position-lookups>%" PRIu64 "</position-lookups>", pos);
+    cprintf(cbret, "<evaluations>%" PRIu64 "</evaluations>", eval);
+    cprintf(cbret, "</xpath-optimize>");
+    nacm_cache_stats(&nr, &users, &hits, &misses);
+    cprintf(cbret, "<nacm-cache xmlns=\"%s\">", CLIXON_LIB_NS);
+    cprintf(cbret, "<nr>%" PRIu64 "</nr>", nr);
+    cprintf(cbret, "<users>%" PRIu64 "</users>", users);
+    cprintf(cbret, "<hits>%" PRIu64 "</hits>", hits);
+    cprintf(cbret, "<misses>%" PRIu64 "</misses>", misses);
+    cprintf(cbret, "</nacm-cache>");
     cprintf(cbret, "<datastores xmlns=\"%s\">", CLIXON_LIB_NS);
     if (clixon_stats_datastore_get(h, "running", cbret) < 0)
         goto done;
@@ -1619,6 +2022,560 @@ from_client_hello(clixon_handle       h,
     return retval;
 }
 
+/*
+ * Read workers
+ * A get or get-config request may be served by a forked worker process, see
+ * CLICON_BACKEND_READ_WORKERS.
+ * The memory of the worker is a copy-on-write snapshot of the backend, including cached
+ * datastores, taken when the request arrives. Edits and commits are made by the backend
+ * process as before and are not seen by the worker.
+ * The worker sends the framed reply on a pipe followed by the session counters it has
+ * updated. The backend forwards the reply to the client as it is read, and stops reading
+ * from the pipe while the output queue of the client is full.
+ * The client socket is not read until the reply is forwarded, which keeps the order of
+ * replies of a session.
+ * A worker that is done is freed when it is reaped, on SIGCHLD if it has not yet exited.
+ */
+struct read_worker{
+    qelem_t       rw_qelem;  /* List header */
+    clixon_handle rw_h;      /* Clixon handle */
+    pid_t         rw_pid;    /* Process id of worker, 0 when reaped */
+    int           rw_fd;     /* Read end of pipe from worker, -1 when reply is done */
+    int           rw_reading;/* rw_fd is registered in event loop */
+    uint32_t      rw_id;     /* Session id of client */
+    int           rw_state;  /* Framing state, see netconf_input_chunked_framing */
+    size_t        rw_size;   /* Remaining bytes of chunk */
+    int           rw_eof;    /* End of frame is read, rest is session counters */
+    size_t        rw_sent;   /* Bytes of reply forwarded to client */
+    cbuf         *rw_cb;     /* Session counters read after reply */
+};
+typedef struct read_worker read_worker;
+
+/* Session counters updated by a read worker, sent to the backend after the reply */
+struct read_worker_counters{
+    uint32_t rc_in_bad_rpcs;
+    uint32_t rc_out_rpc_errors;
+};
+
+/* List of read workers, modified with SIGCHLD blocked, see backend_read_workers_reap */
+static read_worker *_read_workers = NULL;
+
+/* Number of active read workers */
+static int _read_worker_nr = 0;
+
+/* Set in worker process */
+static int _read_worker_child = 0;
+
+/* In worker process: session counters when worker started */
+static struct read_worker_counters _read_worker_counters0 = {0,};
+
+/*! Find active read worker of client
+ *
+ * @param[in]  id   Session id of client
+ * @retval     rw   Read worker
+ * @retval     NULL Not found
+ */
+static read_worker *
+read_worker_find(uint32_t id)
+{
+    read_worker *rw;
+
+    if ((rw = _read_workers) != NULL)
+        do {
+            if (rw->rw_fd != -1 && rw->rw_id == id)
+                return rw;
+            rw = NEXTQ(read_worker *, rw);
+        } while (rw && rw != _read_workers);
+    return NULL;
+}
+
+/*! Free read worker and remove it from list
+ *
+ * @param[in]  rw   Read worker
+ * @note close rw_fd and reap worker before
+ */
+static void
+read_worker_free(read_worker *rw)
+{
+    clicon_signal_block(SIGCHLD);
+    DELQ(rw, _read_workers, read_worker *);
+    clicon_signal_unblock(SIGCHLD);
+    if (rw->rw_cb)
+        cbuf_free(rw->rw_cb);
+    free(rw);
+}
+
+/*! Free read workers that are done and reaped
+ */
+static void
+read_worker_gc(void)
+{
+    read_worker *rw;
+    read_worker *rwn;
+    int          last;
+
+    rw = _read_workers;
+    while (rw != NULL){
+        rwn = NEXTQ(read_worker *, rw);
+        last = (rwn == _read_workers);
+        if (rw->rw_fd == -1 && rw->rw_pid == 0)
+            read_worker_free(rw);
+        if (last || _read_workers == NULL)
+            break;
+        rw = rwn;
+    }
+}
+
+/*! Stop reading from read worker, signal it and reap it if it has exited
+ *
+ * @param[in]  rw   Read worker
+ * @param[in]  sig  Signal to send to worker, or 0
+ */
+static void
+read_worker_close(read_worker *rw,
+                  int          sig)
+{
+    int status = 0;
+
+    if (rw->rw_reading){
+        clixon_event_unreg_fd(rw->rw_fd, read_worker_reply);
+        rw->rw_reading = 0;
+    }
+    /* rw_pid is cleared in SIGCHLD handler */
+    clicon_signal_block(SIGCHLD);
+    close(rw->rw_fd);
+    rw->rw_fd = -1;
+    _read_worker_nr--;
+    if (rw->rw_pid){
+        if (sig)
+            kill(rw->rw_pid, sig);
+        if (waitpid(rw->rw_pid, &status, WNOHANG) == rw->rw_pid)
+            rw->rw_pid = 0;
+    }
+    clicon_signal_unblock(SIGCHLD);
+}
+
+/*! Register or unregister reading reply from read worker of client
+ *
+ * @param[in]  ce    Client entry
+ * @param[in]  read  Read reply from worker, otherwise stop reading
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see backend_client_read_update
+ */
+static int
+read_worker_read_update(struct client_entry *ce,
+                        int                  read)
+{
+    read_worker *rw;
+
+    if ((rw = read_worker_find(ce->ce_id)) == NULL)
+        return 0;
+    if (read && !rw->rw_reading){
+        if (clixon_event_reg_fd(rw->rw_fd, read_worker_reply, rw, "read worker") < 0)
+            return -1;
+        rw->rw_reading = 1;
+    }
+    else if (!read && rw->rw_reading){
+        clixon_event_unreg_fd(rw->rw_fd, read_worker_reply);
+        rw->rw_reading = 0;
+    }
+    return 0;
+}
+
+/*! Terminate read worker of a client that is removed
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  ce   Client entry
+ * @retval     0    OK
+ * @see backend_client_rm
+ */
+static int
+read_worker_cancel(clixon_handle        h,
+                   struct client_entry *ce)
+{
+    read_worker *rw;
+
+    if ((rw = read_worker_find(ce->ce_id)) != NULL){
+        clixon_debug(CLIXON_DBG_BACKEND, "worker:%d ce_id:%u", rw->rw_pid, rw->rw_id);
+        read_worker_close(rw, SIGTERM);
+    }
+    ce->ce_worker = 0;
+    return 0;
+}
+
+/*! In worker: send session counters updated by worker after the reply
+ *
+ * @param[in]  ce   Client entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+read_worker_counters_send(struct client_entry *ce)
+{
+    struct read_worker_counters rc;
+
+    rc.rc_in_bad_rpcs = ce->ce_in_bad_rpcs - _read_worker_counters0.rc_in_bad_rpcs;
+    rc.rc_out_rpc_errors = ce->ce_out_rpc_errors - _read_worker_counters0.rc_out_rpc_errors;
+    if (ce_write(ce->ce_s, (char*)&rc, sizeof(rc)) < 0){
+        clixon_err(OE_UNIX, errno, "write");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Add session counters sent by worker to client and monitoring counters
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  rw   Read worker
+ * @param[in]  ce   Client entry
+ */
+static void
+read_worker_counters_add(clixon_handle        h,
+                         read_worker         *rw,
+                         struct client_entry *ce)
+{
+    struct read_worker_counters rc;
+    uint32_t                    i;
+
+    if (cbuf_len(rw->rw_cb) != sizeof(rc)) /* Worker exited before sending counters */
+        return;
+    memcpy(&rc, cbuf_get(rw->rw_cb), sizeof(rc));
+    ce->ce_in_bad_rpcs += rc.rc_in_bad_rpcs;
+    for (i=0; i<rc.rc_in_bad_rpcs; i++)
+        netconf_monitoring_counter_inc(h, "in-bad-rpcs");
+    ce->ce_out_rpc_errors += rc.rc_out_rpc_errors;
+    for (i=0; i<rc.rc_out_rpc_errors; i++)
+        netconf_monitoring_counter_inc(h, "out-rpc-errors");
+}
+
+/*! Track the chunked frame of the reply read from worker
+ *
+ * @param[in]  rw    Read worker
+ * @param[in]  buf   Data read from worker
+ * @param[in]  len   Length of data
+ * @retval     n     Number of bytes that are part of the reply, the rest are session counters
+ * @retval    -1     Framing error
+ */
+static ssize_t
+read_worker_frame(read_worker *rw,
+                  char        *buf,
+                  size_t       len)
+{
+    size_t i = 0;
+    size_t n;
+    int    ret;
+
+    while (i < len && !rw->rw_eof){
+        /* Skip chunk-data */
+        if (rw->rw_state == 4 && rw->rw_size > 0){
+            n = MIN(rw->rw_size, len - i);
+            rw->rw_size -= n;
+            i += n;
+            continue;
+        }
+        if ((ret = netconf_input_chunked_framing(buf[i++], &rw->rw_state, &rw->rw_size)) < 0)
+            return -1;
+        if (ret == 2)
+            rw->rw_eof = 1;
+    }
+    return i;
+}
+
+/*! Read worker is done, complete reply to client
+ *
+ * If the worker exits inside the reply frame, an error is sent if no part of the reply is
+ * forwarded. Otherwise the reply cannot be completed and the session is closed.
+ * @param[in]  h     Clixon handle
+ * @param[in]  rw    Read worker
+ * @param[in]  ce    Client entry
+ * @param[in]  descr Description of client for logging
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+read_worker_done(clixon_handle        h,
+                 read_worker         *rw,
+                 struct client_entry *ce,
+                 const char          *descr)
+{
+    int   retval = -1;
+    cbuf *cbret = NULL;
+
+    clixon_debug(CLIXON_DBG_BACKEND, "worker:%d ce_id:%u len:%zu eof:%d",
+                 rw->rw_pid, rw->rw_id, rw->rw_sent, rw->rw_eof);
+    read_worker_close(rw, rw->rw_eof ? 0 : SIGTERM);
+    if (rw->rw_eof)
+        read_worker_counters_add(h, rw, ce);
+    else if (rw->rw_sent == 0){ /* Worker failed without a reply */
+        if ((cbret = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        if (netconf_operation_failed(cbret, "application", "Read worker failed") < 0)
+            goto done;
+        if (ce_send_reply(h, ce, descr, cbuf_get(cbret), cbuf_len(cbret)+1) < 0)
+            goto done;
+        ce->ce_out_rpc_errors++;
+        netconf_monitoring_counter_inc(h, "out-rpc-errors");
+    }
+    else {
+        clixon_log(h, LOG_WARNING, "client %d read worker failed in reply, closing session",
+                   ce->ce_nr);
+        /* Client is removed when reading EOF */
+        ce_outq_reset(ce);
+        shutdown(ce->ce_s, SHUT_RDWR);
+    }
+    /* Continue reading from client */
+    ce->ce_worker = 0;
+    if (backend_client_read_update(h, ce) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cbret)
+        cbuf_free(cbret);
+    return retval;
+}
+
+/*! Reply data from read worker, forward it to client
+ *
+ * @param[in]   s    Read end of pipe from worker
+ * @param[in]   arg  Read worker
+ * @retval      0    OK
+ * @retval     -1    Error
+ */
+static int
+read_worker_reply(int   s,
+                  void *arg)
+{
+    int                  retval = -1;
+    read_worker         *rw = (read_worker *)arg;
+    clixon_handle        h = rw->rw_h;
+    struct client_entry *ce;
+    char                 buf[BUFSIZ];
+    ssize_t              len;
+    ssize_t              n;
+    int                  poll;
+    cbuf                *cbce = NULL;
+    cbuf                *cb = NULL;
+
+    /* Worker is terminated when client is removed, see read_worker_cancel */
+    if ((ce = ce_find_byid(backend_client_list(h), rw->rw_id)) == NULL){
+        clixon_err(OE_UNIX, ENOENT, "No client with session id %u", rw->rw_id);
+        goto done;
+    }
+    if (ce_client_descr(ce, &cbce) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    /* Reading stops if output queue of client gets full */
+    while (rw->rw_reading){
+        if ((len = read(s, buf, sizeof(buf))) < 0){
+            if (errno == EINTR)
+                continue;
+            clixon_err(OE_UNIX, errno, "read");
+            goto done;
+        }
+        if (len == 0) /* Worker is done */
+            break;
+        if ((n = read_worker_frame(rw, buf, len)) < 0){
+            clixon_log(h, LOG_WARNING, "client %d read worker: %s", ce->ce_nr, clixon_err_reason());
+            clixon_err_reset();
+            break;
+        }
+        /* Reply is already framed, forward as is */
+        if (n > 0){
+            cbuf_reset(cb);
+            if (cbuf_append_buf(cb, buf, n) < 0){
+                clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+                goto done;
+            }
+            if (ce_send(h, ce, cbuf_get(cbce), cb) < 0)
+                goto done;
+            rw->rw_sent += n;
+        }
+        if (n < len &&
+            cbuf_append_buf(rw->rw_cb, buf + n, len - n) < 0){
+            clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+            goto done;
+        }
+        /* poll==1 if more, poll==0 if none */
+        if ((poll = clixon_event_poll(s)) < 0)
+            goto done;
+        if (poll == 0)
+            goto ok; /* Wait for more */
+    }
+    if (rw->rw_reading &&
+        read_worker_done(h, rw, ce, cbuf_get(cbce)) < 0)
+        goto done;
+ ok:
+    read_worker_gc();
+    retval = 0;
+ done:
+    if (cbce)
+        cbuf_free(cbce);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Serve a read-only request in a forked read worker process
+ *
+ * Only get and get-config are served by workers, and only if the number of active
+ * workers is less than CLICON_BACKEND_READ_WORKERS.
+ * In the worker, the request is handled as usual but the reply is sent on a pipe to the
+ * backend. The worker process exits when from_client returns.
+ * @param[in]  h     Clixon handle
+ * @param[in]  ce    Client entry
+ * @param[in]  xe    Request, eg <get>
+ * @retval     1     Request is served by worker, backend is done
+ * @retval     0     Handle request as usual, in backend or in worker
+ * @retval    -1     Error
+ * @note State data callbacks of plugins are called in the worker process
+ */
+static int
+read_worker_start(clixon_handle        h,
+                  struct client_entry *ce,
+                  cxobj               *xe)
+{
+    int          retval = -1;
+    read_worker *rw = NULL;
+    yang_stmt   *ye;
+    char        *ns;
+    int          fds[2] = {-1, -1};
+    pid_t        pid;
+
+    read_worker_gc();
+    if (_read_worker_nr >= clicon_option_int(h, "CLICON_BACKEND_READ_WORKERS"))
+        goto skip;
+    if (strcmp(xml_name(xe), "get") != 0 && strcmp(xml_name(xe), "get-config") != 0)
+        goto skip;
+    if ((ye = xml_spec(xe)) == NULL ||
+        (ns = yang_find_mynamespace(ye)) == NULL ||
+        strcmp(ns, NETCONF_BASE_NAMESPACE) != 0)
+        goto skip;
+    if ((rw = malloc(sizeof(*rw))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(rw, 0, sizeof(*rw));
+    rw->rw_h = h;
+    rw->rw_fd = -1;
+    if ((rw->rw_cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (pipe(fds) < 0){
+        clixon_err(OE_UNIX, errno, "pipe");
+        goto done;
+    }
+    clicon_signal_block(SIGCHLD);
+    if ((pid = fork()) < 0){
+        clicon_signal_unblock(SIGCHLD);
+        clixon_err(OE_UNIX, errno, "fork");
+        goto done;
+    }
+    if (pid == 0){ /* Worker: handle request and send reply on pipe */
+        /* Drop backend events, the epoll instance is shared with the backend */
+        clixon_event_exit();
+        ce->ce_reading = 0;
+        clicon_signal_unblock(SIGCHLD);
+        /* Backend event loop is not run in worker, terminate directly */
+        set_signal(SIGTERM, SIG_DFL, NULL);
+        close(fds[0]);
+        ce->ce_s = fds[1];
+        /* Queued output is written by the backend */
+        if (ce->ce_outq)
+            cbuf_reset(ce->ce_outq);
+        ce->ce_outq_start = 0;
+        _read_worker_child = 1;
+        _read_worker_counters0.rc_in_bad_rpcs = ce->ce_in_bad_rpcs;
+        _read_worker_counters0.rc_out_rpc_errors = ce->ce_out_rpc_errors;
+        cbuf_free(rw->rw_cb);
+        free(rw);
+        rw = NULL;
+        goto skip;
+    }
+    close(fds[1]);
+    fds[1] = -1;
+    rw->rw_pid = pid;
+    rw->rw_fd = fds[0];
+    rw->rw_id = ce->ce_id;
+    ADDQ(rw, _read_workers);
+    clicon_signal_unblock(SIGCHLD);
+    _read_worker_nr++;
+    clixon_debug(CLIXON_DBG_BACKEND, "worker:%d ce_id:%u %s", pid, ce->ce_id, xml_name(xe));
+    rw = NULL;
+    /* Do not read more requests from client until reply is sent, start reading reply */
+    ce->ce_worker = 1;
+    if (backend_client_read_update(h, ce) < 0)
+        goto done;
+    retval = 1;
+ done:
+    if (rw){
+        if (fds[0] != -1)
+            close(fds[0]);
+        if (fds[1] != -1)
+            close(fds[1]);
+        if (rw->rw_cb)
+            cbuf_free(rw->rw_cb);
+        free(rw);
+    }
+    return retval;
+ skip:
+    retval = 0;
+    goto done;
+}
+
+/*! Reap read workers that have exited
+ *
+ * Called from SIGCHLD handler: only waitpid, the list is not modified
+ * @retval     0   OK
+ */
+int
+backend_read_workers_reap(void)
+{
+    read_worker *rw;
+    int          status;
+    int          err = errno;
+
+    if ((rw = _read_workers) != NULL)
+        do {
+            if (rw->rw_pid && waitpid(rw->rw_pid, &status, WNOHANG) == rw->rw_pid)
+                rw->rw_pid = 0;
+            rw = NEXTQ(read_worker *, rw);
+        } while (rw && rw != _read_workers);
+    errno = err;
+    return 0;
+}
+
+/*! Terminate read workers
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     0   OK
+ */
+int
+backend_read_workers_exit(clixon_handle h)
+{
+    read_worker *rw;
+    int          status = 0;
+
+    while ((rw = _read_workers) != NULL){
+        if (rw->rw_fd != -1)
+            read_worker_close(rw, SIGTERM);
+        clicon_signal_block(SIGCHLD);
+        if (rw->rw_pid){
+            waitpid(rw->rw_pid, &status, 0);
+            rw->rw_pid = 0;
+        }
+        clicon_signal_unblock(SIGCHLD);
+        read_worker_free(rw);
+    }
+    return 0;
+}
+
 /*! An internal clixon NETCONF message has arrived from a local client. Receive and dispatch.
  *
  * @param[in]   h    Clixon handle
@@ -1653,6 +2610,8 @@ from_client_msg(clixon_handle        h,
     char                *namespace = NULL;
     int                  nr = 0;
     cbuf                *cbce = NULL;
+    xml_arena           *xa = NULL;
+    xml_arena           *xa0;
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
     yspec = clicon_dbspec_yang(h);
@@ -1663,10 +2622,17 @@ from_client_msg(clixon_handle        h,
         clixon_err(OE_XML, errno, "cbuf_new");
         goto done;
     }
+    /* Request and error trees are allocated from an arena released when the request is done
+     * The arena is only set while they are created, not while the request is handled */
+    if ((xa = xml_arena_new()) == NULL)
+        goto done;
     /* Decode msg from client -> xml top (ct) and session id 
      * Bind is a part of the decode function
      */
-    if ((ret = clixon_xml_parse_string(msg, YB_RPC, yspec, &xt, &xret)) < 0){
+    xa0 = xml_arena_set(xa);
+    ret = clixon_xml_parse_string(msg, YB_RPC, yspec, &xt, &xret);
+    xml_arena_set(xa0);
+    if (ret < 0){
         if (netconf_malformed_message(cbret, "XML parse error") < 0)
             goto done;
         goto reply;
@@ -1759,7 +2725,10 @@ from_client_msg(clixon_handle        h,
      * This may not be correct, the RFC does not mention expanding default values for
      * input RPC
      */
-    if ((ret = xml_yang_validate_rpc(h, x, 1, &xret)) < 0){
+    xa0 = xml_arena_set(xa);
+    ret = xml_yang_validate_rpc(h, x, 1, &xret);
+    xml_arena_set(xa0);
+    if (ret < 0){
         ce->ce_in_bad_rpcs++;
         netconf_monitoring_counter_inc(h, "in-bad-rpcs");
         goto done;
@@ -1829,18 +2798,27 @@ from_client_msg(clixon_handle        h,
                 goto reply;
             }
         }
+        /* Read-only request may be served by a worker */
+        if ((ret = read_worker_start(h, ce, xe)) < 0)
+            goto done;
+        if (ret == 1)
+            goto ok;
         clixon_err_reset();
         if ((ret = rpc_callback_call(h, xe, ce, &nr, cbret)) < 0){
-            if (netconf_operation_failed(cbret, "application", clixon_err_reason())< 0)
-                goto done;
             clixon_log(h, LOG_NOTICE, "%s Error in rpc_callback_call:%s", __FUNCTION__, xml_name(xe));
             ce->ce_out_rpc_errors++;
             netconf_monitoring_counter_inc(h, "out-rpc-errors");
+            if (ce->ce_chunked)
+                goto abort;
+            if (netconf_operation_failed(cbret, "application", clixon_err_reason())< 0)
+                goto done;
             goto reply; /* Dont quit here on user callbacks */
         }
         if (ret == 0){
             ce->ce_out_rpc_errors++;
             netconf_monitoring_counter_inc(h, "out-rpc-errors");
+            if (ce->ce_chunked)
+                goto abort;
             goto reply;
         }
         if (nr == 0){ /* not handled by callback */
@@ -1858,7 +2836,8 @@ from_client_msg(clixon_handle        h,
         }
     } /* while */
  reply:
-    if (cbuf_len(cbret) == 0)
+    /* If part of the reply is already sent, the remainder may be empty */
+    if (cbuf_len(cbret) == 0 && !ce->ce_chunked)
         if (netconf_operation_failed(cbret, "application",
                                      clixon_err_category()?clixon_err_reason():"unknown")< 0)
             goto done;
@@ -1867,24 +2846,13 @@ from_client_msg(clixon_handle        h,
        parse errors */
     if (ce_client_descr(ce, &cbce) < 0)
         goto done;
-    if (send_msg_reply(ce->ce_s, cbuf_get(cbce), cbuf_get(cbret), cbuf_len(cbret)+1) < 0){
-        switch (errno){
-        case EPIPE:
-            /* man (2) write: 
-             * EPIPE  fd is connected to a pipe or socket whose reading end is 
-             * closed.  When this happens the writing process will also receive 
-             * a SIGPIPE signal. 
-             * In Clixon this means a client, eg restconf, netconf or cli closes
-             * the (UNIX domain) socket.
-             */
-        case ECONNRESET:
-            clixon_log(h, LOG_WARNING, "client rpc reset");
-            break;
-        default:
-            goto done;
-        }
-    }
-    // ok:
+    /* Write errors, eg if a client closes the socket, are logged and the client is removed
+     * when reading EOF */
+    /* The last chunk is followed by end-of-chunks, see backend_client_reply_chunk */
+    ce->ce_chunked = 0;
+    if (ce_send_reply(h, ce, cbuf_get(cbce), cbuf_get(cbret), cbuf_len(cbret)+1) < 0)
+        goto done;
+  ok:
     retval = 0;
   done:
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "retval:%d", retval);
@@ -1897,6 +2865,8 @@ from_client_msg(clixon_handle        h,
         xml_free(xret);
     if (xt)
         xml_free(xt);
+    if (xa)
+        xml_arena_free(xa);
     if (cbce)
         cbuf_free(cbce);
     if (cbret)
@@ -1907,6 +2877,10 @@ from_client_msg(clixon_handle        h,
                    __FUNCTION__, rpc?rpc:"");
     //    clixon_debug(CLIXON_DBG_BACKEND, "retval:%d", retval);
     return retval;// -1 here terminates backend
+ abort: /* Part of the reply is sent, it cannot be followed by an error reply */
+    if (ce_reply_abort(h, ce) < 0)
+        goto done;
+    goto ok;
 }
 
 /*! Internal clixon message has arrived from a client. Receive and dispatch.
@@ -1951,6 +2925,12 @@ from_client(int   s,
         cbuf_free(cb);
     if (cbce)
         cbuf_free(cbce);
+    /* Read worker is done when reply and session counters are sent */
+    if (_read_worker_child){
+        if (read_worker_counters_send(ce) < 0)
+            retval = -1;
+        _exit(retval < 0 ? 1 : 0);
+    }
     return retval; /* -1 here terminates backend */
 }
 
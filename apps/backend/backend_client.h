@@ -43,6 +43,10 @@
 int backend_monitoring_state_get(clixon_handle h, yang_stmt *yspec, char *xpath, cvec *nsc, cxobj **xret, cxobj **xerr);
 int backend_client_rm(clixon_handle h, struct client_entry *ce);
 int from_client(int fd, void *arg);
+int backend_client_read_update(clixon_handle h, struct client_entry *ce);
+int backend_client_reply_chunk(clixon_handle h, struct client_entry *ce, cbuf *cb);
+int backend_read_workers_reap(void);
+int backend_read_workers_exit(clixon_handle h);
 int backend_rpc_init(clixon_handle h);
 
 #endif  /* _BACKEND_CLIENT_H_ */
@@ -84,6 +84,7 @@
  * @param[in]   h       Clixon handle
  * @param[in]   yspec   Yang spec
  * @param[in]   td      Transaction data
+ * @param[in]   incremental  Source is valid, only validate what is affected by the differences
  * @param[out]  xret    Error XML tree. Free with xml_free after use
  * @retval      1       Validation OK       
  * @retval      0       Validation failed (with cbret set)
@@ -93,6 +94,7 @@ static int
 generic_validate(clixon_handle       h,
                  yang_stmt          *yspec,
                  transaction_data_t *td,
+                 int                 incremental,
                  cxobj             **xret)
 {
     int        retval = -1;
@@ -101,8 +103,14 @@ generic_validate(clixon_handle       h,
     int        ret;
     cbuf      *cb = NULL;
 
-    /* All entries */
-    if ((ret = xml_yang_validate_all_top(h, td->td_target, xret)) < 0)
+    if (incremental)
+        ret = xml_yang_validate_changes(h, td->td_target,
+                                        td->td_dvec, td->td_dlen,
+                                        td->td_avec, td->td_alen,
+                                        td->td_tcvec, td->td_clen, xret);
+    else /* All entries */
+        ret = xml_yang_validate_all_top(h, td->td_target, xret);
+    if (ret < 0)
         goto done;
     if (ret == 0)
         goto fail;
@@ -180,7 +188,7 @@ startup_common(clixon_handle       h,
             goto done;
     clixon_debug(CLIXON_DBG_BACKEND, "Reading initial config from %s", db);
     if (clicon_option_bool(h, "CLICON_XMLDB_UPGRADE_CHECKOLD")){
-        if ((ret = xmldb_get0(h, db, YB_MODULE, NULL, "/", 0, 0, &xt, msdiff, &xerr)) < 0)
+        if ((ret = xmldb_get0(h, db, YB_MODULE, NULL, "/", 1, 0, &xt, msdiff, &xerr)) < 0)
             goto done;
         if (ret == 0){     /* ret should not be 0 */
             /* Print upgraded db: -q backend switch for debugging/ showing upgraded config only */
@@ -200,7 +208,7 @@ startup_common(clixon_handle       h,
         /* Get the startup datastore WITHOUT binding to YANG, sorting and default setting.
          * It is done below, later in this function
          */
-        if (xmldb_get0(h, db, YB_NONE, NULL, "/", 0, 0, &xt, msdiff, &xerr) < 0)
+        if (xmldb_get0(h, db, YB_NONE, NULL, "/", 1, 0, &xt, msdiff, &xerr) < 0)
             goto done;
     }
     clixon_debug_xml(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, xt, "startup");
@@ -310,7 +318,7 @@ startup_common(clixon_handle       h,
     /* 5. Make generic validation on all new or changed data.
        Note this is only call that uses 3-values */
     clixon_debug(CLIXON_DBG_BACKEND, "Validating startup %s", db);
-    if ((ret = generic_validate(h, yspec, td, &xret)) < 0)
+    if ((ret = generic_validate(h, yspec, td, 0, &xret)) < 0)
         goto done;
     if (ret == 0){
         if (clixon_xml2cbuf(cbret, xret, 0, 0, NULL, -1, 0) < 0)
@@ -464,6 +472,54 @@ startup_commit(clixon_handle  h,
     goto done;
 }
 
+/*! Reset flags set by validate_common on changed nodes of a transaction
+ *
+ * Only the changed nodes, their subtrees and ancestors are visited, since the source
+ * and target trees may be datastore caches
+ * @param[in]  vec   Vector of changed nodes
+ * @param[in]  len   Length of vector
+ */
+static void
+transaction_flags_reset(cxobj **vec,
+                        int     len)
+{
+    int    i;
+    cxobj *xn;
+
+    for (i=0; i<len; i++){
+        xn = vec[i];
+        xml_flag_reset(xn, XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE);
+        xml_apply(xn, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+                  (void*)(XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE));
+        xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_CHANGE);
+    }
+}
+
+/*! Release source and target trees of a transaction made by validate_common
+ *
+ * Reset flags of changed nodes and free the trees unless they are datastore caches
+ * @param[in]  h   Clixon handle
+ * @param[in]  td  Transaction data, free with transaction_free after this call
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+transaction_release(clixon_handle       h,
+                    transaction_data_t *td)
+{
+    transaction_flags_reset(td->td_dvec, td->td_dlen);
+    transaction_flags_reset(td->td_avec, td->td_alen);
+    if (td->td_scvec)
+        transaction_flags_reset(td->td_scvec, td->td_clen);
+    if (td->td_tcvec)
+        transaction_flags_reset(td->td_tcvec, td->td_clen);
+    if (xmldb_get0_free(h, &td->td_src) < 0)
+        return -1;
+    if (xmldb_get0_free(h, &td->td_target) < 0)
+        return -1;
+    return 0;
+}
+
 /*! Validate a candidate db and comnpare to running
  *
  * Get both source and dest datastore, validate target, compute diffs
@@ -477,6 +533,10 @@ startup_commit(clixon_handle  h,
  * @retval    -1       Error - or validation failed (but cbret not set)
  * @note Need to differentiate between error and validation fail 
  *       (only done for generic_validate)
+ * @note If edits since running are known, source and target are the datastore caches
+ *       and must not be modified, and are the same tree if db and running are shared.
+ *       Release them with transaction_release
+ * @see transaction_data in clixon_plugin.h  Read-only for plugins
  * @see startup_common  for startup scenario
  */
 static int
@@ -490,44 +550,64 @@ validate_common(clixon_handle       h,
     int         i;
     cxobj      *xn;
     int         ret;
+    cxobj      *xs;
+    int         copy;
 
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
         clixon_err(OE_FATAL, 0, "No DB_SPEC");
         goto done;
     }
-    if (xmldb_cache_get(h, db) != NULL){
+    /* Edits made since db was equal to running, if known.
+     * If so, the edits are already populated and written to file (unless volatile) */
+    xs = xmldb_changes_get(h, db);
+    if ((xs == NULL || xmldb_volatile_get(h, db)) &&
+        xmldb_cache_get(h, db) != NULL){
         if (xmldb_populate(h, db) < 0)
             goto done;
         if (xmldb_write_cache2file(h, db) < 0)
             goto done;
     }
+    /* If edits are known, use the cached trees instead of copies.
+     * Flags of changed nodes are set below, so the caches must not be shared with other
+     * datastores, unless db and running are the same tree in which case nothing changed */
+    copy = (xs == NULL);
+    td->td_readonly = !copy;
+    if (!copy && xmldb_cache_get(h, db) != xmldb_cache_get(h, "running")){
+        if (xmldb_cache_unshare(h, db) < 0)
+            goto done;
+        if (xmldb_cache_unshare(h, "running") < 0)
+            goto done;
+    }
     /* This is the state we are going to */
-    if ((ret = xmldb_get0(h, db, YB_MODULE, NULL, "/", 0, 0, &td->td_target, NULL, xret)) < 0)
+    if ((ret = xmldb_get0(h, db, YB_MODULE, NULL, "/", copy, 0, &td->td_target, NULL, xret)) < 0)
         goto done;
     if (ret == 0)
         goto fail;
     /* Clear flags xpath for get */
-    xml_apply0(td->td_target, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
-               (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
+    if (copy)
+        xml_apply0(td->td_target, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+                   (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
     /* 2. Parse xml trees
      * This is the state we are going from */
-    if ((ret = xmldb_get0(h, "running", YB_MODULE, NULL, "/", 0, 0, &td->td_src, NULL, xret)) < 0)
+    if ((ret = xmldb_get0(h, "running", YB_MODULE, NULL, "/", copy, 0, &td->td_src, NULL, xret)) < 0)
         goto done;
     if (ret == 0)
         goto fail;
     /* Clear flags xpath for get */
-    xml_apply0(td->td_src, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
-               (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
-    /* 3. Compute differences */
-    if (xml_diff(td->td_src,
-                 td->td_target,
-                 &td->td_dvec,      /* removed: only in running */
-                 &td->td_dlen,
-                 &td->td_avec,      /* added: only in candidate */
-                 &td->td_alen,
-                 &td->td_scvec,     /* changed: original values */
-                 &td->td_tcvec,     /* changed: wanted values */
-                 &td->td_clen) < 0)
+    if (copy)
+        xml_apply0(td->td_src, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+                   (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
+    /* 3. Compute differences, restricted to edited parts if known */
+    if (xml_diff_changes(td->td_src,
+                         td->td_target,
+                         xs,
+                         &td->td_dvec,      /* removed: only in running */
+                         &td->td_dlen,
+                         &td->td_avec,      /* added: only in candidate */
+                         &td->td_alen,
+                         &td->td_scvec,     /* changed: original values */
+                         &td->td_tcvec,     /* changed: wanted values */
+                         &td->td_clen) < 0)
         goto done;
     if (clixon_debug_get() & CLIXON_DBG_DETAIL)
         transaction_dbg(h, CLIXON_DBG_DETAIL, td, __FUNCTION__);
@@ -557,8 +637,11 @@ validate_common(clixon_handle       h,
         goto done;
 
     /* 5. Make generic validation on all new or changed data.
+       If edits since running are known, only what they may affect is validated.
        Note this is only call that uses 3-values */
-    if ((ret = generic_validate(h, yspec, td, xret)) < 0)
+    if ((ret = generic_validate(h, yspec, td,
+                                xs != NULL && clicon_option_bool(h, "CLICON_VALIDATE_INCREMENTAL"),
+                                xret)) < 0)
         goto done;
     if (ret == 0)
         goto fail;
@@ -637,6 +720,8 @@ candidate_validate(clixon_handle h,
      if (td){
          if (retval < 1)
              plugin_transaction_abort_all(h, td);
+         if (transaction_release(h, td) < 0)
+             retval = -1;
          transaction_free(td);
      }
     return retval;
@@ -717,11 +802,11 @@ candidate_commit(clixon_handle  h,
     if (plugin_transaction_commit_done_all(h, td) < 0)
         goto done;
     /* 8. Success: Copy candidate to running 
+     * Deleted and changed nodes of old (source) tree are not passed to end callbacks
      */
-    if (xmldb_copy(h, db, "running") < 0)
-        goto done;
-    xmldb_modified_set(h, db, 0); /* reset dirty bit */
-    /* Here pointers to old (source) tree are obsolete */
+    transaction_flags_reset(td->td_dvec, td->td_dlen);
+    if (td->td_scvec)
+        transaction_flags_reset(td->td_scvec, td->td_clen);
     if (td->td_dvec){
         td->td_dlen = 0;
         free(td->td_dvec);
@@ -731,6 +816,12 @@ candidate_commit(clixon_handle  h,
         free(td->td_scvec);
         td->td_scvec = NULL;
     }
+    /* Source may be the running cache, keep it until the transaction is released */
+    if (td->td_src != NULL && td->td_src == xmldb_cache_get(h, "running"))
+        xmldb_cache_detach(h, "running");
+    if (xmldb_copy(h, db, "running") < 0)
+        goto done;
+    xmldb_modified_set(h, db, 0); /* reset dirty bit */
 
     /* 9. Call plugin transaction end callbacks */
     plugin_transaction_end_all(h, td);
@@ -740,6 +831,8 @@ candidate_commit(clixon_handle  h,
     if (td){
         if (retval < 1)
             plugin_transaction_abort_all(h, td);
+        if (transaction_release(h, td) < 0)
+            retval = -1;
         transaction_free(td);
     }
     if (xret)
@@ -976,7 +1069,7 @@ from_client_restart_one(clixon_handle    h,
     if ((td = transaction_new()) == NULL)
         goto done;
     /* This is the state we are going to */
-    if ((ret = xmldb_get0(h, "running", YB_MODULE, NULL, "/", 0, 0, &td->td_target, NULL, &xerr)) < 0)
+    if ((ret = xmldb_get0(h, "running", YB_MODULE, NULL, "/", 1, 0, &td->td_target, NULL, &xerr)) < 0)
         goto done;
     if (ret == 1 && (ret = xml_yang_validate_all_top(h, td->td_target, &xerr)) < 0)
         goto done;
@@ -986,7 +1079,7 @@ from_client_restart_one(clixon_handle    h,
         goto fail;
     }
     /* This is the state we are going from */
-    if (xmldb_get0(h, db, YB_NONE, NULL, "/", 0, 0, &td->td_src, NULL, NULL) < 0)
+    if (xmldb_get0(h, db, YB_NONE, NULL, "/", 1, 0, &td->td_src, NULL, NULL) < 0)
         goto done;
 
     /* 3. Compute differences */
@@ -1027,7 +1120,7 @@ from_client_restart_one(clixon_handle    h,
         goto fail;
     /* Make generic validation on all new or changed data.
        Note this is only call that uses 3-values */
-    if ((ret = generic_validate(h, yspec, td, &xerr)) < 0)
+    if ((ret = generic_validate(h, yspec, td, 0, &xerr)) < 0)
         goto done;
     if (ret == 0){
         if (clixon_xml2cbuf(cbret, xerr, 0, 0, NULL, -1, 0) < 0)
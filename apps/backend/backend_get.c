@@ -360,6 +360,9 @@ filter_xpath_again(clixon_handle h,
         clixon_err(OE_PLUGIN, EINVAL, "xret is NULL");
         goto done;
     }
+    /* Complete tree selected, nothing to filter */
+    if (xlen == 1 && xvec[0] == xret)
+        goto ok;
     /* If vectors are specified then mark the nodes found and
      * then filter out everything else,
      * otherwise return complete tree.
@@ -375,14 +378,195 @@ filter_xpath_again(clixon_handle h,
     /* reset flag */
     if (xml_apply(xret, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_MARK) < 0)
         goto done;
+ ok:
     retval = 0;
  done:
     return retval;
 }
 
+/*! Flush callback when serializing a get reply, send buffer as a chunk to client
+ *
+ * @param[in]  cb   Part of reply
+ * @param[in]  arg  Client entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see get_nacm_and_reply
+ */
+static int
+get_reply_flush(cbuf *cb,
+                void *arg)
+{
+    struct client_entry *ce = (struct client_entry *)arg;
+
+    return backend_client_reply_chunk(ce->ce_handle, ce, cb);
+}
+
+/*! Argument of get_json_flush
+ */
+struct json_reply {
+    struct client_entry *jr_ce;    /* Client entry */
+    cbuf                *jr_cbret; /* Reply buffer, starting with rpc-reply header */
+};
+
+/*! Append JSON to reply buffer inside a CDATA section, "]]>" is split in two sections
+ *
+ * @param[in]  cbret  Reply buffer
+ * @param[in]  str    JSON string, modified during the call but restored
+ */
+static void
+get_json_cdata(cbuf *cbret,
+               char *str)
+{
+    char *p;
+
+    while ((p = strstr(str, "]]>")) != NULL){
+        *p = '\0';
+        cbuf_append_str(cbret, str);
+        *p = ']';
+        cbuf_append_str(cbret, "]]]]><![CDATA[>");
+        str = p + strlen("]]>");
+    }
+    cbuf_append_str(cbret, str);
+}
+
+/*! Flush callback of JSON encoder: append JSON to reply and send reply chunk to client
+ *
+ * The JSON encoder flushes between objects, ie "]]>" is never split between two calls
+ * @param[in]  cb   JSON buffer, reset by the encoder after the call
+ * @param[in]  arg  Reply state, struct json_reply
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see get_reply_flush
+ */
+static int
+get_json_flush(cbuf *cb,
+               void *arg)
+{
+    struct json_reply *jr = (struct json_reply *)arg;
+
+    get_json_cdata(jr->jr_cbret, cbuf_get(cb));
+    if (get_reply_flush(jr->jr_cbret, jr->jr_ce) < 0)
+        return -1;
+    cbuf_reset(jr->jr_cbret);
+    return 0;
+}
+
+/*! Encode reply data as JSON directly from the result tree, see clicon_rpc_get_json
+ *
+ * The JSON is sent in a CDATA section on the form:
+ *   <rpc-reply><cl:json count="N"><![CDATA[...]]></cl:json></rpc-reply>
+ * where N is the number of objects selected by xpath, and "]]>" is split in two sections.
+ * If chunk is set, the reply is sent to the client in pieces while encoding, as XML replies.
+ * @param[in]  h        Clixon handle
+ * @param[in]  ce       Client entry, or NULL
+ * @param[in]  xret     Result XML tree, may be a cached datastore
+ * @param[in]  xpath    XPath point to object to get
+ * @param[in]  nsc      Namespace context of xpath
+ * @param[in]  pretty   Set if JSON is pretty-printed
+ * @param[in]  wdef     With-defaults parameter, not WITHDEFAULTS_REPORT_ALL_TAGGED
+ * @param[in]  chunk    Send reply in chunks of this size, 0 means no chunks
+ * @param[out] cbret    Return xml tree, eg <rpc-reply>...
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+get_json_reply(clixon_handle        h,
+               struct client_entry *ce,
+               cxobj               *xret,
+               char                *xpath,
+               cvec                *nsc,
+               int                  pretty,
+               withdefaults_type    wdef,
+               uint32_t             chunk,
+               cbuf                *cbret)
+{
+    int               retval = -1;
+    cbuf             *cbj = NULL;
+    char             *name = NULL;
+    yang_stmt        *y0 = NULL;
+    cxobj           **xvec = NULL;
+    size_t            xlen = 0;
+    size_t            n = 0;
+    size_t            i;
+    struct json_reply jr = {ce, cbret};
+    int               ret;
+
+    if ((cbj = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    /* xret may be a cached datastore, restore its name and yang below */
+    if ((name = strdup(xml_name(xret))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    y0 = xml_spec(xret);
+    if (xml_name_set(xret, NETCONF_OUTPUT_DATA) < 0)
+        goto done;
+    /* Same as data of a reply parsed by the client */
+    if (xml_bind_special(xret, clicon_dbspec_yang(h), "/nc:get/output/data") < 0)
+        goto done;
+    if (xpath == NULL || strcmp(xpath, "/") == 0)
+        n = 1;
+    else {
+        if (xpath_vec(xret, nsc, "%s", &xvec, &xlen, xpath) < 0)
+            goto done;
+        /* Only objects printed according to with-defaults */
+        for (i=0; i<xlen; i++){
+            if ((ret = xml2output_wdef(xvec[i], wdef, NULL)) < 0)
+                goto done;
+            if (ret == 1)
+                xvec[n++] = xvec[i];
+        }
+    }
+    /* Count is known before encoding, so the header is sent with the first chunk */
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><%s:json xmlns:%s=\"%s\" count=\"%zu\"><![CDATA[",
+            NETCONF_BASE_NAMESPACE,
+            CLIXON_LIB_PREFIX, CLIXON_LIB_PREFIX, CLIXON_LIB_NS,
+            n);
+    if (ce == NULL)
+        chunk = 0;
+    if (xvec == NULL){
+        if (chunk != 0){
+            if (clixon_json2cbuf_stream(cbj, xret, pretty, wdef,
+                                        chunk, get_json_flush, &jr) < 0)
+                goto done;
+        }
+        else if (clixon_json2cbuf1(cbj, xret, pretty, 0, 0, wdef) < 0)
+            goto done;
+    }
+    else if (n > 0){
+        if (chunk != 0){
+            if (xml2json_cbuf_vec_stream(cbj, xvec, n, pretty, wdef,
+                                         chunk, get_json_flush, &jr) < 0)
+                goto done;
+        }
+        else if (xml2json_cbuf_vec1(cbj, xvec, n, pretty, 0, wdef) < 0)
+            goto done;
+    }
+    /* Remainder is sent by the caller */
+    get_json_cdata(cbret, cbuf_get(cbj));
+    cprintf(cbret, "]]></%s:json></rpc-reply>", CLIXON_LIB_PREFIX);
+    retval = 0;
+ done:
+    if (name){
+        xml_name_set(xret, name);
+        xml_spec_set(xret, y0);
+        free(name);
+    }
+    if (xvec)
+        free(xvec);
+    if (cbj)
+        cbuf_free(cbj);
+    return retval;
+}
+
 /*! Help function for NACM access and return message
  *
+ * If CLICON_BACKEND_REPLY_CHUNK is set, the reply is sent to the client in chunks of that size
+ * while serializing, and only the remainder is left in cbret.
  * @param[in]  h        Clixon handle
+ * @param[in]  ce       Client entry, or NULL
  * @param[in]  xret     Result XML tree
  * @param[in]  xvec    xpath lookup result on xret
  * @param[in]  xlen    length of xvec
@@ -391,12 +575,15 @@ filter_xpath_again(clixon_handle h,
  * @param[in]  username User name for NACM access
  * @param[in]  depth    Nr of levels to print, -1 is all, 0 is none
  * @param[in]  wdef     With-defaults parameter
+ * @param[in]  json     -1: XML reply, 0: JSON reply if possible, 1: pretty-printed JSON
  * @param[out] cbret    Return xml tree, eg <rpc-reply>..., <rpc-error..
  * @retval     0        OK
  * @retval    -1        Error
+ * @see get_json_reply
  */
 static int
 get_nacm_and_reply(clixon_handle        h,
+                   struct client_entry *ce,
                    cxobj               *xret,
                    cxobj              **xvec,
                    size_t               xlen,
@@ -405,10 +592,12 @@ get_nacm_and_reply(clixon_handle        h,
                    char                *username,
                    int32_t              depth,
                    withdefaults_type    wdef,
+                   int                  json,
                    cbuf                *cbret)
 {
-    int     retval = -1;
-    cxobj  *xnacm = NULL;
+    int      retval = -1;
+    cxobj   *xnacm = NULL;
+    uint32_t chunk;
 
     /* Pre-NACM access step */
     xnacm = clicon_nacm_cache(h);
@@ -417,17 +606,29 @@ get_nacm_and_reply(clixon_handle        h,
         if (nacm_datanode_read(h, xret, xvec, xlen, username, xnacm) < 0)
             goto done;
     }
+    chunk = clicon_option_int(h, "CLICON_BACKEND_REPLY_CHUNK");
+    /* The whole reply is validated if CLICON_VALIDATE_STATE_XML, see rpc_reply_check */
+    if (clicon_option_bool(h, "CLICON_VALIDATE_STATE_XML"))
+        chunk = 0;
+    /* The JSON encoder does not support depth or with-defaults tags, reply with XML */
+    if (json != -1 && xret != NULL && depth == -1 &&
+        wdef != WITHDEFAULTS_REPORT_ALL_TAGGED){
+        if (get_json_reply(h, ce, xret, xpath, nsc, json, wdef, chunk, cbret) < 0)
+            goto done;
+        goto ok;
+    }
     cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);     /* OK */
     if (xret==NULL)
         cprintf(cbret, "<data/>");
     else{
-        if (xml_name_set(xret, NETCONF_OUTPUT_DATA) < 0)
-            goto done;
-        /* Top level is data, so add 1 to depth if significant */
-        if (clixon_xml2cbuf1(cbret, xret, 0, 0, NULL, depth>0?depth+1:depth, 0, wdef) < 0)
+        /* xret may be a cached datastore, print it as data without renaming it
+         * Top level is data, so add 1 to depth if significant */
+        if (clixon_xml2cbuf_stream(cbret, xret, NETCONF_OUTPUT_DATA, depth>0?depth+1:depth, 0, wdef,
+                                   chunk, (ce != NULL && chunk != 0)?get_reply_flush:NULL, ce) < 0)
             goto done;
     }
     cprintf(cbret, "</rpc-reply>");
+ ok:
     retval = 0;
  done:
     return retval;
@@ -897,7 +1098,7 @@ get_list_pagination(clixon_handle        h,
             cbuf_free(cba);
     }
 #endif /* LIST_PAGINATION_REMAINING */
-    if (get_nacm_and_reply(h, xret, xvec, xlen, xpath, nsc, username, depth, wdef, cbret) < 0)
+    if (get_nacm_and_reply(h, ce, xret, xvec, xlen, xpath, nsc, username, depth, wdef, -1, cbret) < 0)
         goto done;
  ok:
     retval = 0;
@@ -913,6 +1114,203 @@ get_list_pagination(clixon_handle        h,
     return retval;
 }
 
+/*! Return body of a subtree filter content match node, ie a leaf with a value
+ *
+ * @param[in]  x    Filter node
+ * @retval     str  Body
+ * @retval     NULL Not a content match node
+ * @see leafstring in netconf_filter.c
+ */
+static char *
+filter_subtree_content(cxobj *x)
+{
+    cxobj *c;
+
+    if (xml_child_nr(x) != 1)
+        return NULL;
+    c = xml_child_i(x, 0);
+    if (xml_type(c) != CX_BODY)
+        return NULL;
+    return xml_value(c);
+}
+
+/*! Print prefixed name of subtree filter node as xpath node test
+ *
+ * @param[in]  x    Filter node
+ * @param[in]  nsc  Namespace context, new prefix added if namespace not found
+ * @param[out] cb   XPath
+ * @retval     1    OK
+ * @retval     0    Not translatable: no namespace, or attribute match node
+ * @retval    -1    Error
+ */
+static int
+filter_subtree_nodetest(cxobj *x,
+                        cvec  *nsc,
+                        cbuf  *cb)
+{
+    cxobj *xa;
+    char  *ns = NULL;
+    char  *prefix = NULL;
+    char   pbuf[16];
+
+    xa = NULL;
+    while ((xa = xml_child_each(x, xa, CX_ATTR)) != NULL){
+        if (strcmp(xml_name(xa), "xmlns") != 0 &&
+            (xml_prefix(xa) == NULL || strcmp(xml_prefix(xa), "xmlns") != 0))
+            return 0; /* Attribute match */
+    }
+    if (xml2ns(x, xml_prefix(x), &ns) < 0)
+        return -1;
+    /* Unqualified filter nodes match any namespace in xml_filter */
+    if (ns == NULL || *ns == '\0' || strcmp(ns, NETCONF_BASE_NAMESPACE) == 0)
+        return 0;
+    if (xml_nsctx_get_prefix(nsc, ns, &prefix) == 0){
+        snprintf(pbuf, sizeof(pbuf), "sf%d", cvec_len(nsc));
+        if (xml_nsctx_add(nsc, pbuf, ns) < 0)
+            return -1;
+        prefix = pbuf;
+    }
+    cprintf(cb, "%s:%s", prefix, xml_name(x));
+    return 1;
+}
+
+/*! Translate a containment or selection node of a subtree filter to xpath
+ *
+ * Each node selected by the filter adds a location path to a union:
+ * - content match children are predicates of the parent step
+ * - a node without selection or containment children selects its subtree
+ * - otherwise each content match child and each selection or containment child
+ *   adds a location path
+ * @param[in]  x     Filter node
+ * @param[in]  path  Location path of parent
+ * @param[in]  nsc   Namespace context
+ * @param[out] cb    XPath union
+ * @retval     1     OK
+ * @retval     0     Not translatable
+ * @retval    -1     Error
+ * @see xml_filter   Client-side subtree filtering in netconf_filter.c
+ */
+static int
+filter_subtree2xpath1(cxobj *x,
+                      char  *path,
+                      cvec  *nsc,
+                      cbuf  *cb)
+{
+    int    retval = -1;
+    cbuf  *cbp = NULL;
+    cxobj *xc;
+    char  *str;
+    int    sel = 0;
+    int    ret;
+
+    if ((cbp = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cbp, "%s/", path);
+    if ((ret = filter_subtree_nodetest(x, nsc, cbp)) <= 0)
+        goto fail;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL){
+        if ((str = filter_subtree_content(xc)) == NULL){
+            sel++;
+            continue;
+        }
+        if (strchr(str, '\'') != NULL)
+            goto fail;
+        cprintf(cbp, "[");
+        if ((ret = filter_subtree_nodetest(xc, nsc, cbp)) <= 0)
+            goto fail;
+        cprintf(cbp, "='%s']", str);
+    }
+    if (sel == 0){
+        cprintf(cb, "%s%s", cbuf_len(cb)?" | ":"", cbuf_get(cbp));
+        goto ok;
+    }
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL){
+        if (filter_subtree_content(xc) != NULL){
+            cprintf(cb, "%s%s/", cbuf_len(cb)?" | ":"", cbuf_get(cbp));
+            if ((ret = filter_subtree_nodetest(xc, nsc, cb)) <= 0)
+                goto fail;
+        }
+        else if ((ret = filter_subtree2xpath1(xc, cbuf_get(cbp), nsc, cb)) <= 0)
+            goto fail;
+    }
+ ok:
+    retval = 1;
+ done:
+    if (cbp)
+        cbuf_free(cbp);
+    return retval;
+ fail:
+    retval = ret < 0 ? -1 : 0;
+    goto done;
+}
+
+/*! Translate a NETCONF subtree filter to an equivalent xpath selection
+ *
+ * Only the selected data is read from the datastore and state callbacks, instead
+ * of the whole tree being filtered by the client.
+ * Filters that cannot be translated, eg with attribute match or unqualified nodes,
+ * select the whole tree as before.
+ * @param[in]  xfilter  Filter: <filter type="subtree">...</filter>
+ * @param[out] xpath    XPath union, free with free()
+ * @param[out] nsc      Namespace context of xpath, free with xml_nsctx_free()
+ * @retval     1        OK, xpath and nsc set
+ * @retval     0        Not translatable
+ * @retval    -1        Error
+ * @see RFC 6241 Section 6
+ */
+static int
+filter_subtree2xpath(cxobj *xfilter,
+                     char **xpath,
+                     cvec **nsc)
+{
+    int    retval = -1;
+    cbuf  *cb = NULL;
+    cvec  *nsc1 = NULL;
+    cxobj *xc;
+    int    ret = 0;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((nsc1 = xml_nsctx_init(NULL, NULL)) == NULL)
+        goto done;
+    xc = NULL;
+    while ((xc = xml_child_each(xfilter, xc, CX_ELMNT)) != NULL){
+        /* Top-level content match nodes do not select in xml_filter */
+        if (filter_subtree_content(xc) != NULL){
+            ret = 0;
+            break;
+        }
+        if ((ret = filter_subtree2xpath1(xc, "", nsc1, cb)) < 0)
+            goto done;
+        if (ret == 0)
+            break;
+    }
+    if (ret == 0) /* Also empty filter */
+        goto fail;
+    if ((*xpath = strdup(cbuf_get(cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    *nsc = nsc1;
+    nsc1 = NULL;
+    retval = 1;
+ done:
+    if (nsc1)
+        xml_nsctx_free(nsc1);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Common get/get-config code for retrieving  configuration and state information.
  *
  * @param[in]  h       Clixon handle
@@ -958,6 +1356,9 @@ get_common(clixon_handle        h,
     cxobj            *xlpg2 = NULL;
     withdefaults_type wdef;
     char             *wdefstr;
+    char             *ftype;
+    int               subtree = 0;
+    int               json = -1;  /* JSON encoding of reply, 1 if pretty-printed */
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
     wdef = WITHDEFAULTS_EXPLICIT;
@@ -967,20 +1368,39 @@ get_common(clixon_handle        h,
         goto done;
     }
     if ((xfilter = xml_find(xe, "filter")) != NULL){
-        if ((xpath0 = xml_find_value(xfilter, "select"))==NULL)
-            xpath0 = "/";
-        if (xml_chardata_decode(&xpath01, "%s", xpath0) < 0)
-            goto done;
-        /* Create namespace context for xpath from <filter>
-         *  The set of namespace declarations are those in scope on the
-         * <filter> element.
-         */
-        else
+        ftype = xml_find_value(xfilter, "type");
+        subtree = xml_find_value(xfilter, "select") == NULL &&
+            (ftype == NULL || strcmp(ftype, "subtree") == 0);
+        if (subtree){
+            /* Translate subtree filter to xpath, else select all */
+            if ((ret = filter_subtree2xpath(xfilter, &xpath01, &nsc0)) < 0)
+                goto done;
+            if (ret == 0 &&
+                (xpath01 = strdup("/")) == NULL){
+                clixon_err(OE_UNIX, errno, "strdup");
+                goto done;
+            }
+        }
+        else{
+            if ((xpath0 = xml_find_value(xfilter, "select"))==NULL)
+                xpath0 = "/";
+            if (xml_chardata_decode(&xpath01, "%s", xpath0) < 0)
+                goto done;
+            /* Create namespace context for xpath from <filter>
+             *  The set of namespace declarations are those in scope on the
+             * <filter> element.
+             */
             if (xml_nsctx_node(xfilter, &nsc0) < 0)
                 goto done;
+        }
         if ((ret = xpath2canonical(xpath01, nsc0, yspec, &xpath, &nsc, &cbreason)) < 0)
             goto done;
-        if (ret == 0){
+        if (ret == 0 && subtree){
+            /* Eg unknown namespace: select all and leave it to client-side filtering */
+            cbuf_free(cbreason);
+            cbreason = NULL;
+        }
+        else if (ret == 0){
             if (netconf_bad_attribute(cbret, "application",
                                       "select", cbuf_get(cbreason)) < 0)
                 goto done;
@@ -1002,6 +1422,9 @@ get_common(clixon_handle        h,
     }
     if ((wdefstr = xml_find_body(xe, "with-defaults")) != NULL)
         wdef = withdefaults_str2int(wdefstr);
+    /* Clixon extensions: encoding=json and pretty, see clicon_rpc_get_json */
+    if ((attr = xml_find_value(xe, "encoding")) != NULL && strcmp(attr, "json") == 0)
+        json = (attr = xml_find_value(xe, "pretty")) != NULL && strcmp(attr, "true") == 0;
     /* How to check if list-pagination?
      * Problem is clixon expands messages on entry and pagination default values + non-presence cont
      * Therefore reverse expands by removing  defaults/nopresence and see if it is empty
@@ -1025,8 +1448,11 @@ get_common(clixon_handle        h,
     /* Read configuration */
     switch (content){
     case CONTENT_CONFIG:    /* config data only */
-        /* specific xpath. with-default gets masked in get_nacm_and_reply */
-        if ((ret = xmldb_get0(h, db, YB_MODULE, nsc, xpath?xpath:"/", 1, WITHDEFAULTS_REPORT_ALL, &xret, NULL, &xerr)) < 0) {
+        /* specific xpath. with-default gets masked in get_nacm_and_reply
+         * Zero-copy if NACM does not prune the tree, it is then only read */
+        if ((ret = xmldb_get0(h, db, YB_MODULE, nsc, xpath?xpath:"/",
+                              clicon_nacm_cache(h) != NULL,
+                              WITHDEFAULTS_REPORT_ALL, &xret, NULL, &xerr)) < 0) {
             if ((cbmsg = cbuf_new()) == NULL){
                 clixon_err(OE_UNIX, errno, "cbuf_new");
                 goto done;
@@ -1148,7 +1574,7 @@ get_common(clixon_handle        h,
         goto done;
     if (filter_xpath_again(h, yspec, xret, xvec, xlen, xpath, nsc) < 0)
         goto done;
-    if (get_nacm_and_reply(h, xret, xvec, xlen, xpath, nsc, username, depth, wdef, cbret) < 0)
+    if (get_nacm_and_reply(h, ce, xret, xvec, xlen, xpath, nsc, username, depth, wdef, json, cbret) < 0)
         goto done;
  ok:
     retval = 0;
@@ -1159,7 +1585,7 @@ get_common(clixon_handle        h,
     if (xvec)
         free(xvec);
     if (xret)
-        xml_free(xret);
+        xmldb_get0_free(h, &xret);
     if (cbreason)
         cbuf_free(cbreason);
     if (nsc0)
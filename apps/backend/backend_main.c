@@ -102,6 +102,10 @@ backend_terminate(clixon_handle h)
     clixon_debug(CLIXON_DBG_BACKEND, "");
     if ((ss = clicon_socket_get(h)) != -1)
         close(ss);
+    /* Terminate read workers */
+    backend_read_workers_exit(h);
+    /* Wait for state collect threads, they run plugin code and may use the handle */
+    clixon_plugin_statedata_cache_free();
     /* Disconnect datastore */
     xmldb_disconnect(h);
     /* Clear module state caches */
@@ -128,6 +132,8 @@ backend_terminate(clixon_handle h)
     clixon_process_delete_all(h); 
 
     xpath_optimize_exit();
+    xpath_cache_exit();
+    nacm_cache_exit();
     clixon_pagination_free(h);
     
     if (pidfile)
@@ -139,6 +145,7 @@ backend_terminate(clixon_handle h)
     clixon_err_exit();
     clixon_log_exit();
     backend_handle_exit(h); /* Also deletes streams. Cannot use h after this. */
+    xml_exit();
     return 0;
 }
 
@@ -160,12 +167,14 @@ backend_sig_term(int arg)
 /*! Wait for killed child
  *
  * primary use in case restconf daemon forked using process-control API
+ * Read workers are reaped directly
  * This may cause EINTR in eg select() in clixon_event_loop() which will be ignored
  */
 static void
 backend_sig_child(int arg)
 {
     clixon_debug(CLIXON_DBG_BACKEND, "");
+    backend_read_workers_reap();
     clicon_sig_child_set(1);
 }
 
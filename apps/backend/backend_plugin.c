@@ -52,7 +52,11 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/param.h>
+#include <sys/time.h>
 #include <netinet/in.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -253,6 +257,22 @@ clixon_plugin_daemon_all(clixon_handle h)
     return retval;
 }
 
+/*! State data collect job of a plugin, see ca_statedata_collect
+ *
+ * Owned by the main thread, or by the worker thread if abandoned at the deadline.
+ */
+struct statedata_job{
+    clixon_handle      sj_h;         /* Clixon handle */
+    plgstatecollect_t *sj_fn;        /* Collect callback */
+    plgstatefree_t    *sj_free;      /* Free callback of data, or NULL */
+    char              *sj_xpath;     /* Copy of xpath */
+    void              *sj_data;      /* Collected data */
+    int                sj_ret;       /* Return value of collect callback */
+    int                sj_done;      /* Collect callback is done */
+    int                sj_abandoned; /* Main thread gave up waiting, worker thread frees job */
+    struct statedata_plugin *sj_sp;  /* Plugin entry, busy while abandoned job runs */
+};
+
 /*! Call single backend statedata callback
  *
  * Create an xml state tree (xret) for one callback only on the form:
@@ -264,11 +284,14 @@ clixon_plugin_daemon_all(clixon_handle h)
  * typically merges the tree with other state trees).
  * In the latter error case, this function returns 0 (invalid) to the caller with no tree
  * If a fatal error occurs in this function, -1 is returned.
+ * If sj is set, the build callback (ca_statedata_build) is called with the collected data
+ * instead.
  *
  * @param[in]  cp      Plugin handle
  * @param[in]  h       clicon handle
  * @param[in]  nsc     namespace context for xpath
  * @param[in]  xpath   String with XPATH syntax. or NULL for all
+ * @param[in]  sj      Done collect job, or NULL
  * @param[out] xp      If retval=1, state tree created and returned: <config>...
  * @retval     1       OK if callback found (and called) xret is set
  * @retval     0       Statedata callback failed. no XML tree returned
@@ -279,20 +302,32 @@ clixon_plugin_statedata_one(clixon_plugin_t *cp,
                             clixon_handle    h,
                             cvec            *nsc,
                             char            *xpath,
+                            struct statedata_job *sj,
                             cxobj          **xp)
 {
-    int             retval = -1;
-    plgstatedata_t *fn;          /* Plugin statedata fn */
-    cxobj          *x = NULL;
-    void           *wh = NULL;
+    int              retval = -1;
+    plgstatedata_t  *fn;          /* Plugin statedata fn */
+    plgstatebuild_t *fnb = NULL;  /* Plugin build fn of collected data */
+    cxobj           *x = NULL;
+    void            *wh = NULL;
 
-    if ((fn = clixon_plugin_api_get(cp)->ca_statedata) != NULL){
+    fn = clixon_plugin_api_get(cp)->ca_statedata;
+    if (sj != NULL){
+        if (sj->sj_ret < 0){
+            if (clixon_err_category() < 0)
+                clixon_err(OE_PLUGIN, 0, "State collect callback in plugin %s returned -1",
+                           clixon_plugin_name_get(cp));
+            goto fail;
+        }
+        fnb = clixon_plugin_api_get(cp)->ca_statedata_build;
+    }
+    if (fnb != NULL || fn != NULL){
         if ((x = xml_new(DATASTORE_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
             goto done;
         wh = NULL;
         if (clixon_resource_check(h, &wh, clixon_plugin_name_get(cp), __FUNCTION__) < 0)
             goto done;
-        if (fn(h, nsc, xpath, x) < 0){
+        if ((fnb ? fnb(h, nsc, xpath, sj->sj_data, x) : fn(h, nsc, xpath, x)) < 0){
             if (clixon_resource_check(h, &wh, clixon_plugin_name_get(cp), __FUNCTION__) < 0)
                 goto done;
             if (clixon_err_category() < 0)
@@ -317,10 +352,566 @@ clixon_plugin_statedata_one(clixon_plugin_t *cp,
     goto done;
 }
 
+/*! Per-plugin state data scope and cache, see ca_statedata_scope and ca_statedata_ttl
+ */
+struct statedata_plugin{
+    qelem_t          sp_qelem;    /* List header */
+    clixon_plugin_t *sp_cp;       /* Plugin */
+    int              sp_resolved; /* Scope resolved to namespaces */
+    cvec           **sp_scope;    /* Resolved scope paths: cv name is namespace, value is name */
+    int              sp_scopelen; /* Length of sp_scope, 0 means any */
+    cxobj           *sp_xcache;   /* Cached bound and sorted state tree, or NULL */
+    struct timeval   sp_expire;   /* Cache expire time */
+    int              sp_call;     /* In current request: 0: skip, 1: call, 2: use cache */
+    struct statedata_job *sp_job; /* In current request: started collect job, or NULL */
+    int              sp_busy;     /* Abandoned collect job still runs, protected by mutex */
+};
+
+/* State data scope and cache of plugins, lazily created */
+static struct statedata_plugin *_statedata_plugins = NULL;
+
+/*! Find or create state data scope and cache entry of a plugin
+ *
+ * @param[in]  cp    Plugin handle
+ * @retval     sp    Entry
+ * @retval     NULL  Error
+ */
+static struct statedata_plugin *
+statedata_plugin_get(clixon_plugin_t *cp)
+{
+    struct statedata_plugin *sp;
+
+    if ((sp = _statedata_plugins) != NULL){
+        do {
+            if (sp->sp_cp == cp)
+                return sp;
+            sp = NEXTQ(struct statedata_plugin *, sp);
+        } while (sp && sp != _statedata_plugins);
+    }
+    if ((sp = malloc(sizeof(*sp))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    memset(sp, 0, sizeof(*sp));
+    sp->sp_cp = cp;
+    ADDQ(sp, _statedata_plugins);
+    return sp;
+}
+
+/*! Resolve state data scope paths of a plugin to namespaces
+ *
+ * Each path is on the form /<module>:<name>/<name>/..., where a name without module
+ * inherits the module of the previous name.
+ * Paths of modules not loaded are skipped. If no path is resolved, the plugin is called for
+ * any xpath.
+ * @param[in]  h     Clixon handle
+ * @param[in]  yspec Yang spec
+ * @param[in]  sp    State data plugin entry
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+statedata_scope_resolve(clixon_handle            h,
+                        yang_stmt               *yspec,
+                        struct statedata_plugin *sp)
+{
+    int          retval = -1;
+    const char **scope;
+    char       **vec = NULL;
+    int          nvec;
+    char        *prefix;
+    char        *id;
+    char        *ns;
+    yang_stmt   *ymod;
+    cvec        *cvv = NULL;
+    cg_var      *cv;
+    int          i;
+    int          j;
+
+    sp->sp_resolved = 1;
+    if ((scope = clixon_plugin_api_get(sp->sp_cp)->ca_statedata_scope) == NULL)
+        goto ok;
+    for (i=0; scope[i]; i++){
+        ns = NULL;
+        if ((vec = clicon_strsep((char*)scope[i], "/", &nvec)) == NULL)
+            goto done;
+        if ((cvv = cvec_new(0)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_new");
+            goto done;
+        }
+        for (j=1; j<nvec; j++){ /* First is empty, path is absolute */
+            if (nodeid_split(vec[j], &prefix, &id) < 0)
+                goto done;
+            if (prefix != NULL){
+                if ((ymod = yang_find_module_by_name(yspec, prefix)) == NULL)
+                    ns = NULL;
+                else
+                    ns = yang_find_mynamespace(ymod);
+                free(prefix);
+            }
+            if (ns == NULL){
+                free(id);
+                break;
+            }
+            if ((cv = cvec_add(cvv, CGV_STRING)) == NULL){
+                clixon_err(OE_UNIX, errno, "cvec_add");
+                free(id);
+                goto done;
+            }
+            cv_name_set(cv, ns);
+            cv_string_set(cv, id);
+            free(id);
+        }
+        if (j < nvec || cvec_len(cvv) == 0){
+            clixon_log(h, LOG_WARNING, "%s: state data scope %s of plugin %s not found",
+                       __FUNCTION__, scope[i], clixon_plugin_name_get(sp->sp_cp));
+            cvec_free(cvv);
+        }
+        else {
+            if ((sp->sp_scope = realloc(sp->sp_scope, (sp->sp_scopelen+1)*sizeof(cvec*))) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+            sp->sp_scope[sp->sp_scopelen++] = cvv;
+        }
+        cvv = NULL;
+        free(vec);
+        vec = NULL;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (cvv)
+        cvec_free(cvv);
+    if (vec)
+        free(vec);
+    return retval;
+}
+
+/*! Descend xpath parse tree nodes that only wrap a single child
+ */
+static xpath_tree *
+statedata_xpath_unwrap(xpath_tree *xs)
+{
+    while (xs && xs->xs_c1 == NULL && xs->xs_s0 == NULL &&
+           (xs->xs_type == XP_EXP ||
+            xs->xs_type == XP_AND ||
+            xs->xs_type == XP_RELEX ||
+            xs->xs_type == XP_ADD ||
+            (xs->xs_type == XP_UNION && xs->xs_int == A_NAN) ||
+            xs->xs_type == XP_PATHEXPR ||
+            xs->xs_type == XP_LOCPATH))
+        xs = xs->xs_c0;
+    return xs;
+}
+
+/*! Check if an xpath may select data in a scope path
+ *
+ * The location steps of xpath are compared with the scope path up to the shortest of
+ * the two. Predicates are ignored.
+ * @param[in]  xs     XPath parse tree
+ * @param[in]  nsc    Namespace context of xpath
+ * @param[in]  cvv    Resolved scope path
+ * @retval     1      May select: one is a prefix of the other, or xpath is not a simple path
+ * @retval     0      Cannot select
+ */
+static int
+statedata_xpath_match(xpath_tree *xs,
+                      cvec       *nsc,
+                      cvec       *cvv)
+{
+    xpath_tree *xr;
+    xpath_tree *steps[64];
+    xpath_tree *xn;
+    int         nsteps = 0;
+    int         i;
+    char       *ns;
+    cg_var     *cv;
+
+    if ((xs = statedata_xpath_unwrap(xs)) == NULL)
+        return 1;
+    if (xs->xs_type == XP_UNION) /* XO_UNION */
+        return statedata_xpath_match(xs->xs_c0, nsc, cvv) ||
+            statedata_xpath_match(xs->xs_c1, nsc, cvv);
+    if (xs->xs_type != XP_ABSPATH || xs->xs_int != A_ROOT || xs->xs_c0 == NULL)
+        return 1;
+    /* Left-recursive relative location path: last step first */
+    for (xr = xs->xs_c0; xr && xr->xs_type == XP_RELLOCPATH; xr = xr->xs_c0){
+        if (nsteps == 64)
+            return 1;
+        if (xr->xs_int == A_DESCENDANT_OR_SELF) /* a//b: only steps before // */
+            nsteps = 0;
+        else if (xr->xs_c1)
+            steps[nsteps++] = xr->xs_c1;
+        else if (xr->xs_c0 && xr->xs_c0->xs_type == XP_STEP)
+            steps[nsteps++] = xr->xs_c0;
+    }
+    /* steps are in reverse order */
+    for (i=0; i<cvec_len(cvv) && i<nsteps; i++){
+        xn = steps[nsteps-1-i];
+        if (xn->xs_type != XP_STEP || xn->xs_int != A_CHILD ||
+            (xn = xn->xs_c0) == NULL || xn->xs_type != XP_NODE ||
+            xn->xs_s1 == NULL || strcmp(xn->xs_s1, "*") == 0)
+            return 1;
+        cv = cvec_i(cvv, i);
+        if (strcmp(xn->xs_s1, cv_string_get(cv)) != 0)
+            return 0;
+        if ((ns = xml_nsctx_get(nsc, xn->xs_s0)) != NULL &&
+            strcmp(ns, cv_name_get(cv)) != 0)
+            return 0;
+    }
+    return 1;
+}
+
+/*! Check if the state data callback of a plugin should be called for an xpath
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  yspec  Yang spec
+ * @param[in]  sp     State data plugin entry
+ * @param[in]  nsc    Namespace context of xpath
+ * @param[in]  xpath  XPath, or NULL for all
+ * @retval     1      Yes
+ * @retval     0      No, xpath cannot select data in the scope of the plugin
+ * @retval    -1      Error
+ */
+static int
+statedata_scope_check(clixon_handle            h,
+                      yang_stmt               *yspec,
+                      struct statedata_plugin *sp,
+                      cvec                    *nsc,
+                      char                    *xpath)
+{
+    xpath_tree *xpt = NULL;
+    int         i;
+    int         ret = 0;
+
+    if (!sp->sp_resolved &&
+        statedata_scope_resolve(h, yspec, sp) < 0)
+        return -1;
+    if (sp->sp_scopelen == 0 || xpath == NULL)
+        return 1;
+    if (xpath_parse(xpath, &xpt) < 0)
+        return -1;
+    for (i=0; i<sp->sp_scopelen; i++)
+        if ((ret = statedata_xpath_match(xpt, nsc, sp->sp_scope[i])) == 1)
+            break;
+    xpath_tree_free(xpt);
+    return ret;
+}
+
+static void statedata_jobs_drain(void);
+
+/*! Free state data scope and cache of all plugins
+ *
+ * Waits for abandoned collect jobs, must be called before plugins are unloaded
+ */
+int
+clixon_plugin_statedata_cache_free(void)
+{
+    struct statedata_plugin *sp;
+    int                      i;
+
+    statedata_jobs_drain();
+    while ((sp = _statedata_plugins) != NULL){
+        DELQ(sp, _statedata_plugins, struct statedata_plugin *);
+        for (i=0; i<sp->sp_scopelen; i++)
+            cvec_free(sp->sp_scope[i]);
+        if (sp->sp_scope)
+            free(sp->sp_scope);
+        if (sp->sp_xcache)
+            xml_free(sp->sp_xcache);
+        free(sp);
+    }
+    return 0;
+}
+
+#ifdef HAVE_LIBPTHREAD
+/* Protects done and abandoned flags of state data collect jobs, and busy flag of plugins */
+static pthread_mutex_t _statedata_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* Signalled when a state data collect job is done */
+static pthread_cond_t  _statedata_cond = PTHREAD_COND_INITIALIZER;
+static pthread_once_t  _statedata_once = PTHREAD_ONCE_INIT;
+#endif
+
+/*! Free state data collect job and its collected data
+ *
+ * @note May be called on a worker thread, only call plugin and libc functions
+ */
+static void
+statedata_job_free(struct statedata_job *sj)
+{
+    if (sj->sj_data){
+        if (sj->sj_free)
+            sj->sj_free(sj->sj_data);
+        else
+            free(sj->sj_data);
+    }
+    if (sj->sj_xpath)
+        free(sj->sj_xpath);
+    free(sj);
+}
+
+#ifdef HAVE_LIBPTHREAD
+/*! Lock job mutex over fork, eg of a read worker, so that it is not inherited locked
+ */
+static void
+statedata_atfork_prepare(void)
+{
+    pthread_mutex_lock(&_statedata_mutex);
+}
+
+static void
+statedata_atfork_release(void)
+{
+    pthread_mutex_unlock(&_statedata_mutex);
+}
+
+static void
+statedata_job_once(void)
+{
+    pthread_atfork(statedata_atfork_prepare,
+                   statedata_atfork_release,
+                   statedata_atfork_release);
+}
+
+/*! Worker thread of a state data collect job
+ *
+ * Call the collect callback, then mark the job as done, or free it if abandoned.
+ * The plugin of an abandoned job is busy until its data is freed, since the free callback
+ * is also plugin code.
+ */
+static void *
+statedata_job_thread(void *arg)
+{
+    struct statedata_job    *sj = (struct statedata_job *)arg;
+    struct statedata_plugin *sp;
+    void                    *data = NULL;
+    int                      ret;
+    int                      abandoned;
+
+    /* The clixon error state is not thread-safe */
+    clixon_err_discard_set(1);
+    ret = sj->sj_fn(sj->sj_h, sj->sj_xpath, &data);
+    pthread_mutex_lock(&_statedata_mutex);
+    sj->sj_data = data;
+    sj->sj_ret = ret;
+    sj->sj_done = 1;
+    abandoned = sj->sj_abandoned;
+    pthread_cond_broadcast(&_statedata_cond);
+    pthread_mutex_unlock(&_statedata_mutex);
+    if (abandoned){
+        sp = sj->sj_sp;
+        statedata_job_free(sj);
+        pthread_mutex_lock(&_statedata_mutex);
+        sp->sp_busy = 0;
+        pthread_cond_broadcast(&_statedata_cond);
+        pthread_mutex_unlock(&_statedata_mutex);
+    }
+    return NULL;
+}
+
+/*! Start detached worker thread of a state data collect job
+ *
+ * Signals are blocked in the thread and handled by the main thread
+ * @param[in]  h     Clixon handle
+ * @param[in]  cp    Plugin handle
+ * @param[in]  sj    Job
+ * @retval     1     Started
+ * @retval     0     Not started
+ */
+static int
+statedata_job_spawn(clixon_handle         h,
+                    clixon_plugin_t      *cp,
+                    struct statedata_job *sj)
+{
+    pthread_t tid;
+    sigset_t  all;
+    sigset_t  old;
+    int       ret;
+
+    pthread_once(&_statedata_once, statedata_job_once);
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    ret = pthread_create(&tid, NULL, statedata_job_thread, sj);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (ret != 0){
+        clixon_log(h, LOG_WARNING, "%s: pthread_create: %s, state of plugin %s collected directly",
+                   __FUNCTION__, strerror(ret), clixon_plugin_name_get(cp));
+        return 0;
+    }
+    pthread_detach(tid);
+    return 1;
+}
+#endif /* HAVE_LIBPTHREAD */
+
+/*! Start state data collect job of a plugin
+ *
+ * The collect callback is called on a worker thread if the backend is built with pthreads,
+ * otherwise it is called directly.
+ * @param[in]  h     Clixon handle
+ * @param[in]  cp    Plugin handle
+ * @param[in]  sp    State data plugin entry, not busy
+ * @param[in]  xpath XPath, or NULL for all
+ * @param[out] sjp   Job, wait for it with statedata_job_wait
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see statedata_plugin_busy
+ */
+static int
+statedata_job_start(clixon_handle            h,
+                    clixon_plugin_t         *cp,
+                    struct statedata_plugin *sp,
+                    char                    *xpath,
+                    struct statedata_job   **sjp)
+{
+    struct statedata_job *sj;
+    clixon_plugin_api    *api;
+    int                   started = 0;
+
+    api = clixon_plugin_api_get(cp);
+    if ((sj = malloc(sizeof(*sj))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return -1;
+    }
+    memset(sj, 0, sizeof(*sj));
+    sj->sj_h = h;
+    sj->sj_fn = api->ca_statedata_collect;
+    sj->sj_free = api->ca_statedata_free;
+    sj->sj_sp = sp;
+    if ((sj->sj_xpath = strdup(xpath?xpath:"/")) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        free(sj);
+        return -1;
+    }
+#ifdef HAVE_LIBPTHREAD
+    started = statedata_job_spawn(h, cp, sj);
+#endif
+    if (!started){
+        sj->sj_ret = sj->sj_fn(h, sj->sj_xpath, &sj->sj_data);
+        sj->sj_done = 1;
+    }
+    *sjp = sj;
+    return 0;
+}
+
+/*! Wait for state data collect job until it is done or the deadline passes
+ *
+ * @param[in]  sj        Job
+ * @param[in]  deadline  Absolute deadline, or NULL to wait until done
+ * @retval     1         Done, free job with statedata_job_free
+ * @retval     0         Deadline passed, job is abandoned and freed by its worker thread
+ */
+static int
+statedata_job_wait(struct statedata_job *sj,
+                   struct timeval       *deadline)
+{
+    int             done = 1;
+#ifdef HAVE_LIBPTHREAD
+    struct timespec ts = {0,};
+
+    if (deadline){
+        ts.tv_sec = deadline->tv_sec;
+        ts.tv_nsec = deadline->tv_usec*1000;
+    }
+    pthread_mutex_lock(&_statedata_mutex);
+    while (!sj->sj_done){
+        if (deadline == NULL)
+            pthread_cond_wait(&_statedata_cond, &_statedata_mutex);
+        else if (pthread_cond_timedwait(&_statedata_cond, &_statedata_mutex, &ts) == ETIMEDOUT)
+            break;
+    }
+    if ((done = sj->sj_done) == 0){
+        sj->sj_abandoned = 1;
+        sj->sj_sp->sp_busy = 1;
+    }
+    pthread_mutex_unlock(&_statedata_mutex);
+#endif
+    return done;
+}
+
+/*! Check if an abandoned collect job of a plugin still runs
+ *
+ * A new job is not started then, so that collect callbacks of a plugin are never concurrent
+ * @param[in]  sp    State data plugin entry
+ * @retval     1     Busy
+ * @retval     0     Not busy
+ */
+static int
+statedata_plugin_busy(struct statedata_plugin *sp)
+{
+    int busy = 0;
+
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_lock(&_statedata_mutex);
+    busy = sp->sp_busy;
+    pthread_mutex_unlock(&_statedata_mutex);
+#endif
+    return busy;
+}
+
+/*! Wait until abandoned collect jobs of all plugins are done
+ *
+ * Worker threads run plugin code, which must not be unloaded before they are done
+ */
+static void
+statedata_jobs_drain(void)
+{
+#ifdef HAVE_LIBPTHREAD
+    struct statedata_plugin *sp;
+    int                      busy;
+    int                      logged = 0;
+
+    pthread_mutex_lock(&_statedata_mutex);
+    do {
+        busy = 0;
+        if ((sp = _statedata_plugins) != NULL){
+            do {
+                if (sp->sp_busy){
+                    busy++;
+                    if (!logged++)
+                        clixon_log(NULL, LOG_NOTICE, "%s: Waiting for state of plugin %s",
+                                   __FUNCTION__, clixon_plugin_name_get(sp->sp_cp));
+                }
+                sp = NEXTQ(struct statedata_plugin *, sp);
+            } while (sp && sp != _statedata_plugins);
+        }
+        if (busy)
+            pthread_cond_wait(&_statedata_cond, &_statedata_mutex);
+    } while (busy);
+    pthread_mutex_unlock(&_statedata_mutex);
+#endif
+}
+
+/*! Abandon state data collect jobs not waited for, eg on error
+ */
+static void
+statedata_jobs_abandon(void)
+{
+    struct statedata_plugin *sp;
+    struct timeval           now = {0,};
+
+    if ((sp = _statedata_plugins) != NULL){
+        do {
+            if (sp->sp_job != NULL){
+                if (statedata_job_wait(sp->sp_job, &now) == 1)
+                    statedata_job_free(sp->sp_job);
+                sp->sp_job = NULL;
+            }
+            sp = NEXTQ(struct statedata_plugin *, sp);
+        } while (sp && sp != _statedata_plugins);
+    }
+}
+
 /*! Go through all backend statedata callbacks and collect state data
  *
  * This is internal system call, plugin is invoked (does not call) this function
  * Backend plugins can register 
+ * A plugin with ca_statedata_scope set is not called if xpath cannot select data in its scope.
+ * A plugin with ca_statedata_ttl set is called with xpath "/" and its bound and sorted state
+ * tree is reused until the TTL expires.
+ * The collect callbacks (ca_statedata_collect) of all plugins are first started in parallel.
+ * Then the state of each plugin is built and merged in plugin order, waiting for its collect
+ * callback at most until CLICON_BACKEND_STATE_DEADLINE after the start.
  * @param[in]     h       clicon handle
  * @param[in]     yspec   Yang spec
  * @param[in]     nsc     Namespace context
@@ -344,10 +935,87 @@ clixon_plugin_statedata_all(clixon_handle   h,
     clixon_plugin_t *cp = NULL;
     cbuf            *cberr = NULL;
     cxobj           *xerr = NULL;
+    struct statedata_plugin *sp;
+    struct statedata_job *sj = NULL;
+    clixon_plugin_api *api;
+    uint32_t         ttl;
+    uint32_t         ms;
+    struct timeval   now;
+    struct timeval   t;
+    struct timeval   deadline = {0,};
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
+    gettimeofday(&now, NULL);
+    /* Decide which plugins to call, and start collect jobs so that they run in parallel */
+    while ((cp = clixon_plugin_each(h, cp)) != NULL) {
+        api = clixon_plugin_api_get(cp);
+        if (api->ca_statedata == NULL &&
+            (api->ca_statedata_collect == NULL || api->ca_statedata_build == NULL))
+            continue;
+        if ((sp = statedata_plugin_get(cp)) == NULL)
+            goto done;
+        /* Skip plugin if xpath cannot select data in its scope */
+        if ((ret = statedata_scope_check(h, yspec, sp, nsc, xpath)) < 0)
+            goto done;
+        ttl = api->ca_statedata_ttl;
+        if (ret == 0)
+            sp->sp_call = 0;
+        else if (ttl && sp->sp_xcache && timercmp(&now, &sp->sp_expire, <))
+            sp->sp_call = 2;
+        else
+            sp->sp_call = 1;
+        if (sp->sp_call == 1 && api->ca_statedata_collect && api->ca_statedata_build){
+            if (statedata_plugin_busy(sp)){
+                clixon_log(h, LOG_WARNING, "%s: State of plugin %s still collected by an earlier request, left out",
+                           __FUNCTION__, clixon_plugin_name_get(cp));
+                sp->sp_call = 0;
+            }
+            else if (statedata_job_start(h, cp, sp, ttl?"/":xpath, &sp->sp_job) < 0)
+                goto done;
+        }
+    }
+    if ((ms = clicon_option_int(h, "CLICON_BACKEND_STATE_DEADLINE")) > 0){
+        t.tv_sec = ms/1000;
+        t.tv_usec = (ms%1000)*1000;
+        timeradd(&now, &t, &deadline);
+    }
+    cp = NULL;
     while ((cp = clixon_plugin_each(h, cp)) != NULL) {
-        if ((ret = clixon_plugin_statedata_one(cp, h, nsc, xpath, &x)) < 0)
+        api = clixon_plugin_api_get(cp);
+        if (api->ca_statedata == NULL &&
+            (api->ca_statedata_collect == NULL || api->ca_statedata_build == NULL))
+            continue;
+        if ((sp = statedata_plugin_get(cp)) == NULL)
+            goto done;
+        if (sp->sp_call == 0)
+            continue;
+        ttl = api->ca_statedata_ttl;
+        if (sp->sp_call == 2){
+            /* Reuse cached, already bound and sorted state tree */
+            if ((x = xml_dup(sp->sp_xcache)) == NULL)
+                goto done;
+            goto merge;
+        }
+        if ((sj = sp->sp_job) != NULL){
+            sp->sp_job = NULL;
+            if (statedata_job_wait(sj, ms?&deadline:NULL) == 0){
+                sj = NULL;
+                clixon_log(h, LOG_WARNING, "%s: State of plugin %s not collected within %u ms, left out",
+                           __FUNCTION__, clixon_plugin_name_get(cp), ms);
+                continue;
+            }
+        }
+        /* Cached state is of the whole tree */
+        ret = clixon_plugin_statedata_one(cp, h,
+                                          ttl?NULL:nsc,
+                                          ttl?"/":xpath,
+                                          sj,
+                                          &x);
+        if (sj){
+            statedata_job_free(sj);
+            sj = NULL;
+        }
+        if (ret < 0)
             goto done;
         if (ret == 0){
             if ((cberr = cbuf_new()) == NULL){
@@ -391,6 +1059,16 @@ clixon_plugin_statedata_all(clixon_handle   h,
         /* XXX: only for state data and according to with-defaults setting */
         if (xml_default_nopresence(x, 2, 0) < 0)
             goto done;
+        if (ttl){
+            if (sp->sp_xcache)
+                xml_free(sp->sp_xcache);
+            if ((sp->sp_xcache = xml_dup(x)) == NULL)
+                goto done;
+            t.tv_sec = ttl/1000;
+            t.tv_usec = (ttl%1000)*1000;
+            timeradd(&now, &t, &sp->sp_expire);
+        }
+    merge:
         if (xpath_first(x, nsc, "%s", xpath) != NULL){
             if ((ret = netconf_trymerge(x, yspec, xret)) < 0)
                 goto done;
@@ -404,6 +1082,7 @@ clixon_plugin_statedata_all(clixon_handle   h,
     } /* while plugin */
     retval = 1;
  done:
+    statedata_jobs_abandon();
     if (xerr)
         xml_free(xerr);
     if (cberr)
@@ -571,6 +1250,35 @@ transaction_free(transaction_data_t *td)
     return 0;
 }
 
+/*! Check that a plugin callback did not modify a read-only transaction tree
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  cp      Plugin handle
+ * @param[in]  fnname  Name of callback
+ * @param[in]  name    Name of tree for logging
+ * @param[in]  x0      Copy of tree made before the callback
+ * @param[in]  x1      Tree after the callback
+ * @param[in]  option  CLICON_PLUGIN_CALLBACK_CHECK, abort if 2 or above
+ * @see clixon_resource_check
+ */
+static void
+plugin_transaction_tree_check(clixon_handle    h,
+                              clixon_plugin_t *cp,
+                              const char      *fnname,
+                              const char      *name,
+                              cxobj           *x0,
+                              cxobj           *x1,
+                              int              option)
+{
+    if (strcmp(xml_name(x0), xml_name(x1)) == 0 &&
+        xml_tree_equal(x0, x1) == 0)
+        return;
+    clixon_log(h, LOG_WARNING, "%s: Plugin '%s' modified the read-only %s tree of the transaction",
+               fnname, clixon_plugin_name_get(cp), name);
+    if (option > 1)
+        abort();
+}
+
 static int
 plugin_transaction_call_one(clixon_handle       h,
 			    clixon_plugin_t    *cp,
@@ -578,16 +1286,31 @@ plugin_transaction_call_one(clixon_handle       h,
 			    const char         *fnname,
 			    transaction_data_t *td)
 {
-    int  retval = -1;
-    int  rv;
-    void *wh = NULL;
-
+    int    retval = -1;
+    int    rv;
+    void  *wh = NULL;
+    int    option = 0;
+    cxobj *xsrc = NULL;
+    cxobj *xtarget = NULL;
+
+    /* Source and target may be datastore caches, check that they are not modified */
+    if (td->td_readonly &&
+        (option = clicon_option_int(h, "CLICON_PLUGIN_CALLBACK_CHECK")) > 0){
+        if (td->td_src && (xsrc = xml_dup(td->td_src)) == NULL)
+            goto done;
+        if (td->td_target && (xtarget = xml_dup(td->td_target)) == NULL)
+            goto done;
+    }
     wh = NULL;
     if (clixon_resource_check(h, &wh, clixon_plugin_name_get(cp), fnname) < 0)
         goto done;
     rv = fn(h, (transaction_data)td);
     if (clixon_resource_check(h, &wh, clixon_plugin_name_get(cp), fnname) < 0)
         goto done;
+    if (xsrc)
+        plugin_transaction_tree_check(h, cp, fnname, "source", xsrc, td->td_src, option);
+    if (xtarget)
+        plugin_transaction_tree_check(h, cp, fnname, "target", xtarget, td->td_target, option);
     if (rv < 0) {
         if (!clixon_err_category()) /* sanity: log if clixon_err() is not called ! */
             clixon_log(h, LOG_NOTICE, "%s: Plugin '%s' callback does not make clixon_err call on error",
@@ -596,6 +1319,10 @@ plugin_transaction_call_one(clixon_handle       h,
     }
     retval = 0;
  done:
+    if (xsrc)
+        xml_free(xsrc);
+    if (xtarget)
+        xml_free(xtarget);
     return retval;
 }
 
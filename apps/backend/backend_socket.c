@@ -293,8 +293,7 @@ backend_accept_client(int   fd,
     /*
      * Register callback for actual data socket
      */
-    if (clixon_event_reg_fd_prio(s, from_client, (void*)ce, "local netconf client socket",
-                                 clicon_option_bool(h, "CLICON_SOCK_PRIO")) < 0)
+    if (backend_client_read_update(h, ce) < 0)
         goto done;
     s = -1;
     retval = 0;
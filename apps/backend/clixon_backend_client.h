@@ -73,6 +73,12 @@ struct client_entry{
     uint32_t              ce_in_bad_rpcs;    /* Not correct <rpc> messages */
     uint32_t              ce_out_rpc_errors; /*  <rpc-error> messages*/
     uint32_t              ce_out_notifications; /* Outgoing notifications */
+    uint32_t              ce_out_dropped; /* Notifications dropped since output queue was full */
+    cbuf                 *ce_outq;    /* Output queue, data not yet written to client socket */
+    size_t                ce_outq_start; /* Start of unwritten data in ce_outq */
+    int                   ce_reading; /* Registered for reading from client socket */
+    int                   ce_worker;  /* Reply from read worker is pending, see read_worker_start */
+    int                   ce_chunked; /* Part of reply is sent, see backend_client_reply_chunk */
 };
 typedef struct client_entry client_entry;
 
@@ -202,6 +202,8 @@ backend_client_delete(clixon_handle        h,
                 free(ce->ce_transport);
             if (ce->ce_source_host)
                 free(ce->ce_source_host);
+            if (ce->ce_outq)
+                cbuf_free(ce->ce_outq);
             ce->ce_next = NULL;
             free(ce);
             break;
@@ -185,6 +185,7 @@ cli_terminate(clixon_handle h)
     clicon_data_cvec_del(h, "cli-edit-cvv");;
     clicon_data_cvec_del(h, "cli-edit-filter");;
     xpath_optimize_exit();
+    xpath_cache_exit();
     /* Delete all plugins, and RPC callbacks */
     clixon_plugin_module_exit(h);
     /* Delete CLI syntax et al */
@@ -192,6 +193,7 @@ cli_terminate(clixon_handle h)
 
     cli_history_save(h);
     cli_handle_exit(h);
+    xml_exit();
     clixon_err_exit();
     clixon_log_exit();
     return 0;
@@ -180,11 +180,12 @@ netconf_get_config(clixon_handle h,
     if ((xfilter = xpath_first(xn, nsc, "%s%sfilter", prefix ? prefix : "", prefix ? ":" : "")) != NULL)
         ftype = xml_find_value(xfilter, "type");
     if (xfilter == NULL || ftype == NULL || strcmp(ftype, "subtree") == 0) {
-        /* Get whole config first, then filter. This is suboptimal
+        /* The backend translates the subtree filter to xpath and returns only the
+         * selected config, or the whole tree if not translatable
          */
         if (clicon_rpc_netconf_xml(h, xml_parent(xn), xret, NULL) < 0)
             goto done;
-        /* Now filter on whole tree */
+        /* Now filter exactly as subtree, eg list keys not in the filter */
         if (netconf_get_config_subtree(h, xfilter, xret) < 0)
             goto done;
     } else if (strcmp(ftype, "xpath") == 0) {
@@ -393,11 +394,12 @@ netconf_get(clixon_handle h,
     if ((xfilter = xpath_first(xn, nsc, "%s%sfilter", prefix ? prefix : "", prefix ? ":" : "")) != NULL)
         ftype = xml_find_value(xfilter, "type");
     if (xfilter == NULL || ftype == NULL || strcmp(ftype, "subtree") == 0) {
-        /* Get whole config + state first, then filter. This is suboptimal
+        /* The backend translates the subtree filter to xpath and returns only the
+         * selected config + state, or the whole tree if not translatable
          */
         if (clicon_rpc_netconf_xml(h, xml_parent(xn), xret, NULL) < 0)
             goto done;
-        /* Now filter on whole tree */
+        /* Now filter exactly as subtree, eg list keys not in the filter */
         if (netconf_get_config_subtree(h, xfilter, xret) < 0)
             goto done;
     } else if (strcmp(ftype, "xpath") == 0) {
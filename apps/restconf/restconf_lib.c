@@ -442,9 +442,11 @@ restconf_terminate(clixon_handle h)
     if ((x = clicon_conf_xml(h)) != NULL)
         xml_free(x);
     xpath_optimize_exit();
+    xpath_cache_exit();
     clixon_err_exit();
     clixon_debug(CLIXON_DBG_RESTCONF, "pid:%u done", getpid());
     restconf_handle_exit(h);
+    xml_exit();
     clixon_log_exit(); /* Must be after last clixon_debug */
     return 0;
 }
@@ -127,6 +127,8 @@ api_data_get2(clixon_handle  h,
     yang_stmt *y = NULL;
     char      *defaults = NULL;
     cvec      *nscd = NULL;
+    int        json = 0;
+    int        count = 0;
 
     clixon_debug(CLIXON_DBG_RESTCONF, "");
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
@@ -203,8 +205,18 @@ api_data_get2(clixon_handle  h,
     }
 
     clixon_debug(CLIXON_DBG_RESTCONF, "path:%s", xpath);
-    ret = clicon_rpc_get(h, xpath, nsc, content, depth, defaults, &xret);
-
+    if (media_out == YANG_DATA_JSON){
+        /* Let the backend encode JSON, falls back to XML eg on error */
+        if ((cbx = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        if ((ret = clicon_rpc_get_json(h, xpath, nsc, content, depth, defaults, pretty,
+                                       cbx, &count, &xret)) == 1)
+            json = 1;
+    }
+    else
+        ret = clicon_rpc_get(h, xpath, nsc, content, depth, defaults, &xret);
     if (ret < 0){
         if (netconf_operation_failed_xml(&xerr, "protocol", clixon_err_reason()) < 0)
             goto done;
@@ -212,6 +224,12 @@ api_data_get2(clixon_handle  h,
             goto done;
         goto ok;
     }
+    if (json){
+        /* JSON of the object encoded by the backend */
+        if (count == 0)
+            goto notfound;
+        goto reply;
+    }
     /* We get return via netconf which is complete tree from root 
      * We need to cut that tree to only the object.
      */
@@ -226,7 +244,7 @@ api_data_get2(clixon_handle  h,
         goto ok;
     }
     /* Normal return, no error */
-    if ((cbx = cbuf_new()) == NULL){
+    if (cbx == NULL && (cbx = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
     }
@@ -253,18 +271,8 @@ api_data_get2(clixon_handle  h,
             goto ok;
         }
         /* Check if not exists */
-        if (xlen == 0){
-            /* 4.3: If a retrieval request for a data resource represents an 
-               instance that does not exist, then an error response containing 
-               a "404 Not Found" status-line MUST be returned by the server.  
-               The error-tag value "invalid-value" is used in this case. */
-            if (netconf_invalid_value_xml(&xerr, "application", "Instance does not exist") < 0)
-                goto done;
-            /* override invalid-value default 400 with 404 */
-            if (api_return_err0(h, req, xerr, pretty, media_out, 404) < 0)
-                goto done;
-            goto ok;
-        }
+        if (xlen == 0)
+            goto notfound;
         switch (media_out){
         case YANG_DATA_XML:
             for (i=0; i<xlen; i++){
@@ -292,6 +300,7 @@ api_data_get2(clixon_handle  h,
             break;
         }
     }
+ reply:
     clixon_debug(CLIXON_DBG_RESTCONF, "cbuf:%s", cbuf_get(cbx));
     if (restconf_reply_header(req, "Content-Type", "%s", restconf_media_int2str(media_out)) < 0)
         goto done;
@@ -321,6 +330,17 @@ api_data_get2(clixon_handle  h,
     if (xvec)
         free(xvec);
     return retval;
+ notfound:
+    /* 4.3: If a retrieval request for a data resource represents an 
+       instance that does not exist, then an error response containing 
+       a "404 Not Found" status-line MUST be returned by the server.  
+       The error-tag value "invalid-value" is used in this case. */
+    if (netconf_invalid_value_xml(&xerr, "application", "Instance does not exist") < 0)
+        goto done;
+    /* override invalid-value default 400 with 404 */
+    if (api_return_err0(h, req, xerr, pretty, media_out, 404) < 0)
+        goto done;
+    goto ok;
 }
 
 /*! GET Collection 
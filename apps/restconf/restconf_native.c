@@ -45,6 +45,7 @@
 #include <pwd.h>
 #include <ctype.h>
 #include <signal.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
@@ -225,6 +226,8 @@ restconf_conn_free(restconf_conn *rc)
     if (rc->rc_ngsession)
         nghttp2_session_del(rc->rc_ngsession);
 #endif
+    if (rc->rc_outq)
+        cbuf_free(rc->rc_outq);
     /* Free all streams */
     while ((sd = rc->rc_streams) != NULL) {
         DELQ(sd, rc->rc_streams,  restconf_stream_data *);
@@ -380,15 +383,394 @@ restconf_connection_sanity(clixon_handle         h,
     return retval;
 }
 
-/* Write buf to socket
+/*! Write buf to socket without blocking
+ *
+ * @param[in]  rc       Connection struct
+ * @param[in]  buf      Buffer to write
+ * @param[in]  buflen   Length of buffer
+ * @param[out] np       Bytes written, 0 if socket write would block
+ * @retval     1        OK
+ * @retval     0        OK, but socket write returned error, caller should close rc
+ * @retval    -1        Error
+ * @note SSL is in partial and moving write buffer mode, a write that would block is made
+ *       again later with the same data from the output queue
+ * @note If SSL needs to read to complete the write, rc_ssl_want_read is set and the write
+ *       is made again when the socket is readable, see native_read_update
+ */
+static int
+native_write1(restconf_conn *rc,
+              char          *buf,
+              size_t         buflen,
+              ssize_t       *np)
+{
+    int     retval = -1;
+    ssize_t len;
+    int     er;
+    SSL    *ssl;
+
+    *np = 0;
+    if ((ssl = rc->rc_ssl) != NULL){
+        if ((len = SSL_write(ssl, buf, buflen)) <= 0){
+            er = errno;
+            switch (SSL_get_error(ssl, len)){
+            case SSL_ERROR_WANT_WRITE:           /* 3 */
+                clixon_debug(CLIXON_DBG_RESTCONF, "write SSL_ERROR_WANT_WRITE");
+                goto ok;
+                break;
+            case SSL_ERROR_WANT_READ:            /* 2 */
+                /* Eg renegotiation, waiting for the socket to be writable would busy-loop */
+                clixon_debug(CLIXON_DBG_RESTCONF, "write SSL_ERROR_WANT_READ");
+                rc->rc_ssl_want_read = 1;
+                goto ok;
+                break;
+            case SSL_ERROR_ZERO_RETURN:          /* 6 */
+                goto closed;
+                break;
+            case SSL_ERROR_SYSCALL:              /* 5 */
+                if (er == ECONNRESET || /* Connection reset by peer */
+                    er == EPIPE) {      /* Reading end of socket is closed */
+                    goto closed; /* Close socket and ssl */
+                }
+                else if (er == EAGAIN || er == EINTR){
+                    /* Same as want_write above on some platforms or ssl lib versions */
+                    clixon_debug(CLIXON_DBG_RESTCONF, "write EAGAIN");
+                    goto ok;
+                }
+                else{
+                    clixon_err(OE_RESTCONF, er, "SSL_write %d", er);
+                    goto done;
+                }
+                break;
+            default:
+                clixon_err(OE_SSL, 0, "SSL_write");
+                goto done;
+                break;
+            }
+        }
+    }
+    else if ((len = write(rc->rc_s, buf, buflen)) < 0){
+        switch (errno){
+        case EAGAIN:     /* Operation would block */
+        case EINTR:
+            clixon_debug(CLIXON_DBG_RESTCONF, "write EAGAIN");
+            goto ok;
+            break;
+        case ECONNRESET: /* Connection reset by peer */
+        case EPIPE:   /* Broken pipe */
+            goto closed; /* Close socket and ssl */
+            break;
+        default:
+            clixon_err(OE_UNIX, errno, "write %d", errno);
+            goto done;
+            break;
+        }
+    }
+    *np = len;
+ ok:
+    retval = 1;
+ done:
+    return retval;
+ closed:
+    retval = 0;
+    goto done;
+}
+
+/*! Length of data in output queue of connection not yet written
+ *
+ * @param[in]  rc   Connection struct
+ * @retval     len  Bytes not yet written
+ */
+static size_t
+native_outq_len(restconf_conn *rc)
+{
+    return rc->rc_outq ? cbuf_len(rc->rc_outq) - rc->rc_outq_start : 0;
+}
+
+/*! Append data to output queue of connection, compact queue if more than half is written
+ *
+ * @param[in]  rc       Connection struct
+ * @param[in]  buf      Buffer to append
+ * @param[in]  buflen   Length of buffer
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+native_outq_append(restconf_conn *rc,
+                   char          *buf,
+                   size_t         buflen)
+{
+    int   retval = -1;
+    cbuf *cbq;
+
+    if (rc->rc_outq == NULL &&
+        (rc->rc_outq = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (rc->rc_outq_start > cbuf_len(rc->rc_outq)/2){
+        if ((cbq = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        if (cbuf_append_buf(cbq, cbuf_get(rc->rc_outq) + rc->rc_outq_start, native_outq_len(rc)) < 0){
+            clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+            cbuf_free(cbq);
+            goto done;
+        }
+        cbuf_free(rc->rc_outq);
+        rc->rc_outq = cbq;
+        rc->rc_outq_start = 0;
+    }
+    if (cbuf_append_buf(rc->rc_outq, buf, buflen) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Do not read requests from connection while HTTP/1 reply is queued or connection is closing
+ *
+ * Read also if SSL_write waits for the socket to be readable, and do not read if SSL_read
+ * waits for the socket to be writable.
+ * @param[in]  rc   Connection struct
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+native_read_update(restconf_conn *rc)
+{
+    int read;
+
+    read = rc->rc_ssl_want_read ||
+        (!rc->rc_ssl_want_write &&
+         !rc->rc_outq_close && (rc->rc_proto == HTTP_2 || native_outq_len(rc) == 0));
+    if (read && !rc->rc_reading){
+        if (clixon_event_reg_fd(rc->rc_s, restconf_connection, (void*)rc, "restconf client socket") < 0)
+            return -1;
+        rc->rc_reading = 1;
+    }
+    else if (!read && rc->rc_reading){
+        clixon_event_unreg_fd(rc->rc_s, restconf_connection);
+        rc->rc_reading = 0;
+    }
+    return 0;
+}
+
+static int native_output_cb(int s, void *arg);
+static int native_outq_write(restconf_conn *rc);
+
+/*! Register connection for writing while output queue is not empty
+ *
+ * Not while SSL_write waits for the socket to be readable, but if SSL_read waits for the
+ * socket to be writable.
+ * @param[in]  rc   Connection struct
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+native_write_update(restconf_conn *rc)
+{
+    int write;
+
+    write = rc->rc_ssl_want_write ||
+        (!rc->rc_ssl_want_read && native_outq_len(rc) > 0);
+    if (write && !rc->rc_writing){
+        if (clixon_event_reg_fd_write(rc->rc_s, native_output_cb, (void*)rc, "restconf client output") < 0)
+            return -1;
+        rc->rc_writing = 1;
+    }
+    else if (!write && rc->rc_writing){
+        clixon_event_unreg_fd(rc->rc_s, native_output_cb);
+        rc->rc_writing = 0;
+    }
+    return native_read_update(rc);
+}
+
+/*! Discard output queue of connection, eg after write error
+ *
+ * @param[in]  rc   Connection struct
+ */
+static void
+native_outq_reset(restconf_conn *rc)
+{
+    if (rc->rc_outq)
+        cbuf_reset(rc->rc_outq);
+    rc->rc_outq_start = 0;
+    rc->rc_ssl_want_read = 0;
+    if (rc->rc_writing){
+        clixon_event_unreg_fd(rc->rc_s, native_output_cb);
+        rc->rc_writing = 0;
+    }
+}
+
+/*! Write from output queue of connection
+ *
+ * Close connection on write error, or if close is requested and queue is written
+ * @param[in]  rc   Connection struct
+ * @retval     1    OK
+ * @retval     0    OK, connection is closed
+ * @retval    -1    Error
+ */
+static int
+native_output(restconf_conn *rc)
+{
+    int retval = -1;
+    int ret;
+
+    if ((ret = native_outq_write(rc)) < 0)
+        goto done;
+    if (ret == 0 ||
+        (rc->rc_outq_close && native_outq_len(rc) == 0)){
+        if (restconf_close_ssl_socket(rc, __FUNCTION__, 0) < 0)
+            goto done;
+        retval = 0;
+        goto done;
+    }
+    retval = 1;
+ done:
+    return retval;
+}
+
+/*! Connection socket is writable, write from output queue
+ *
+ * If SSL_read waits for the socket to be writable, read from connection instead
+ * @param[in]  s    Connection socket
+ * @param[in]  arg  Connection struct
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see native_buf_write  where this callback is registered
+ * @see read_ssl  where it is registered for SSL_read
+ */
+static int
+native_output_cb(int   s,
+                 void *arg)
+{
+    int            retval = -1;
+    restconf_conn *rc = (restconf_conn *)arg;
+
+    clixon_debug(CLIXON_DBG_RESTCONF, "%d", s);
+    if (rc->rc_ssl_want_write){
+        rc->rc_ssl_want_write = 0;
+        if (native_write_update(rc) < 0)
+            goto done;
+        /* Queued output is written when socket is writable again, rc may be closed here */
+        return restconf_connection(s, rc);
+    }
+    if (native_output(rc) < 0)
+        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Write as much as possible from output queue of connection without blocking
+ *
+ * The rest is written when the socket is writable.
+ * For HTTP/2, frames kept by nghttp2 when the queue was full are sent when it is written.
+ * @param[in]  rc   Connection struct
+ * @retval     1    OK
+ * @retval     0    OK, but socket write returned error, caller should close rc
+ * @retval    -1    Error
+ */
+static int
+native_outq_write(restconf_conn *rc)
+{
+    int           retval = -1;
+    int           ret;
+    ssize_t       n;
+#ifdef HAVE_LIBNGHTTP2
+    nghttp2_error ngerr;
+#endif
+
+    rc->rc_ssl_want_read = 0;
+    while (native_outq_len(rc) > 0){
+        if ((ret = native_write1(rc, cbuf_get(rc->rc_outq) + rc->rc_outq_start,
+                                 native_outq_len(rc), &n)) < 0)
+            goto done;
+        if (ret == 0){
+            native_outq_reset(rc);
+            goto closed;
+        }
+        if (n == 0) /* Would block */
+            break;
+        rc->rc_outq_start += n;
+        gettimeofday(&rc->rc_t, NULL); /* activity timer */
+        if (native_outq_len(rc) == 0){
+            cbuf_reset(rc->rc_outq);
+            rc->rc_outq_start = 0;
+#ifdef HAVE_LIBNGHTTP2
+            if (rc->rc_proto == HTTP_2 && rc->rc_ngsession &&
+                nghttp2_session_want_write(rc->rc_ngsession) &&
+                (ngerr = nghttp2_session_send(rc->rc_ngsession)) != 0){
+                clixon_err(OE_NGHTTP2, ngerr, "nghttp2_session_send");
+                goto done;
+            }
+#endif
+        }
+    }
+    if (native_write_update(rc) < 0)
+        goto done;
+    retval = 1;
+ done:
+    return retval;
+ closed:
+    retval = 0;
+    goto done;
+}
+
+/*! Write output queue of connection, unless it waits for the socket to be writable
+ *
+ * @param[in]  rc   Connection struct
+ * @retval     1    OK
+ * @retval     0    OK, but socket write returned error, caller should close rc
+ * @retval    -1    Error
+ * @see native_buf_queue
+ */
+int
+native_buf_flush(restconf_conn *rc)
+{
+    if (rc->rc_writing ||      /* Written by native_output_cb */
+        rc->rc_ssl_want_read)  /* Written by restconf_connection */
+        return 1;
+    return native_outq_write(rc);
+}
+
+/*! Queue buf for output on connection without writing it
+ *
+ * Used by HTTP/2 to coalesce the frames of one nghttp2_session_send into fewer writes.
+ * @param[in]  rc       Connection struct
+ * @param[in]  buf      Buffer to write
+ * @param[in]  buflen   Length of buffer
+ * @retval     1        OK, queued
+ * @retval     0        Queue full, try again when written
+ * @retval    -1        Error
+ * @see native_buf_flush  to write the queue
+ */
+int
+native_buf_queue(restconf_conn *rc,
+                 char          *buf,
+                 size_t         buflen)
+{
+    if (native_outq_len(rc) >= RESTCONF_NATIVE_OUTQ_HIGH)
+        return 0;
+    if (native_outq_append(rc, buf, buflen) < 0)
+        return -1;
+    return 1;
+}
+
+/*! Write buf to socket
  *
  * Only (at least mostly?) for HTTP/1
+ * If earlier data is queued or the write would block, the rest is queued on the connection
+ * and written when the socket is writable, so that a slow client does not block others.
  * @param[in]  h        Clixon handle
  * @param[in]  buf      Buffer to write
  * @param[in]  buflen   Length of buffer
  * @param[in]  rc       Connection struct
  * @param[in]  callfn   For debug
- * @retval  1  OK
+ * @retval  1  OK, written or queued
  * @retval  0  OK, but socket write returned error, caller should close rc
  * @retval -1  Error
  */
@@ -400,16 +782,13 @@ native_buf_write(clixon_handle    h,
                  const char      *callfn)
 {
     int     retval = -1;
-    ssize_t len;
-    ssize_t totlen = 0;
-    int     er;
-    SSL    *ssl;
+    ssize_t n = 0;
+    int     ret;
 
     if (rc == NULL){
         clixon_err(OE_RESTCONF, EINVAL, "rc is NULL");
         goto done;
     }
-    ssl = rc->rc_ssl;
     /* Two problems with debugging buffers that this fixes:
      * 1. they are not "strings" in the sense they are not NULL-terminated
      * 2. they are often very long
@@ -427,65 +806,49 @@ native_buf_write(clixon_handle    h,
         clixon_debug(CLIXON_DBG_RESTCONF, "%s buflen:%zu buf:\n%s", callfn, buflen, dbgstr);
         free(dbgstr);
     }
-    while (totlen < buflen){
-        if (ssl){
-            if ((len = SSL_write(ssl, buf+totlen, buflen-totlen)) <= 0){
-                er = errno;
-                switch (SSL_get_error(ssl, len)){
-                case SSL_ERROR_SYSCALL:              /* 5 */
-                    if (er == ECONNRESET || /* Connection reset by peer */
-                        er == EPIPE) {      /* Reading end of socket is closed */
-                        goto closed; /* Close socket and ssl */
-                    }
-                    else if (er == EAGAIN){
-                        clixon_debug(CLIXON_DBG_RESTCONF, "write EAGAIN");
-                        usleep(10000);
-                        continue;
-                    }
-                    else{
-                        clixon_err(OE_RESTCONF, er, "SSL_write %d", er);
-                        goto done;
-                    }
-                    break;
-                default:
-                    clixon_err(OE_SSL, 0, "SSL_write");
-                    goto done;
-                    break;
-                }
-                goto done;
-            }
-        }
-        else{
-            if ((len = write(rc->rc_s, buf+totlen, buflen-totlen)) < 0){
-                switch (errno){
-                case EAGAIN:     /* Operation would block */
-                    clixon_debug(CLIXON_DBG_RESTCONF, "write EAGAIN");
-                    usleep(10000);
-                    continue;
-                    break;
-                    //          case EBADF: // XXX if this happens there is some larger error
-                case ECONNRESET: /* Connection reset by peer */
-                case EPIPE:   /* Broken pipe */
-                    goto closed; /* Close socket and ssl */
-                    break;
-                default:
-                    clixon_err(OE_UNIX, errno, "write %d", errno);
-                    goto done;
-                    break;
-                }
-            }
-        }
-        totlen += len;
-    } /* while */
+    if (native_outq_len(rc) == 0){ /* Nothing queued, try to write directly */
+        if ((ret = native_write1(rc, buf, buflen, &n)) < 0)
+            goto done;
+        if (ret == 0)
+            goto closed;
+        if (n == buflen)
+            goto ok;
+    }
+    if (native_outq_append(rc, buf + n, buflen - n) < 0)
+        goto done;
+    if (native_write_update(rc) < 0)
+        goto done;
+ ok:
     retval = 1;
  done:
     clixon_debug(CLIXON_DBG_RESTCONF, "retval:%d", retval);
     return retval;
  closed:
+    native_outq_reset(rc);
     retval = 0;
     goto done;
 }
 
+/*! Close connection when all queued output is written
+ *
+ * No more requests are read from the connection.
+ * @param[in]  rc       Connection struct
+ * @param[in]  callfn   For debug
+ * @retval     0        OK, closed or closing
+ * @retval    -1        Error
+ * @see native_output_cb  where it is closed if output is queued
+ */
+int
+native_close_after_write(restconf_conn *rc,
+                         const char    *callfn)
+{
+    clixon_debug(CLIXON_DBG_RESTCONF, "%s", callfn);
+    if (native_outq_len(rc) == 0)
+        return restconf_close_ssl_socket(rc, callfn, 0);
+    rc->rc_outq_close = 1;
+    return native_read_update(rc);
+}
+
 /*! Send early handcoded bad request reply before actual packet received, just after accept
  *
  * @param[in]  h    Clixon handle
@@ -562,7 +925,8 @@ http1_native_clear_input(clixon_handle         h,
  * @param[in]  buf   Input buffer
  * @param[in]  sz    Size of input buffer
  * @param[out] np    Bytes read
- * @param[out] again    If set, read data again, do not continue processing
+ * @param[out] again    If set, no data now, read again when socket is readable, or writable
+ *                      if SSL needs to write to complete the read, see native_output_cb
  * @retval     0     OK
  * @retval    -1    Error
  */
@@ -587,7 +951,14 @@ read_ssl(restconf_conn *rc,
              * with SOCK_NONBLOCK
              */
             clixon_debug(CLIXON_DBG_RESTCONF, "SSL_read SSL_ERROR_WANT_READ");
-            usleep(1000);
+            *again = 1;
+            break;
+        case SSL_ERROR_WANT_WRITE:           /* 3 */
+            /* Eg renegotiation, wait for the socket to be writable instead of readable */
+            clixon_debug(CLIXON_DBG_RESTCONF, "SSL_read SSL_ERROR_WANT_WRITE");
+            rc->rc_ssl_want_write = 1;
+            if (native_write_update(rc) < 0)
+                goto done;
             *again = 1;
             break;
         case SSL_ERROR_ZERO_RETURN: /* 6 */
@@ -600,7 +971,7 @@ read_ssl(restconf_conn *rc,
         } /* switch */
     }
     retval = 0;
-    // done:
+ done:
     clixon_debug(CLIXON_DBG_RESTCONF, "retval:%d", retval);
     return retval;
 }
@@ -611,7 +982,7 @@ read_ssl(restconf_conn *rc,
  * @param[in]  buf      Input buffer
  * @param[in]  sz       Size of input buffer
  * @param[out] np       Bytes read
- * @param[out] again    If set, read data again, do not continue processing
+ * @param[out] again    If set, no data now, read again when socket is readable
  * @retval     1        OK
  * @retval     0        Socket closed, quit
  * @retval    -1        Error
@@ -639,7 +1010,6 @@ read_regular(restconf_conn *rc,
             break;
         case EAGAIN:
             clixon_debug(CLIXON_DBG_RESTCONF, "read EAGAIN");
-            usleep(1000);
             *again = 1;
             break;
         default:;
@@ -736,7 +1106,7 @@ restconf_http1_process(restconf_conn *rc,
                 goto done;
             if (http1_native_clear_input(h, sd) < 0)
                 goto done;
-            if (restconf_close_ssl_socket(rc, __FUNCTION__, 0) < 0)
+            if (native_close_after_write(rc, __FUNCTION__) < 0)
                 goto done;
             rc = NULL;
             goto closed;
@@ -794,11 +1164,16 @@ restconf_http1_process(restconf_conn *rc,
         cvec_free(sd->sd_qvec);
         sd->sd_qvec = NULL;
     }
-    if (ret == 0 || rc->rc_exit){  /* Server-initiated exit */
+    if (ret == 0){
         if (restconf_close_ssl_socket(rc, __FUNCTION__, 0) < 0)
             goto done;
         goto closed;
     }
+    if (rc->rc_exit){  /* Server-initiated exit, close when reply is written */
+        if (native_close_after_write(rc, __FUNCTION__) < 0)
+            goto done;
+        goto closed;
+    }
  ok:
     retval = 1;
  done:
@@ -966,6 +1341,7 @@ restconf_connection(int   s,
     ssize_t        n;
     char           buf[1024]; /* Alter BUFSIZ (8K) from stdio.h 8K. 256 fails some tests */
     int            readmore = 1;
+    int            again;
     int            ret;
 
     clixon_debug(CLIXON_DBG_RESTCONF, "%d", s);
@@ -978,23 +1354,33 @@ restconf_connection(int   s,
         goto done;
     }
     gettimeofday(&rc->rc_t, NULL); /* activity timer */
+    if (rc->rc_ssl_want_read){ /* SSL_write waits for socket to be readable, see native_write1 */
+        if ((ret = native_output(rc)) < 0)
+            goto done;
+        if (ret == 0)
+            goto ok;
+        /* Read requests only if registered for them */
+        if (rc->rc_ssl_want_read || !rc->rc_reading)
+            goto ok;
+    }
     while (readmore) {
         clixon_debug(CLIXON_DBG_RESTCONF, "readmore");
         readmore = 0;
+        again = 0;
         /* Example: curl -Ssik -u wilma:bar -X GET https://localhost/restconf/data/example:x */
         if (rc->rc_ssl){
-            if (read_ssl(rc, buf, sizeof(buf), &n, &readmore) < 0)
+            if (read_ssl(rc, buf, sizeof(buf), &n, &again) < 0)
                 goto done;
         }
         else{ /* Not SSL */
-            if ((ret = read_regular(rc, buf, sizeof(buf), &n, &readmore)) < 0)
+            if ((ret = read_regular(rc, buf, sizeof(buf), &n, &again)) < 0)
                 goto done;
             if (ret == 0)
                 goto ok; /* abort here */
         }
         clixon_debug(CLIXON_DBG_RESTCONF, "read:%zd", n);
-        if (readmore)
-            continue;
+        if (again) /* Socket is non-blocking, wait until it is readable */
+            goto ok;
         if (n == 0){
             clixon_debug(CLIXON_DBG_RESTCONF, "n=0 closing socket");
             if (restconf_close_ssl_socket(rc, __FUNCTION__, 0) < 0)
@@ -1067,6 +1453,10 @@ restconf_connection_close1(restconf_conn *rc)
     }
     rsock = rc->rc_socket;
     clixon_debug(CLIXON_DBG_RESTCONF, "%s", rsock->rs_description?rsock->rs_description:"");
+    if (rc->rc_writing){
+        clixon_event_unreg_fd(rc->rc_s, native_output_cb);
+        rc->rc_writing = 0;
+    }
     if (close(rc->rc_s) < 0){
         clixon_err(OE_UNIX, errno, "close");
         goto done;
@@ -1188,7 +1578,7 @@ ssl_alpn_check(clixon_handle        h,
                                        "application/yang-data+xml",
                                        cbuf_get(cberr), rc) < 0)
                 goto done;
-            if (restconf_close_ssl_socket(rc, __FUNCTION__, 0) < 0)
+            if (native_close_after_write(rc, __FUNCTION__) < 0)
                 goto done;
             goto fail;
         }
@@ -1255,6 +1645,7 @@ restconf_ssl_accept_client(clixon_handle    h,
     const unsigned char    *alpn = NULL;
     unsigned int            alpnlen = 0;
     restconf_http_proto     proto = HTTP_11;  /* Non-SSL negotiation NYI */
+    int                     flags;
 
     clixon_debug(CLIXON_DBG_RESTCONF, "");
 #ifdef HAVE_LIBNGHTTP2
@@ -1439,7 +1830,13 @@ restconf_ssl_accept_client(clixon_handle    h,
         break;
     } /* switch proto */
     gettimeofday(&rc->rc_t, NULL); /* activity timer */
-    if (clixon_event_reg_fd(rc->rc_s, restconf_connection, (void*)rc, "restconf client socket") < 0)
+    /* Reads and writes of data are non-blocking, see native_buf_write */
+    if ((flags = fcntl(rc->rc_s, F_GETFL)) < 0 ||
+        fcntl(rc->rc_s, F_SETFL, flags | O_NONBLOCK) < 0){
+        clixon_err(OE_UNIX, errno, "fcntl");
+        goto done;
+    }
+    if (native_read_update(rc) < 0)
         goto done;
     if (rcp)
         *rcp = rc;
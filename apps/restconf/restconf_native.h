@@ -122,6 +122,13 @@ typedef struct restconf_conn {
     struct timeval        rc_t;         /* Timestamp of last read/write activity, used by callhome
                                            idle-timeout algorithm */
     int                   rc_event_stream;    /* Event notification stream socket (maybe in sd?) */
+    cbuf                 *rc_outq;      /* Output queue, data not yet written to socket */
+    size_t                rc_outq_start; /* Start of unwritten data in rc_outq */
+    int                   rc_outq_close; /* Close connection when output queue is written */
+    int                   rc_reading;   /* Socket is registered for reading */
+    int                   rc_writing;   /* Socket is registered for writing */
+    int                   rc_ssl_want_read;  /* SSL_write waits for socket to be readable */
+    int                   rc_ssl_want_write; /* SSL_read waits for socket to be writable */
 } restconf_conn;
 
 /* Restconf per socket handle
@@ -181,6 +188,9 @@ int               ssl_x509_name_oneline(SSL *ssl, char **oneline);
 int               restconf_close_ssl_socket(restconf_conn *rc, const char *callfn, int sslerr0);
 int               restconf_connection_sanity(clixon_handle h, restconf_conn *rc, restconf_stream_data *sd);
 int               native_buf_write(clixon_handle h, char *buf, size_t buflen, restconf_conn *rc, const char *callfn);
+int               native_buf_queue(restconf_conn *rc, char *buf, size_t buflen);
+int               native_buf_flush(restconf_conn *rc);
+int               native_close_after_write(restconf_conn *rc, const char *callfn);
 restconf_native_handle *restconf_native_handle_get(clixon_handle h);
 int               restconf_connection(int s, void *arg);
 int               restconf_ssl_accept_client(clixon_handle h, int s, restconf_socket *rsock, restconf_conn  **rcp);
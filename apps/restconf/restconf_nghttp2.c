@@ -176,93 +176,19 @@ session_send_callback(nghttp2_session *session,
                       int              flags,
                       void            *user_data)
 {
-    int            retval = NGHTTP2_ERR_CALLBACK_FAILURE;
     restconf_conn *rc = (restconf_conn *)user_data;
-    int            er;
-    ssize_t        len;
-    ssize_t        totlen = 0;
-    int            s;
-    int            sslerr;
+    int            ret;
 
     clixon_debug(CLIXON_DBG_RESTCONF, "buflen:%zu", buflen);
-    s = rc->rc_s;
-    while (totlen < buflen){
-        if (rc->rc_ssl){
-            if ((len = SSL_write(rc->rc_ssl, buf+totlen, buflen-totlen)) <= 0){
-                er = errno;
-                sslerr = SSL_get_error(rc->rc_ssl, len);
-                clixon_debug(CLIXON_DBG_RESTCONF, "SSL_write: errno:%s(%d) sslerr:%d",
-                             strerror(er),
-                             er,
-                             sslerr);
-                switch (sslerr){
-                case SSL_ERROR_WANT_WRITE:           /* 3 */
-                    clixon_debug(CLIXON_DBG_RESTCONF, "write SSL_ERROR_WANT_WRITE");
-                    usleep(1000);
-                    continue;
-                    break;
-                case SSL_ERROR_SYSCALL:              /* 5 */
-                    if (er == ECONNRESET || /* Connection reset by peer */
-                        er == EPIPE) {      /* Reading end of socket is closed */
-                        goto done; /* Cleanup in http2_recv() */
-                    }
-                    else if (er == EAGAIN){
-                        /* same as want_write above, but different behaviour on different
-                         * platforms, linux here, freebsd want_write, or possibly differnt
-                         * ssl lib versions?
-                         */
-                        clixon_debug(CLIXON_DBG_RESTCONF, "write EAGAIN");
-                        usleep(1000);
-                        continue;
-                    }
-                    else{
-                        clixon_err(OE_RESTCONF, er, "SSL_write %d", sslerr);
-                        goto done;
-                    }
-                    break;
-                default:
-                    clixon_err(OE_SSL, 0, "SSL_write");
-                    goto done;
-                    break;
-                }
-                goto done;
-            }
-        }
-        else{
-            if ((len = write(s, buf+totlen, buflen-totlen)) < 0){
-                if (errno == EAGAIN){
-                    clixon_debug(CLIXON_DBG_RESTCONF, "write EAGAIN");
-                    usleep(10000);
-                    continue;
-                }
-#if 1
-                else if (errno == ECONNRESET) {/* Connection reset by peer */
-                    close(s);
-                    // XXXUnclear why this is commented, maybe should call
-                    // restconf_connection_close?
-                    //  clixon_event_unreg_fd(s, restconf_connection);
-
-                    goto ok; /* Close socket and ssl */
-                }
-#endif
-                else{
-                    clixon_err(OE_UNIX, errno, "write");
-                    goto done;
-                }
-            }
-            assert(len != 0);
-        }
-        totlen += len;
-    } /* while */
- ok:
-    retval = 0;
- done:
-    if (retval < 0){
-        clixon_debug(CLIXON_DBG_RESTCONF, "retval:%d", retval);
-        return retval;
+    /* Frames are queued and written together after nghttp2_session_send, see native_buf_flush */
+    if ((ret = native_buf_queue(rc, (char*)buf, buflen)) < 0)
+        return NGHTTP2_ERR_CALLBACK_FAILURE;
+    if (ret == 0){ /* Queue full, nghttp2_session_send is called again when it is written */
+        clixon_debug(CLIXON_DBG_RESTCONF, "output queue full");
+        return NGHTTP2_ERR_WOULDBLOCK;
     }
-    clixon_debug(CLIXON_DBG_RESTCONF, "retval:%zd", totlen);
-    return retval == 0 ? totlen : retval;
+    clixon_debug(CLIXON_DBG_RESTCONF, "retval:%zu", buflen);
+    return buflen;
 }
 
 /*! Invoked when |session| wants to receive data from the remote peer.  
@@ -955,6 +881,7 @@ http2_recv(restconf_conn       *rc,
 {
     int           retval = -1;
     nghttp2_error ngerr;
+    int           ret;
 
     clixon_debug(CLIXON_DBG_RESTCONF, "");
     if (rc->rc_ngsession == NULL){
@@ -991,6 +918,10 @@ http2_recv(restconf_conn       *rc,
         else
             goto fail; /* Not fatal error */
     }
+    if ((ret = native_buf_flush(rc)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail; /* Closed by peer */
     retval = 1; /* OK */
  done:
     clixon_debug(CLIXON_DBG_RESTCONF, "retval:%d", retval);
@@ -1022,6 +953,10 @@ http2_send_server_connection(restconf_conn *rc)
         clixon_err(OE_NGHTTP2, ngerr, "nghttp2_session_send");
         goto done;
     }
+    if (native_buf_flush(rc) != 1){
+        clixon_err(OE_RESTCONF, EPIPE, "write server connection preface");
+        goto done;
+    }
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_RESTCONF, "retval:%d", retval);
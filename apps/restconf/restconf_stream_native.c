@@ -188,6 +188,12 @@ stream_native_backend_cb(int   s,
             goto done;
         if ((ngerr = nghttp2_session_send(rc->rc_ngsession)) != 0)
             goto done;
+        if ((ret = native_buf_flush(rc)) < 0)
+            goto done;
+        if (ret == 0){
+            restconf_close_ssl_socket(rc, __FUNCTION__, 0);
+            goto ok;
+        }
         if (sd->sd_body){
             cbuf_free(sd->sd_body);
             sd->sd_body = NULL;
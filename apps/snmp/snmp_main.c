@@ -127,8 +127,10 @@ snmp_terminate(clixon_handle h)
     if ((x = clicon_conf_xml(h)) != NULL)
         xml_free(x);
     xpath_optimize_exit();
+    xpath_cache_exit();
     clixon_event_exit();
     clixon_handle_exit(h);
+    xml_exit();
     clixon_err_exit();
     clixon_log_exit();
     if (pidfile)
@@ -47,14 +47,54 @@
  */
 #undef RPC_USERNAME_ASSERT
 
-/*! Optimize special list key searches in XPath finds
+/*! Optimize list searches in XPath finds
  *
- * Identify xpaths that search for exactly a list key, eg: "y[k='3']" and then call
- * binary search. This only works if "y" has proper yang binding and is sorted by system
- * Dont optimize on "hierarchical" lists such as: a/y[k='3'], where a is another list.
+ * Compile a lookup plan for each XPath step to a YANG list and cache it in the XPath tree:
+ * - Equality predicates on leading list keys, eg: "y[k='3']", use binary search
+ * - Equality predicates on explicit indexes use index search, see XML_EXPLICIT_INDEX
+ * - A single positional predicate, eg: "y[3]", is looked up directly
+ * Other steps are evaluated as usual. See xpath_optimize_stats()
  */
 #define XPATH_LIST_OPTIMIZE
 
+/*! Cache parsed XPath trees, keyed by XPath string
+ *
+ * Value is max number of entries in the LRU cache of XPaths evaluated at runtime.
+ * XPaths of YANG when, must and path statements are compiled when YANG is loaded and
+ * are kept in addition to these.
+ * Undefine to parse XPaths on every evaluation.
+ */
+#define XPATH_CACHE_SIZE 1024
+
+/*! Use epoll instead of select in the event loop
+ *
+ * epoll is not limited to FD_SETSIZE file descriptors and the cost of a wakeup does not
+ * depend on the number of registered file descriptors, which matters with many concurrent
+ * client sessions.
+ * Only available on Linux, other platforms use select
+ */
+#ifdef __linux__
+#define EVENT_EPOLL
+#endif
+
+/*! Allocate XML nodes from slabs instead of one malloc per node
+ *
+ * Freed nodes are kept on a free-list per node size and reused, which removes the per-node
+ * malloc overhead and reduces fragmentation of large XML trees.
+ * Undefine this when debugging XML memory errors with valgrind, since errors within a slab
+ * are not detected.
+ */
+#define XML_SLAB
+
+/*! Allocate short-lived XML trees from a per-request arena
+ *
+ * Nodes, child vectors and values larger than the inline buffer of nodes created while an
+ * arena is set are allocated from 64K chunks, which are released at once with the arena.
+ * The backend parses and validates each request into an arena, see xml_arena_new.
+ * Undefine this when debugging XML memory errors with valgrind.
+ */
+#define XML_ARENA
+
 /*! Add explicit search indexes, so that binary search can be made for non-key list indexes
  *
  * This also applies if there are multiple keys and you want to search on only the second for 
@@ -64,6 +104,28 @@
  */
 #define XML_EXPLICIT_INDEX
 
+/*! Hash index of key values of ordered-by user and state lists
+ *
+ * Value is the minimum number of children of an XML node for the index to be built.
+ * Ordered-by user and state lists are not sorted by key, so finding an entry is a linear
+ * search. With the index an entry is found by hashing its key values.
+ * The index is built at the first search and kept up-to-date when entries are inserted with
+ * xml_insert() or removed. Other changes of the children, or of key values, remove the index.
+ * If not set, entries are always searched linearly and memory is reduced with 8 bytes
+ * per XML element.
+ */
+#define XML_KEY_INDEX 64
+
+/*! Bulk merge of new list entries in edit-config
+ *
+ * Value is the minimum number of element children of an edit-config node for its new list
+ * and leaf-list entries to be inserted in bulk, see xml_insert_bulk().
+ * New entries are collected, sorted once and merged with the existing children in one pass,
+ * instead of being inserted one by one with a binary search and a memmove each.
+ * If not set, new entries are always inserted one by one.
+ */
+#define XMLDB_BULK_MERGE 1024
+
 /*! Let state data be ordered-by system
  *
  * RFC 7950 is cryptic about this
@@ -144,6 +206,15 @@
  */
 #define HTTP_ON_HTTPS_REPLY
 
+/*! Max bytes queued for output on a restconf native HTTP/2 connection
+ *
+ * HTTP/2 frames are queued on the connection and written when the socket is writable.
+ * When the queue exceeds this size, nghttp2 keeps further frames until the queue is written.
+ * HTTP/1 replies are always queued whole, but no more requests are read from the
+ * connection until the reply is written.
+ */
+#define RESTCONF_NATIVE_OUTQ_HIGH (64*1024)
+
 /*! Indentation number of spaces for XML, JSON and TEXT pretty-printed output.
  *
  * Consider moving to configure.ac(compile-time) or to clixon-config.yang(run-time)
@@ -204,3 +275,12 @@
  * If not set, reduces memory with 8 bytes per yang-stmt.
  */
 #undef YANG_SPEC_LINENR
+
+/*! Hash index of children of YANG statements used by yang_find and yang_find_datanode
+ *
+ * Value is the minimum number of children of a YANG statement for it to be indexed.
+ * The index is built at first lookup and removed when children are added or removed.
+ * If not set, children are always searched linearly and memory is reduced with 8 bytes
+ * per yang-stmt.
+ */
+#define YANG_FIND_INDEX 16
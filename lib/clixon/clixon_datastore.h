@@ -50,12 +50,19 @@ struct db_elmnt {
     uint32_t       de_id;       /* If set, locked by this client/session id */
     struct timeval de_tv;       /* Timevalue, set by lock/unlock */
     cxobj         *de_xml;      /* cache */
+    int           *de_refs;     /* Nr of datastores sharing de_xml, the counter is shared by
+                                 * them. NULL if not shared, see xmldb_copy */
     int            de_modified; /* Dirty since loaded/copied/committed/etc
                                  * For NETCONF lock. Set by edit-config, copy, delete,
                                  * reset by commit, discard
                                  */
     int            de_empty;    /* Empty on read from file, xmldb_readfile and xmldb_put sets it */
     int            de_volatile; /* Disable auto-sync of cache to disk on every update (ie xmldb_put) */
+    int            de_journal;  /* Nr of records in journal since last full write, see CLICON_XMLDB_JOURNAL */
+    uint64_t       de_generation; /* Generation of datastore file, journal records of other
+                                   * generations are stale, see CLICON_XMLDB_JOURNAL */
+    cxobj         *de_changes;  /* Change set relative to running, or NULL if unknown
+                                 * see xmldb_changes_get */
 };
 typedef struct db_elmnt db_elmnt;
 
@@ -67,6 +74,8 @@ db_elmnt *clicon_db_elmnt_get(clixon_handle h, const char *db);
 int clicon_db_elmnt_set(clixon_handle h, const char *db, db_elmnt *xc);
 int xmldb_db2file(clixon_handle h, const char *db, char **filename);
 int xmldb_db2subdir(clixon_handle h, const char *db, char **dir);
+int xmldb_db2journal(clixon_handle h, const char *db, char **filename);
+int xmldb_journal_reset(clixon_handle h, const char *db);
 
 /* API */
 int xmldb_connect(clixon_handle h);
@@ -76,11 +85,17 @@ int xmldb_get(clixon_handle h, const char *db, cvec *nsc, char *xpath, cxobj **x
 int xmldb_get0(clixon_handle h, const char *db, yang_bind yb,
                cvec *nsc, const char *xpath, int copy, withdefaults_type wdef,
                cxobj **xret, modstate_diff_t *msd, cxobj **xerr);
+int xmldb_get0_free(clixon_handle h, cxobj **xtp);
 /* in clixon_datastore_write.[ch]: */
 int xmldb_put(clixon_handle h, const char *db, enum operation_type op, cxobj *xt, char *username, cbuf *cbret);
 int xmldb_dump(clixon_handle h, FILE *f, cxobj *xt, enum format_enum format, int pretty, withdefaults_type wdef, int multi, const char *multidb);
 int xmldb_write_cache2file(clixon_handle h, const char *db);
 
+int xmldb_cache_unshare(clixon_handle h, const char *db);
+cxobj *xmldb_cache_detach(clixon_handle h, const char *db);
+cxobj *xmldb_changes_get(clixon_handle h, const char *db);
+int xmldb_changes_reset(clixon_handle h, const char *db);
+int xmldb_running_gen(clixon_handle h);
 int xmldb_copy(clixon_handle h, const char *from, const char *to);
 int xmldb_lock(clixon_handle h, const char *db, uint32_t id);
 int xmldb_unlock(clixon_handle h, const char *db);
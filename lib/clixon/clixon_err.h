@@ -108,6 +108,7 @@ int   clixon_err_subnr(void);
 char *clixon_err_reason(void);
 char *clixon_err_str(void);
 int   clixon_err_reset(void);
+void  clixon_err_discard_set(int discard);
 int   clixon_err_fn(clixon_handle h, const char *fn, const int line, int category, int suberr, cxobj *xerr, const char *format, ...) __attribute__ ((format (printf, 7, 8)));
 int   netconf_err2cb(clixon_handle h, cxobj *xerr, cbuf *cberr);
 
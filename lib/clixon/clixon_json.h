@@ -44,8 +44,17 @@
  * Prototypes
  */
 int json2xml_decode(cxobj *x, cxobj **xerr);
+int clixon_json2cbuf1(cbuf *cb, cxobj *x, int pretty, int skiptop, int autocliext,
+                      withdefaults_type wdef);
 int clixon_json2cbuf(cbuf *cb, cxobj *x, int pretty, int skiptop, int autocliext);
+int clixon_json2cbuf_stream(cbuf *cb, cxobj *x, int pretty, withdefaults_type wdef,
+                            size_t chunk, int (*fn)(cbuf *cb, void *arg), void *arg);
+int xml2json_cbuf_vec1(cbuf *cb, cxobj **vec, size_t veclen, int pretty, int skiptop,
+                       withdefaults_type wdef);
 int xml2json_cbuf_vec(cbuf *cb, cxobj **vec, size_t veclen, int pretty, int skiptop);
+int xml2json_cbuf_vec_stream(cbuf *cb, cxobj **vec, size_t veclen, int pretty,
+                             withdefaults_type wdef, size_t chunk,
+                             int (*fn)(cbuf *cb, void *arg), void *arg);
 int clixon_json2file(FILE *f, cxobj *x, int pretty, clicon_output_cb *fn, int skiptop, int autocliext);
 int json_print(FILE *f, cxobj *x);
 int xml2json_vec(FILE *f, cxobj **vec, size_t veclen, int pretty, clicon_output_cb *fn, int skiptop);
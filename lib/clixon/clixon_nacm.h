@@ -64,5 +64,7 @@ int nacm_datanode_write(clixon_handle h, cxobj *xr, cxobj *xt,
                         char *username, cxobj *xnacm, cbuf *cbret);
 int nacm_access_pre(clixon_handle h, char *peername, char *username, cxobj **xnacmp, cbuf *cbret);
 int verify_nacm_user(clixon_handle h, enum nacm_credentials_t cred, char *peername, char *nacmname, char *rpcname, cbuf *cbret);
+int nacm_cache_stats(uint64_t *nr, uint64_t *users, uint64_t *hits, uint64_t *misses);
+void nacm_cache_exit(void);
 
 #endif /* _CLIXON_NACM_H */
@@ -91,5 +91,6 @@ int clixon_xml_find_instance_id(cxobj *xt, yang_stmt *yt, cxobj ***xvec, int *xl
                      ...) __attribute__ ((format (printf, 5, 6)));;
 int clixon_instance_id_bind(yang_stmt *yt, cvec *nsctx, const char *format, ...) __attribute__ ((format (printf, 3, 4)));
 int clixon_instance_id_parse(yang_stmt *yt, clixon_path **cplistp, cxobj **xerr, const char *format, ...) __attribute__ ((format (printf, 4, 5)));
+int clixon_instance_id_search(cxobj *xt, yang_stmt *yt, clixon_path *cplist, cxobj ***xvec, int *xlen);
 
 #endif  /* _CLIXON_PATH_H_ */
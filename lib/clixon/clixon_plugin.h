@@ -227,6 +227,43 @@ typedef int (plgreset_t)(clixon_handle h, const char *db);
  */
 typedef int (plgstatedata_t)(clixon_handle h, cvec *nsc, char *xpath, cxobj *xtop);
 
+/* Collect state data from plugin on a backend worker thread
+ *
+ * Called in parallel with the collect callbacks of other plugins, on a worker thread if
+ * the backend is built with pthreads. The callback must not call clixon library functions,
+ * which are not thread-safe, but only collect raw data, eg from hardware or another process.
+ * Calls of the same plugin are never concurrent: while a call abandoned at the deadline
+ * still runs, the state of the plugin is left out of later requests.
+ * The backend waits for running calls before plugins are unloaded.
+ * The data is then given to the build callback on the backend main thread.
+ * @param[in]  h          Clixon handle, not to be used other than passed to build callback
+ * @param[in]  xpath      Part of state requested (copy)
+ * @param[out] data       Collected data, freed by the free callback or free(3)
+ * @retval     0          OK
+ * @retval    -1          Error
+ * @see plgstatebuild_t
+ */
+typedef int (plgstatecollect_t)(clixon_handle h, const char *xpath, void **data);
+
+/* Build state data from data collected by the collect callback
+ *
+ * Called on the backend main thread in plugin order when the collect callback is done.
+ * Works as plgstatedata_t otherwise.
+ * @param[in]  h          Clixon handle
+ * @param[in]  nsc        XPath namespace context.
+ * @param[in]  xpath      Part of state requested
+ * @param[in]  data       Data collected by the collect callback
+ * @param[out] xtop       XML tree where statedata is added
+ * @retval     0          OK
+ * @retval    -1          Error
+ * @see plgstatecollect_t
+ */
+typedef int (plgstatebuild_t)(clixon_handle h, cvec *nsc, char *xpath, void *data, cxobj *xtop);
+
+/* Free data collected by the collect callback, may be called on a worker thread
+ */
+typedef void (plgstatefree_t)(void *data);
+
 /*! Pagination-data type
  *
  * @see pagination_data_t in for full pagination data structure
@@ -247,6 +284,10 @@ typedef int (plglockdb_t)(clixon_handle h, char *db, int lock, int id);
 
 /*! Transaction-data type
  *
+ * The source and target trees of a transaction are read-only for the callbacks.
+ * In a validate or commit of a candidate with known edits they are the datastore caches
+ * themselves, and the same tree if nothing changed. Copy a tree to modify it.
+ * Checked if CLICON_PLUGIN_CALLBACK_CHECK is set.
  * @see transaction_data_t and clixon_backend_transaction.h for full transaction API 
  */
 typedef void *transaction_data;
@@ -407,6 +448,12 @@ struct clixon_plugin_api{
             trans_cb_t       *cb_trans_end;      /* Transaction completed  */
             trans_cb_t       *cb_trans_abort;    /* Transaction aborted */
             datastore_upgrade_t *cb_datastore_upgrade; /* General-purpose datastore upgrade */
+            /* Appended to keep the layout of earlier fields for compiled plugins */
+            const char      **cb_statedata_scope; /* Schema paths of state data, NULL-terminated */
+            uint32_t          cb_statedata_ttl;   /* Cache state data this many ms, 0: no cache */
+            plgstatecollect_t *cb_statedata_collect; /* Collect state data on worker thread */
+            plgstatebuild_t  *cb_statedata_build; /* Build state data XML from collected data */
+            plgstatefree_t   *cb_statedata_free; /* Free collected data, or NULL for free(3) */
         } cau_backend;
     } u;
 };
@@ -430,6 +477,11 @@ struct clixon_plugin_api{
 #define ca_trans_end      u.cau_backend.cb_trans_end
 #define ca_trans_abort    u.cau_backend.cb_trans_abort
 #define ca_datastore_upgrade  u.cau_backend.cb_datastore_upgrade
+#define ca_statedata_scope u.cau_backend.cb_statedata_scope
+#define ca_statedata_ttl  u.cau_backend.cb_statedata_ttl
+#define ca_statedata_collect u.cau_backend.cb_statedata_collect
+#define ca_statedata_build u.cau_backend.cb_statedata_build
+#define ca_statedata_free u.cau_backend.cb_statedata_free
 
 /*
  * Macros
@@ -56,6 +56,7 @@ int clicon_rpc_lock(clixon_handle h, char *db);
 int clicon_rpc_unlock(clixon_handle h, char *db);
 int clicon_rpc_get2(clixon_handle h, char *xpath, cvec *nsc, netconf_content content, int32_t depth, char *defaults, int bind, cxobj **xret);
 int clicon_rpc_get(clixon_handle h, char *xpath, cvec *nsc, netconf_content content, int32_t depth, char *defaults, cxobj **xret);
+int clicon_rpc_get_json(clixon_handle h, char *xpath, cvec *nsc, netconf_content content, int32_t depth, char *defaults, int pretty, cbuf *cbjson, int *count, cxobj **xret);
 int clicon_rpc_get_pageable_list(clixon_handle h, char *datastore, char *xpath,
                                  cvec *nsc, netconf_content content, int32_t depth, char *defaults,
                                  uint32_t offset, uint32_t limit,
@@ -167,6 +167,7 @@ typedef enum yang_bind yang_bind;
 #define CX_ANY CX_ERROR /* catch all and error is same */
 
 typedef struct xml cxobj; /* struct defined in clicon_xml.c */
+typedef struct xml_arena xml_arena; /* struct defined in clicon_xml.c */
 
 /*! Callback function type for xml_apply
  *
@@ -208,11 +209,17 @@ enum format_enum{
 #define XML_FLAG_BODYKEY  0x100 /* Text parsing key to be translated from body to key */
 #define XML_FLAG_ANYDATA  0x200 /* Treat as anydata, eg mount-points before bound */
 #define XML_FLAG_CACHE_DIRTY 0x400 /* This part of XML tree is not synced to disk */
+#define XML_FLAG_NACM     0x800 /* NACM tree is equal to compiled NACM rules, see nacm_cache */
+#define XML_FLAG_CACHE_TOP 0x1000 /* Top of a datastore cache tree, see xmldb_get0_free */
 
 /*
  * Prototypes
  */
 char     *xml_type2str(enum cxobj_type type);
+void      xml_exit(void);
+xml_arena *xml_arena_new(void);
+xml_arena *xml_arena_set(xml_arena *xa);
+int       xml_arena_free(xml_arena *xa);
 int       xml_stats_global(uint64_t *nr);
 int       xml_stats(cxobj *xt, uint64_t *nrp, size_t *szp);
 char     *xml_name(cxobj *xn);
@@ -298,6 +305,10 @@ int       xml_operation(char *opstr, enum operation_type *op);
 char     *xml_operation2str(enum operation_type op);
 int       xml_attr_insert2val(char *instr, enum insert_type *ins);
 cxobj    *xml_add_attr(cxobj *xn, char *name, char *value, char *prefix, char *ns);
+#ifdef XML_KEY_INDEX
+void     *xml_key_index_get(cxobj *x);
+int       xml_key_index_set(cxobj *x, void *xk);
+#endif
 #ifdef XML_EXPLICIT_INDEX
 int       xml_search_index_p(cxobj *x);
 int       xml_search_vector_get(cxobj *x, char *name, clixon_xvec **xvec);
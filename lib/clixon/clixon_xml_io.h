@@ -40,9 +40,17 @@
 #ifndef _CLIXON_XML_IO_H_
 #define _CLIXON_XML_IO_H_
 
+/*
+ * Types
+ */
+/*! Flush callback of clixon_xml2cbuf_stream, consumes the content of the buffer
+ */
+typedef int (clixon_xml_stream_fn)(cbuf *cb, void *arg);
+
 /*
  * Prototypes
  */
+int   xml2output_wdef(cxobj *x, withdefaults_type wdef, int *tag);
 int   clixon_xml2file1(FILE *f, cxobj *xn, int level, int pretty, char *prefix,
                        clicon_output_cb *fn, int skiptop, int autocliext, withdefaults_type wdef,
                        int multi);
@@ -56,6 +64,9 @@ int   clixon_xml2cbuf1(cbuf *cb, cxobj *x, int level, int prettyprint, char *pre
                        int32_t depth, int skiptop, withdefaults_type wdef);
 int   clixon_xml2cbuf(cbuf *cb, cxobj *x, int level, int prettyprint, char *prefix, int32_t depth, 
 int skiptop);
+int   clixon_xml2cbuf_stream(cbuf *cb, cxobj *xn, char *topname, int32_t depth, int skiptop,
+                             withdefaults_type wdef, size_t chunk, clixon_xml_stream_fn *fn,
+                             void *arg);
 int   xmltree2cbuf(cbuf *cb, cxobj *x, int level);
 int   clixon_xml_parse_file(FILE *f, yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr);
 int   clixon_xml_parse_string(const char *str, yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr);
@@ -46,11 +46,16 @@ int xml_sort(cxobj *x);
 int xml_sort_by(cxobj *x, char *indexvar);
 int xml_sort_recurse(cxobj *xn);
 int xml_insert(cxobj *xp, cxobj *xc, enum insert_type ins, char *key_val, cvec *nsckey);
+int xml_insert_bulk(cxobj *xp, clixon_xvec *xvec);
 int xml_sort_verify(cxobj *x, void *arg);
 #ifdef XML_EXPLICIT_INDEX
 int xml_search_indexvar_binary_pos(cxobj *xp, char *indexvar, clixon_xvec *xvec,
                                    int low, int upper, int max, int *eq);
 #endif
+#ifdef XML_KEY_INDEX
+int xml_key_index_free(cxobj *xp);
+int xml_key_index_change(cxobj *x, cxobj *xc, int rm);
+#endif
 int match_base_child(cxobj *x0, cxobj *x1c, yang_stmt *yc, cxobj **x0cp);
 int clixon_xml_find_index(cxobj *xp, yang_stmt *yp, char *ns, char *name,
                           cvec *cvk, clixon_xvec *xvec);
@@ -118,6 +118,7 @@ struct xpath_tree{
     struct xpath_tree *xs_c0;     /* child 0 */
     struct xpath_tree *xs_c1;     /* child 1 */
     int                xs_match;  /* meta: match this node */
+    void              *xs_plan;   /* meta: compiled lookup plan of step, see xpath_optimize_check */
 };
 typedef struct xpath_tree xpath_tree;
 
@@ -132,8 +133,14 @@ int   xpath_tree_print(FILE *f, xpath_tree *xs);
 int   xpath_tree2cbuf(xpath_tree *xs, cbuf *xpathcb);
 int   xpath_tree_eq(xpath_tree *xt1, xpath_tree *xt2, xpath_tree ***vec, size_t *len);
 xpath_tree *xpath_tree_traverse(xpath_tree *xt, ...);
+int   xpath_tree_deps(xpath_tree *xs, cvec *cvv);
 int   xpath_tree_free(xpath_tree *xs);
 int   xpath_parse(const char *xpath, xpath_tree **xptree);
+int   xpath_cache_get(const char *xpath, xpath_tree **xpt);
+int   xpath_cache_release(const char *xpath, xpath_tree *xpt);
+int   xpath_cache_compile(const char *xpath);
+int   xpath_cache_stats(uint64_t *nr, uint64_t *hits, uint64_t *misses);
+void  xpath_cache_exit(void);
 int   xpath_vec_ctx(cxobj *xcur, cvec *nsc, const char *xpath, int localonly, xp_ctx  **xrp);
 
 int    xpath_vec_bool(cxobj *xcur, cvec *nsc, const char *xpformat, ...) __attribute__ ((format (printf, 3, 4)));
@@ -40,8 +40,11 @@
 
 
 int  xpath_list_optimize_stats(int *hits);
+int  xpath_optimize_stats(uint64_t *keys, uint64_t *index, uint64_t *pos, uint64_t *eval);
 int  xpath_list_optimize_set(int enable);
 void xpath_optimize_exit(void);
-int  xpath_optimize_check(xpath_tree *xs, cxobj *xv, cxobj ***xvec0, int *xlen0);
+void xpath_optimize_plan_free(void *plan);
+int  xpath_optimize_check(xpath_tree *xs, cxobj *xv, int nr, cvec *nsc, int localonly,
+                          cxobj ***xvec0, int *xlen0);
 
 #endif /* _CLIXON_XPATH_OPTIMIZE_H */
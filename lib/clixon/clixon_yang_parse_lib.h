@@ -64,6 +64,7 @@ int        yang_spec_parse_file(clixon_handle h, char *filename, yang_stmt *yspe
 int        yang_spec_load_dir(clixon_handle h, char *dir, yang_stmt *yspec);
 int        ys_parse_date_arg(char *datearg, uint32_t *dateint);
 cg_var    *ys_parse(yang_stmt *ys, enum cv_type cvtype);
+int        ys_parse_sub_deferred(yang_stmt *ys);
 int        ys_parse_sub(yang_stmt *ys, const char *filename, char *extra);
 
 #endif  /* _CLIXON_YANG_LIB_H_ */
@@ -42,9 +42,11 @@
 #endif
 
 #include <stdlib.h>
+#include <inttypes.h>
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <limits.h>
 #include <signal.h>
 #include <syslog.h>
 #include <dlfcn.h>
@@ -235,6 +237,235 @@ xmldb_db2subdir(clixon_handle h,
     return retval;
 }
 
+/*! Translate from symbolic database name to journal filename, no checks
+ *
+ * @param[in]   h        Clixon handle
+ * @param[in]   db       Symbolic database name, eg "candidate", "running"
+ * @param[out]  filename Journal filename. Unallocate after use with free()
+ * @retval      0        OK
+ * @retval     -1        Error
+ * @see CLICON_XMLDB_JOURNAL
+ */
+int
+xmldb_db2journal(clixon_handle h,
+                 const char   *db,
+                 char        **filename)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+    char *dir;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if ((dir = clicon_xmldb_dir(h)) == NULL){
+        clixon_err(OE_XML, errno, "CLICON_XMLDB_DIR not set");
+        goto done;
+    }
+    cprintf(cb, "%s/%s_db.journal", dir, db);
+    if ((*filename = strdup4(cbuf_get(cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Remove datastore journal, if any
+ *
+ * Called when the complete datastore has been written to file, ie the journal is compacted
+ * @param[in]   h        Clixon handle
+ * @param[in]   db       Symbolic database name, eg "candidate", "running"
+ * @retval      0        OK
+ * @retval     -1        Error
+ * @see CLICON_XMLDB_JOURNAL
+ */
+int
+xmldb_journal_reset(clixon_handle h,
+                    const char   *db)
+{
+    int       retval = -1;
+    char     *filename = NULL;
+    db_elmnt *de;
+
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+        de->de_journal = 0;
+    if (xmldb_db2journal(h, db, &filename) < 0)
+        goto done;
+    if (unlink(filename) < 0 && errno != ENOENT){
+        clixon_err(OE_UNIX, errno, "unlink(%s)", filename);
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (filename)
+        free(filename);
+    return retval;
+}
+
+/*! Drop reference of a datastore to its cache tree
+ *
+ * Caches are shared between datastores after xmldb_copy until one of them is modified
+ * @param[in]  de   Database element, cache is set to NULL
+ * @retval     xt   Cache tree that no other datastore refers to
+ * @retval     NULL No cache, or shared with other datastores
+ * @see xmldb_copy
+ */
+static cxobj *
+xmldb_cache_unref(db_elmnt *de)
+{
+    cxobj *xt;
+
+    xt = de->de_xml;
+    de->de_xml = NULL;
+    if (de->de_refs){
+        if (--(*de->de_refs) > 0)
+            xt = NULL;
+        else
+            free(de->de_refs);
+        de->de_refs = NULL;
+    }
+    if (xt)
+        xml_flag_reset(xt, XML_FLAG_CACHE_TOP);
+    return xt;
+}
+
+/*! Free datastore cache unless it is shared with other datastores
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  de   Database element
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xmldb_cache_free(clixon_handle h,
+                 db_elmnt     *de)
+{
+    cxobj *xt;
+
+    if ((xt = xmldb_cache_unref(de)) != NULL)
+        xml_free(xt);
+    return 0;
+}
+
+/*! Get change set of datastore relative to running
+ *
+ * A change set is started when a datastore is copied from or to running and is
+ * extended by every xmldb_put. It is removed when the datastore or running is
+ * modified in other ways, eg running is edited directly, or the datastore is deleted.
+ * It is used to compute differences to running without comparing complete trees.
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Database name
+ * @retval     xs   Change set, see xml_diff_changes for format
+ * @retval     NULL No change set, differences to running are unknown
+ * @see xml_diff_changes
+ */
+cxobj *
+xmldb_changes_get(clixon_handle h,
+                  const char   *db)
+{
+    db_elmnt *de;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL)
+        return NULL;
+    return de->de_changes;
+}
+
+/*! Remove change set of datastore, or of all datastores if db is running
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Database name
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xmldb_changes_get
+ */
+int
+xmldb_changes_reset(clixon_handle h,
+                    const char   *db)
+{
+    int       retval = -1;
+    char    **keys = NULL;
+    size_t    klen;
+    int       i;
+    db_elmnt *de;
+
+    if (strcmp(db, "running") != 0){
+        if ((de = clicon_db_elmnt_get(h, db)) != NULL && de->de_changes != NULL){
+            xml_free(de->de_changes);
+            de->de_changes = NULL;
+        }
+        goto ok;
+    }
+    /* Running is modified, see xmldb_running_gen */
+    if (clicon_data_int_set(h, "xmldb_running_gen", (xmldb_running_gen(h) + 1) & INT_MAX) < 0)
+        goto done;
+    /* Change sets are relative to running */
+    if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
+        goto done;
+    for (i = 0; i < klen; i++){
+        if ((de = clicon_db_elmnt_get(h, keys[i])) != NULL && de->de_changes != NULL){
+            xml_free(de->de_changes);
+            de->de_changes = NULL;
+        }
+    }
+ ok:
+    retval = 0;
+ done:
+    if (keys)
+        free(keys);
+    return retval;
+}
+
+/*! Get modification generation of running datastore
+ *
+ * The generation is incremented every time running is modified, ie when the change
+ * sets relative to running are reset. Used to detect that running, or data derived from
+ * it, has changed without comparing trees.
+ * @param[in]  h    Clixon handle
+ * @retval     gen  Generation of running
+ * @see xmldb_changes_reset
+ */
+int
+xmldb_running_gen(clixon_handle h)
+{
+    int gen;
+
+    if ((gen = clicon_data_int_get(h, "xmldb_running_gen")) < 0)
+        gen = 0;
+    return gen;
+}
+
+/*! Start an empty change set of datastore, ie it is equal to running
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Database name
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xmldb_changes_get
+ */
+static int
+xmldb_changes_start(clixon_handle h,
+                    const char   *db)
+{
+    int       retval = -1;
+    db_elmnt *de;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL)
+        goto ok;
+    if (de->de_changes != NULL)
+        xml_free(de->de_changes);
+    if ((de->de_changes = xml_new(DATASTORE_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Connect to a datastore plugin, allocate resources to be used in API calls
  *
  * @param[in]  h    Clixon handle
@@ -266,9 +497,11 @@ xmldb_disconnect(clixon_handle h)
         goto done;
     for(i = 0; i < klen; i++) 
         if ((de = clicon_hash_value(clicon_db_elmnt(h), keys[i], NULL)) != NULL){
-            if (de->de_xml){
-                xml_free(de->de_xml);
-                de->de_xml = NULL;
+            if (xmldb_cache_free(h, de) < 0)
+                goto done;
+            if (de->de_changes){
+                xml_free(de->de_changes);
+                de->de_changes = NULL;
             }
         }
     retval = 0;
@@ -278,9 +511,103 @@ xmldb_disconnect(clixon_handle h)
     return retval;
 }
 
+/*! Free XML tree returned by xmldb_get0, unless it is a cached datastore tree
+ *
+ * @param[in]     h    Clixon handle
+ * @param[in,out] xtp  XML tree, set to NULL
+ * @retval        0    OK
+ * @retval       -1    Error
+ * @see xmldb_get0
+ */
+int
+xmldb_get0_free(clixon_handle h,
+                cxobj       **xtp)
+{
+    if (*xtp == NULL)
+        return 0;
+    if (xml_flag(*xtp, XML_FLAG_CACHE_TOP) == 0)
+        xml_free(*xtp);
+    *xtp = NULL;
+    return 0;
+}
+
+/*! Ensure datastore cache is not shared with other datastores before modifying it
+ *
+ * xmldb_copy shares the source cache with the target (copy-on-write). Before
+ * a cache is modified, eg by xmldb_put, it must be made private by copying it.
+ * The copy is of the complete tree, ie the first edit after a commit or discard-changes
+ * is O(size of config)
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Database name
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xmldb_copy
+ */
+int
+xmldb_cache_unshare(clixon_handle h,
+                    const char   *db)
+{
+    int       retval = -1;
+    db_elmnt *de;
+    cxobj    *x1;
+    cxobj    *x2 = NULL;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL ||
+        (x1 = de->de_xml) == NULL ||
+        de->de_refs == NULL)
+        goto ok;
+    if (*de->de_refs > 1){
+        clixon_debug(CLIXON_DBG_DATASTORE, "%s", db);
+        if ((x2 = xml_new(xml_name(x1), NULL, CX_ELMNT)) == NULL)
+            goto done;
+        if (xml_copy(x1, x2) < 0)
+            goto done;
+        xml_flag_set(x2, XML_FLAG_TOP | XML_FLAG_CACHE_TOP);
+        xmldb_cache_unref(de);
+        de->de_xml = x2;
+        x2 = NULL;
+    }
+    else{ /* Last reference */
+        free(de->de_refs);
+        de->de_refs = NULL;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (x2)
+        xml_free(x2);
+    return retval;
+}
+
+/*! Detach cache from datastore without freeing it
+ *
+ * The datastore is left without cache. The caller takes over the tree unless it is
+ * shared with other datastores, use xmldb_get0_free() to free it.
+ * Used to keep a tree returned by xmldb_get0 valid when the datastore is replaced
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Database name
+ * @retval     xt   Detached cache tree
+ * @retval     NULL No cache
+ * @see xmldb_get0_free
+ */
+cxobj *
+xmldb_cache_detach(clixon_handle h,
+                   const char   *db)
+{
+    db_elmnt *de;
+    cxobj    *xt = NULL;
+
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL){
+        xt = de->de_xml;
+        xmldb_cache_unref(de);
+    }
+    return xt;
+}
+
 /*! Copy datastore from db1 to db2, both cache and datastore
  *
  * May include copying datastore directory structure
+ * The cache is not copied but shared until one of the datastores is modified
  * @param[in]  h     Clixon handle
  * @param[in]  from  Source datastore
  * @param[in]  to    Destination datastore
@@ -299,7 +626,6 @@ xmldb_copy(clixon_handle h,
     db_elmnt   *de2 = NULL; /* to */
     db_elmnt    de0 = {0,};
     cxobj      *x1 = NULL;  /* from */
-    cxobj      *x2 = NULL;  /* to */
     char       *fromdir = NULL;
     char       *todir = NULL;
     char       *subdir = NULL;
@@ -307,40 +633,28 @@ xmldb_copy(clixon_handle h,
 
     clixon_debug(CLIXON_DBG_DATASTORE, "%s %s", from, to);
     /* XXX lock */
-    /* Copy in-memory cache */
-    /* 1. "to" xml tree in x1 */
+    /* Copy in-memory cache by sharing the "from" tree with "to" (copy-on-write).
+     * The tree is copied by xmldb_cache_unshare() first when one of them is modified
+     */
     if ((de1 = clicon_db_elmnt_get(h, from)) != NULL)
         x1 = de1->de_xml;
-    if ((de2 = clicon_db_elmnt_get(h, to)) != NULL)
-        x2 = de2->de_xml;
-    if (x1 == NULL && x2 == NULL){
-        /* do nothing */
-    }
-    else if (x1 == NULL){  /* free x2 and set to NULL */
-        xml_free(x2);
-        x2 = NULL;
-    }
-    else  if (x2 == NULL){ /* create x2 and copy from x1 */
-        if ((x2 = xml_new(xml_name(x1), NULL, CX_ELMNT)) == NULL)
-            goto done;
-        xml_flag_set(x2, XML_FLAG_TOP);
-        if (xml_copy(x1, x2) < 0) 
+    if ((de2 = clicon_db_elmnt_get(h, to)) != NULL){
+        if (de2->de_xml != x1 && xmldb_cache_free(h, de2) < 0)
             goto done;
+        de0 = *de2;
     }
-    else{ /* copy x1 to x2 */
-        xml_free(x2);
-        if ((x2 = xml_new(xml_name(x1), NULL, CX_ELMNT)) == NULL)
-            goto done;
-        xml_flag_set(x2, XML_FLAG_TOP);
-        if (xml_copy(x1, x2) < 0) 
-            goto done;
+    if (x1 != NULL && de0.de_xml != x1){ /* Add reference to the shared tree */
+        if (de1->de_refs == NULL){
+            if ((de1->de_refs = malloc(sizeof(*de1->de_refs))) == NULL){
+                clixon_err(OE_UNIX, errno, "malloc");
+                goto done;
+            }
+            *de1->de_refs = 1;
+        }
+        (*de1->de_refs)++;
+        de0.de_refs = de1->de_refs;
     }
-    /* always set cache although not strictly necessary in case 1
-     * above, but logic gets complicated due to differences with
-     * de and de->de_xml */
-    if (de2)
-        de0 = *de2;
-    de0.de_xml = x2; /* The new tree */
+    de0.de_xml = x1; /* The new (shared) tree */
     if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
         if (xmldb_db2subdir(h, to, &subdir) < 0)
             goto done;
@@ -352,6 +666,41 @@ xmldb_copy(clixon_handle h,
         }
     }
     clicon_db_elmnt_set(h, to, &de0);
+    /* Update change sets relative to running */
+    if (strcmp(to, "running") == 0){
+        if (xmldb_changes_reset(h, to) < 0)
+            goto done;
+        if (xmldb_changes_start(h, from) < 0)
+            goto done;
+    }
+    else if (strcmp(from, "running") == 0){
+        if (xmldb_changes_start(h, to) < 0)
+            goto done;
+    }
+    else if (xmldb_changes_reset(h, to) < 0)
+        goto done;
+    /* Copy journal along with the file, see CLICON_XMLDB_JOURNAL
+     * The journal is copied before the file: its records are tagged with the generation of
+     * the "from" file and are skipped as stale if the file copy below is interrupted
+     */
+    if (xmldb_journal_reset(h, to) < 0)
+        goto done;
+    if ((de2 = clicon_db_elmnt_get(h, to)) != NULL)
+        de2->de_generation = de1 ? de1->de_generation : 0;
+    if (xmldb_db2journal(h, from, &fromfile) < 0)
+        goto done;
+    if (stat(fromfile, &st) == 0){
+        if (xmldb_db2journal(h, to, &tofile) < 0)
+            goto done;
+        if (clicon_file_copy(fromfile, tofile) < 0)
+            goto done;
+        if (de2 != NULL)
+            de2->de_journal = de1 ? de1->de_journal : 0;
+        free(tofile);
+        tofile = NULL;
+    }
+    free(fromfile);
+    fromfile = NULL;
     /* Copy the files themselves (above only in-memory cache)
      * Alt, dump the cache to file
      */
@@ -523,6 +872,7 @@ xmldb_exists(clixon_handle h,
 {
     int                 retval = -1;
     char               *filename = NULL;
+    char               *journal = NULL;
     struct stat         sb;
 
     clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "%s", db);
@@ -531,13 +881,22 @@ xmldb_exists(clixon_handle h,
     if (lstat(filename, &sb) < 0)
         retval = 0;
     else{
-        if (sb.st_size == 0)
-            retval = 0;
+        if (sb.st_size == 0){
+            /* Empty file but edits may be in journal */
+            if (xmldb_db2journal(h, db, &journal) < 0)
+                goto done;
+            if (lstat(journal, &sb) == 0 && sb.st_size != 0)
+                retval = 1;
+            else
+                retval = 0;
+        }
         else
             retval = 1;
     }
  done:
     clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "retval:%d", retval);
+    if (journal)
+        free(journal);
     if (filename)
         free(filename);
     return retval;
@@ -554,14 +913,13 @@ int
 xmldb_clear(clixon_handle h,
             const char   *db)
 {
-    cxobj    *xt = NULL;
     db_elmnt *de = NULL;
 
+    if (xmldb_changes_reset(h, db) < 0)
+        return -1;
     if ((de = clicon_db_elmnt_get(h, db)) != NULL){
-        if ((xt = de->de_xml) != NULL){
-            xml_free(xt);
-            de->de_xml = NULL;
-        }
+        if (xmldb_cache_free(h, de) < 0)
+            return -1;
     }
     return 0;
 }
@@ -599,6 +957,8 @@ xmldb_delete(clixon_handle h,
             clixon_err(OE_DB, errno, "truncate %s", filename);
             goto done;
         }
+    if (xmldb_journal_reset(h, db) < 0)
+        goto done;
     if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
         if (xmldb_db2subdir(h, db, &subdir) < 0)
             goto done;
@@ -654,16 +1014,15 @@ xmldb_create(clixon_handle h,
     char       *filename = NULL;
     int         fd = -1;
     db_elmnt   *de = NULL;
-    cxobj      *xt = NULL;
     char       *subdir = NULL;
     struct stat st = {0,};
 
     clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "%s", db);
+    if (xmldb_changes_reset(h, db) < 0)
+        goto done;
     if ((de = clicon_db_elmnt_get(h, db)) != NULL){
-        if ((xt = de->de_xml) != NULL){
-            xml_free(xt);
-            de->de_xml = NULL;
-        }
+        if (xmldb_cache_free(h, de) < 0)
+            goto done;
     }
     if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
         if (xmldb_db2subdir(h, db, &subdir) < 0)
@@ -675,6 +1034,8 @@ xmldb_create(clixon_handle h,
             }
         }
     }
+    if (xmldb_journal_reset(h, db) < 0)
+        goto done;
     if (xmldb_db2file(h, db, &filename) < 0)
         goto done;
     if ((fd = open(filename, O_CREAT|O_WRONLY, S_IRWXU)) == -1) {
@@ -889,8 +1250,11 @@ xmldb_print(clixon_handle h,
         fprintf(f, "Datastore:  %s\n", keys[i]);
         fprintf(f, "  Session:  %u\n", de->de_id);
         fprintf(f, "  XML:      %p\n", de->de_xml);
+        fprintf(f, "  Shared:   %d\n", de->de_refs ? *de->de_refs : 0);
         fprintf(f, "  Modified: %d\n", de->de_modified);
         fprintf(f, "  Empty:    %d\n", de->de_empty);
+        fprintf(f, "  Journal:  %d\n", de->de_journal);
+        fprintf(f, "  Generation: %" PRIu64 "\n", de->de_generation);
     }
     retval = 0;
  done:
@@ -915,10 +1279,14 @@ xmldb_rename(clixon_handle h,
              const char    *newdb,
              const char    *suffix)
 {
-    int    retval = -1;
-    char  *old;
-    char  *fname = NULL;
-    cbuf  *cb = NULL;
+    int         retval = -1;
+    char       *old = NULL;
+    char       *fname = NULL;
+    char       *journal = NULL;
+    cbuf       *cb = NULL;
+    struct stat st = {0,};
+    cxobj      *xt = NULL;
+    int         ret;
 
     if ((xmldb_db2file(h, db, &old)) < 0)
         goto done;
@@ -932,12 +1300,35 @@ xmldb_rename(clixon_handle h,
     if (suffix)
         cprintf(cb, "%s", suffix);
     fname = cbuf_get(cb);
+    /* Compact journal into datastore file, if any, so that a single file is renamed */
+    if (xmldb_db2journal(h, db, &journal) < 0)
+        goto done;
+    if (lstat(journal, &st) == 0){
+        if ((ret = xmldb_get0(h, db, YB_MODULE, NULL, "/", 0, 0, &xt, NULL, NULL)) < 0)
+            goto done;
+        if (ret == 1 && xmldb_write_cache2file(h, db) < 0)
+            goto done;
+        if (xmldb_get0_free(h, &xt) < 0)
+            goto done;
+    }
     if ((rename(old, fname)) < 0) {
         clixon_err(OE_UNIX, errno, "rename: %s", strerror(errno));
         goto done;
     };
+    /* Rename journal along with datastore file if it could not be compacted */
+    if (lstat(journal, &st) == 0){
+        cprintf(cb, ".journal");
+        if ((rename(journal, cbuf_get(cb))) < 0) {
+            clixon_err(OE_UNIX, errno, "rename: %s", strerror(errno));
+            goto done;
+        }
+    }
     retval = 0;
  done:
+    if (xt)
+        xmldb_get0_free(h, &xt);
+    if (journal)
+        free(journal);
     if (cb)
         cbuf_free(cb);
     if (old)
@@ -962,6 +1353,8 @@ xmldb_populate(clixon_handle h,
     yang_stmt *yspec;
     int        ret;
 
+    if (xmldb_cache_unshare(h, db) < 0)
+        goto done;
     if ((x = xmldb_cache_get(h, db)) == NULL){
         clixon_err(OE_XML, 0, "XML cache not found");
         goto done;
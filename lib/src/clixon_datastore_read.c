@@ -71,10 +71,10 @@
 #include "clixon_data.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
+#include "clixon_netconf_lib.h"
 #include "clixon_json.h"
 #include "clixon_nacm.h"
 #include "clixon_path.h"
-#include "clixon_netconf_lib.h"
 #include "clixon_yang_module.h"
 #include "clixon_yang_parse_lib.h"
 #include "clixon_xml_map.h"
@@ -82,6 +82,7 @@
 #include "clixon_xml_io.h"
 #include "clixon_xml_nsctx.h"
 #include "clixon_datastore.h"
+#include "clixon_datastore_write.h"
 #include "clixon_datastore_read.h"
 
 #define handle(xh) (assert(text_handle_check(xh)==0),(struct text_handle *)(xh))
@@ -416,6 +417,33 @@ text_read_modstate(clixon_handle       h,
     return retval;
 }
 
+/*! Check if nacm is present and only contains default values
+ *
+ * @param[in]  xt    Top-level XML
+ * @param[in]  yspec YANG spec
+ * @retval     1     NACM is present and empty
+ * @retval     0     NACM is not present or not empty
+ */
+static int
+nacm_on_empty(cxobj     *xt,
+              yang_stmt *yspec)
+{
+    cxobj *xnacm;
+    cxobj *x;
+
+    if (yang_find(yspec, Y_MODULE, "ietf-netconf-acm") == NULL)
+        return 0;
+    if ((xnacm = xpath_first(xt, NULL, "nacm")) == NULL)
+        return 0;
+    /* Go through all children and check all are defaults */
+    x = NULL;
+    while ((x = xml_child_each(xnacm, x, CX_ELMNT)) != NULL) {
+        if (!xml_flag(x, XML_FLAG_DEFAULT))
+            return 0; /* not empty, at least one non-default child of nacm */
+    }
+    return 1;
+}
+
 /*! Check if nacm only contains default values, if so disable NACM
  *
  * @param[in]  xt    Top-level XML
@@ -428,25 +456,12 @@ disable_nacm_on_empty(cxobj     *xt,
                       yang_stmt *yspec)
 {
     int        retval = -1;
-    yang_stmt *ymod;
     cxobj    **vec = NULL;
     int        len = 0;
-    cxobj     *xnacm = NULL;
-    cxobj     *x;
     cxobj     *xb;
 
-    if ((ymod = yang_find(yspec, Y_MODULE, "ietf-netconf-acm")) == NULL)
-        goto ok;
-    if ((xnacm = xpath_first(xt, NULL, "nacm")) == NULL)
+    if (!nacm_on_empty(xt, yspec))
         goto ok;
-    /* Go through all children and check all are defaults, otherwise quit */
-    x = NULL;
-    while ((x = xml_child_each(xnacm, x, CX_ELMNT)) != NULL) {
-        if (!xml_flag(x, XML_FLAG_DEFAULT))
-            break;
-    }
-    if (x != NULL)
-        goto ok; /* not empty, at least one non-default child of nacm */
     if (clixon_xml_find_instance_id(xt, yspec, &vec, &len, "/nacm:nacm/nacm:enable-nacm") < 1)
         goto done;
     if (len){
@@ -570,6 +585,8 @@ xmldb_readfile(clixon_handle    h,
     cxobj           *x;
     yang_stmt       *yspec1 = NULL;
     struct xmldb_multi_read_arg mr = {0, };
+    int              nr;
+    uint64_t         gen = 0;
 
     if (yb != YB_MODULE && yb != YB_NONE){
         clixon_err(OE_XML, EINVAL, "yb is %d but should be module or none", yb);
@@ -642,6 +659,18 @@ xmldb_readfile(clixon_handle    h,
     x = NULL;
     while ((x = xml_find_type(x0, NULL, "body", CX_BODY)) != NULL)
         xml_purge(x);
+    /* Generation of datastore file, see CLICON_XMLDB_JOURNAL */
+    if ((x = xml_find_type(x0, CLIXON_LIB_PREFIX, "generation", CX_ATTR)) != NULL){
+        if (parse_uint64(xml_value(x), &gen, NULL) <= 0){
+            clixon_err(OE_DB, 0, "Datastore %s: invalid generation %s", db, xml_value(x));
+            goto done;
+        }
+        xml_purge(x);
+        if ((x = xml_find_type(x0, "xmlns", CLIXON_LIB_PREFIX, CX_ATTR)) != NULL)
+            xml_purge(x);
+    }
+    if (de)
+        de->de_generation = gen;
 
     xml_flag_set(x0, XML_FLAG_TOP);
     if (xml_child_nr(x0) == 0 && de)
@@ -734,6 +763,17 @@ xmldb_readfile(clixon_handle    h,
         if (xml_sort_recurse(x0) < 0)
             goto done;
     }
+    /* Replay edits written to journal since datastore file was last written */
+    if (clicon_option_bool(h, "CLICON_XMLDB_JOURNAL") &&
+        !clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
+        /* If yb is YB_NONE, x0 is yang bound only if there are records to replay */
+        if ((ret = xmldb_journal_replay(h, db, yb, yspec, x0, gen, &nr, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        if (de)
+            de->de_journal = nr;
+    }
     if (xp){
         *xp = x0;
         x0 = NULL;
@@ -765,6 +805,80 @@ xmldb_readfile(clixon_handle    h,
     goto done;
 }
 
+/*! Get cached XML tree of database, read it from file on cache miss
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Name of database
+ * @param[in]  yb     How to bind yang to XML top-level when parsing
+ * @param[in]  yspec  YANG spec
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpath  String with XPath syntax. or NULL for all
+ * @param[out] x0tp   Cached XML tree, owned by the cache
+ * @param[out] msdiff If set, return modules-state differences
+ * @param[out] xerr   XML error if retval is 0
+ * @retval     1      OK
+ * @retval     0      Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval    -1      Error
+ */
+static int
+xmldb_cache_load(clixon_handle     h,
+                 const char       *db,
+                 yang_bind         yb,
+                 yang_stmt        *yspec,
+                 cvec             *nsc,
+                 const char       *xpath,
+                 cxobj           **x0tp,
+                 modstate_diff_t  *msdiff,
+                 cxobj           **xerr)
+{
+    int        retval = -1;
+    cxobj     *x0t = NULL; /* (cached) top of tree */
+    db_elmnt  *de = NULL;
+    db_elmnt   de0 = {0,};
+    int        ret;
+
+    de = clicon_db_elmnt_get(h, db);
+    if (de == NULL || de->de_xml == NULL){ /* Cache miss, read XML from file */
+        /* If there is no xml x0 tree (in cache), then read it from file */
+        /* xml looks like: <top><config><x>... where "x" is a top-level symbol in a module */
+        if ((ret = xmldb_readfile(h, db, yb, yspec, &x0t, &de0, msdiff, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        /* Should we validate file if read from disk?
+         * No, argument against: we may want to have a semantically wrong file and wish to edit?
+         */
+        /* Add default global values (to make xpath below include defaults)
+         * Done before the tree is set as cache, it is not yet shared with other datastores
+         */
+        // Alt:  xmldb_populate(h, db)
+        if (yb != YB_NONE) {
+            if (xml_global_defaults(h, x0t, nsc, xpath, yspec, 0) < 0)
+                goto done;
+            /* Add default recursive values */
+            if (xml_default_recurse(x0t, 0, 0) < 0)
+                goto done;
+        }
+        xml_flag_set(x0t, XML_FLAG_CACHE_TOP);
+        de0.de_xml = x0t;
+        if (de){
+            de0.de_id = de->de_id;
+            de0.de_changes = de->de_changes;
+        }
+        clicon_db_elmnt_set(h, db, &de0); /* Content is copied */
+        x0t = NULL;
+    } /* x0t == NULL */
+    *x0tp = clicon_db_elmnt_get(h, db)->de_xml;
+    retval = 1;
+ done:
+    if (x0t)
+        xml_free(x0t);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Get content of database using xpath. return a set of matching sub-trees
  *
  * The function returns a minimal tree that includes all sub-trees that match
@@ -801,9 +915,7 @@ xmldb_get_cache(clixon_handle     h,
     cxobj    **xvec = NULL;
     size_t     xlen;
     int        i;
-    db_elmnt  *de = NULL;
     cxobj     *x1t = NULL;
-    db_elmnt   de0 = {0,};
     int        ret;
 
     clixon_debug(CLIXON_DBG_DATASTORE, "db %s", db);
@@ -815,33 +927,10 @@ xmldb_get_cache(clixon_handle     h,
         clixon_err(OE_YANG, ENOENT, "No yang spec");
         goto done;
     }
-    de = clicon_db_elmnt_get(h, db);
-    if (de == NULL || de->de_xml == NULL){ /* Cache miss, read XML from file */
-        /* If there is no xml x0 tree (in cache), then read it from file */
-        /* xml looks like: <top><config><x>... where "x" is a top-level symbol in a module */
-        if ((ret = xmldb_readfile(h, db, yb, yspec, &x0t, &de0, msdiff, xerr)) < 0)
-            goto done;
-        if (ret == 0)
-            goto fail;
-        /* Should we validate file if read from disk?
-         * No, argument against: we may want to have a semantically wrong file and wish to edit?
-         */
-        de0.de_xml = x0t;
-        if (de)
-            de0.de_id = de->de_id;
-        clicon_db_elmnt_set(h, db, &de0); /* Content is copied */
-        /* Add default global values (to make xpath below include defaults) */
-        // Alt:  xmldb_populate(h, db)
-        if (yb != YB_NONE) {
-            if (xml_global_defaults(h, x0t, nsc, xpath, yspec, 0) < 0)
-                goto done;
-            /* Add default recursive values */
-            if (xml_default_recurse(x0t, 0, 0) < 0)
-                goto done;
-        }
-    } /* x0t == NULL */
-    else
-        x0t = de->de_xml;
+    if ((ret = xmldb_cache_load(h, db, yb, yspec, nsc, xpath, &x0t, msdiff, xerr)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
     /* Here x0t looks like: <config>...</config> */
     /* Given the xpath, return a vector of matches in xvec 
      * Can we do everything in one go?
@@ -871,6 +960,16 @@ xmldb_get_cache(clixon_handle     h,
         }
     }
     else {
+        /* Marking modifies the cache, make sure it is not shared with other datastores */
+        if (xmldb_cache_unshare(h, db) < 0)
+            goto done;
+        if ((x0 = xmldb_cache_get(h, db)) != x0t){
+            x0t = x0;
+            free(xvec);
+            xvec = NULL;
+            if (xpath_vec(x0t, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
+                goto done;
+        }
         /* Iterate through the match vector
          * For every node found in x0, mark the tree up to t1
          * XXX can we do this directly from xvec?
@@ -882,8 +981,12 @@ xmldb_get_cache(clixon_handle     h,
         }
         if (xml_copy_marked(x0t, x1t) < 0) /* config */
             goto done;
-        if (xml_apply(x0t, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE)) < 0)
-            goto done;
+        /* Reset only the marked nodes and their ancestors in the cache */
+        for (i=0; i<xlen; i++){
+            x0 = xvec[i];
+            xml_flag_reset(x0, XML_FLAG_MARK);
+            xml_apply_ancestor(x0, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_CHANGE);
+        }
         if (xml_apply(x1t, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE)) < 0)
             goto done;
     }
@@ -946,9 +1049,9 @@ xmldb_get(clixon_handle    h,
  * @param[in]  yb     How to bind yang to XML top-level when parsing (if YB_NONE, no defaults)
  * @param[in]  nsc    External XML namespace context, or NULL
  * @param[in]  xpath  String with XPath syntax. or NULL for all
- * @param[in]  copy   Force copy. Overrides cache_zerocopy -> cache 
+ * @param[in]  copy   1: Return a copy. 0: May return the cached tree itself (zero-copy)
  * @param[in]  wdef   With-defaults parameter, see RFC 6243
- * @param[out] xret   Single return XML tree. Free with xml_free()
+ * @param[out] xret   Single return XML tree. Free with xmldb_get0_free()
  * @param[out] msdiff If set, return modules-state differences (upgrade code)
  * @param[out] xerr   XML error if retval is 0
  * @retval     1      OK
@@ -964,8 +1067,12 @@ xmldb_get(clixon_handle    h,
  *      # Error handling
  *   }
  *   ...
+ *   xmldb_get0_free(h, &xt);
  *   xml_free(xerr);
  * @endcode
+ * If copy is 0 and the complete datastore is requested, the cached tree is returned without
+ * copying it. The caller must then not modify it, and it is only valid until the datastore
+ * is modified. Use copy=1 if the tree is to be modified.
  * @see xml_nsctx_node  to get a XML namespace context from XML tree
  * @see xmldb_get for a copy version (old-style)
  * @note An annoying issue is one with default values and xpath miss:
@@ -994,10 +1101,32 @@ xmldb_get0(clixon_handle    h,
            modstate_diff_t *msdiff,
            cxobj          **xerr)
 {
-    int    retval = -1;
-    int    ret;
-    cxobj *x = NULL;
+    int        retval = -1;
+    int        ret;
+    cxobj     *x = NULL;
+    yang_stmt *yspec;
 
+    /* Zero-copy: return cached tree if it is returned as-is */
+    if (!copy &&
+        wdef != WITHDEFAULTS_EXPLICIT &&
+        (xpath == NULL || strcmp(xpath, "/") == 0)){
+        if ((yspec = clicon_dbspec_yang(h)) == NULL){
+            clixon_err(OE_YANG, ENOENT, "No yang spec");
+            goto done;
+        }
+        if ((ret = xmldb_cache_load(h, db, yb, yspec, nsc, xpath, &x, msdiff, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        /* Empty NACM is modified in returned tree, see disable_nacm_on_empty */
+        if (!clicon_option_bool(h, "CLICON_NACM_DISABLED_ON_EMPTY") ||
+            !nacm_on_empty(x, yspec)){
+            clixon_debug(CLIXON_DBG_DATASTORE, "db %s zero-copy", db);
+            *xret = x;
+            return 1;
+        }
+        x = NULL;
+    }
     if (wdef != WITHDEFAULTS_EXPLICIT)
         return xmldb_get_cache(h, db, yb, nsc, xpath, 0, xret, msdiff, xerr);
     if ((ret = xmldb_get_cache(h, db, yb, nsc, xpath, 0, &x, msdiff, xerr)) < 0)
@@ -1017,3 +1146,4 @@ xmldb_get0(clixon_handle    h,
     retval = 0;
     goto done;
 }
+
@@ -45,12 +45,14 @@
 #include <string.h>
 #include <limits.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <unistd.h>
 #include <dirent.h>
 #include <syslog.h>
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -68,14 +70,15 @@
 #include "clixon_log.h"
 #include "clixon_debug.h"
 #include "clixon_file.h"
+#include "clixon_xml_vec.h"
 #include "clixon_xml_sort.h"
 #include "clixon_options.h"
 #include "clixon_data.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
+#include "clixon_netconf_lib.h"
 #include "clixon_json.h"
 #include "clixon_nacm.h"
-#include "clixon_netconf_lib.h"
 #include "clixon_yang_type.h"
 #include "clixon_yang_module.h"
 #include "clixon_yang_schema_mount.h"
@@ -539,6 +542,7 @@ choice_other_match(cxobj              *x0,
             case OP_CREATE:
                 if (xml_purge(x0c) < 0)
                     goto done;
+                xml_flag_set(x0, XML_FLAG_DEL);
                 x0c = x0prev;
                 continue;
                 break;
@@ -576,6 +580,7 @@ choice_other_match(cxobj              *x0,
  * @param[in]  username User name of requestor for nacm
  * @param[in]  xnacm    NACM XML tree (only if !permit)
  * @param[in]  permit   If set, no NACM tests using xnacm required
+ * @param[in]  xbulk    If set, collect new list entries here instead of inserting them in x0p
  * @param[out] cbret    Initialized cligen buffer. Contains return XML if retval is 0.
  * @retval     1        OK
  * @retval     0        Failed (cbret set)
@@ -600,6 +605,7 @@ text_modify(clixon_handle       h,
             char               *username,
             cxobj              *xnacm,
             int                 permit,
+            clixon_xvec        *xbulk,
             cbuf               *cbret)
 {
     int        retval = -1;
@@ -627,6 +633,8 @@ text_modify(clixon_handle       h,
     char      *restype;
     int        ismount = 0;
     yang_stmt *mount_yspec = NULL;
+    clixon_xvec *xbulkc = NULL; /* New children of x0 to insert in bulk */
+    cxobj     *xc;
 
     if (x1 == NULL){
         clixon_err(OE_XML, EINVAL, "x1 is missing");
@@ -732,6 +740,8 @@ text_modify(clixon_handle       h,
                  * original object is not reverted.
                  */
                 if (x0){
+                    /* Record deletion in parent, see xmldb_changes_add */
+                    xml_flag_set(x0p, XML_FLAG_DEL);
                     xml_purge(x0);
                     x0 = NULL;
                 }
@@ -832,9 +842,15 @@ text_modify(clixon_handle       h,
                 }
             } /* x1bstr */
             if (changed){
-                if (xml_insert(x0p, x0, insert, valstr, NULL) < 0)
-                    goto done;
                 xml_flag_set(x0, XML_FLAG_ADD);
+                if (xbulk && insert == INS_LAST && yang_keyword_get(y0) == Y_LEAF_LIST){
+                    /* Inserted by parent, see xml_insert_bulk */
+                    if (clixon_xvec_append(xbulk, x0) < 0)
+                        goto done;
+                    changed = 0;
+                }
+                else if (xml_insert(x0p, x0, insert, valstr, NULL) < 0)
+                    goto done;
             }
             break;
         case OP_DELETE:
@@ -933,6 +949,8 @@ text_modify(clixon_handle       h,
                  * original object is not reverted.
                  */
                 if (x0){
+                    /* Record deletion in parent, see xmldb_changes_add */
+                    xml_flag_set(x0p, XML_FLAG_DEL);
                     xml_purge(x0);
                     x0 = NULL;
                 }
@@ -957,12 +975,15 @@ text_modify(clixon_handle       h,
                     permit = 1;
                 }
                 if (x0){
+                    /* Record deletion in parent, see xmldb_changes_add */
+                    xml_flag_set(x0p, XML_FLAG_DEL);
                     xml_purge(x0);
                 }
                 if ((x0 = xml_new(x1name, x0p, CX_ELMNT)) == NULL)
                     goto done;
                 if (xml_copy(x1, x0) < 0)
                     goto done;
+                xml_flag_set(x0, XML_FLAG_ADD);
                 break;
             } /* anyxml, anydata */
             if (x0==NULL){
@@ -1053,6 +1074,12 @@ text_modify(clixon_handle       h,
                 }
                 i++;
             }
+#ifdef XMLDB_BULK_MERGE
+            /* Many children: insert new list entries in bulk after second pass */
+            if (xml_child_nr_type(x1, CX_ELMNT) >= XMLDB_BULK_MERGE &&
+                (xbulkc = clixon_xvec_new()) == NULL)
+                goto done;
+#endif
             /* Second pass: Loop through children of the x1 modification tree again
              * Now potentially modify x0:s children 
              * Here x0vec contains one-to-one matching nodes of x1:s children.
@@ -1077,25 +1104,37 @@ text_modify(clixon_handle       h,
                     else{
                         if ((ret = text_modify(h, x0c, x0, x0t, x1c, x1t,
                                                yc, op,
-                                               username, xnacm, permit, cbret)) < 0)
+                                               username, xnacm, permit, xbulkc, cbret)) < 0)
                             goto done;
                     }
                 }
                 else if ((ret = text_modify(h, x0c, x0, x0t, x1c, x1t,
                                             yc, op,
-                                            username, xnacm, permit, cbret)) < 0)
+                                            username, xnacm, permit, xbulkc, cbret)) < 0)
                     goto done;
                 /* If xml return - ie netconf error xml tree, then stop and return OK */
                 if (ret == 0)
                     goto fail;
             }
+            if (xbulkc){
+                if (xml_insert_bulk(x0, xbulkc) < 0)
+                    goto done;
+                clixon_xvec_free(xbulkc);
+                xbulkc = NULL;
+            }
             if (changed){
 #ifdef XML_PARENT_CANDIDATE
                 xml_parent_candidate_set(x0, NULL);
 #endif
-                if (xml_insert(x0p, x0, insert, keystr, nscx1) < 0)
-                    goto done;
                 xml_flag_set(x0, XML_FLAG_ADD);
+                if (xbulk && insert == INS_LAST && yang_keyword_get(y0) == Y_LIST){
+                    /* Inserted by parent, see xml_insert_bulk */
+                    if (clixon_xvec_append(xbulk, x0) < 0)
+                        goto done;
+                    changed = 0;
+                }
+                else if (xml_insert(x0p, x0, insert, keystr, nscx1) < 0)
+                    goto done;
             }
             break;
         case OP_DELETE:
@@ -1135,11 +1174,20 @@ text_modify(clixon_handle       h,
         free(createstr);
     if (nscx1)
         xml_nsctx_free(nscx1);
-    /* Remove dangling added objects */
+    /* Remove dangling added objects
+     * Not a deletion: x0 was created above but never inserted in x0p */
     if (changed && x0 && xml_parent(x0)==NULL)
         xml_purge(x0);
     if (x0vec)
         free(x0vec);
+    if (xbulkc){ /* Remove collected objects not inserted on error */
+        for (i=0; i<clixon_xvec_len(xbulkc); i++){
+            xc = clixon_xvec_i(xbulkc, i);
+            if (xml_parent(xc) == NULL)
+                xml_free(xc);
+        }
+        clixon_xvec_free(xbulkc);
+    }
     return retval;
  fail: /* cbret set */
     retval = 0;
@@ -1214,6 +1262,7 @@ text_modify_top(clixon_handle       h,
                 while ((x0c = xml_child_i(x0t, 0)) != 0)
                     if (xml_purge(x0c) < 0)
                         goto done;
+                xml_flag_set(x0t, XML_FLAG_DEL);
                 break;
             default:
                 break;
@@ -1254,6 +1303,7 @@ text_modify_top(clixon_handle       h,
         while ((x0c = xml_child_i(x0t, 0)) != 0)
             if (xml_purge(x0c) < 0)
                 goto done;
+        xml_flag_set(x0t, XML_FLAG_DEL);
     }
     /* Loop through children of the modification tree */
     x1c = NULL;
@@ -1289,11 +1339,12 @@ text_modify_top(clixon_handle       h,
             /* There is a match but is should be replaced (choice)*/
             if (xml_purge(x0c) < 0)
                 goto done;
+            xml_flag_set(x0t, XML_FLAG_DEL);
             x0c = NULL;
         }
         if ((ret = text_modify(h, x0c, x0t, x0t, x1c, x1t,
                                yc, op,
-                               username, xnacm, permit, cbret)) < 0)
+                               username, xnacm, permit, NULL, cbret)) < 0)
             goto done;
         /* If xml return - ie netconf error xml tree, then stop and return OK */
         if (ret == 0)
@@ -1351,6 +1402,472 @@ xml_mark_cache_dirty(cxobj *x,
     return 2;
 }
 
+/*! Create change set node corresponding to datastore node, with list keys
+ *
+ * @param[in]  xs   Change set parent node
+ * @param[in]  x0   Datastore node
+ * @param[in]  y    Yang spec of x0
+ * @param[out] xsp  New change set node
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xmldb_changes_node(cxobj     *xs,
+                   cxobj     *x0,
+                   yang_stmt *y,
+                   cxobj    **xsp)
+{
+    int     retval = -1;
+    cxobj  *xn = NULL;
+    cxobj  *x0k;
+    cxobj  *xk;
+    cvec   *cvk;
+    cg_var *cvi;
+    char   *keyname;
+
+    if ((xn = xml_new(xml_name(x0), NULL, CX_ELMNT)) == NULL)
+        goto done;
+    if (xml_copy_one(x0, xn) < 0)
+        goto done;
+    switch (yang_keyword_get(y)){
+    case Y_LIST:
+        cvk = yang_cvec_get(y); /* Use Y_LIST cache, see ys_populate_list() */
+        cvi = NULL;
+        while ((cvi = cvec_each(cvk, cvi)) != NULL) {
+            keyname = cv_string_get(cvi);
+            if ((x0k = xml_find_type(x0, NULL, keyname, CX_ELMNT)) == NULL)
+                continue;
+            if ((xk = xml_new(keyname, xn, CX_ELMNT)) == NULL)
+                goto done;
+            if (xml_copy(x0k, xk) < 0)
+                goto done;
+        }
+        if (xml_sort(xn) < 0)
+            goto done;
+        break;
+    case Y_LEAF_LIST:
+        if ((x0k = xml_body_get(x0)) != NULL){
+            if ((xk = xml_new("body", xn, CX_BODY)) == NULL)
+                goto done;
+            if (xml_copy_one(x0k, xk) < 0)
+                goto done;
+        }
+        break;
+    default:
+        break;
+    }
+    xml_flag_set(xn, XML_FLAG_CHANGE);
+    if (xml_insert(xs, xn, INS_LAST, NULL, NULL) < 0)
+        goto done;
+    *xsp = xn;
+    xn = NULL;
+    retval = 0;
+ done:
+    if (xn)
+        xml_free(xn);
+    return retval;
+}
+
+/*! Mark change set node as a complete subtree change
+ *
+ * @param[in]  xs   Change set node
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xmldb_changes_subtree(cxobj *xs)
+{
+    cxobj *xc;
+    cxobj *xprev = NULL;
+
+    xml_flag_set(xs, XML_FLAG_ADD);
+    xc = NULL;
+    while ((xc = xml_child_each(xs, xc, CX_ELMNT)) != NULL) {
+        if (xml_flag(xc, XML_FLAG_CHANGE) == 0){ /* List key */
+            xprev = xc;
+            continue;
+        }
+        if (xml_purge(xc) < 0)
+            return -1;
+        xc = xprev;
+    }
+    return 0;
+}
+
+/*! Add changes of an edit to a datastore change set
+ *
+ * Follow the nodes marked by text_modify and add them to the change set.
+ * Added or replaced nodes (XML_FLAG_ADD) are complete subtree changes, nodes where
+ * children are deleted (XML_FLAG_DEL) are marked for lock-step comparison of children
+ * @param[in]  x0   Datastore node, marked with XML_FLAG_ADD/DEL/CHANGE
+ * @param[in]  xs   Corresponding change set node
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xmldb_changes_get
+ * @see xml_diff_changes
+ */
+static int
+xmldb_changes_add(cxobj *x0,
+                  cxobj *xs)
+{
+    int        retval = -1;
+    cxobj     *x0c;
+    cxobj     *xsc;
+    yang_stmt *yc;
+
+    if (xml_flag(xs, XML_FLAG_ADD))
+        goto ok;
+    if (xml_flag(x0, XML_FLAG_DEL))
+        xml_flag_set(xs, XML_FLAG_DEL);
+    x0c = NULL;
+    while ((x0c = xml_child_each(x0, x0c, CX_ELMNT)) != NULL) {
+        if (xml_flag(x0c, XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE) == 0)
+            continue;
+        /* Ordered-by user and nodes without yang are compared with siblings */
+        if ((yc = xml_spec(x0c)) == NULL ||
+            yang_find(yc, Y_ORDERED_BY, "user") != NULL){
+            if (xmldb_changes_subtree(xs) < 0)
+                goto done;
+            goto ok;
+        }
+        if (match_base_child(xs, x0c, yc, &xsc) < 0)
+            goto done;
+        if (xsc != NULL && xml_flag(xsc, XML_FLAG_CHANGE) == 0)
+            xsc = NULL; /* List key */
+        if (xsc == NULL &&
+            xmldb_changes_node(xs, x0c, yc, &xsc) < 0)
+            goto done;
+        if (xml_flag(x0c, XML_FLAG_ADD)){
+            if (xmldb_changes_subtree(xsc) < 0)
+                goto done;
+        }
+        else if (xmldb_changes_add(x0c, xsc) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Encode an edit as a datastore journal record
+ *
+ * A record is on the form:
+ *   <edit operation="merge" generation="17" xmlns:..><config>...</config></edit>\n
+ * where namespaces in scope of the modification tree are declared on the edit element,
+ * and generation is the generation of the datastore file the edit applies to.
+ * A record always ends with "</edit>\n", which cannot occur inside a record since the
+ * modification tree is printed without newlines.
+ * @param[in]  op     Top-level operation
+ * @param[in]  x1     Modification tree. Top-level symbol is config
+ * @param[in]  gen    Generation of datastore file
+ * @param[out] cb     Record is appended to this buffer
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xmldb_journal_replay
+ */
+static int
+xmldb_journal_record(enum operation_type op,
+                     cxobj              *x1,
+                     uint64_t            gen,
+                     cbuf               *cb)
+{
+    int     retval = -1;
+    cvec   *nsc = NULL;
+    cg_var *cv = NULL;
+    char   *prefix;
+
+    if (xml_nsctx_node(x1, &nsc) < 0)
+        goto done;
+    cprintf(cb, "<edit operation=\"%s\" generation=\"%" PRIu64 "\"",
+            xml_operation2str(op), gen);
+    while ((cv = cvec_each(nsc, cv)) != NULL){
+        if ((prefix = cv_name_get(cv)) != NULL)
+            cprintf(cb, " xmlns:%s=\"%s\"", prefix, cv_string_get(cv));
+        else
+            cprintf(cb, " xmlns=\"%s\"", cv_string_get(cv));
+    }
+    cprintf(cb, ">");
+    if (clixon_xml2cbuf(cb, x1, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    cprintf(cb, "</edit>\n");
+    retval = 0;
+ done:
+    if (nsc)
+        xml_nsctx_free(nsc);
+    return retval;
+}
+
+/*! Append a record to datastore journal and sync it to disk
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Datastore
+ * @param[in]  cb     Encoded record
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see CLICON_XMLDB_JOURNAL
+ */
+static int
+xmldb_journal_append(clixon_handle h,
+                     const char   *db,
+                     cbuf         *cb)
+{
+    int       retval = -1;
+    char     *filename = NULL;
+    int       fd = -1;
+    db_elmnt *de;
+
+    if (xmldb_db2journal(h, db, &filename) < 0)
+        goto done;
+    if ((fd = open(filename, O_CREAT|O_WRONLY|O_APPEND, S_IRWXU)) < 0) {
+        clixon_err(OE_UNIX, errno, "open(%s)", filename);
+        goto done;
+    }
+    if (write(fd, cbuf_get(cb), cbuf_len(cb)) != cbuf_len(cb)){
+        clixon_err(OE_UNIX, errno, "write(%s)", filename);
+        goto done;
+    }
+    if (fsync(fd) < 0){
+        clixon_err(OE_UNIX, errno, "fsync(%s)", filename);
+        goto done;
+    }
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+        de->de_journal++;
+    retval = 0;
+ done:
+    if (fd != -1)
+        close(fd);
+    if (filename)
+        free(filename);
+    return retval;
+}
+
+/*! Read datastore journal into memory and remove a truncated trailing record, if any
+ *
+ * A record is truncated if the backend was stopped while it was appended. It was then
+ * never acknowledged and is removed so that it is not followed by new records.
+ * @param[in]  filename Journal filename
+ * @param[out] bufp     Journal contents, NULL if no journal. Free with free()
+ * @param[out] lenp     Length of complete records in buf
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+xmldb_journal_read(const char *filename,
+                   char      **bufp,
+                   size_t     *lenp)
+{
+    int         retval = -1;
+    int         fd = -1;
+    struct stat st;
+    char       *buf = NULL;
+    size_t      len = 0;
+    ssize_t     n;
+    char       *p;
+    char       *q;
+
+    *bufp = NULL;
+    *lenp = 0;
+    if ((fd = open(filename, O_RDWR)) < 0){
+        if (errno == ENOENT)
+            goto ok;
+        clixon_err(OE_UNIX, errno, "open(%s)", filename);
+        goto done;
+    }
+    if (fstat(fd, &st) < 0){
+        clixon_err(OE_UNIX, errno, "fstat(%s)", filename);
+        goto done;
+    }
+    if ((buf = malloc(st.st_size + 1)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    while (len < st.st_size){
+        if ((n = read(fd, buf + len, st.st_size - len)) < 0){
+            if (errno == EINTR)
+                continue;
+            clixon_err(OE_UNIX, errno, "read(%s)", filename);
+            goto done;
+        }
+        if (n == 0)
+            break;
+        len += n;
+    }
+    buf[len] = '\0';
+    /* Find end of last complete record */
+    p = buf;
+    while ((q = strstr(p, "</edit>\n")) != NULL)
+        p = q + strlen("</edit>\n");
+    if (p - buf < len){
+        clixon_log(NULL, LOG_WARNING, "Journal %s: removing truncated record of %zu bytes",
+                   filename, len - (p - buf));
+        len = p - buf;
+        buf[len] = '\0';
+        if (ftruncate(fd, len) < 0){
+            clixon_err(OE_UNIX, errno, "ftruncate(%s)", filename);
+            goto done;
+        }
+        if (fsync(fd) < 0){
+            clixon_err(OE_UNIX, errno, "fsync(%s)", filename);
+            goto done;
+        }
+    }
+    *bufp = buf;
+    buf = NULL;
+    *lenp = len;
+ ok:
+    retval = 0;
+ done:
+    if (buf)
+        free(buf);
+    if (fd != -1)
+        close(fd);
+    return retval;
+}
+
+/*! Replay datastore journal on a tree read from the datastore file
+ *
+ * Each record is applied as an edit with NACM disabled, since it was already
+ * accepted when it was originally written.
+ * Records of another generation than the datastore file are stale, ie they were written
+ * before the file was compacted, and are skipped. This makes replay idempotent.
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Datastore
+ * @param[in]  yb     How x0 is bound to yang. If YB_NONE, x0 is bound only if a record is replayed
+ * @param[in]  yspec  Top-level yang spec
+ * @param[in]  x0     Datastore top-level tree
+ * @param[in]  gen    Generation of datastore file
+ * @param[out] nr     Number of records replayed
+ * @param[out] xerr   XML error if retval is 0
+ * @retval     1      OK
+ * @retval     0      Journal record could not be applied, xerr set
+ * @retval    -1      Error
+ * @see xmldb_journal_record
+ */
+int
+xmldb_journal_replay(clixon_handle h,
+                     const char   *db,
+                     yang_bind     yb,
+                     yang_stmt    *yspec,
+                     cxobj        *x0,
+                     uint64_t      gen,
+                     int          *nr,
+                     cxobj       **xerr)
+{
+    int                 retval = -1;
+    char               *filename = NULL;
+    char               *buf = NULL;
+    size_t              len;
+    char               *p;
+    char               *q;
+    char                c;
+    cxobj              *xj = NULL;
+    cxobj              *xe;
+    cxobj              *x1;
+    char               *str;
+    enum operation_type op;
+    uint64_t            g;
+    cbuf               *cbret = NULL;
+    int                 ret;
+
+    *nr = 0;
+    if (xmldb_db2journal(h, db, &filename) < 0)
+        goto done;
+    if (xmldb_journal_read(filename, &buf, &len) < 0)
+        goto done;
+    if (buf == NULL || len == 0)
+        goto ok;
+    clixon_debug(CLIXON_DBG_DATASTORE, "Replaying journal %s generation %" PRIu64, filename, gen);
+    if ((cbret = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    p = buf;
+    while ((q = strstr(p, "</edit>\n")) != NULL){
+        q += strlen("</edit>\n");
+        c = *q;
+        *q = '\0';
+        if (xj){
+            xml_free(xj);
+            xj = NULL;
+        }
+        ret = clixon_xml_parse_string(p, YB_NONE, yspec, &xj, xerr);
+        *q = c;
+        p = q;
+        if (ret < 0)
+            goto done;
+        if ((xe = xml_child_i_type(xj, 0, CX_ELMNT)) == NULL)
+            continue;
+        g = 0;
+        if ((str = xml_find_value(xe, "generation")) != NULL &&
+            parse_uint64(str, &g, NULL) <= 0){
+            clixon_err(OE_DB, 0, "Journal %s: invalid generation %s", filename, str);
+            goto done;
+        }
+        if (g != gen){
+            clixon_debug(CLIXON_DBG_DATASTORE, "Skipping stale record of generation %" PRIu64, g);
+            continue;
+        }
+        op = OP_MERGE;
+        if ((str = xml_find_value(xe, "operation")) != NULL &&
+            xml_operation(str, &op) < 0)
+            goto done;
+        if ((x1 = xml_find_type(xe, NULL, NETCONF_INPUT_CONFIG, CX_ELMNT)) == NULL){
+            clixon_err(OE_DB, 0, "Journal %s: no config in record %d", filename, *nr);
+            goto done;
+        }
+        /* Journal edits requires yang binding of the datastore tree */
+        if (*nr == 0 && yb == YB_NONE){
+            if ((ret = xml_bind_yang(h, x0, YB_MODULE, yspec, xerr)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+            if (xml_sort_recurse(x0) < 0)
+                goto done;
+        }
+        if ((ret = xml_bind_yang(h, x1, YB_MODULE, yspec, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        cbuf_reset(cbret);
+        if ((ret = text_modify_top(h, x0, x1, yspec, op, NULL, NULL, 1, cbret)) < 0)
+            goto done;
+        if (ret == 0){
+            if (xerr && clixon_xml_parse_string(cbuf_get(cbret), YB_NONE, NULL, xerr, NULL) < 0)
+                goto done;
+            goto fail;
+        }
+        (*nr)++;
+    }
+    if (*nr == 0)
+        goto ok;
+    /* Same cleanup as after edit in xmldb_put, except defaults which are added by reader */
+    if (xml_tree_prune_flagged_sub(x0, XML_FLAG_NONE, 0, NULL) <0)
+        goto done;
+    if (xml_apply(x0, CX_ELMNT, xml_mark_added_ancestors, (void*)(XML_FLAG_ADD|XML_FLAG_DEL)) < 0)
+        goto done;
+    if (xml_default_nopresence(x0, 3, XML_FLAG_ADD|XML_FLAG_DEL) < 0)
+        goto done;
+    if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+                  (void*)(XML_FLAG_NONE|XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE)) < 0)
+        goto done;
+ ok:
+    retval = 1;
+ done:
+    if (cbret)
+        cbuf_free(cbret);
+    if (xj)
+        xml_free(xj);
+    if (buf)
+        free(buf);
+    if (filename)
+        free(filename);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Modify database given an xml tree and an operation
  *
  * @param[in]  h      CLICON handle
@@ -1395,6 +1912,9 @@ xmldb_put(clixon_handle       h,
     cvec       *nsc = NULL; /* nacm namespace context */
     int         firsttime = 0;
     cxobj      *xerr = NULL;
+    cbuf       *cbj = NULL; /* journal record */
+    int         journal;
+    cxobj      *xs = NULL;  /* change set */
 
     clixon_debug(CLIXON_DBG_DATASTORE|CLIXON_DBG_DETAIL, "db %s", db);
     if (cbret == NULL){
@@ -1410,14 +1930,24 @@ xmldb_put(clixon_handle       h,
                    xml_name(x1), NETCONF_INPUT_CONFIG);
         goto done;
     }
+    /* Cache may be shared with other datastores after xmldb_copy */
+    if (xmldb_cache_unshare(h, db) < 0)
+        goto done;
+    /* Change sets are relative to running */
+    if (strcmp(db, "running") == 0 &&
+        xmldb_changes_reset(h, db) < 0)
+        goto done;
     if ((de = clicon_db_elmnt_get(h, db)) != NULL){
         x0 = de->de_xml; /* XXX flag is not XML_FLAG_TOP */
+        /* Change set is kept only if edit succeeds */
+        xs = de->de_changes;
+        de->de_changes = NULL;
     }
     /* If there is no xml x0 tree (in cache), then read it from file */
     if (x0 == NULL){
         firsttime++; /* to avoid leakage on error, see fail from text_modify */
         /* xml looks like: <top><config><x>... where "x" is a top-level symbol in a module */
-        if ((ret = xmldb_readfile(h, db, YB_MODULE, yspec, &x0, de, NULL, &xerr)) < 0)
+        if ((ret = xmldb_readfile(h, db, YB_MODULE, yspec, &x0, de?de:&de0, NULL, &xerr)) < 0)
             goto done;
         if (ret == 0)
             goto fail;
@@ -1428,6 +1958,18 @@ xmldb_put(clixon_handle       h,
                    xml_name(x0), DATASTORE_TOP_SYMBOL);
         goto done;
     }
+    /* Journal the edit, must be encoded before modification since x1 may change */
+    journal = x1 != NULL &&
+        clicon_option_bool(h, "CLICON_XMLDB_JOURNAL") &&
+        !clicon_option_bool(h, "CLICON_XMLDB_MULTI");
+    if (journal){
+        if ((cbj = cbuf_new()) == NULL){
+            clixon_err(OE_XML, errno, "cbuf_new");
+            goto done;
+        }
+        if (xmldb_journal_record(op, x1, de?de->de_generation:de0.de_generation, cbj) < 0)
+            goto done;
+    }
     /* Here x0 looks like: <config>...</config> */
     xnacm = clicon_nacm_cache(h);
     permit = (xnacm==NULL);
@@ -1468,16 +2010,30 @@ xmldb_put(clixon_handle       h,
     /* Add default recursive values */
     if (xml_default_recurse(x0, 0, XML_FLAG_ADD|XML_FLAG_DEL) < 0)
         goto done;
+    /* Add edit to change set */
+    if (xs != NULL && xmldb_changes_add(x0, xs) < 0)
+        goto done;
+    xml_flag_reset(x0, XML_FLAG_DEL);
     /* Write back to datastore cache if first time */
     if (de != NULL)
         de0 = *de;
-    if (de0.de_xml == NULL)
+    if (de0.de_xml == NULL){
+        xml_flag_set(x0, XML_FLAG_CACHE_TOP);
         de0.de_xml = x0;
+    }
+    de0.de_changes = xs;
+    xs = NULL;
     de0.de_empty = (xml_child_nr(de0.de_xml) == 0);
     clicon_db_elmnt_set(h, db, &de0);
     /* Write cache to file unless volatile (ie stop syncing to store) */
     if (xmldb_volatile_get(h, db) == 0){
-        if (xmldb_write_cache2file(h, db) < 0)
+        /* Append edit to journal, or write complete cache to file (which compacts journal) */
+        if (journal &&
+            de0.de_journal < clicon_option_int(h, "CLICON_XMLDB_JOURNAL_COMPACT")){
+            if (xmldb_journal_append(h, db, cbj) < 0)
+                goto done;
+        }
+        else if (xmldb_write_cache2file(h, db) < 0)
             goto done;
         /* Clear flags from previous steps + dirty */
         if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
@@ -1493,6 +2049,10 @@ xmldb_put(clixon_handle       h,
     retval = 1;
  done:
     clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "retval:%d", retval);
+    if (xs)
+        xml_free(xs);
+    if (cbj)
+        cbuf_free(cbj);
     if (xerr)
         xml_free(xerr);
     if (nsc)
@@ -1660,6 +2220,62 @@ xmldb_dump(clixon_handle     h,
     return retval;
 }
 
+/*! Generation of a new datastore file, unique across datastores and restarts
+ *
+ * @param[in]  prev  Generation of previous datastore file
+ * @retval     gen   New generation
+ * @see CLICON_XMLDB_JOURNAL
+ */
+static uint64_t
+xmldb_generation_next(uint64_t prev)
+{
+    struct timeval tv;
+    uint64_t       gen;
+
+    gettimeofday(&tv, NULL);
+    gen = (uint64_t)tv.tv_sec*1000000 + tv.tv_usec;
+    if (gen <= prev)
+        gen = prev + 1;
+    return gen;
+}
+
+/*! Sync directory of a file to disk, eg after a rename
+ *
+ * @param[in]  filename  File in directory
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+xmldb_dir_sync(const char *filename)
+{
+    int   retval = -1;
+    char *dir = NULL;
+    char *p;
+    int   fd = -1;
+
+    if ((dir = strdup(filename)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if ((p = strrchr(dir, '/')) != NULL)
+        *p = '\0';
+    if ((fd = open(p?dir:".", O_RDONLY)) < 0){
+        clixon_err(OE_UNIX, errno, "open(%s)", dir);
+        goto done;
+    }
+    if (fsync(fd) < 0){
+        clixon_err(OE_UNIX, errno, "fsync(%s)", dir);
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (fd != -1)
+        close(fd);
+    if (dir)
+        free(dir);
+    return retval;
+}
+
 /*! Given datastore, get cache and format, set wdef, add modstate and print to multiple files
  *
  * Also add mod-state if applicable
@@ -1679,8 +2295,15 @@ xmldb_write_cache2file(clixon_handle h,
     withdefaults_type wdef = WITHDEFAULTS_EXPLICIT;
     int               pretty;
     int               multi;
+    int               journal;
     FILE             *f = NULL;
     char             *dbfile = NULL;
+    cbuf             *cbtmp = NULL;
+    db_elmnt         *de;
+    uint64_t          gen = 0;
+    char              genstr[24];
+    cxobj            *xa = NULL;
+    cxobj            *xns = NULL;
 
     if ((xt = xmldb_cache_get(h, db)) == NULL){
         clixon_err(OE_XML, 0, "XML cache not found");
@@ -1688,6 +2311,7 @@ xmldb_write_cache2file(clixon_handle h,
     }
     pretty = clicon_option_bool(h, "CLICON_XMLDB_PRETTY");
     multi = clicon_option_bool(h, "CLICON_XMLDB_MULTI");
+    journal = clicon_option_bool(h, "CLICON_XMLDB_JOURNAL") && !multi;
     if ((formatstr = clicon_option_str(h, "CLICON_XMLDB_FORMAT")) != NULL){
         if ((format = format_str2int(formatstr)) < 0){
             clixon_err(OE_XML, 0, "Format %s invalid", formatstr);
@@ -1696,14 +2320,64 @@ xmldb_write_cache2file(clixon_handle h,
     }
     if (xmldb_db2file(h, db, &dbfile) < 0)
         goto done;
-    if ((f = fopen(dbfile, "w")) == NULL){
-        clixon_err(OE_CFG, errno, "fopen(%s)", dbfile);
+    if (journal){
+        /* Compact journal: write file with a new generation to a temporary file and rename it.
+         * Journal records of the previous generation are then stale.
+         */
+        if ((cbtmp = cbuf_new()) == NULL){
+            clixon_err(OE_XML, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cbtmp, "%s.tmp", dbfile);
+        /* Generation is only recorded in XML files, otherwise it remains 0 */
+        if (format == FORMAT_XML){
+            if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+                gen = de->de_generation;
+            gen = xmldb_generation_next(gen);
+            snprintf(genstr, sizeof(genstr), "%" PRIu64, gen);
+            xns = xml_find_type(xt, "xmlns", CLIXON_LIB_PREFIX, CX_ATTR);
+            if ((xa = xml_add_attr(xt, "generation", genstr, CLIXON_LIB_PREFIX,
+                                   xns?NULL:CLIXON_LIB_NS)) == NULL)
+                goto done;
+            if (xns == NULL)
+                xns = xml_find_type(xt, "xmlns", CLIXON_LIB_PREFIX, CX_ATTR);
+            else
+                xns = NULL; /* Not added here */
+        }
+    }
+    if ((f = fopen(cbtmp?cbuf_get(cbtmp):dbfile, "w")) == NULL){
+        clixon_err(OE_CFG, errno, "fopen(%s)", cbtmp?cbuf_get(cbtmp):dbfile);
         goto done;
     }
     if (xmldb_dump(h, f, xt, format, pretty, wdef, multi, db) < 0)
         goto done;
+    if (journal){
+        if (fflush(f) != 0 || fsync(fileno(f)) < 0){
+            clixon_err(OE_UNIX, errno, "fsync(%s)", cbuf_get(cbtmp));
+            goto done;
+        }
+        fclose(f);
+        f = NULL;
+        if (rename(cbuf_get(cbtmp), dbfile) < 0){
+            clixon_err(OE_UNIX, errno, "rename(%s)", dbfile);
+            goto done;
+        }
+        if (xmldb_dir_sync(dbfile) < 0)
+            goto done;
+        if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+            de->de_generation = gen;
+    }
+    /* Complete cache is written, journal not needed anymore */
+    if (xmldb_journal_reset(h, db) < 0)
+        goto done;
     retval = 0;
  done:
+    if (xa)
+        xml_purge(xa);
+    if (xns)
+        xml_purge(xns);
+    if (cbtmp)
+        cbuf_free(cbtmp);
     if (dbfile)
         free(dbfile);
     if (f)
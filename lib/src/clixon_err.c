@@ -117,6 +117,9 @@ static int  _err_subnr      = 0;
 /* Clixon error reason */
 static char _err_reason[ERR_STRLEN] = {0, };
 
+/* Discard errors in this thread, see clixon_err_discard_set */
+static __thread int _err_discard = 0;
+
 /*
  * Error descriptions. Must stop with NULL element.
  */
@@ -229,6 +232,18 @@ clixon_err_reset(void)
     return 0;
 }
 
+/*! Discard errors reported in the calling thread
+ *
+ * Worker threads cannot log or call plugin error callbacks, and do not touch the
+ * global error state. The caller detects errors from return values only.
+ * @param[in] discard  If set, errors in the calling thread are discarded
+ */
+void
+clixon_err_discard_set(int discard)
+{
+    _err_discard = discard;
+}
+
 /*! Find error category struct given name
  *
  * @param[in] category Error category
@@ -423,6 +438,8 @@ clixon_err_fn(clixon_handle h,
     va_list ap;
     cbuf   *cb = NULL;
 
+    if (_err_discard)
+        return 0;
     if (h == NULL)     /* Accept NULL, use saved clixon handle */
         h = _err_clixon_h;
     if (xerr){
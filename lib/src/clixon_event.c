@@ -50,9 +50,14 @@
 #include <string.h>
 #include <signal.h>
 #include <syslog.h>
+#include <limits.h>
+#include <poll.h>
 #include <sys/param.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#ifdef EVENT_EPOLL
+#include <sys/epoll.h>
+#endif
 
 #include <cligen/cligen.h>
 
@@ -74,6 +79,16 @@
  */
 #define EVENT_STRLEN 32
 
+/* Max number of ready file descriptors returned by one epoll_wait */
+#define EVENT_EPOLL_MAXEVENTS 64
+
+/* Name of wait function for logging */
+#ifdef EVENT_EPOLL
+#define EVENT_WAIT_STR "epoll_wait"
+#else
+#define EVENT_WAIT_STR "select"
+#endif
+
 /*
  * Types
  */
@@ -83,7 +98,10 @@ struct event_data{
     enum {EVENT_FD, EVENT_TIME} e_type;                 /* Type of event */
     int                         e_fd;                   /* File descriptor */
     int                         e_prio;                 /* 1: high-prio FD:s only*/
+    int                         e_write;                /* FD: call when writable, not readable */
     struct timeval              e_time;                 /* Timeout */
+    uint64_t                    e_seq;                  /* Timeout: registration order */
+    struct event_data          *e_fdnext;               /* FD: next registration of same fd */
     void                       *e_arg;                  /* Function argument */
     char                        e_string[EVENT_STRLEN]; /* String for debugging */
 };
@@ -93,7 +111,17 @@ struct event_data{
  * XXX consider use handle variables instead of global
  */
 static struct event_data *ee = NULL;
-static struct event_data *ee_timers = NULL;
+
+/* Timeouts as a binary min-heap ordered by timeout and registration order */
+static struct event_data **ee_timers = NULL;
+static int                 ee_timers_len = 0;
+static int                 ee_timers_size = 0;
+static uint64_t            ee_timers_seq = 0;
+
+#ifdef EVENT_EPOLL
+/* epoll file descriptor, created on first file descriptor registration */
+static int _ee_epfd = -1;
+#endif
 
 /* Set if element in ee is deleted (clixon_event_unreg_fd). Check in ee loops */
 static int _ee_unreg = 0;
@@ -168,6 +196,135 @@ clicon_sig_ignore_get(void)
     return _clicon_sig_ignore;
 }
 
+#ifdef EVENT_EPOLL
+/*! Get epoll events of a chain of registrations of the same fd
+ *
+ * @param[in]  e    First registration of fd
+ * @retval     ev   EPOLLIN and/or EPOLLOUT
+ */
+static uint32_t
+event_epoll_events(struct event_data *e)
+{
+    uint32_t events = 0;
+
+    for (; e; e = e->e_fdnext)
+        events |= e->e_write ? EPOLLOUT : EPOLLIN;
+    return events;
+}
+
+/*! Get first registration of fd, ie the one in epoll
+ *
+ * @param[in]  fd   File descriptor
+ * @retval     e    First registration
+ * @retval     NULL Not registered
+ */
+static struct event_data *
+event_epoll_first(int fd)
+{
+    struct event_data *e;
+    struct event_data *e1;
+
+    for (e = ee; e; e = e->e_next){
+        if (e->e_type != EVENT_FD || e->e_fd != fd)
+            continue;
+        for (e1 = ee; e1; e1 = e1->e_next)
+            if (e1->e_fdnext == e)
+                break;
+        if (e1 == NULL)
+            return e;
+    }
+    return NULL;
+}
+
+/*! Add file descriptor event to epoll
+ *
+ * The first registration of a file descriptor is added to epoll, subsequent registrations
+ * of the same fd are chained to it, since epoll only allows one entry per fd.
+ * @param[in]  e    Event, not yet in ee list
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+event_epoll_add(struct event_data *e)
+{
+    struct epoll_event  ev = {0,};
+    struct event_data  *e0;
+    struct event_data  *e1;
+
+    if (_ee_epfd == -1 &&
+        (_ee_epfd = epoll_create1(EPOLL_CLOEXEC)) < 0){
+        clixon_err(OE_EVENTS, errno, "epoll_create1");
+        return -1;
+    }
+    if ((e0 = event_epoll_first(e->e_fd)) != NULL){ /* Already registered, chain it */
+        for (e1 = e0; e1->e_fdnext; e1 = e1->e_fdnext)
+            ;
+        e1->e_fdnext = e;
+        ev.events = event_epoll_events(e0);
+        ev.data.ptr = e0;
+        if (epoll_ctl(_ee_epfd, EPOLL_CTL_MOD, e->e_fd, &ev) < 0){
+            e1->e_fdnext = NULL;
+            clixon_err(OE_EVENTS, errno, "epoll_ctl MOD %s", e->e_string);
+            return -1;
+        }
+        return 0;
+    }
+    ev.events = event_epoll_events(e);
+    ev.data.ptr = e;
+    if (epoll_ctl(_ee_epfd, EPOLL_CTL_ADD, e->e_fd, &ev) < 0){
+        clixon_err(OE_EVENTS, errno, "epoll_ctl ADD %s", e->e_string);
+        return -1;
+    }
+    return 0;
+}
+
+/*! Remove file descriptor event from epoll
+ *
+ * @param[in]  e    Event, still in ee list
+ * @note fd may already be closed, in which case it is already removed from epoll
+ */
+static void
+event_epoll_del(struct event_data *e)
+{
+    struct epoll_event  ev = {0,};
+    struct event_data  *e1;
+
+    for (e1 = ee; e1; e1 = e1->e_next)
+        if (e1->e_fdnext == e){ /* Not first registration, unchain */
+            e1->e_fdnext = e->e_fdnext;
+            if ((e1 = event_epoll_first(e->e_fd)) != NULL){
+                ev.events = event_epoll_events(e1);
+                ev.data.ptr = e1;
+                epoll_ctl(_ee_epfd, EPOLL_CTL_MOD, e->e_fd, &ev);
+            }
+            return;
+        }
+    if (e->e_fdnext){ /* First registration, let next take over epoll entry */
+        ev.events = event_epoll_events(e->e_fdnext);
+        ev.data.ptr = e->e_fdnext;
+        epoll_ctl(_ee_epfd, EPOLL_CTL_MOD, e->e_fd, &ev);
+    }
+    else
+        epoll_ctl(_ee_epfd, EPOLL_CTL_DEL, e->e_fd, NULL);
+}
+
+/*! Check if epoll events of fd are ready for registration
+ *
+ * @param[in]  e       Registration
+ * @param[in]  events  Ready epoll events of fd
+ * @retval     1       Ready, call e
+ * @retval     0       Not ready
+ */
+static int
+event_epoll_ready(struct event_data *e,
+                  uint32_t           events)
+{
+    if (events & (EPOLLERR | EPOLLHUP)) /* Let callback detect error */
+        return 1;
+    return (events & (e->e_write ? EPOLLOUT : EPOLLIN)) != 0;
+}
+#endif /* EVENT_EPOLL */
+
 /*! Register a callback function to be called on input on a file descriptor.
  *
  * @param[in]  fd   File descriptor
@@ -202,6 +359,12 @@ clixon_event_reg_fd_prio(int   fd,
     e->e_arg = arg;
     e->e_type = EVENT_FD;
     e->e_prio = prio;
+#ifdef EVENT_EPOLL
+    if (event_epoll_add(e) < 0){
+        free(e);
+        return -1;
+    }
+#endif
     e->e_next = ee;
     ee = e;
     clixon_debug(CLIXON_DBG_EVENT, "registering %s", e->e_string);
@@ -217,6 +380,49 @@ clixon_event_reg_fd(int   fd,
     return clixon_event_reg_fd_prio(fd, fn, arg, str, 0);
 }
 
+/*! Register a callback function to be called when a file descriptor is writable
+ *
+ * Typically registered when a non-blocking write would block, and unregistered when all
+ * data is written.
+ * @param[in]  fd   File descriptor
+ * @param[in]  fn   Function to call when fd is writable
+ * @param[in]  arg  Argument to function fn
+ * @param[in]  str  Describing string for logging
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see clixon_event_unreg_fd  Unregister with same fd and fn
+ */
+int
+clixon_event_reg_fd_write(int   fd,
+                          int (*fn)(int, void*),
+                          void *arg,
+                          char *str)
+{
+    struct event_data *e;
+
+    if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
+        clixon_err(OE_EVENTS, errno, "malloc");
+        return -1;
+    }
+    memset(e, 0, sizeof(struct event_data));
+    strncpy(e->e_string, str, EVENT_STRLEN-1);
+    e->e_fd = fd;
+    e->e_fn = fn;
+    e->e_arg = arg;
+    e->e_type = EVENT_FD;
+    e->e_write = 1;
+#ifdef EVENT_EPOLL
+    if (event_epoll_add(e) < 0){
+        free(e);
+        return -1;
+    }
+#endif
+    e->e_next = ee;
+    ee = e;
+    clixon_debug(CLIXON_DBG_EVENT, "registering %s (write)", e->e_string);
+    return 0;
+}
+
 /*! Deregister a file descriptor callback
  *
  * @param[in]  s   File descriptor
@@ -239,6 +445,9 @@ clixon_event_unreg_fd(int   s,
     for (e = ee; e; e = e->e_next){
         if (fn == e->e_fn && s == e->e_fd) {
             found++;
+#ifdef EVENT_EPOLL
+            event_epoll_del(e);
+#endif
             *e_prev = e->e_next;
             _ee_unreg++;
             free(e);
@@ -249,6 +458,56 @@ clixon_event_unreg_fd(int   s,
     return found?0:-1;
 }
 
+/*! Compare two timeouts, earliest first, then in registration order
+ */
+static int
+event_timer_before(struct event_data *e1,
+                   struct event_data *e2)
+{
+    if (timercmp(&e1->e_time, &e2->e_time, !=))
+        return timercmp(&e1->e_time, &e2->e_time, <);
+    return e1->e_seq < e2->e_seq;
+}
+
+/*! Move timeout at heap position i up or down until heap is ordered
+ */
+static void
+event_timer_sift(int i)
+{
+    struct event_data *e = ee_timers[i];
+    int                j;
+
+    /* Up */
+    while (i > 0 && event_timer_before(e, ee_timers[(i-1)/2])){
+        ee_timers[i] = ee_timers[(i-1)/2];
+        i = (i-1)/2;
+    }
+    /* Down */
+    while ((j = 2*i+1) < ee_timers_len){
+        if (j+1 < ee_timers_len && event_timer_before(ee_timers[j+1], ee_timers[j]))
+            j++;
+        if (!event_timer_before(ee_timers[j], e))
+            break;
+        ee_timers[i] = ee_timers[j];
+        i = j;
+    }
+    ee_timers[i] = e;
+}
+
+/*! Remove timeout at heap position i and return it
+ */
+static struct event_data *
+event_timer_remove(int i)
+{
+    struct event_data *e = ee_timers[i];
+
+    if (--ee_timers_len > i){
+        ee_timers[i] = ee_timers[ee_timers_len];
+        event_timer_sift(i);
+    }
+    return e;
+}
+
 /*! Call a callback function at an absolute time
  *
  * @param[in]  t   Absolute (not relative!) timestamp when callback is called
@@ -281,8 +540,8 @@ clixon_event_reg_timeout(struct timeval t,
 {
     int                 retval = -1;
     struct event_data  *e;
-    struct event_data  *e1;
-    struct event_data **e_prev;
+    struct event_data **vec;
+    int                 size;
 
     if (str == NULL || fn == NULL){
         clixon_err(OE_CFG, EINVAL, "str or fn is NULL");
@@ -298,15 +557,20 @@ clixon_event_reg_timeout(struct timeval t,
     e->e_arg = arg;
     e->e_type = EVENT_TIME;
     e->e_time = t;
-    /* Sort into right place */
-    e_prev = &ee_timers;
-    for (e1=ee_timers; e1; e1=e1->e_next){
-        if (timercmp(&e->e_time, &e1->e_time, <))
-            break;
-        e_prev = &e1->e_next;
+    e->e_seq = ee_timers_seq++;
+    /* Insert into heap */
+    if (ee_timers_len == ee_timers_size){
+        size = ee_timers_size ? 2*ee_timers_size : 16;
+        if ((vec = realloc(ee_timers, size*sizeof(*vec))) == NULL){
+            clixon_err(OE_EVENTS, errno, "realloc");
+            free(e);
+            goto done;
+        }
+        ee_timers = vec;
+        ee_timers_size = size;
     }
-    e->e_next = e1;
-    *e_prev = e;
+    ee_timers[ee_timers_len++] = e;
+    event_timer_sift(ee_timers_len-1);
     clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "%s", str);
     retval = 0;
  done:
@@ -331,17 +595,16 @@ clixon_event_unreg_timeout(int (*fn)(int, void*),
 {
     struct event_data  *e;
     int                 found = 0;
-    struct event_data **e_prev;
+    int                 i;
 
-    e_prev = &ee_timers;
-    for (e = ee_timers; e; e = e->e_next){
+    for (i = 0; i < ee_timers_len; i++){
+        e = ee_timers[i];
         if (fn == e->e_fn && arg == e->e_arg) {
             found++;
-            *e_prev = e->e_next;
+            e = event_timer_remove(i);
             free(e);
             break;
         }
-        e_prev = &e->e_next;
     }
     return found?0:-1;
 }
@@ -356,14 +619,13 @@ clixon_event_unreg_timeout(int (*fn)(int, void*),
 int
 clixon_event_poll(int fd)
 {
-    int            retval = -1;
-    fd_set         fdset;
-    struct timeval tnull = {0,};
-
-    FD_ZERO(&fdset);
-    FD_SET(fd, &fdset);
-    if ((retval = select(FD_SETSIZE, &fdset, NULL, NULL, &tnull)) < 0)
-        clixon_err(OE_EVENTS, errno, "select");
+    int           retval = -1;
+    struct pollfd pfd = {0,};
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    if ((retval = poll(&pfd, 1, 0)) < 0)
+        clixon_err(OE_EVENTS, errno, "poll");
     return retval;
 }
 
@@ -375,6 +637,8 @@ clixon_event_poll(int fd)
  * @note There is an issue with fairness between timeouts and events
  *       Currently a socket that is not read/emptied properly starve timeouts.
  *       One could try to poll the file descriptors after a timeout?
+ * @note With EVENT_EPOLL, dispatch stops when an event is unregistered by a callback, since
+ *       remaining ready events may refer to it. They are level-triggered and reported again.
  */
 int
 clixon_event_loop(clixon_handle h)
@@ -383,32 +647,62 @@ clixon_event_loop(clixon_handle h)
     int                n;
     struct timeval     t;
     struct timeval     t0;
+    int                retval = -1;
+#ifdef EVENT_EPOLL
+    struct epoll_event events[EVENT_EPOLL_MAXEVENTS];
+    int                timeout;
+    int                i;
+    int                stop;
+#else
     struct timeval     tnull = {0,};
     fd_set             fdset;
-    int                retval = -1;
+    fd_set             wfdset;
     struct event_data *e_next;
+#endif
 
     while (clixon_exit_get() != 1){
-        FD_ZERO(&fdset);
         if (clicon_sig_child_get()){
             /* Go through processes and wait for child processes */
             if (clixon_process_waitpid(h) < 0)
                 goto err;
             clicon_sig_child_set(0);
         }
+#ifdef EVENT_EPOLL
+        if (_ee_epfd == -1 &&
+            (_ee_epfd = epoll_create1(EPOLL_CLOEXEC)) < 0){
+            clixon_err(OE_EVENTS, errno, "epoll_create1");
+            goto err;
+        }
+        if (ee_timers_len){
+            gettimeofday(&t0, NULL);
+            timersub(&ee_timers[0]->e_time, &t0, &t);
+            if (t.tv_sec < 0)
+                timeout = 0;
+            else if (t.tv_sec >= INT_MAX/1000 - 1)
+                timeout = INT_MAX;
+            else /* Round up so that timeout has passed on return */
+                timeout = t.tv_sec*1000 + (t.tv_usec+999)/1000;
+        }
+        else
+            timeout = -1;
+        n = epoll_wait(_ee_epfd, events, EVENT_EPOLL_MAXEVENTS, timeout);
+#else
+        FD_ZERO(&fdset);
+        FD_ZERO(&wfdset);
         for (e=ee; e; e=e->e_next)
             if (e->e_type == EVENT_FD)
-                FD_SET(e->e_fd, &fdset);
-        if (ee_timers != NULL){
+                FD_SET(e->e_fd, e->e_write ? &wfdset : &fdset);
+        if (ee_timers_len){
             gettimeofday(&t0, NULL);
-            timersub(&ee_timers->e_time, &t0, &t);
+            timersub(&ee_timers[0]->e_time, &t0, &t);
             if (t.tv_sec < 0)
-                n = select(FD_SETSIZE, &fdset, NULL, NULL, &tnull);
+                n = select(FD_SETSIZE, &fdset, &wfdset, NULL, &tnull);
             else
-                n = select(FD_SETSIZE, &fdset, NULL, NULL, &t);
+                n = select(FD_SETSIZE, &fdset, &wfdset, NULL, &t);
         }
         else
-            n = select(FD_SETSIZE, &fdset, NULL, NULL, NULL);
+            n = select(FD_SETSIZE, &fdset, &wfdset, NULL, NULL);
+#endif
         if (clixon_exit_get() == 1){
             break;
         }
@@ -424,9 +718,9 @@ clixon_event_loop(clixon_handle h)
                  *     New select loop is called
                  * (3) Other signals result in an error and return -1.
                  */
-                clixon_debug(CLIXON_DBG_EVENT, "select: %s", strerror(errno));
+                clixon_debug(CLIXON_DBG_EVENT, "%s: %s", EVENT_WAIT_STR, strerror(errno));
                 if (clixon_exit_get() == 1){
-                    clixon_err(OE_EVENTS, errno, "select");
+                    clixon_err(OE_EVENTS, errno, "%s", EVENT_WAIT_STR);
                     retval = 0;
                 }
                 else if (clicon_sig_child_get()){
@@ -441,15 +735,14 @@ clixon_event_loop(clixon_handle h)
                     continue;
                 }
                 else
-                    clixon_err(OE_EVENTS, errno, "select");
+                    clixon_err(OE_EVENTS, errno, "%s", EVENT_WAIT_STR);
             }
             else
-                clixon_err(OE_EVENTS, errno, "select");
+                clixon_err(OE_EVENTS, errno, "%s", EVENT_WAIT_STR);
             goto err;
         }
         if (n==0){ /* Timeout */
-            e = ee_timers;
-            ee_timers = ee_timers->e_next;
+            e = event_timer_remove(0);
             clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "timeout: %s", e->e_string);
             if ((*e->e_fn)(0, e->e_arg) < 0){
                 free(e);
@@ -458,12 +751,63 @@ clixon_event_loop(clixon_handle h)
             free(e);
         }
         _ee_unreg = 0;
+#ifdef EVENT_EPOLL
+        stop = 0;
+        if (clicon_option_bool(h, "CLICON_SOCK_PRIO")){
+            for (i=0; i<n && !stop; i++){
+                for (e=events[i].data.ptr; e; e=e->e_fdnext){
+                    if (clixon_exit_get() == 1){
+                        stop++;
+                        break;
+                    }
+                    if (e->e_prio == 0 || !event_epoll_ready(e, events[i].events))
+                        continue;
+                    clixon_debug(CLIXON_DBG_EVENT, "ready: %s prio:%d", e->e_string, e->e_prio);
+                    if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
+                        clixon_debug(CLIXON_DBG_EVENT, "Error in: %s", e->e_string);
+                        goto err;
+                    }
+                    if (_ee_unreg){
+                        _ee_unreg = 0;
+                        stop++;
+                        break;
+                    }
+                }
+            }
+        }
+        /* Unprio
+         * Note that without prio, round-robin fairness is ensured, not with prio */
+        for (i=0; i<n && !stop; i++){
+            for (e=events[i].data.ptr; e; e=e->e_fdnext){
+                if (clixon_exit_get() == 1){
+                    stop++;
+                    break;
+                }
+                if (e->e_prio || !event_epoll_ready(e, events[i].events))
+                    continue;
+                clixon_debug(CLIXON_DBG_EVENT, "ready: %s", e->e_string);
+                if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
+                    clixon_debug(CLIXON_DBG_EVENT, "Error in: %s", e->e_string);
+                    goto err;
+                }
+                if (_ee_unreg){
+                    _ee_unreg = 0;
+                    stop++;
+                    break;
+                }
+                if (clicon_option_bool(h, "CLICON_SOCK_PRIO")){
+                    stop++;
+                    break;
+                }
+            }
+        }
+#else /* EVENT_EPOLL */
         if (clicon_option_bool(h, "CLICON_SOCK_PRIO")){
             for (e=ee; e; e=e_next) {
                 if (clixon_exit_get() == 1)
                     break;
                 e_next = e->e_next;
-                if (e->e_type == EVENT_FD && FD_ISSET(e->e_fd, &fdset) && e->e_prio){
+                if (e->e_type == EVENT_FD && FD_ISSET(e->e_fd, e->e_write ? &wfdset : &fdset) && e->e_prio){
                     clixon_debug(CLIXON_DBG_EVENT, "FD_ISSET: %s prio:%d", e->e_string, e->e_prio);
                     if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
                         clixon_debug(CLIXON_DBG_EVENT, "Error in: %s", e->e_string);
@@ -483,7 +827,7 @@ clixon_event_loop(clixon_handle h)
             if (clixon_exit_get() == 1)
                 break;
             e_next = e->e_next;
-            if (e->e_type == EVENT_FD && FD_ISSET(e->e_fd, &fdset) && e->e_prio==0){
+            if (e->e_type == EVENT_FD && FD_ISSET(e->e_fd, e->e_write ? &wfdset : &fdset) && e->e_prio==0){
                 clixon_debug(CLIXON_DBG_EVENT, "FD_ISSET: %s", e->e_string);
                 if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
                     clixon_debug(CLIXON_DBG_EVENT, "Error in: %s", e->e_string);
@@ -497,6 +841,7 @@ clixon_event_loop(clixon_handle h)
                     break;
             }
         }
+#endif /* EVENT_EPOLL */
         clixon_exit_decr(); /* If exit is set and > 1, decrement it (and exit when 1) */
         continue;
       err:
@@ -509,11 +854,19 @@ clixon_event_loop(clixon_handle h)
     return retval;
 }
 
+/*! Free all event registrations and close the epoll file descriptor
+ *
+ * File descriptors are not removed from epoll with EPOLL_CTL_DEL, so this can also be
+ * called in a forked child to drop the events of the parent, whose epoll instance is
+ * shared with the child.
+ * @retval  0  OK
+ */
 int
 clixon_event_exit(void)
 {
     struct event_data *e;
     struct event_data *e_next;
+    int                i;
 
     e_next = ee;
     while ((e = e_next) != NULL){
@@ -521,11 +874,18 @@ clixon_event_exit(void)
         free(e);
     }
     ee = NULL;
-    e_next = ee_timers;
-    while ((e = e_next) != NULL){
-        e_next = e->e_next;
-        free(e);
-    }
+    for (i = 0; i < ee_timers_len; i++)
+        free(ee_timers[i]);
+    if (ee_timers)
+        free(ee_timers);
     ee_timers = NULL;
+    ee_timers_len = 0;
+    ee_timers_size = 0;
+#ifdef EVENT_EPOLL
+    if (_ee_epfd != -1){
+        close(_ee_epfd);
+        _ee_epfd = -1;
+    }
+#endif
     return 0;
 }
@@ -77,6 +77,7 @@
 #include "clixon_netconf_lib.h"
 #include "clixon_json.h"
 #include "clixon_json_parse.h"
+#include "clixon_xml_io.h"
 
 /* Let xml2json_cbuf_vec() return json array: [a,b].
    ALternative is to create a pseudo-object and return that: {top:{a,b}}
@@ -98,6 +99,14 @@ enum array_element_type{
     BODY_ARRAY
 };
 
+/*! Streaming state of clixon_json2cbuf_stream and xml2json_cbuf_vec_stream
+ */
+struct json_stream {
+    size_t                js_chunk; /* Flush when buffer reaches this size */
+    clixon_xml_stream_fn *js_fn;    /* Flush callback */
+    void                 *js_arg;   /* Flush callback argument */
+};
+
 enum childtype{
     NULL_CHILD=0, /* eg <a/> no children. Translated to null if in 
                    * array or leaf terminal, and to {} if proper object, ie container.
@@ -781,6 +790,45 @@ xml2json_encode_attr(cxobj     *xa,
     return retval;
 }
 
+/*! Internal: hand over buffer to flush callback if it has reached the chunk size
+ *
+ * Called between objects. A "]]>" sequence may only occur inside a JSON string and is
+ * therefore never split between two flushes.
+ * @param[in,out] cb  Cligen buffer, reset after a flush
+ * @param[in]     js  Streaming state, or NULL
+ * @retval        0   OK
+ * @retval       -1   Error
+ */
+static int
+json_stream_flush(cbuf               *cb,
+                  struct json_stream *js)
+{
+    if (js == NULL || cbuf_len(cb) < js->js_chunk)
+        return 0;
+    if ((*js->js_fn)(cb, js->js_arg) < 0)
+        return -1;
+    cbuf_reset(cb);
+    return 0;
+}
+
+/*! Check if object is printed according to with-defaults mode
+ *
+ * @param[in]  x     XML object
+ * @param[in]  wdef  With-defaults parameter
+ * @retval     1     Print it
+ * @retval     0     Skip it
+ * @retval    -1     Error
+ * @see xml2output_wdef
+ */
+static int
+json_wdef_keep(cxobj            *x,
+               withdefaults_type wdef)
+{
+    if (wdef == WITHDEFAULTS_REPORT_ALL || xml_type(x) != CX_ELMNT)
+        return 1;
+    return xml2output_wdef(x, wdef, NULL);
+}
+
 /*! Do the actual work of translating XML to JSON 
  *
  * @param[out]  cb        Cligen text buffer containing json on exit
@@ -791,6 +839,8 @@ xml2json_encode_attr(cxobj     *xa,
  * @param[in]   flat      Dont print NO_ARRAY object name (for _vec call)
  * @param[in]   modname0
  * @param[out]  metacbp   Meta encoding of attribute
+ * @param[in]   wdef      With-defaults parameter
+ * @param[in]   js        Flush buffer between child objects when it reaches chunk size, or NULL
  * @retval      0         OK
  * @retval     -1         Error
  *
@@ -830,10 +880,13 @@ xml2json1_cbuf(cbuf                   *cb,
                int                     pretty,
                int                     flat,
                char                   *modname0,
-               cbuf                   *metacbp)
+               cbuf                   *metacbp,
+               withdefaults_type       wdef,
+               struct json_stream     *js)
 {
     int              retval = -1;
     int              i;
+    int              ret;
     cxobj           *xc;
     cxobj           *xp;
     enum childtype   childt;
@@ -945,7 +998,20 @@ xml2json1_cbuf(cbuf                   *cb,
      * arraytype=* but child-type is BODY_CHILD 
      * This is code for writing <a>42</a> as "a":42 and not "a":"42"
      */
-    commas = xml_child_nr_notype(x, CX_ATTR) - 1;
+    if (wdef == WITHDEFAULTS_REPORT_ALL)
+        commas = xml_child_nr_notype(x, CX_ATTR) - 1;
+    else{
+        /* Only count children printed according to with-defaults */
+        commas = -1;
+        for (i=0; i<xml_child_nr(x); i++){
+            xc = xml_child_i(x, i);
+            if (xml_type(xc) == CX_ATTR)
+                continue;
+            if ((ret = json_wdef_keep(xc, wdef)) < 0)
+                goto done;
+            commas += ret;
+        }
+    }
     for (i=0; i<xml_child_nr(x); i++){
         xc = xml_child_i(x, i);
         if (xml_type(xc) == CX_ATTR){
@@ -954,6 +1020,12 @@ xml2json1_cbuf(cbuf                   *cb,
                 goto done;
             continue;
         }
+        /* Defaults and non-presence containers are never list or leaf-list entries,
+         * so skipping them does not change the array type of siblings */
+        if ((ret = json_wdef_keep(xc, wdef)) < 0)
+            goto done;
+        if (ret == 0)
+            continue;
         xc_arraytype = array_eval(i?xml_child_i(x,i-1):NULL,
                                   xc,
                                   xml_child_i(x, i+1));
@@ -961,12 +1033,14 @@ xml2json1_cbuf(cbuf                   *cb,
                            xc,
                            xc_arraytype,
                            level+1, pretty, 0, modname0,
-                           metacbc) < 0)
+                           metacbc, wdef, js) < 0)
             goto done;
         if (commas > 0) {
             cprintf(cb, ",%s", pretty?"\n":"");
             --commas;
         }
+        if (json_stream_flush(cb, js) < 0)
+            goto done;
     }
     if (cbuf_len(metacbc)){
         cprintf(cb, "%s", cbuf_get(metacbc));
@@ -1045,6 +1119,8 @@ xml2json1_cbuf(cbuf                   *cb,
  * @param[in]     x      XML tree to translate from
  * @param[in]     pretty Set if output is pretty-printed
  * @param[in]     autocliext How to handle autocli extensions: 0: ignore 1: follow
+ * @param[in]     wdef   With-defaults parameter, default is WITHDEFAULTS_REPORT_ALL
+ * @param[in]     js     Streaming state, or NULL
  * @retval        0      OK
  * @retval       -1      Error
  *
@@ -1052,10 +1128,12 @@ xml2json1_cbuf(cbuf                   *cb,
  * @see xml2json_cbuf_vec   Top symbol is list
  */
 static int
-xml2json_cbuf1(cbuf   *cb,
-               cxobj  *x,
-               int     pretty,
-               int     autocliext)
+xml2json_cbuf1(cbuf               *cb,
+               cxobj              *x,
+               int                 pretty,
+               int                 autocliext,
+               withdefaults_type   wdef,
+               struct json_stream *js)
 {
     int                     retval = 1;
     int                     level = 0;
@@ -1091,7 +1169,8 @@ xml2json_cbuf1(cbuf   *cb,
                        pretty,
                        0,
                        NULL, /* ancestor modname / namespace */
-                       NULL) < 0)
+                       NULL,
+                       wdef, js) < 0)
         goto done;
     cprintf(cb, "%s%*s}%s",
             pretty?"\n":"",
@@ -1103,6 +1182,91 @@ xml2json_cbuf1(cbuf   *cb,
     return retval;
 }
 
+/*! Translate an XML tree to JSON in a CLIgen buffer with with-defaults
+ *
+ * XML-style namespace notation in tree, but RFC7951 in output assume yang 
+ * populated 
+ * Assume xt being in REPORT_ALL state, skip default values according to wdef
+ *
+ * @param[in,out] cb      Cligen buffer to write to
+ * @param[in]     xt      Top-level xml object
+ * @param[in]     pretty  Set if output is pretty-printed
+ * @param[in]     skiptop 0: Include top object 1: Skip top-object, only children, 
+ * @param[in]     autocliext How to handle autocli extensions: 0: ignore 1: follow
+ * @param[in]     wdef    With-defaults parameter, default is WITHDEFAULTS_REPORT_ALL
+ * @retval        0       OK
+ * @retval       -1       Error
+ * @note WITHDEFAULTS_REPORT_ALL_TAGGED is printed as WITHDEFAULTS_REPORT_ALL
+ * @see clixon_json2cbuf
+ * @see clixon_xml2cbuf1  XML corresponding function
+ */
+int
+clixon_json2cbuf1(cbuf             *cb,
+                  cxobj            *xt,
+                  int               pretty,
+                  int               skiptop,
+                  int               autocliext,
+                  withdefaults_type wdef)
+{
+    int    retval = -1;
+    cxobj *xc;
+    int    i=0;
+    int    ret;
+
+    if (skiptop){
+        xc = NULL;
+        while ((xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL){
+            if ((ret = json_wdef_keep(xc, wdef)) < 0)
+                goto done;
+            if (ret == 0)
+                continue;
+            if (i++)
+                cprintf(cb, ",");
+            if (xml2json_cbuf1(cb, xc, pretty, autocliext, wdef, NULL) < 0)
+                goto done;
+        }
+    }
+    else {
+        if (xml2json_cbuf1(cb, xt, pretty, autocliext, wdef, NULL) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Translate an XML tree to JSON in a CLIgen buffer in pieces with with-defaults
+ *
+ * Same as clixon_json2cbuf1 without skiptop and autocli extensions, but whenever the buffer
+ * reaches chunk bytes between two objects, the buffer is handed over to a flush callback
+ * and then reset.
+ * Any content already in cb is included in the first flush.
+ * The remainder is left in cb when the function returns.
+ * @param[in,out] cb      Cligen buffer to write to
+ * @param[in]     xt      Top-level xml object
+ * @param[in]     pretty  Set if output is pretty-printed
+ * @param[in]     wdef    With-defaults parameter, default is WITHDEFAULTS_REPORT_ALL
+ * @param[in]     chunk   Flush buffer when it reaches this size
+ * @param[in]     fn      Flush callback, consumes the buffer
+ * @param[in]     arg     Argument to flush callback
+ * @retval        0       OK
+ * @retval       -1       Error
+ * @see clixon_xml2cbuf_stream  XML corresponding function
+ */
+int
+clixon_json2cbuf_stream(cbuf                 *cb,
+                        cxobj                *xt,
+                        int                   pretty,
+                        withdefaults_type     wdef,
+                        size_t                chunk,
+                        clixon_xml_stream_fn *fn,
+                        void                 *arg)
+{
+    struct json_stream js = {chunk, fn, arg};
+
+    return xml2json_cbuf1(cb, xt, pretty, 0, wdef, &js);
+}
+
 /*! Translate an XML tree to JSON in a CLIgen buffer skip top-level object
  *
  * XML-style namespace notation in tree, but RFC7951 in output assume yang 
@@ -1122,6 +1286,7 @@ xml2json_cbuf1(cbuf   *cb,
  *   cbuf_free(cb);
  * @endcode
  * @see xml2json_cbuf where the top level object is included
+ * @see clixon_json2cbuf1 with with-defaults
  */
 int
 clixon_json2cbuf(cbuf  *cb,
@@ -1130,25 +1295,71 @@ clixon_json2cbuf(cbuf  *cb,
                  int    skiptop,
                  int    autocliext)
 {
-    int    retval = -1;
-    cxobj *xc;
-    int    i=0;
+    return clixon_json2cbuf1(cb, xt, pretty, skiptop, autocliext, WITHDEFAULTS_REPORT_ALL);
+}
 
-    if (skiptop){
-        xc = NULL;
-        while ((xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL){
-            if (i++)
-                cprintf(cb, ",");
-            if (xml2json_cbuf1(cb, xc, pretty, autocliext) < 0)
-                goto done;
-        }
+/*! Internal: translate a vector of xml objects to members of one JSON object
+ *
+ * The objects are printed in place, as if they were children of a pseudo-object whose
+ * name is not printed, see xml2json_cbuf_vec1
+ * @param[out] cb     Cligen buffer to write to
+ * @param[in]  vec    Vector of xml objects
+ * @param[in]  veclen Length of vector, > 0
+ * @param[in]  pretty Set if output is pretty-printed
+ * @param[in]  wdef   With-defaults parameter, objects skipped by wdef are not printed
+ * @param[in]  js     Streaming state, or NULL
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xml2json_vec_cbuf(cbuf               *cb,
+                  cxobj             **vec,
+                  size_t              veclen,
+                  int                 pretty,
+                  withdefaults_type   wdef,
+                  struct json_stream *js)
+{
+    int     retval = -1;
+    cbuf   *metacb = NULL;
+    size_t  i;
+    int     commas = -1;
+    int     ret;
+
+    if ((metacb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
     }
-    else {
-        if (xml2json_cbuf1(cb, xt, pretty, autocliext) < 0)
+    for (i=0; i<veclen; i++){
+        if ((ret = json_wdef_keep(vec[i], wdef)) < 0)
+            goto done;
+        commas += ret;
+    }
+    cprintf(cb, "{%s", pretty?"\n":"");
+    for (i=0; i<veclen; i++){
+        if ((ret = json_wdef_keep(vec[i], wdef)) < 0)
+            goto done;
+        if (ret == 0)
+            continue;
+        if (xml2json1_cbuf(cb,
+                           vec[i],
+                           array_eval(i?vec[i-1]:NULL, vec[i], i+1<veclen?vec[i+1]:NULL),
+                           1, pretty, 0, NULL,
+                           metacb, wdef, js) < 0)
+            goto done;
+        if (commas > 0) {
+            cprintf(cb, ",%s", pretty?"\n":"");
+            --commas;
+        }
+        if (json_stream_flush(cb, js) < 0)
             goto done;
     }
+    if (cbuf_len(metacb))
+        cprintf(cb, "%s", cbuf_get(metacb));
+    cprintf(cb, "%s}", pretty?"\n":"");
     retval = 0;
  done:
+    if (metacb)
+        cbuf_free(metacb);
     return retval;
 }
 
@@ -1161,18 +1372,21 @@ clixon_json2cbuf(cbuf  *cb,
  * @param[in]  veclen Length of vector
  * @param[in]  pretty Set if output is pretty-printed (2 for debug)
  * @param[in]  skiptop 0: Include top object 1: Skip top-object, only children, 
+ * @param[in]  wdef   With-defaults parameter, default is WITHDEFAULTS_REPORT_ALL
  * @retval     0      OK
  * @retval    -1      Error
  * @note This only works if the vector is uniform, ie same object name.
+ * @note Objects of vec skipped by wdef are not printed if skiptop is 0
  * Example: <b/><c/> --> <a><b/><c/></a> --> {"b" : null,"c" : null}
- * @see clixon_json2cbuf
+ * @see clixon_json2cbuf1
  */
 int
-xml2json_cbuf_vec(cbuf      *cb,
-                  cxobj    **vec,
-                  size_t     veclen,
-                  int        pretty,
-                  int        skiptop)
+xml2json_cbuf_vec1(cbuf             *cb,
+                   cxobj           **vec,
+                   size_t            veclen,
+                   int               pretty,
+                   int               skiptop,
+                   withdefaults_type wdef)
 {
     int    retval = -1;
     int    level = 0;
@@ -1182,6 +1396,9 @@ xml2json_cbuf_vec(cbuf      *cb,
     cxobj *xc;
     cvec  *nsc = NULL;
 
+    /* Print objects in place, only children of objects are copied */
+    if (!skiptop && veclen > 0)
+        return xml2json_vec_cbuf(cb, vec, veclen, pretty, wdef, NULL);
     if ((xp = xml_new("xml2json", NULL, CX_ELMNT)) == NULL)
         goto done;
     /* Make a copy of old and graft it into new top-object
@@ -1193,6 +1410,8 @@ xml2json_cbuf_vec(cbuf      *cb,
         if (skiptop){
             cxobj *x = NULL;
             while ((x = xml_child_each(xc0, x, CX_ELMNT)) != NULL) {
+                if (json_wdef_keep(x, wdef) == 0)
+                    continue;
                 if ((xc = xml_dup(x)) == NULL)
                     goto done;
                 xml_addsub(xp, xc);
@@ -1217,7 +1436,7 @@ xml2json_cbuf_vec(cbuf      *cb,
                        NO_ARRAY,
                        level,
                        pretty,
-                       1, NULL, NULL) < 0)
+                       1, NULL, NULL, wdef, NULL) < 0)
         goto done;
 
     if (0){
@@ -1235,6 +1454,59 @@ xml2json_cbuf_vec(cbuf      *cb,
     return retval;
 }
 
+/*! Translate a vector of xml objects to JSON Cligen buffer.
+ *
+ * @param[out] cb     Cligen buffer to write to
+ * @param[in]  vec    Vector of xml objecst
+ * @param[in]  veclen Length of vector
+ * @param[in]  pretty Set if output is pretty-printed (2 for debug)
+ * @param[in]  skiptop 0: Include top object 1: Skip top-object, only children, 
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xml2json_cbuf_vec1 with with-defaults
+ */
+int
+xml2json_cbuf_vec(cbuf      *cb,
+                  cxobj    **vec,
+                  size_t     veclen,
+                  int        pretty,
+                  int        skiptop)
+{
+    return xml2json_cbuf_vec1(cb, vec, veclen, pretty, skiptop, WITHDEFAULTS_REPORT_ALL);
+}
+
+/*! Translate a vector of xml objects to JSON in a CLIgen buffer in pieces with with-defaults
+ *
+ * Same as xml2json_cbuf_vec1 without skiptop, but whenever the buffer reaches chunk bytes
+ * between two objects, the buffer is handed over to a flush callback and then reset.
+ * The remainder is left in cb when the function returns.
+ * @param[out] cb     Cligen buffer to write to
+ * @param[in]  vec    Vector of xml objects
+ * @param[in]  veclen Length of vector, > 0
+ * @param[in]  pretty Set if output is pretty-printed
+ * @param[in]  wdef   With-defaults parameter, default is WITHDEFAULTS_REPORT_ALL
+ * @param[in]  chunk  Flush buffer when it reaches this size
+ * @param[in]  fn     Flush callback, consumes the buffer
+ * @param[in]  arg    Argument to flush callback
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see clixon_json2cbuf_stream
+ */
+int
+xml2json_cbuf_vec_stream(cbuf                 *cb,
+                         cxobj               **vec,
+                         size_t                veclen,
+                         int                   pretty,
+                         withdefaults_type     wdef,
+                         size_t                chunk,
+                         clixon_xml_stream_fn *fn,
+                         void                 *arg)
+{
+    struct json_stream js = {chunk, fn, arg};
+
+    return xml2json_vec_cbuf(cb, vec, veclen, pretty, wdef, &js);
+}
+
 /*! Translate from xml tree to JSON and print to file using a callback
  *
  * @param[in]  f       File to print to
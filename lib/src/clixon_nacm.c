@@ -108,16 +108,673 @@ match_access(char *access_operations,
     return 0;
 }
 
+/*---------------------------------------------------------------
+ * Compiled NACM rules
+ * The NACM config is compiled into rules and per-user rule vectors that are kept
+ * until the NACM config changes, instead of evaluating XPaths in the NACM tree for
+ * every request.
+ */
+
+/* Access-operations of a compiled rule, see match_access */
+#define NACM_OP_CREATE 0x01
+#define NACM_OP_READ   0x02
+#define NACM_OP_UPDATE 0x04
+#define NACM_OP_DELETE 0x08
+#define NACM_OP_EXEC   0x10
+
+/* Compiled NACM rule. Strings point into the NACM tree of the cache (except path) */
+struct nacm_rule{
+    char        *nr_module;   /* module-name, "*" is any */
+    char        *nr_rpc;      /* rpc-name or NULL */
+    int          nr_notif;    /* notification-name is set */
+    int          nr_haspath;  /* path element exists */
+    char        *nr_path;     /* Trimmed copy of path or NULL */
+    char        *nr_action;   /* "permit", "deny" or NULL */
+    int          nr_ops;      /* Access operations as NACM_OP_* bits */
+    yang_stmt   *nr_yspec;    /* Yang spec path is resolved in, NULL if not resolved */
+    int          nr_resolved; /* 1 if path resolved OK, 0 if failed. Valid if nr_yspec set */
+    clixon_path *nr_cplist;   /* Parsed and resolved path */
+};
+typedef struct nacm_rule nacm_rule;
+
+/* Compiled NACM rule-list */
+struct nacm_rulelist{
+    cxobj       *nl_xrlist;   /* rule-list in NACM tree of cache */
+    nacm_rule   *nl_rules;    /* Vector of rules in order */
+    int          nl_len;      /* Length of rule vector */
+};
+typedef struct nacm_rulelist nacm_rulelist;
+
+/* Sorted set of YANG schema nodes */
+struct nacm_yset{
+    yang_stmt    **ny_vec;    /* Vector sorted on pointer value */
+    int            ny_len;    /* Length of vector */
+};
+typedef struct nacm_yset nacm_yset;
+
+/* Rules of a user, compiled at first request of user */
+struct nacm_user{
+    int            nu_groups; /* Number of groups of user */
+    nacm_rule    **nu_rules;  /* Rules of rule-lists matching user's groups, in order */
+    int            nu_len;    /* Length of rule vector */
+    clicon_hash_t *nu_rpc;    /* "module:rpc" -> index of first matching exec rule, or -1 */
+    yang_stmt     *nu_ryspec; /* Yang spec of read index, NULL if not built */
+    int            nu_rskip;  /* Read index is complete, subtrees may be skipped */
+    int            nu_rmodule; /* Some read rule has a module-name other than "*" */
+    nacm_yset      nu_rabove; /* Schema nodes with read rule path targets beneath */
+};
+typedef struct nacm_user nacm_user;
+
+/* Compiled NACM config */
+struct nacm_cache{
+    cxobj          *nc_xnacm; /* Copy of NACM tree rules are compiled from */
+    cxobj          *nc_xsrc;  /* Last NACM tree found equal to nc_xnacm, marked XML_FLAG_NACM */
+    int             nc_gen;   /* Running generation of nc_xnacm, -1 if unknown */
+    nacm_rulelist  *nc_rlists; /* Vector of rule-lists in order */
+    int             nc_rllen; /* Length of rule-list vector */
+    int             nc_rules; /* Total number of rules */
+    clicon_hash_t  *nc_users; /* username -> nacm_user* */
+    yang_stmt      *nc_myspec; /* Yang spec of nc_mixed, NULL if not built */
+    nacm_yset       nc_mixed; /* Schema nodes with descendants of other modules */
+};
+typedef struct nacm_cache nacm_cache;
+
+static nacm_cache *_nacm_cache = NULL;
+static uint64_t    _nacm_hits = 0;
+static uint64_t    _nacm_misses = 0;
+
+/*! Add YANG node to set, call nacm_yset_sort after last add
+ */
+static int
+nacm_yset_add(nacm_yset *ny,
+              yang_stmt *ys)
+{
+    yang_stmt **vec;
+
+    if ((ny->ny_len & 15) == 0){
+        if ((vec = realloc(ny->ny_vec, (ny->ny_len+16)*sizeof(*vec))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+        ny->ny_vec = vec;
+    }
+    ny->ny_vec[ny->ny_len++] = ys;
+    return 0;
+}
+
+/*! Add YANG schema node ancestors of YANG node to set, not including module
+ */
+static int
+nacm_yset_ancestors(nacm_yset *ny,
+                    yang_stmt *ys)
+{
+    yang_stmt *yp = ys;
+
+    while ((yp = yang_parent_get(yp)) != NULL &&
+           yang_keyword_get(yp) != Y_MODULE &&
+           yang_keyword_get(yp) != Y_SUBMODULE &&
+           yang_keyword_get(yp) != Y_SPEC)
+        if (nacm_yset_add(ny, yp) < 0)
+            return -1;
+    return 0;
+}
+
+static int
+nacm_yset_cmp(const void *a,
+              const void *b)
+{
+    uintptr_t pa = (uintptr_t)*(yang_stmt **)a;
+    uintptr_t pb = (uintptr_t)*(yang_stmt **)b;
+
+    return pa < pb ? -1 : pa > pb ? 1 : 0;
+}
+
+/*! Sort set and remove duplicates
+ */
+static int
+nacm_yset_sort(nacm_yset *ny)
+{
+    int i;
+    int j;
+
+    if (ny->ny_len == 0)
+        return 0;
+    qsort(ny->ny_vec, ny->ny_len, sizeof(*ny->ny_vec), nacm_yset_cmp);
+    for (i=1, j=1; i<ny->ny_len; i++)
+        if (ny->ny_vec[i] != ny->ny_vec[j-1])
+            ny->ny_vec[j++] = ny->ny_vec[i];
+    ny->ny_len = j;
+    return 0;
+}
+
+/*! Check if YANG node is in set
+ *
+ * @retval  1  Yes
+ * @retval  0  No
+ */
+static int
+nacm_yset_has(nacm_yset *ny,
+              yang_stmt *ys)
+{
+    if (ny->ny_len == 0)
+        return 0;
+    return bsearch(&ys, ny->ny_vec, ny->ny_len, sizeof(*ny->ny_vec), nacm_yset_cmp) != NULL;
+}
+
+static void
+nacm_yset_reset(nacm_yset *ny)
+{
+    if (ny->ny_vec)
+        free(ny->ny_vec);
+    ny->ny_vec = NULL;
+    ny->ny_len = 0;
+}
+
+/*! Free compiled NACM user
+ */
+static int
+nacm_user_free(nacm_user *nu)
+{
+    if (nu->nu_rules)
+        free(nu->nu_rules);
+    if (nu->nu_rpc)
+        clicon_hash_free(nu->nu_rpc);
+    nacm_yset_reset(&nu->nu_rabove);
+    free(nu);
+    return 0;
+}
+
+/*! Free compiled NACM config
+ */
+static int
+nacm_cache_free(nacm_cache *nc)
+{
+    nacm_rulelist *nl;
+    nacm_rule     *nr;
+    nacm_user    **nup;
+    char         **keys = NULL;
+    size_t         klen;
+    int            i;
+    int            j;
+
+    if (nc->nc_users){
+        if (clicon_hash_keys(nc->nc_users, &keys, &klen) == 0){
+            for (i=0; i<klen; i++)
+                if ((nup = clicon_hash_value(nc->nc_users, keys[i], NULL)) != NULL)
+                    nacm_user_free(*nup);
+        }
+        clicon_hash_free(nc->nc_users);
+    }
+    for (i=0; i<nc->nc_rllen; i++){
+        nl = &nc->nc_rlists[i];
+        for (j=0; j<nl->nl_len; j++){
+            nr = &nl->nl_rules[j];
+            if (nr->nr_path)
+                free(nr->nr_path);
+            if (nr->nr_cplist)
+                clixon_path_free(nr->nr_cplist);
+        }
+        if (nl->nl_rules)
+            free(nl->nl_rules);
+    }
+    if (nc->nc_rlists)
+        free(nc->nc_rlists);
+    if (nc->nc_xnacm)
+        xml_free(nc->nc_xnacm);
+    nacm_yset_reset(&nc->nc_mixed);
+    if (keys)
+        free(keys);
+    free(nc);
+    return 0;
+}
+
+/*! Compile single NACM rule
+ *
+ * @param[in]  xrule  NACM rule XML tree
+ * @param[out] nr     Compiled rule
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+nacm_rule_compile(cxobj     *xrule,
+                  nacm_rule *nr)
+{
+    cxobj *xpath;
+    char  *ao;
+    char  *path0;
+
+    nr->nr_module = xml_find_body(xrule, "module-name");
+    nr->nr_rpc = xml_find_body(xrule, "rpc-name");
+    nr->nr_notif = xml_find_body(xrule, "notification-name") != NULL;
+    nr->nr_action = xml_find_body(xrule, "action");
+    if ((xpath = xml_find_type(xrule, NULL, "path", CX_ELMNT)) != NULL){
+        nr->nr_haspath = 1;
+        if ((path0 = xml_body(xpath)) != NULL){
+            /* Trim a copy, the tree is compared with new NACM trees */
+            if ((nr->nr_path = strdup(path0)) == NULL){
+                clixon_err(OE_UNIX, errno, "strdup");
+                return -1;
+            }
+            path0 = clixon_trim2(nr->nr_path, " \t\n");
+            memmove(nr->nr_path, path0, strlen(path0)+1);
+        }
+    }
+    ao = xml_find_body(xrule, "access-operations");
+    if (match_access(ao, "create", "write"))
+        nr->nr_ops |= NACM_OP_CREATE;
+    if (match_access(ao, "read", NULL))
+        nr->nr_ops |= NACM_OP_READ;
+    if (match_access(ao, "update", "write"))
+        nr->nr_ops |= NACM_OP_UPDATE;
+    if (match_access(ao, "delete", "write"))
+        nr->nr_ops |= NACM_OP_DELETE;
+    if (match_access(ao, "exec", NULL))
+        nr->nr_ops |= NACM_OP_EXEC;
+    return 0;
+}
+
+/*! Compile NACM config into rule-lists
+ *
+ * Users are compiled on demand, see nacm_user_get
+ * @param[in]  xnacm  NACM XML tree, root is "nacm"
+ * @param[in]  gen    Running generation of xnacm, or -1
+ * @param[out] ncp    Compiled NACM config, free with nacm_cache_free
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+nacm_cache_compile(cxobj       *xnacm,
+                   int          gen,
+                   nacm_cache **ncp)
+{
+    int            retval = -1;
+    nacm_cache    *nc = NULL;
+    nacm_rulelist *nl;
+    cxobj         *xrlist;
+    cxobj         *xrule;
+    int            n;
+
+    if ((nc = calloc(1, sizeof(*nc))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    nc->nc_gen = gen;
+    if ((nc->nc_users = clicon_hash_init()) == NULL)
+        goto done;
+    if ((nc->nc_xnacm = xml_dup(xnacm)) == NULL)
+        goto done;
+    n = 0;
+    xrlist = NULL;
+    while ((xrlist = xml_child_each(nc->nc_xnacm, xrlist, CX_ELMNT)) != NULL)
+        if (strcmp(xml_name(xrlist), "rule-list") == 0)
+            n++;
+    if (n && (nc->nc_rlists = calloc(n, sizeof(*nc->nc_rlists))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    xrlist = NULL;
+    while ((xrlist = xml_child_each(nc->nc_xnacm, xrlist, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(xrlist), "rule-list") != 0)
+            continue;
+        nl = &nc->nc_rlists[nc->nc_rllen++];
+        nl->nl_xrlist = xrlist;
+        n = 0;
+        xrule = NULL;
+        while ((xrule = xml_child_each(xrlist, xrule, CX_ELMNT)) != NULL)
+            if (strcmp(xml_name(xrule), "rule") == 0)
+                n++;
+        if (n && (nl->nl_rules = calloc(n, sizeof(*nl->nl_rules))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        xrule = NULL;
+        while ((xrule = xml_child_each(xrlist, xrule, CX_ELMNT)) != NULL) {
+            if (strcmp(xml_name(xrule), "rule") != 0)
+                continue;
+            if (nacm_rule_compile(xrule, &nl->nl_rules[nl->nl_len++]) < 0)
+                goto done;
+        }
+        nc->nc_rules += nl->nl_len;
+    }
+    clixon_debug(CLIXON_DBG_NACM, "rule-lists:%d rules:%d", nc->nc_rllen, nc->nc_rules);
+    *ncp = nc;
+    nc = NULL;
+    retval = 0;
+ done:
+    if (nc)
+        nacm_cache_free(nc);
+    return retval;
+}
+
+/*! Get compiled NACM config of NACM tree, compile if NACM config has changed
+ *
+ * The NACM tree last found equal to the compiled config is marked, so that repeated
+ * calls with the same tree, eg for every node of an edit, do not compare trees.
+ * @param[in]  xnacm  NACM XML tree, root is "nacm"
+ * @param[in]  gen    Running generation of xnacm, or -1 if not read from running
+ * @param[out] ncp    Compiled NACM config, valid until next call
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xmldb_running_gen
+ */
+static int
+nacm_cache_get(cxobj       *xnacm,
+               int          gen,
+               nacm_cache **ncp)
+{
+    nacm_cache *nc;
+
+    if ((nc = _nacm_cache) != NULL){
+        if (xnacm == nc->nc_xsrc && xml_flag(xnacm, XML_FLAG_NACM)){
+            _nacm_hits++;
+            goto ok;
+        }
+        /* Running not modified since compiled, or NACM config not modified */
+        if ((gen >= 0 && gen == nc->nc_gen) ||
+            xml_tree_equal(xnacm, nc->nc_xnacm) == 0){
+            _nacm_hits++;
+            if (gen >= 0)
+                nc->nc_gen = gen;
+            goto mark;
+        }
+        nacm_cache_free(nc);
+        _nacm_cache = NULL;
+    }
+    _nacm_misses++;
+    if (nacm_cache_compile(xnacm, gen, &_nacm_cache) < 0)
+        return -1;
+    nc = _nacm_cache;
+ mark:
+    nc->nc_xsrc = xnacm;
+    xml_flag_set(xnacm, XML_FLAG_NACM);
+ ok:
+    *ncp = nc;
+    return 0;
+}
+
+/*! Get compiled rules of user, compile user if not done before
+ *
+ * @param[in]  nc        Compiled NACM config
+ * @param[in]  username  User name
+ * @param[out] nup       Compiled user
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @see RFC8341 3.4.4 steps 4-6 and 3.4.5 steps 3-5
+ */
+static int
+nacm_user_get(nacm_cache *nc,
+              char       *username,
+              nacm_user **nup)
+{
+    int            retval = -1;
+    nacm_user    **nup0;
+    nacm_user     *nu = NULL;
+    nacm_rulelist *nl;
+    cxobj         *xgroups;
+    cxobj         *xg;
+    cxobj         *xu;
+    cxobj         *xlg;
+    cvec          *groups = NULL;
+    char          *gname;
+    int            i;
+    int            j;
+    int            n;
+
+    if ((nup0 = clicon_hash_value(nc->nc_users, username, NULL)) != NULL){
+        *nup = *nup0;
+        goto ok;
+    }
+    if ((nu = calloc(1, sizeof(*nu))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if ((nu->nu_rpc = clicon_hash_init()) == NULL)
+        goto done;
+    if ((groups = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    /* User's groups, ie groups/group[user-name='%s'] */
+    if ((xgroups = xml_find_type(nc->nc_xnacm, NULL, "groups", CX_ELMNT)) != NULL){
+        xg = NULL;
+        while ((xg = xml_child_each(xgroups, xg, CX_ELMNT)) != NULL) {
+            if (strcmp(xml_name(xg), "group") != 0 ||
+                (gname = xml_find_body(xg, "name")) == NULL)
+                continue;
+            xu = NULL;
+            while ((xu = xml_child_each(xg, xu, CX_ELMNT)) != NULL)
+                if (strcmp(xml_name(xu), "user-name") == 0 &&
+                    xml_body(xu) && strcmp(xml_body(xu), username) == 0)
+                    break;
+            if (xu && cvec_add_string(groups, NULL, gname) < 0){
+                clixon_err(OE_UNIX, errno, "cvec_add_string");
+                goto done;
+            }
+        }
+    }
+    nu->nu_groups = cvec_len(groups);
+    /* Rules of rule-lists whose group leaf-list matches any of the user's groups */
+    if (nu->nu_groups && nc->nc_rules &&
+        (nu->nu_rules = calloc(nc->nc_rules, sizeof(*nu->nu_rules))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i=0; nu->nu_groups && i<nc->nc_rllen; i++){
+        nl = &nc->nc_rlists[i];
+        xlg = NULL;
+        while ((xlg = xml_child_each(nl->nl_xrlist, xlg, CX_ELMNT)) != NULL) {
+            if (strcmp(xml_name(xlg), "group") != 0 || xml_body(xlg) == NULL)
+                continue;
+            for (n=0; n<cvec_len(groups); n++)
+                if (strcmp(cv_string_get(cvec_i(groups, n)), xml_body(xlg)) == 0)
+                    break;
+            if (n < cvec_len(groups))
+                break; /* found */
+        }
+        if (xlg == NULL) /* not found */
+            continue;
+        for (j=0; j<nl->nl_len; j++)
+            nu->nu_rules[nu->nu_len++] = &nl->nl_rules[j];
+    }
+    if (clicon_hash_add(nc->nc_users, username, &nu, sizeof(nu)) == NULL)
+        goto done;
+    clixon_debug(CLIXON_DBG_NACM, "user:%s groups:%d rules:%d", username, nu->nu_groups, nu->nu_len);
+    *nup = nu;
+    nu = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (groups)
+        cvec_free(groups);
+    if (nu)
+        nacm_user_free(nu);
+    return retval;
+}
+
+/*! Resolve path of compiled data-node rule in YANG spec, once per YANG spec
+ *
+ * @param[in]  nr     Compiled rule with path
+ * @param[in]  yspec  YANG spec
+ * @retval     1      OK, nr_cplist is set
+ * @retval     0      Path does not resolve in yspec
+ * @retval    -1      Error
+ */
+static int
+nacm_rule_resolve(nacm_rule *nr,
+                  yang_stmt *yspec)
+{
+    int ret;
+
+    if (nr->nr_yspec != yspec){
+        if (nr->nr_cplist){
+            clixon_path_free(nr->nr_cplist);
+            nr->nr_cplist = NULL;
+        }
+        if ((ret = clixon_instance_id_parse(yspec, &nr->nr_cplist, NULL, "%s", nr->nr_path)) < 0)
+            return -1;
+        nr->nr_resolved = ret;
+        nr->nr_yspec = yspec;
+    }
+    return nr->nr_resolved;
+}
+
+/*! Add schema nodes with descendants of other modules to set, eg by augment
+ *
+ * @param[in]  yp    YANG schema node or module
+ * @param[in]  ymod  Real module of yp
+ * @param[in]  ny    Set
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+nacm_mixed_recurse(yang_stmt *yp,
+                   yang_stmt *ymod,
+                   nacm_yset *ny)
+{
+    yang_stmt *yc;
+    yang_stmt *ycmod = NULL;
+    int        inext = 0;
+
+    while ((yc = yn_iter(yp, &inext)) != NULL) {
+        if (!yang_datanode(yc) &&
+            yang_keyword_get(yc) != Y_CHOICE &&
+            yang_keyword_get(yc) != Y_CASE)
+            continue;
+        if (ys_real_module(yc, &ycmod) < 0)
+            return -1;
+        if (ycmod != ymod && nacm_yset_ancestors(ny, yc) < 0)
+            return -1;
+        if (nacm_mixed_recurse(yc, ycmod, ny) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*! Build read index of user: which schema nodes NACM read rules may apply beneath
+ *
+ * A subtree where no rule path target is beneath, and where all nodes are of the same
+ * module, or all rules apply to any module, gets the same rule result in all nodes.
+ * Built once per user and YANG spec.
+ * @param[in]  nc     Compiled NACM config
+ * @param[in]  nu     Compiled user
+ * @param[in]  yspec  YANG spec
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see nacm_read_uniform
+ */
+static int
+nacm_user_read_index(nacm_cache *nc,
+                     nacm_user  *nu,
+                     yang_stmt  *yspec)
+{
+    nacm_rule   *nr;
+    clixon_path *cp;
+    yang_stmt   *ymod;
+    yang_stmt   *yreal = NULL;
+    int          inext;
+    int          ret;
+    int          i;
+
+    if (nu->nu_ryspec == yspec)
+        return 0;
+    nacm_yset_reset(&nu->nu_rabove);
+    nu->nu_rskip = 1;
+    nu->nu_rmodule = 0;
+    for (i=0; i<nu->nu_len; i++){
+        nr = nu->nu_rules[i];
+        if ((nr->nr_ops & NACM_OP_READ) == 0)
+            continue;
+        if (!nr->nr_haspath){
+            if (nr->nr_rpc || nr->nr_notif)
+                continue;
+        }
+        else {
+            if (nr->nr_path == NULL)
+                continue;
+            if ((ret = nacm_rule_resolve(nr, yspec)) < 0)
+                return -1;
+            if (ret == 0) /* Never matches */
+                continue;
+            cp = PREVQ(clixon_path *, nr->nr_cplist); /* Last path element */
+            if (cp == NULL || cp->cp_yang == NULL)
+                nu->nu_rskip = 0;
+            else if (nacm_yset_ancestors(&nu->nu_rabove, cp->cp_yang) < 0)
+                return -1;
+        }
+        if (nr->nr_module && strcmp(nr->nr_module, "*") != 0)
+            nu->nu_rmodule = 1;
+    }
+    nacm_yset_sort(&nu->nu_rabove);
+    if (nu->nu_rmodule && nc->nc_myspec != yspec){
+        nacm_yset_reset(&nc->nc_mixed);
+        inext = 0;
+        while ((ymod = yn_iter(yspec, &inext)) != NULL) {
+            if (yang_keyword_get(ymod) != Y_MODULE &&
+                yang_keyword_get(ymod) != Y_SUBMODULE)
+                continue;
+            if (ys_real_module(ymod, &yreal) < 0)
+                return -1;
+            if (nacm_mixed_recurse(ymod, yreal, &nc->nc_mixed) < 0)
+                return -1;
+        }
+        nacm_yset_sort(&nc->nc_mixed);
+        nc->nc_myspec = yspec;
+    }
+    nu->nu_ryspec = yspec;
+    return 0;
+}
+
+/*! Get compiled NACM statistics
+ *
+ * @param[out]  nr      Number of compiled rules
+ * @param[out]  users   Number of compiled users
+ * @param[out]  hits    Number of NACM checks using already compiled rules
+ * @param[out]  misses  Number of NACM checks where rules were compiled
+ * @retval      0       OK
+ */
+int
+nacm_cache_stats(uint64_t *nr,
+                 uint64_t *users,
+                 uint64_t *hits,
+                 uint64_t *misses)
+{
+    char  **keys = NULL;
+    size_t  klen = 0;
+
+    if (nr)
+        *nr = _nacm_cache ? _nacm_cache->nc_rules : 0;
+    if (users){
+        *users = 0;
+        if (_nacm_cache && clicon_hash_keys(_nacm_cache->nc_users, &keys, &klen) == 0)
+            *users = klen;
+        if (keys)
+            free(keys);
+    }
+    if (hits)
+        *hits = _nacm_hits;
+    if (misses)
+        *misses = _nacm_misses;
+    return 0;
+}
+
+/*! Free compiled NACM rules
+ */
+void
+nacm_cache_exit(void)
+{
+    if (_nacm_cache){
+        nacm_cache_free(_nacm_cache);
+        _nacm_cache = NULL;
+    }
+}
+
 /*! Match nacm single rule. Either match with access or deny. Or not match.
  *
  * @param[in]  rpc    rpc name
  * @param[in]  module Yang module name
- * @param[in]  xrule  NACM rule XML tree
- * @param[out] cbret  Cligen buffer result. Set to an error msg if retval=0.
- * @retval     2      No matching rule Goto step 10
- * @retval     1      Matching rule AND Access
- * @retval     0      Matching rule AND Not access and cbret set
- * @retval    -1      Error
+ * @param[in]  nr     Compiled NACM rule
+ * @retval     1      Matching rule
+ * @retval     0      No matching rule
  * @see RFC8341 3.4.4.  Incoming RPC Message Validation
  7.(cont) A rule matches if all of the following criteria are met: 
         *  The rule's "module-name" leaf is "*" or equals the name of
@@ -132,42 +789,77 @@ match_access(char *access_operations,
            has the special value "*".
  */
 static int
-nacm_rule_rpc(char         *rpc,
-              char         *module,
-              cxobj        *xrule)
+nacm_rule_rpc(char      *rpc,
+              char      *module,
+              nacm_rule *nr)
 {
-    int    retval = -1;
-    char  *module_rule; /* rule module name */
-    char  *rpc_rule;
-    char  *access_operations;
-
     /*  7a) The rule's "module-name" leaf is "*" or equals the name of
         the YANG module where the protocol operation is defined. */
-    if ((module_rule = xml_find_body(xrule, "module-name")) == NULL)
-        goto nomatch;
-    if (strcmp(module_rule,"*") && strcmp(module_rule,module))
-        goto nomatch;
+    if (nr->nr_module == NULL)
+        return 0;
+    if (strcmp(nr->nr_module, "*") && strcmp(nr->nr_module, module))
+        return 0;
     /*  7b) Either (1) the rule does not have a "rule-type" defined or
         (2) the "rule-type" is "protocol-operation" and the
         "rpc-name" is "*" or equals the name of the requested
         protocol operation. */
-    if ((rpc_rule = xml_find_body(xrule, "rpc-name")) == NULL){
-        if (xml_find_body(xrule, "path") || xml_find_body(xrule, "notification-name"))
-            goto nomatch;
+    if (nr->nr_rpc == NULL){
+        if (nr->nr_path || nr->nr_notif)
+            return 0;
     }
-    if (rpc_rule && (strcmp(rpc_rule, "*") && strcmp(rpc_rule, rpc)))
-        goto nomatch;
+    else if (strcmp(nr->nr_rpc, "*") && strcmp(nr->nr_rpc, rpc))
+        return 0;
     /* 7c) The rule's "access-operations" leaf has the "exec" bit set or
         has the special value "*". */
-    access_operations = xml_find_body(xrule, "access-operations");
-    if (!match_access(access_operations, "exec", NULL))
-        goto nomatch;
-    retval = 1;
+    if ((nr->nr_ops & NACM_OP_EXEC) == 0)
+        return 0;
+    return 1;
+}
+
+/*! Find first rule of user matching rpc, result is saved per module and rpc
+ *
+ * @param[in]  nu     Compiled user
+ * @param[in]  rpc    rpc name
+ * @param[in]  module Yang module name
+ * @param[out] nrp    First matching rule, or NULL if no match
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+nacm_user_rpc(nacm_user  *nu,
+              char       *rpc,
+              char       *module,
+              nacm_rule **nrp)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+    int  *ip;
+    int   i;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s:%s", module, rpc);
+    if ((ip = clicon_hash_value(nu->nu_rpc, cbuf_get(cb), NULL)) != NULL)
+        i = *ip;
+    else {
+        /* 7. Process all rules, in order, until a rule that matches the requested
+           access operation is found. */
+        for (i=0; i<nu->nu_len; i++)
+            if (nacm_rule_rpc(rpc, module, nu->nu_rules[i]))
+                break;
+        if (i == nu->nu_len)
+            i = -1;
+        if (clicon_hash_add(nu->nu_rpc, cbuf_get(cb), &i, sizeof(i)) == NULL)
+            goto done;
+    }
+    *nrp = i < 0 ? NULL : nu->nu_rules[i];
+    retval = 0;
  done:
+    if (cb)
+        cbuf_free(cb);
     return retval;
- nomatch:
-    retval = 0;
-    goto done;
 }
 
 /*! Process nacm incoming RPC message validation steps
@@ -191,25 +883,12 @@ nacm_rpc(char         *rpc,
          cxobj        *xnacm,
          cbuf         *cbret)
 {
-    int     retval = -1;
-    cxobj  *xrule;
-    cxobj **gvec = NULL; /* groups */
-    size_t  glen;
-    cxobj  *rlist;
-    cxobj **rlistvec = NULL; /* rule-list */
-    size_t  rlistlen;
-    cxobj **rvec = NULL; /* rules */
-    size_t  rlen;
-    int     i, j;
-    char   *exec_default = NULL;
-    char   *gname;
-    char   *action;
-    int     match= 0;
-    cvec   *nsc = NULL;
-
-    /* Create namespace context for with nacm namespace as default */
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
-        goto done;
+    int         retval = -1;
+    nacm_cache *nc;
+    nacm_user  *nu;
+    nacm_rule  *nr = NULL;
+    char       *exec_default = NULL;
+
     /* 3.   If the requested operation is the NETCONF <close-session>
        protocol operation, then the protocol operation is permitted.
     */
@@ -222,58 +901,33 @@ nacm_rpc(char         *rpc,
        transport layer.)               */
     if (username == NULL)
         goto step10;
-
     /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
+    if (nacm_cache_get(xnacm, -1, &nc) < 0)
+        goto done;
+    if (nacm_user_get(nc, username, &nu) < 0)
         goto done;
     /* 5. If no groups are found, continue with step 10. */
-    if (glen == 0)
+    if (nu->nu_groups == 0)
         goto step10;
     /* 6. Process all rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
-        entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
-        goto done;
-    for (i=0; i<rlistlen; i++){
-        rlist = rlistvec[i];
-        /* Loop through user's group to find match in this rule-list */
-        for (j=0; j<glen; j++){
-            gname = xml_find_body(gvec[j], "name");
-            if (xpath_first(rlist, nsc, ".[group='%s']", gname)!=NULL)
-                break; /* found */
-        }
-        if (j==glen) /* not found */
-            continue;
-        /* 7. For each rule-list entry found, process all rules, in order,
+        entry. 
+       7. For each rule-list entry found, process all rules, in order,
            until a rule that matches the requested access operation is
            found.
-        */
-        if (xpath_vec(rlist, nsc, "rule", &rvec, &rlen) < 0)
-            goto done;
-        for (j=0; j<rlen; j++){
-            xrule = rvec[j];
-            if ((match = nacm_rule_rpc(rpc, module, xrule)) < 0)
-                goto done;
-            if (match)
-                break;
-        }
-        if (match)
-            break;
-        if (rvec){
-            free(rvec);
-            rvec=NULL;
-        }
-    }
-    if (match){
-        if ((action = xml_find_body(xrule, "action")) == NULL)
+    */
+    if (nacm_user_rpc(nu, rpc, module, &nr) < 0)
+        goto done;
+    if (nr){
+        if (nr->nr_action == NULL)
             goto step10;
-        if (strcmp(action, "deny")==0){
+        if (strcmp(nr->nr_action, "deny")==0){
             if (netconf_access_denied(cbret, "application", "access denied") < 0)
                 goto done;
             goto deny;
         }
-        else if (strcmp(action, "permit")==0)
+        else if (strcmp(nr->nr_action, "permit")==0)
             goto permit;
 
     }
@@ -302,14 +956,6 @@ nacm_rpc(char         *rpc,
     retval = 1;
  done:
     clixon_debug(CLIXON_DBG_NACM, "retval:%d (0:deny 1:permit)", retval);
-    if (nsc)
-        xml_nsctx_free(nsc);
-    if (gvec)
-        free(gvec);
-    if (rlistvec)
-        free(rlistvec);
-    if (rvec)
-        free(rvec);
     return retval;
  deny: /* Here, cbret must contain a netconf error msg */
     assert(cbuf_len(cbret));
@@ -320,7 +966,7 @@ nacm_rpc(char         *rpc,
 /* Local struct for keeping preparation/compiled data in NACM data path code */
 struct prepvec{
     qelem_t       pv_q;
-    cxobj        *pv_xrule;
+    nacm_rule    *pv_rule;
     clixon_xvec  *pv_xpathvec;
 };
 typedef struct prepvec prepvec;
@@ -343,7 +989,7 @@ prepvec_free(prepvec *pv_list)
 
 prepvec *
 prepvec_add(prepvec  **pv_listp,
-            cxobj     *xrule)
+            nacm_rule *nr)
 {
     prepvec *pv;
 
@@ -353,7 +999,7 @@ prepvec_add(prepvec  **pv_listp,
     }
     memset(pv, 0, sizeof(*pv));
     ADDQ(pv, *pv_listp);
-    pv->pv_xrule = xrule;
+    pv->pv_rule = nr;
     if ((pv->pv_xpathvec = clixon_xvec_new()) == NULL)
         return NULL;
     return pv;
@@ -367,6 +1013,10 @@ prepvec_add(prepvec  **pv_listp,
  *  - have read access-op, etc
  * Also make instance-id lookups on top object for each rule. Assume at most one result
  * @param[in] h      Clixon handle
+ * @param[in] xt     XML tree to lookup rule paths in
+ * @param[in] access NACM access
+ * @param[in] nu     Compiled rules of user
+ * @param[out] pv_listp Rules applicable to access with path lookups in xt
  * @retval    0      OK
  * @retval   -1      Error
  */
@@ -374,151 +1024,95 @@ static int
 nacm_datanode_prepare(clixon_handle     h,
                       cxobj            *xt,
                       enum nacm_access  access,
-                      cxobj           **gvec,
-                      size_t            glen,
-                      cxobj           **rlistvec,
-                      size_t            rlistlen,
-                      cvec             *nsc,
+                      nacm_user        *nu,
                       prepvec         **pv_listp)
 {
     int        retval = -1;
-    cxobj     *rlist;
-    int        i;
     int        j;
     int        k;
-    char      *gname;
-    cxobj    **rvec = NULL; /* rules */
-    size_t     rlen;
-    cxobj     *xrule;
-    cxobj     *pathobj;
-    char      *access_operations;
-    char      *path0;         /* Non-canonical path */
-    char      *path=NULL;     /* Canonical path */
-    cvec      *nsc0 = NULL;   /* Non-canonical namespace context */
+    nacm_rule *nr;
+    int        op;
     yang_stmt *yspec;
-    cxobj   **xvec = NULL;
-    int       xlen = 0;
-    int       ret;
-    prepvec *pv;
+    cxobj    **xvec = NULL;
+    int        xlen = 0;
+    int        ret;
+    prepvec   *pv;
 
+    switch (access){
+    case NACM_READ:
+        /* 6c) For a "read" access operation, the rule's "access-operations"
+           leaf has the "read" bit set or has the special value "*" */
+        op = NACM_OP_READ;
+        break;
+    case NACM_CREATE:
+        /* 6d) For a "create" access operation, the rule's "access-operations"
+           leaf has the "create" bit set or has the special value "*". */
+        op = NACM_OP_CREATE;
+        break;
+    case NACM_DELETE:
+        /* 6e) For a "delete" access operation, the rule's "access-operations" 
+           leaf has the "delete" bit set or has the  special value "*". */
+        op = NACM_OP_DELETE;
+        break;
+    case NACM_UPDATE:
+        /* 6f) For an "update" access operation, the rule's "access-operations"
+           leaf has the "update" bit set or has the special value "*". */ 
+        op = NACM_OP_UPDATE;
+        break;
+    default:
+        clixon_err(OE_XML, EINVAL, "Access %d unupported (shouldnt happen)", access);
+        goto done;
+        break;
+    }
     yspec = clicon_dbspec_yang(h);
-    for (i=0; i<rlistlen; i++){         /* Loop through rule list */
-        rlist = rlistvec[i];
-        /* Loop through user's group to find match in this rule-list */
-        for (j=0; j<glen; j++){
-            gname = xml_find_body(gvec[j], "name");
-            if (xpath_first(rlist, nsc, ".[group='%s']", gname)!=NULL)
-                break; /* found */
-        }
-        if (j==glen) /* not found */
+    /* 6. For each rule-list entry found, process all rules, in order,
+       until a rule that matches the requested access operation is
+       found. (see 6 sub rules in nacm_rule_datanode
+    */
+    for (j=0; j<nu->nu_len; j++){ /* Loop through rules */
+        nr = nu->nu_rules[j];
+        if ((nr->nr_ops & op) == 0)
             continue;
-        /* 6. For each rule-list entry found, process all rules, in order,
-           until a rule that matches the requested access operation is
-           found. (see 6 sub rules in nacm_rule_datanode
-        */
-        if (xpath_vec(rlist, nsc, "rule", &rvec, &rlen) < 0)
-            goto done;
-        for (j=0; j<rlen; j++){ /* Loop through rules */
-            xrule = rvec[j];
-            /* 6c) For a "read" access operation, the rule's "access-operations"
-               leaf has the "read" bit set or has the special value "*" */
-            access_operations = xml_find_body(xrule, "access-operations");
-            switch (access){
-            case NACM_READ:
-                /* 6c) For a "read" access operation, the rule's "access-operations"
-                   leaf has the "read" bit set or has the special value "*" */
-                if (!match_access(access_operations, "read", NULL))
-                    continue;
-                break;
-            case NACM_CREATE:
-                /* 6d) For a "create" access operation, the rule's "access-operations"
-                   leaf has the "create" bit set or has the special value "*". */
-                if (!match_access(access_operations, "create", "write"))
-                    continue;
-                break;
-            case NACM_DELETE:
-                /* 6e) For a "delete" access operation, the rule's "access-operations" 
-                   leaf has the "delete" bit set or has the  special value "*". */
-                if (!match_access(access_operations, "delete", "write"))
-                    continue;
-                break;
-            case NACM_UPDATE:
-                /* 6f) For an "update" access operation, the rule's "access-operations"
-                   leaf has the "update" bit set or has the special value "*". */ 
-                if (!match_access(access_operations, "update", "write"))
-                    continue;
-                break;
-            default:
-                clixon_err(OE_XML, EINVAL, "Access %d unupported (shouldnt happen)", access);
+        /*  6b) Either (1) the rule does not have a "rule-type" defined or
+            (2) the "rule-type" is "data-node" and the "path" matches the
+            requested data node, action node, or notification node. */    
+        if (!nr->nr_haspath){
+            if (nr->nr_rpc || nr->nr_notif)
+                continue;
+            /* Here a new rule is found, add it */
+            if (prepvec_add(pv_listp, nr) == NULL)
                 goto done;
-                break;
-            }
-            /*  6b) Either (1) the rule does not have a "rule-type" defined or
-                (2) the "rule-type" is "data-node" and the "path" matches the
-                requested data node, action node, or notification node. */    
-            if ((pathobj = xml_find_type(xrule, NULL, "path", CX_ELMNT)) == NULL){
-                if (xml_find_body(xrule, "rpc-name") || xml_find_body(xrule, "notification-name"))
-                    continue;
-                /* Here a new xrule is found, add it */
-                if (prepvec_add(pv_listp, xrule) == NULL)
+        }
+        else if (nr->nr_path){
+            /* See https://github.com/clicon/clixon/issues/129:
+             * Paths are not made canonical, you are back to the problem of JSON encodings
+             * Path is parsed and resolved once per rule
+             */
+            if ((ret = nacm_rule_resolve(nr, yspec)) < 0)
+                goto done;
+            if (ret == 0)
+                continue;
+            if ((ret = clixon_instance_id_search(xt, yspec, nr->nr_cplist, &xvec, &xlen)) < 0)
+                goto done;
+            if (ret == 0)
+                continue;
+            /* Here a new rule is found, add it */
+            if ((pv = prepvec_add(pv_listp, nr)) == NULL)
+                goto done;
+            for (k=0; k<xlen; k++){
+                if (clixon_xvec_append(pv->pv_xpathvec, xvec[k]) < 0)
                     goto done;
             }
-            else{
-                path0 = clixon_trim2(xml_body(pathobj), " \t\n");
-                /* Get canonical namespace context for nacm paths */
-                if ((path = strdup(path0)) == NULL){
-                    clixon_err(OE_UNIX, errno, "strdup");
-                    goto done;
-                }
-#if 0
-                /* See https://github.com/clicon/clixon/issues/129:
-                 * If this is enabled, you are back to the problem of JSON encodings
-                 */
-                /* Create namespace context for with nacm namespace as default */
-                if (xml_nsctx_node(pathobj, &nsc0) < 0)
-                    goto done;
-                /* instance-id requires canonical paths */
-                if (xpath2canonical(path0, nsc0, yspec, &path, NULL) < 0)
-                    goto done;
-#endif
-                if ((ret = clixon_xml_find_instance_id(xt, yspec, &xvec, &xlen, "%s", path)) < 0)
-                    goto done;
-                if (ret == 0)
-                    continue;
-                /* Here a new xrule is found, add it */
-                if ((pv = prepvec_add(pv_listp, xrule)) == NULL)
-                    goto done;
-                for (k=0; k<xlen; k++){
-                    if (clixon_xvec_append(pv->pv_xpathvec, xvec[k]) < 0)
-                        goto done;
-                }
-                if (xvec){
-                    free(xvec);
-                    xvec = NULL;
-                }
-                if (nsc0){
-                    cvec_free(nsc0);
-                    nsc0 = NULL;
-                }
-                if (path){
-                    free(path);
-                    path = NULL;
-                }
+            if (xvec){
+                free(xvec);
+                xvec = NULL;
             }
         }
-        if (rvec){
-            free(rvec);
-            rvec=NULL;
-        }
     }
     retval = 0;
  done:
     if (xvec)
         free(xvec);
-    if (path)
-        free(path);
-    if (nsc0)
-        cvec_free(nsc0);
     return retval;
 }
 
@@ -529,8 +1123,8 @@ nacm_datanode_prepare(clixon_handle     h,
 /*! Match specific rule to specific requested node
  *
  * @param[in]  xn       XML node (requested node)
- * @param[in]  xrule    NACM rule
- * @param[in]  xp       Xpath match
+ * @param[in]  nr       Compiled NACM rule
+ * @param[in]  xpathvec Nodes matching rule path
  * @param[in]  yspec    YANG spec
  * @retval  2  OK and rule matches permit
  * @retval  1  OK and rule matches deny
@@ -539,7 +1133,7 @@ nacm_datanode_prepare(clixon_handle     h,
  */
 static int
 nacm_data_write_xrule_xml(cxobj       *xn,
-                          cxobj       *xrule,
+                          nacm_rule   *nr,
                           clixon_xvec *xpathvec,
                           yang_stmt   *yspec)
 {
@@ -550,7 +1144,7 @@ nacm_data_write_xrule_xml(cxobj       *xn,
     cxobj     *xp;
     int        i;
 
-    if ((module_pattern = xml_find_body(xrule, "module-name")) == NULL)
+    if ((module_pattern = nr->nr_module) == NULL)
         goto nomatch;
     /* 6a) The rule's "module-name" leaf is "*" or equals the name of
      * the YANG module where the requested data node is defined. 
@@ -562,12 +1156,12 @@ nacm_data_write_xrule_xml(cxobj       *xn,
         if (ymod && strcmp(yang_argument_get(ymod), module_pattern) != 0)
             goto nomatch;
     }
-    action = xml_find_body(xrule, "action"); /* mandatory */
+    action = nr->nr_action; /* mandatory */
     /*  6b) Either (1) the rule does not have a "rule-type" defined or
         (2) the "rule-type" is "data-node" and the "path" matches the
         Requested data node, action node, or notification node. */    
-    if (xml_find_type(xrule, NULL, "path", CX_ELMNT) == NULL){
-        if (strcmp(action, "deny")==0)
+    if (!nr->nr_haspath){
+        if (action && strcmp(action, "deny")==0)
             goto deny;
         goto permit;
     }
@@ -575,7 +1169,7 @@ nacm_data_write_xrule_xml(cxobj       *xn,
         xp = clixon_xvec_i(xpathvec, i);
         /* Check if ancestor is xp (for every xpathvec?) */
         if (xn == xp || xml_isancestor(xn, xp)){
-            if (strcmp(action, "deny")==0)
+            if (action && strcmp(action, "deny")==0)
                 goto deny;
             goto permit;
         }
@@ -628,7 +1222,7 @@ nacm_datanode_write_recurse(clixon_handle h,
         do {
             /* return values: -1:Error /0:no match /1: deny /2: permit
              */
-            if ((ret = nacm_data_write_xrule_xml(xn, pv->pv_xrule, pv->pv_xpathvec, yspec)) < 0)
+            if ((ret = nacm_data_write_xrule_xml(xn, pv->pv_rule, pv->pv_xpathvec, yspec)) < 0)
                 goto done;
             switch(ret){
             case 0: /* No match, continue with next rule */
@@ -696,20 +1290,13 @@ nacm_datanode_write(clixon_handle    h,
                     cxobj           *xnacm,
                     cbuf            *cbret)
 {
-    int      retval = -1;
-    cxobj  **gvec = NULL; /* groups */
-    size_t   glen;
-    cxobj  **rlistvec = NULL; /* rule-list */
-    size_t   rlistlen;
-    cxobj  **rvec = NULL; /* rules */
-    char    *write_default = NULL;
-    cvec    *nsc = NULL;
-    int      ret;
-    prepvec *pv_list = NULL;
-
-    /* Create namespace context for with nacm namespace as default */
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
-        goto done;
+    int         retval = -1;
+    nacm_cache *nc;
+    nacm_user  *nu;
+    char       *write_default = NULL;
+    int         ret;
+    prepvec    *pv_list = NULL;
+
     if (xnacm == NULL)
         goto permit;
     /* write-default (create, update, or delete) has default deny so should never be NULL */
@@ -725,20 +1312,20 @@ nacm_datanode_write(clixon_handle    h,
     if (username == NULL)
         goto step9;
     /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
+    if (nacm_cache_get(xnacm, -1, &nc) < 0)
+        goto done;
+    if (nacm_user_get(nc, username, &nu) < 0)
         goto done;
     /* 4. If no groups are found, continue with step 9. */
-    if (glen == 0)
+    if (nu->nu_groups == 0)
         goto step9;
     /* 5. Process all rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
-        entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
-        goto done;
-    /* First run through rules and cache rules as well as lookup objects in xt. 
+        entry. (Done when user is compiled)
+       First run through rules and cache rules as well as lookup objects in xt. 
      */
-    if (nacm_datanode_prepare(h, xt, access, gvec, glen, rlistvec, rlistlen, nsc, &pv_list) < 0)
+    if (nacm_datanode_prepare(h, xt, access, nu, &pv_list) < 0)
         goto done;
     /* Then recursivelyy traverse all requested nodes */
     if ((ret = nacm_datanode_write_recurse(h, xreq, pv_list,
@@ -775,14 +1362,6 @@ nacm_datanode_write(clixon_handle    h,
     clixon_debug(CLIXON_DBG_NACM, "retval:%d (0:deny 1:permit)", retval);
     if (pv_list)
         prepvec_free(pv_list);
-    if (nsc)
-        xml_nsctx_free(nsc);
-    if (gvec)
-        free(gvec);
-    if (rlistvec)
-        free(rlistvec);
-    if (rvec)
-        free(rvec);
     return retval;
  deny: /* Here, cbret must contain a netconf error msg */
     assert(cbuf_len(cbret));
@@ -796,20 +1375,20 @@ nacm_datanode_write(clixon_handle    h,
 
 /*! Perform NACM action: mark if permit, del if deny
  *
- * @param[in] xrule    NACM rule
+ * @param[in] nr       Compiled NACM rule
  * @param[in] xn       XML node (requested node)
  * @retval    0        OK
  * @retval   -1        Error
 
  */
 static int
-nacm_data_read_action(cxobj *xrule,
-                      cxobj *xn)
+nacm_data_read_action(nacm_rule *nr,
+                      cxobj     *xn)
 {
     int   retval = -1;
     char *action;
 
-    if ((action = xml_find_body(xrule, "action")) != NULL){
+    if ((action = nr->nr_action) != NULL){
         if (strcmp(action, "deny")==0)
             xml_flag_set(xn, XML_FLAG_DEL);
         else if (strcmp(action, "permit")==0)
@@ -823,7 +1402,8 @@ nacm_data_read_action(cxobj *xrule,
 /*! Match specific rule to specific requested node
  *
  * @param[in]  xn       XML node (requested node)
- * @param[in]  xrule    NACM rule
+ * @param[in]  nr       Compiled NACM rule
+ * @param[in]  xpathvec Nodes matching rule path
  * @param[in]  yspec    YANG spec
  * @retval     1        OK and rule matches
  * @retval     0        OK and rule does not match
@@ -836,7 +1416,7 @@ nacm_data_read_action(cxobj *xrule,
  */
 static int
 nacm_data_read_xrule_xml(cxobj        *xn,
-                         cxobj        *xrule,
+                         nacm_rule    *nr,
                          clixon_xvec  *xpathvec,
                          yang_stmt    *yspec)
 {
@@ -846,7 +1426,7 @@ nacm_data_read_xrule_xml(cxobj        *xn,
     cxobj     *xp;
     int        i;
 
-    if ((module_pattern = xml_find_body(xrule, "module-name")) == NULL)
+    if ((module_pattern = nr->nr_module) == NULL)
         goto nomatch;
     /* 6a) The rule's "module-name" leaf is "*" or equals the name of
      * the YANG module where the requested data node is defined. 
@@ -860,8 +1440,8 @@ nacm_data_read_xrule_xml(cxobj        *xn,
     /*  6b) Either (1) the rule does not have a "rule-type" defined or
         (2) the "rule-type" is "data-node" and the "path" matches the
         requested data node, action node, or notification node. */    
-    if (xml_find_type(xrule, NULL, "path", CX_ELMNT) == NULL){
-        if (nacm_data_read_action(xrule, xn) < 0)
+    if (!nr->nr_haspath){
+        if (nacm_data_read_action(nr, xn) < 0)
             goto done;
         goto match;
     }
@@ -869,7 +1449,7 @@ nacm_data_read_xrule_xml(cxobj        *xn,
         xp = clixon_xvec_i(xpathvec, i);
         /* Check if ancestor is xp (for every xpathvec?) */
         if (xn == xp || xml_isancestor(xn, xp)){
-            if (nacm_data_read_action(xrule, xn) < 0)
+            if (nacm_data_read_action(nr, xn) < 0)
                 goto done;
             goto match;
         }
@@ -883,42 +1463,92 @@ nacm_data_read_xrule_xml(cxobj        *xn,
     goto done;
 }
 
+/* Per-request state of NACM read traversal */
+struct nacm_read{
+    prepvec     *nrd_pv_list;  /* Precomputed rules + paths that apply to this user group */
+    yang_stmt   *nrd_yspec;    /* YANG spec */
+    nacm_user   *nrd_user;     /* Compiled user with read index, see nacm_user_read_index */
+    nacm_cache  *nrd_cache;    /* Compiled NACM config */
+    int          nrd_defdeny;  /* read-default is deny */
+    clixon_xvec *nrd_marked;   /* Nodes marked with XML_FLAG_MARK by rules */
+};
+typedef struct nacm_read nacm_read;
+
+/*! All descendants of XML node get the same rule result as the node
+ *
+ * @param[in]  nrd     NACM read state
+ * @param[in]  ys      YANG spec of XML node
+ * @param[in]  inmount XML node is in mounted YANG
+ * @retval     1       Yes, descendants need not be checked
+ * @retval     0       No, or unknown
+ * @see nacm_user_read_index
+ */
+static int
+nacm_read_uniform(nacm_read *nrd,
+                  yang_stmt *ys,
+                  int        inmount)
+{
+    nacm_user *nu = nrd->nrd_user;
+
+    if (nu == NULL || !nu->nu_rskip)
+        return 0;
+    /* A rule path target is beneath */
+    if (nacm_yset_has(&nu->nu_rabove, ys))
+        return 0;
+    /* Nodes of other modules are beneath */
+    if (nu->nu_rmodule &&
+        (inmount ||
+         yang_flag_get(ys, YANG_FLAG_MTPOINT_POTENTIAL) ||
+         nacm_yset_has(&nrd->nrd_cache->nc_mixed, ys)))
+        return 0;
+    return 1;
+}
+
 /*! Recursive check for NACM read rules among all XML nodes
  *
- * @param[in]  h        Clixon handle
+ * Subtrees where all nodes get the same rule result are not traversed:
+ * - if a rule permits the node, it is marked and kept as a whole
+ * - if no rule matches and read-default is deny, it is removed as a whole
+ * - otherwise it is kept without marks
+ * @param[in]  nrd      NACM read state
  * @param[in]  xn       XML node (requested node)
- * @param[in]  pv_list  Precomputed rules + paths that apply to this user group
- * @param[in]  yspec    YANG spec
+ * @param[in]  upmark   An ancestor of xn is marked (permitted)
+ * @param[in]  inmount  xn is in mounted YANG
  * @retval     0        OK
  * @retval    -1        Error
  */
 static int
-nacm_datanode_read_recurse(clixon_handle h,
-                           cxobj        *xn,
-                           prepvec      *pv_list,
-                           yang_stmt    *yspec)
+nacm_datanode_read_recurse(nacm_read *nrd,
+                           cxobj     *xn,
+                           int        upmark,
+                           int        inmount)
 {
-    int      retval = -1;
-    cxobj   *x;
-    cxobj   *xprev;
-    int      ret;
-    prepvec *pv;
+    int        retval = -1;
+    cxobj     *x;
+    cxobj     *xprev;
+    int        ret = 0;
+    prepvec   *pv;
+    yang_stmt *ys;
 
-    if (xml_spec(xn)){ /* Check this node */
-        pv = pv_list;
+    if ((ys = xml_spec(xn)) != NULL){ /* Check this node */
+        pv = nrd->nrd_pv_list;
         if (pv){
             do {
                 if ((ret = nacm_data_read_xrule_xml(xn,
-                                                    pv->pv_xrule,
+                                                    pv->pv_rule,
                                                     pv->pv_xpathvec,
-                                                    yspec)) < 0)
+                                                    nrd->nrd_yspec)) < 0)
                     goto done;
                 if (ret == 1)
                     break; /* stop at first match */
                 pv = NEXTQ(prepvec *, pv);
-            } while (pv && pv != pv_list);
+            } while (pv && pv != nrd->nrd_pv_list);
+        }
+        if (ret == 1 && xml_flag(xn, XML_FLAG_MARK)){
+            if (clixon_xvec_append(nrd->nrd_marked, xn) < 0)
+                goto done;
+            upmark = 1;
         }
-
 #if 0 /* 6(A) in algorithm
        * If N did not match any rule R, and default rule is deny, remove that subtree */
         if (strcmp(read_default, "deny") == 0)
@@ -926,22 +1556,34 @@ nacm_datanode_read_recurse(clixon_handle h,
                 goto done;
 #endif
     }
-
     /* If node should be purged, dont recurse and defer removal to caller */
-    if (xml_flag(xn, XML_FLAG_DEL) == 0){
-        x = NULL;       /* Recursively check XML */
-        xprev = NULL;
-        while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
-            if (nacm_datanode_read_recurse(h, x, pv_list, yspec) < 0)
+    if (xml_flag(xn, XML_FLAG_DEL))
+        goto ok;
+    if (ys){
+        if (nacm_read_uniform(nrd, ys, inmount)){
+            /* Not marked and would be pruned, keys are leafs and are kept by the parent */
+            if (ret == 0 && nrd->nrd_defdeny && !upmark &&
+                (yang_keyword_get(ys) == Y_CONTAINER || yang_keyword_get(ys) == Y_LIST))
+                xml_flag_set(xn, XML_FLAG_DEL);
+            goto ok;
+        }
+        if (yang_flag_get(ys, YANG_FLAG_MTPOINT_POTENTIAL))
+            inmount = 1;
+    }
+    x = NULL;       /* Recursively check XML */
+    xprev = NULL;
+    while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
+        if (nacm_datanode_read_recurse(nrd, x, upmark, inmount) < 0)
+            goto done;
+        /* check for delayed remove */
+        if (xml_flag(x, XML_FLAG_DEL)){
+            if (xml_purge(x) < 0)
                 goto done;
-            /* check for delayed remove */
-            if (xml_flag(x, XML_FLAG_DEL)){
-                if (xml_purge(x) < 0)
-                    goto done;
-                x = xprev;
-            }
+            x = xprev;
         }
+        xprev = x;
     }
+ ok:
     retval = 0;
  done:
     return retval;
@@ -1005,18 +1647,12 @@ nacm_datanode_read(clixon_handle h,
                    cxobj        *xnacm)
 {
     int             retval = -1;
-    cxobj         **gvec = NULL; /* groups */
-    size_t          glen;
-    cxobj         **rlistvec = NULL; /* rule-list */
-    size_t          rlistlen;
+    nacm_cache     *nc;
+    nacm_user      *nu;
     int             i;
     char           *read_default = NULL;
-    cvec           *nsc = NULL;
-    prepvec        *pv_list = NULL;
+    nacm_read       nrd = {0,};
 
-    /* Create namespace context for with nacm namespace as default */
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
-        goto done;
     /* 3.   Check all the "group" entries to see if any of them contain a
        "user-name" entry that equals the username for the session
        making the request.  (If the "enable-external-groups" leaf is
@@ -1025,16 +1661,16 @@ nacm_datanode_read(clixon_handle h,
     if (username == NULL)
         goto step9;
     /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
+    if (nacm_cache_get(xnacm, -1, &nc) < 0)
         goto done;
-    /* 4. If no groups are found (glen=0), continue and check read-default 
+    if (nacm_user_get(nc, username, &nu) < 0)
+        goto done;
+    /* 4. If no groups are found, continue and check read-default 
           in step 11. */
     /* 5. Process all rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
-        entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
-        goto done;
+        entry. (Done when user is compiled) */
     /* read-default has default permit so should never be NULL */
     if ((read_default = xml_find_body(xnacm, "read-default")) == NULL){
         clixon_err(OE_XML, EINVAL, "No nacm read-default rule");
@@ -1043,22 +1679,31 @@ nacm_datanode_read(clixon_handle h,
     /* First run through rules and cache rules as well as lookup objects in xt. 
      * DANGER: objects could be stale if they are removed?
      */
-    if (nacm_datanode_prepare(h, xt, NACM_READ, gvec, glen, rlistvec, rlistlen, nsc, &pv_list) < 0)
+    if (nacm_datanode_prepare(h, xt, NACM_READ, nu, &nrd.nrd_pv_list) < 0)
+        goto done;
+    nrd.nrd_yspec = clicon_dbspec_yang(h);
+    nrd.nrd_cache = nc;
+    nrd.nrd_defdeny = strcmp(read_default, "deny") == 0;
+    /* Which subtrees rules may apply beneath */
+    if (nacm_user_read_index(nc, nu, nrd.nrd_yspec) < 0)
+        goto done;
+    nrd.nrd_user = nu;
+    if ((nrd.nrd_marked = clixon_xvec_new()) == NULL)
         goto done;
     /* Then recursivelyy traverse all nodes */
-    if (nacm_datanode_read_recurse(h, xt, pv_list, clicon_dbspec_yang(h)) < 0)
+    if (nacm_datanode_read_recurse(&nrd, xt, 0, 0) < 0)
         goto done;
 #if 1
     /* Step 8(B) above:
      * If default rule is deny, recursively remove all subtrees that are not marked
      */
-    if (strcmp(read_default, "deny") == 0)
+    if (nrd.nrd_defdeny)
         if (xml_tree_prune_flagged_sub(xt, XML_FLAG_MARK, 1, NULL) < 0)
             goto done;
 #endif
-    /* reset flag */
-    if (xml_apply(xt, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_MARK) < 0)
-        goto done;
+    /* reset flag, only nodes marked by rules */
+    for (i=0; i<clixon_xvec_len(nrd.nrd_marked); i++)
+        xml_flag_reset(clixon_xvec_i(nrd.nrd_marked, i), XML_FLAG_MARK);
 
     goto ok;
     /* 8.   At this point, no matching rule was found in any rule-list
@@ -1077,14 +1722,10 @@ nacm_datanode_read(clixon_handle h,
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_NACM, "retval:%d", retval);
-    if (pv_list)
-        prepvec_free(pv_list);
-    if (nsc)
-        xml_nsctx_free(nsc);
-    if (gvec)
-        free(gvec);
-    if (rlistvec)
-        free(rlistvec);
+    if (nrd.nrd_pv_list)
+        prepvec_free(nrd.nrd_pv_list);
+    if (nrd.nrd_marked)
+        clixon_xvec_free(nrd.nrd_marked);
     return retval;
 }
 
@@ -1229,7 +1870,9 @@ nacm_access_pre(clixon_handle  h,
     cxobj *xnacm = NULL;
     cvec  *nsc = NULL;
     cxobj *xerr = NULL;
+    int    gen = -1;
     int    ret;
+    nacm_cache *nc;
 
     /* Check clixon option: disabled, external tree or internal */
     mode = clicon_option_str(h, "CLICON_NACM_MODE");
@@ -1243,6 +1886,7 @@ nacm_access_pre(clixon_handle  h,
                 goto done;
     }
     else if (strcmp(mode, "internal")==0){
+        gen = xmldb_running_gen(h);
         if ((ret = xmldb_get0(h, "running", YB_MODULE, nsc, "nacm", 1, 0, &xnacm0, NULL, &xerr)) < 0)
             goto done;
         if (ret == 0){
@@ -1270,6 +1914,11 @@ nacm_access_pre(clixon_handle  h,
     if ((retval = nacm_access_check(h, xnacm, peername, username)) < 0)
         goto done;
     if (retval == 0){ /* if retval == 0 then return an xml nacm tree */
+        /* Compile NACM rules unless the NACM config is unchanged */
+        if (nacm_cache_get(xnacm, gen, &nc) < 0){
+            retval = -1;
+            goto done;
+        }
         *xnacmp = xnacm;
         xnacm = NULL;
     }
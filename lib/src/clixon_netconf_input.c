@@ -182,6 +182,9 @@ netconf_input_read2(int            s,
  * - bufp/lenp
  * - cbmsg
  * - frame_state/frame_size
+ * Data is appended to cbmsg in blocks: chunk-data of known size, and EOM data up to the
+ * next possible delimiter, is copied at once. Only framing characters are handled one at
+ * a time by the state machines.
  */
 int
 netconf_input_msg2(unsigned char      **bufp,
@@ -192,17 +195,57 @@ netconf_input_msg2(unsigned char      **bufp,
                    size_t              *frame_size,
                    int                 *eom)
 {
-    int       retval = -1;
-    int       i;
-    int       ret;
-    int       found = 0;
-    size_t    len;
-    char      ch;
+    int            retval = -1;
+    size_t         i;
+    int            ret;
+    int            found = 0;
+    size_t         len;
+    size_t         n;
+    unsigned char *p;
+    unsigned char *q;
+    char           ch;
 
     clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "");
+    p = *bufp;
     len = *lenp;
-    for (i=0; i<len; i++){
-        if ((ch = (*bufp)[i]) == 0)
+    i = 0;
+    while (i < len){
+        if (framing_type == NETCONF_SSH_CHUNKED){
+            if (*frame_state == 4 && *frame_size > 0){
+                /* Inside chunk-data: append as much as possible up to next NULL char */
+                n = len - i;
+                if (n > *frame_size)
+                    n = *frame_size;
+                if ((q = memchr(p + i, '\0', n)) != NULL)
+                    n = q - (p + i);
+                if (n > 0){
+                    if (cbuf_append_buf(cbmsg, p + i, n) < 0){
+                        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+                        goto done;
+                    }
+                    *frame_size -= n;
+                    i += n;
+                    continue;
+                }
+            }
+        }
+        else if (*frame_state == 0){
+            /* Not inside a possible delimiter: append up to next ']' or NULL char */
+            n = len - i;
+            if ((q = memchr(p + i, '\0', n)) != NULL)
+                n = q - (p + i);
+            if ((q = memchr(p + i, ']', n)) != NULL)
+                n = q - (p + i);
+            if (n > 0){
+                if (cbuf_append_buf(cbmsg, p + i, n) < 0){
+                    clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+                    goto done;
+                }
+                i += n;
+                continue;
+            }
+        }
+        if ((ch = p[i++]) == 0)
             continue; /* Skip NULL chars (eg from terminals) */
         if (framing_type == NETCONF_SSH_CHUNKED){
             /* Track chunked framing defined in RFC6242 */
@@ -232,11 +275,9 @@ netconf_input_msg2(unsigned char      **bufp,
                 found++;
             }
         }
-        if (found){
-            i++;
+        if (found)
             break;
-        }
-    } /* for */
+    } /* while */
     *bufp += i;
     *lenp -= i;
     *eom = found;
@@ -73,6 +73,7 @@
 #include "clixon_debug.h"
 #include "clixon_map.h"
 #include "clixon_file.h"
+#include "clixon_netconf_lib.h"
 #include "clixon_json.h"
 #include "clixon_text_syntax.h"
 #include "clixon_proto.h"
@@ -81,7 +82,6 @@
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
 #include "clixon_yang_parse_lib.h"
-#include "clixon_netconf_lib.h"
 #include "clixon_xml_sort.h"
 #include "clixon_xml_nsctx.h"
 #include "clixon_xml_io.h"
@@ -2100,3 +2100,44 @@ clixon_instance_id_parse(yang_stmt    *yt,
     retval = 0;
     goto done;
 }
+
+/*! Given parsed (instance-id) path and an XML tree, return matching xml node vector
+ *
+ * Same as clixon_xml_find_instance_id but the path is parsed and resolved in advance
+ * with clixon_instance_id_parse, eg when the same path is searched repeatedly.
+ * @param[in]  xt       Top xml-tree where to search
+ * @param[in]  yt       Yang statement of top symbol (can be yang-spec if top-level)
+ * @param[in]  cplist   Path parse-tree, see clixon_instance_id_parse
+ * @param[out] xvec     Vector of xml-trees. Vector must be free():d after use
+ * @param[out] xlen     Length of vector
+ * @retval     1        OK with found xml nodes in xvec (if any)
+ * @retval     0        Non-fatal failure, eg no yang
+ * @retval    -1        Error
+ * @see clixon_xml_find_instance_id
+ */
+int
+clixon_instance_id_search(cxobj       *xt,
+                          yang_stmt   *yt,
+                          clixon_path *cplist,
+                          cxobj     ***xvec,
+                          int         *xlen)
+{
+    int          retval = -1;
+    clixon_xvec *xv = NULL;
+    int          ret;
+
+    if ((ret = clixon_path_search(xt, yt, cplist, &xv)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (xv && clixon_xvec_extract(xv, xvec, xlen, NULL) < 0)
+        goto done;
+    retval = 1;
+ done:
+    if (xv)
+        clixon_xvec_free(xv);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
@@ -392,32 +392,32 @@ clixon_msg_rcv10(int         s,
                  cbuf       *cb,
                  int        *eof)
 {
-    int           retval = -1;
-    unsigned char buf[BUFSIZ];
-    int           i;
-    int           len;
-    int           xml_state = 0;
-    int           poll;
+    int            retval = -1;
+    unsigned char  buf[BUFSIZ];
+    unsigned char *p;
+    size_t         plen;
+    ssize_t        len;
+    int            xml_state = 0;
+    size_t         frame_size = 0;
+    int            eom = 0;
+    int            poll;
 
     clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "");
     *eof = 0;
-    memset(buf, 0, sizeof(buf));
     while (1){
         if ((len = netconf_input_read2(s, buf, sizeof(buf), eof)) < 0)
             goto done;
-        for (i=0; i<len; i++){
-            if (buf[i] == 0)
-                continue; /* Skip NULL chars (eg from terminals) */
-            cprintf(cb, "%c", buf[i]);
-            if (detect_endtag("]]>]]>",
-                              buf[i],
-                              &xml_state)) {
-                /* OK, we have an xml string from a client */
-                /* Remove trailer */
-                *(((char*)cbuf_get(cb)) + cbuf_len(cb) - strlen("]]>]]>")) = '\0';
-                goto ok;
-            }
-        }
+        p = buf;
+        plen = len;
+        /* Scan the whole buffer for the EOM delimiter and append data in bulk */
+        if (netconf_input_msg2(&p, &plen, cb,
+                               NETCONF_SSH_EOM,
+                               &xml_state,
+                               &frame_size,
+                               &eom) < 0)
+            goto done;
+        if (eom)
+            goto ok;
         /* poll==1 if more, poll==0 if none */
         if ((poll = clixon_event_poll(s)) < 0)
             goto done;
@@ -184,26 +184,22 @@ clicon_rpc_msg_once(clixon_handle      h,
     return retval;
 }
 
-/*! Send internal netconf rpc from client to backend
+/*! Send internal netconf rpc from client to backend and return reply as string
  *
- * @param[in]    h      Clixon handle
- * @param[in]    msg    Encoded message. Deallocate with free
- * @param[out]   xret0  Return value from backend as xml tree. Free w xml_free
- * @retval       0      OK
- * @retval      -1      Error
- * @note xret is populated with yangspec according to standard handle yangspec
+ * @param[in]    h        Clixon handle
+ * @param[in]    msg      Encoded message. Deallocate with free
+ * @param[out]   retdata  Reply from backend, not parsed. Free with free
+ * @retval       0        OK
+ * @retval      -1        Error
  * @note side-effect, a socket created here is cached
- * @see clicon_rpc_msg_persistent
- * @see clicon_rpc_close_session
+ * @see clicon_rpc_msg
  */
-int
-clicon_rpc_msg(clixon_handle      h,
-               struct clicon_msg *msg,
-               cxobj            **xret0)
+static int
+clicon_rpc_msg_str(clixon_handle      h,
+                   struct clicon_msg *msg,
+                   char             **retdata)
 {
     int     retval = -1;
-    char   *retdata = NULL;
-    cxobj  *xret = NULL;
     int     s = -1;
     int     eof = 0;
 
@@ -212,7 +208,7 @@ clicon_rpc_msg(clixon_handle      h,
     assert(strstr(msg->op_body, "username")!=NULL); /* XXX */
 #endif
     /* Create a socket and connect to it, either UNIX, IPv4 or IPv6 per config options */
-    if (clicon_rpc_msg_once(h, msg, 1, &retdata, &eof, &s) < 0)
+    if (clicon_rpc_msg_once(h, msg, 1, retdata, &eof, &s) < 0)
         goto done;
     if (eof){
         /* 2. check socket shutdown AFTER rpc */
@@ -221,7 +217,7 @@ clicon_rpc_msg(clixon_handle      h,
         clicon_client_socket_set(h, -1);
 #ifdef PROTO_RESTART_RECONNECT
         if (!clixon_exit_get()) { /* May be part of termination */
-            if (clicon_rpc_msg_once(h, msg, 1, &retdata, &eof, NULL) < 0)
+            if (clicon_rpc_msg_once(h, msg, 1, retdata, &eof, NULL) < 0)
                 goto done;
             if (eof){
                 close(s);
@@ -240,7 +236,34 @@ clicon_rpc_msg(clixon_handle      h,
         goto done;
 #endif
     }
+    retval = 0;
+ done:
+    return retval;
+}
 
+/*! Send internal netconf rpc from client to backend
+ *
+ * @param[in]    h      Clixon handle
+ * @param[in]    msg    Encoded message. Deallocate with free
+ * @param[out]   xret0  Return value from backend as xml tree. Free w xml_free
+ * @retval       0      OK
+ * @retval      -1      Error
+ * @note xret is populated with yangspec according to standard handle yangspec
+ * @note side-effect, a socket created here is cached
+ * @see clicon_rpc_msg_persistent
+ * @see clicon_rpc_close_session
+ */
+int
+clicon_rpc_msg(clixon_handle      h,
+               struct clicon_msg *msg,
+               cxobj            **xret0)
+{
+    int     retval = -1;
+    char   *retdata = NULL;
+    cxobj  *xret = NULL;
+
+    if (clicon_rpc_msg_str(h, msg, &retdata) < 0)
+        goto done;
     if (retdata){
         /* Cannot populate xret here because need to know RPC name (eg "lock") in order to associate yang
          * to reply.
@@ -918,6 +941,166 @@ clicon_rpc_unlock(clixon_handle h,
     return retval;
 }
 
+/*! Create internal get rpc message
+ *
+ * @param[in]  h         Clixon handle
+ * @param[in]  xpath     XPath in a filter stmt (or NULL/"" for no filter)
+ * @param[in]  nsc       Namespace context for filter
+ * @param[in]  content   Clixon extension: all, config, noconfig. -1 means all
+ * @param[in]  depth     Nr of XML levels to get, -1 is all, 0 is none
+ * @param[in]  defaults  Value of the with-defaults mode, rfc6243, or NULL
+ * @param[in]  json      Clixon extension: -1: XML reply, 0: JSON reply, 1: pretty-printed JSON
+ * @param[out] msgp      Encoded message. Free with free
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+clicon_rpc_get_msg(clixon_handle       h,
+                   char               *xpath,
+                   cvec               *nsc,
+                   netconf_content     content,
+                   int32_t             depth,
+                   char               *defaults,
+                   int                 json,
+                   struct clicon_msg **msgp)
+{
+    int                retval = -1;
+    cbuf              *cb = NULL;
+    char              *username;
+    uint32_t           session_id;
+
+    if (session_id_check(h, &session_id) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
+    cprintf(cb, " xmlns:%s=\"%s\"", NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE);
+    if ((username = clicon_username_get(h)) != NULL){
+        cprintf(cb, " %s:username=\"%s\"", CLIXON_LIB_PREFIX, username);
+        cprintf(cb, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+    }
+    cprintf(cb, " message-id=\"%d\"", netconf_message_id_next(h));
+    cprintf(cb, "><get");
+    /* Clixon extension, content=all,config, or nonconfig */
+    if ((int)content != -1)
+        cprintf(cb, " %s:content=\"%s\" xmlns:%s=\"%s\"",
+                CLIXON_LIB_PREFIX,
+                netconf_content_int2str(content),
+                CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+    /* Clixon extension, depth=<level> */
+    if (depth != -1)
+        cprintf(cb, " %s:depth=\"%d\" xmlns:%s=\"%s\"",
+                CLIXON_LIB_PREFIX,
+                depth,
+                CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+    /* Clixon extension, encoding=json and pretty=true */
+    if (json != -1){
+        cprintf(cb, " %s:encoding=\"json\" xmlns:%s=\"%s\"",
+                CLIXON_LIB_PREFIX,
+                CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+        if (json)
+            cprintf(cb, " %s:pretty=\"true\"", CLIXON_LIB_PREFIX);
+    }
+    cprintf(cb, ">"); /* get */
+    /* If xpath, add a filter */
+    if (xpath && strlen(xpath)) {
+        cprintf(cb, "<%s:filter %s:type=\"xpath\" %s:select=\"",
+                NETCONF_BASE_PREFIX, NETCONF_BASE_PREFIX, NETCONF_BASE_PREFIX);
+        if (xml_chardata_cbuf_append(cb, 1, xpath) < 0)
+            goto done;
+        cprintf(cb, "\"");
+        if (xml_nsctx_cbuf(cb, nsc) < 0)
+            goto done;
+        cprintf(cb, "/>");
+    }
+    if (defaults != NULL)
+        cprintf(cb, "<with-defaults xmlns=\"%s\">%s</with-defaults>",
+                IETF_NETCONF_WITH_DEFAULTS_YANG_NAMESPACE,
+                defaults);
+    cprintf(cb, "</get></rpc>");
+    if ((*msgp = clicon_msg_encode(session_id,
+                                   "%s", cbuf_get(cb))) == NULL)
+        goto done;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Bind and extract data or error of an internal get reply
+ *
+ * @param[in]  h         Clixon handle
+ * @param[in]  xret      Reply from backend, or NULL
+ * @param[in]  bind      Bind data to yang
+ * @param[out] xt        XML tree, either <data> or <rpc-error>. Free with xml_free
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+clicon_rpc_get_reply(clixon_handle h,
+                     cxobj        *xret,
+                     int           bind,
+                     cxobj       **xt)
+{
+    int                retval = -1;
+    cxobj             *xerr = NULL;
+    cxobj             *xd = NULL;
+    int                ret;
+    yang_stmt         *yspec;
+    cvec              *nscd = NULL;
+
+    yspec = clicon_dbspec_yang(h);
+    /* Send xml error back: first check error, then ok */
+    if ((xd = xpath_first(xret, NULL, "/rpc-reply/rpc-error")) != NULL)
+        xd = xml_parent(xd); /* point to rpc-reply */
+    else if ((xd = xpath_first(xret, NULL, "/rpc-reply/data")) == NULL){
+        if ((xd = xml_new(NETCONF_OUTPUT_DATA, NULL, CX_ELMNT)) == NULL)
+            goto done;
+        if (xml_bind_special(xd, yspec, "/nc:get/output/data") < 0)
+            goto done;
+    }
+    else{
+        if (xml_bind_special(xd, yspec, "/nc:get/output/data") < 0)
+            goto done;
+        if (bind){
+            if ((ret = xml_bind_yang(h, xd, YB_MODULE, yspec, &xerr)) < 0)
+                goto done;
+            if (ret == 0){
+                if (clixon_netconf_internal_error(xerr,
+                                                  ". Internal error, backend returned invalid XML.",
+                                                  NULL) < 0)
+                    goto done;
+                xd = xerr;
+                xerr = NULL;
+            }
+        }
+    }
+    if (xt && xd){
+        /* Sync namespaces, ie explicitly set all xmlns attributes to xd */
+        if (xml_nsctx_node(xd, &nscd) < 0)
+            goto done;
+        if (xml_rm(xd) < 0)
+            goto done;
+        if (xmlns_set_all(xd, nscd) < 0)
+            goto done;
+        xml_sort(xd); /* Ensure attr is first */
+        *xt = xd;
+        xd = NULL;
+    }
+    retval = 0;
+  done:
+    if (nscd)
+        cvec_free(nscd);
+    if (xerr)
+        xml_free(xerr);
+    if (xd && xml_parent(xd) == NULL)
+        xml_free(xd);
+    return retval;
+}
+
 /*! Get database configuration and state data
  *
  * @param[in]  h         Clixon handle
@@ -1014,118 +1197,129 @@ clicon_rpc_get2(clixon_handle   h,
 {
     int                retval = -1;
     struct clicon_msg *msg = NULL;
-    cbuf              *cb = NULL;
     cxobj             *xret = NULL;
-    cxobj             *xerr = NULL;
-    cxobj             *xd = NULL;
-    char              *username;
-    uint32_t           session_id;
-    int                ret;
-    yang_stmt         *yspec;
-    cvec              *nscd = NULL;
 
     clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "");
-    if (session_id_check(h, &session_id) < 0)
+    if (clicon_rpc_get_msg(h, xpath, nsc, content, depth, defaults, -1, &msg) < 0)
+        goto done;
+    if (clicon_rpc_msg(h, msg, &xret) < 0)
+        goto done;
+    if (clicon_rpc_get_reply(h, xret, bind, xt) < 0)
+        goto done;
+    retval = 0;
+  done:
+    clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "retval:%d", retval);
+    if (xret)
+        xml_free(xret);
+    if (msg)
+        free(msg);
+    return retval;
+}
+
+/*! Get database configuration and state data encoded as JSON by the backend
+ *
+ * Same as clicon_rpc_get2 but the backend encodes the data as JSON (RFC 7951) directly from
+ * its tree, and the reply is not parsed.
+ * The JSON of the whole data tree is returned if xpath is NULL or "/", otherwise of the objects
+ * selected by xpath, as clixon_json2cbuf and xml2json_cbuf_vec respectively.
+ * If the backend cannot encode the reply as JSON, eg an error, if depth is set or with-defaults
+ * is report-all-tagged, the reply is returned as XML as by clicon_rpc_get.
+ * @param[in]  h         Clixon handle
+ * @param[in]  xpath     XPath in a filter stmt (or NULL/"" for no filter)
+ * @param[in]  nsc       Namespace context for filter
+ * @param[in]  content   Clixon extension: all, config, noconfig. -1 means all
+ * @param[in]  depth     Nr of XML levels to get, -1 is all, 0 is none
+ * @param[in]  defaults  Value of the with-defaults mode, rfc6243, or NULL
+ * @param[in]  pretty    Set if JSON is pretty-printed
+ * @param[out] cbjson    JSON of data is appended, if retval is 1
+ * @param[out] count     Number of objects selected by xpath, if retval is 1
+ * @param[out] xt        XML tree, if retval is 0, see clicon_rpc_get. Free with xml_free.
+ * @retval     1         OK, JSON in cbjson
+ * @retval     0         OK, XML in xt
+ * @retval    -1         Error, fatal or xml
+ * @see clicon_rpc_get
+ */
+int
+clicon_rpc_get_json(clixon_handle   h,
+                    char           *xpath,
+                    cvec           *nsc,
+                    netconf_content content,
+                    int32_t         depth,
+                    char           *defaults,
+                    int             pretty,
+                    cbuf           *cbjson,
+                    int            *count,
+                    cxobj         **xt)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    char              *retdata = NULL;
+    cxobj             *xret = NULL;
+    cbuf              *cb = NULL;
+    char              *str;
+    char              *end;
+    char              *p;
+    size_t             len;
+
+    clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "");
+    if (clicon_rpc_get_msg(h, xpath, nsc, content, depth, defaults, pretty, &msg) < 0)
+        goto done;
+    if (clicon_rpc_msg_str(h, msg, &retdata) < 0)
         goto done;
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_XML, errno, "cbuf_new");
         goto done;
     }
-    cprintf(cb, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
-    cprintf(cb, " xmlns:%s=\"%s\"", NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE);
-    if ((username = clicon_username_get(h)) != NULL){
-        cprintf(cb, " %s:username=\"%s\"", CLIXON_LIB_PREFIX, username);
-        cprintf(cb, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
-    }
-    cprintf(cb, " message-id=\"%d\"", netconf_message_id_next(h));
-    cprintf(cb, "><get");
-    /* Clixon extension, content=all,config, or nonconfig */
-    if ((int)content != -1)
-        cprintf(cb, " %s:content=\"%s\" xmlns:%s=\"%s\"",
-                CLIXON_LIB_PREFIX,
-                netconf_content_int2str(content),
-                CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
-    /* Clixon extension, depth=<level> */
-    if (depth != -1)
-        cprintf(cb, " %s:depth=\"%d\" xmlns:%s=\"%s\"",
-                CLIXON_LIB_PREFIX,
-                depth,
-                CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
-    cprintf(cb, ">"); /* get */
-    /* If xpath, add a filter */
-    if (xpath && strlen(xpath)) {
-        cprintf(cb, "<%s:filter %s:type=\"xpath\" %s:select=\"",
-                NETCONF_BASE_PREFIX, NETCONF_BASE_PREFIX, NETCONF_BASE_PREFIX);
-        if (xml_chardata_cbuf_append(cb, 1, xpath) < 0)
+    /* Reply on the form:
+     * <rpc-reply xmlns="..."><cl:json xmlns:cl="..." count="N"><![CDATA[...]]></cl:json></rpc-reply>
+     * see the backend get_json_reply
+     */
+    cprintf(cb, "<rpc-reply xmlns=\"%s\"><%s:json xmlns:%s=\"%s\" count=\"",
+            NETCONF_BASE_NAMESPACE,
+            CLIXON_LIB_PREFIX, CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+    if (retdata == NULL ||
+        strncmp(retdata, cbuf_get(cb), cbuf_len(cb)) != 0){
+        /* Not JSON, eg an error */
+        if (retdata &&
+            clixon_xml_parse_string(retdata, YB_NONE, NULL, &xret, NULL) < 0)
             goto done;
-        cprintf(cb, "\"");
-        if (xml_nsctx_cbuf(cb, nsc) < 0)
+        if (clicon_rpc_get_reply(h, xret, 1, xt) < 0)
             goto done;
-        cprintf(cb, "/>");
-    }
-    if (defaults != NULL)
-        cprintf(cb, "<with-defaults xmlns=\"%s\">%s</with-defaults>",
-                IETF_NETCONF_WITH_DEFAULTS_YANG_NAMESPACE,
-                defaults);
-    cprintf(cb, "</get></rpc>");
-    if ((msg = clicon_msg_encode(session_id,
-                                 "%s", cbuf_get(cb))) == NULL)
-        goto done;
-    if (clicon_rpc_msg(h, msg, &xret) < 0)
+        retval = 0;
         goto done;
-    yspec = clicon_dbspec_yang(h);
-    /* Send xml error back: first check error, then ok */
-    if ((xd = xpath_first(xret, NULL, "/rpc-reply/rpc-error")) != NULL)
-        xd = xml_parent(xd); /* point to rpc-reply */
-    else if ((xd = xpath_first(xret, NULL, "/rpc-reply/data")) == NULL){
-        if ((xd = xml_new(NETCONF_OUTPUT_DATA, NULL, CX_ELMNT)) == NULL)
-            goto done;
-        if (xml_bind_special(xd, yspec, "/nc:get/output/data") < 0)
-            goto done;
     }
-    else{
-        if (xml_bind_special(xd, yspec, "/nc:get/output/data") < 0)
-            goto done;
-        if (bind){
-            if ((ret = xml_bind_yang(h, xd, YB_MODULE, yspec, &xerr)) < 0)
-                goto done;
-            if (ret == 0){
-                if (clixon_netconf_internal_error(xerr,
-                                                  ". Internal error, backend returned invalid XML.",
-                                                  NULL) < 0)
-                    goto done;
-                xd = xerr;
-                xerr = NULL;
-            }
-        }
+    str = retdata + cbuf_len(cb);
+    *count = strtol(str, &str, 10);
+    cbuf_reset(cb);
+    cprintf(cb, "]]></%s:json></rpc-reply>", CLIXON_LIB_PREFIX);
+    if (strncmp(str, "\"><![CDATA[", strlen("\"><![CDATA[")) != 0 ||
+        (len = strlen(str)) < strlen("\"><![CDATA[") + cbuf_len(cb) ||
+        strcmp(str + len - cbuf_len(cb), cbuf_get(cb)) != 0){
+        clixon_err(OE_PROTO, 0, "Malformed JSON reply from backend");
+        goto done;
     }
-    if (xt && xd){
-        /* Sync namespaces, ie explicitly set all xmlns attributes to xd */
-        if (xml_nsctx_node(xd, &nscd) < 0)
-            goto done;
-        if (xml_rm(xd) < 0)
-            goto done;
-        if (xmlns_set_all(xd, nscd) < 0)
-            goto done;
-        xml_sort(xd); /* Ensure attr is first */
-        *xt = xd;
-        xd = NULL;
+    str += strlen("\"><![CDATA[");
+    end = retdata + strlen(retdata) - cbuf_len(cb);
+    *end = '\0';
+    /* "]]>" in JSON is split in two CDATA sections by the backend */
+    while ((p = strstr(str, "]]]]><![CDATA[>")) != NULL){
+        *p = '\0';
+        cbuf_append_str(cbjson, str);
+        cbuf_append_str(cbjson, "]]");
+        str = p + strlen("]]]]><![CDATA[");
     }
-    retval = 0;
+    cbuf_append_str(cbjson, str);
+    retval = 1;
   done:
     clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "retval:%d", retval);
-    if (nscd)
-        cvec_free(nscd);
     if (cb)
         cbuf_free(cb);
-    if (xerr)
-        xml_free(xerr);
     if (xret)
         xml_free(xret);
+    if (retdata)
+        free(retdata);
     if (msg)
         free(msg);
-    if (xd)
-        xml_free(xd);
     return retval;
 }
 
@@ -78,6 +78,7 @@
 #include "clixon_yang_schema_mount.h"
 #include "clixon_xml_default.h"
 #include "clixon_xml_map.h"
+#include "clixon_xml_sort.h"
 #include "clixon_xml_bind.h"
 #include "clixon_validate_minmax.h"
 #include "clixon_validate.h"
@@ -1209,30 +1210,22 @@ xml_yang_validate_leaf_union(clixon_handle h,
     goto done;
 }
 
-/*! Validate a single XML node with yang specification for all (not only added) entries
+/*! Validate a single XML node with yang specification, optionally recursively
  *
- * 1. Check leafrefs. Eg you delete a leaf and a leafref references it.
- * @param[in]  xt  XML node to be validated
- * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
- * @retval     1     Validation OK
- * @retval     0     Validation failed (cbret set)
- * @retval    -1     Error
- * @code
- *   cxobj *x;
- *   cbuf *xret = NULL;
- *   if ((ret = xml_yang_validate_all(h, x, &xret)) < 0)
- *      err;
- *   if (ret == 0)
- *      fail;
- *   xml_free(xret);
- * @endcode
- * @see xml_yang_validate_add
- * @see xml_yang_validate_rpc
+ * @param[in]  h       Clixon handle
+ * @param[in]  xt      XML node to be validated
+ * @param[in]  recurse If set, validate all descendants, otherwise only xt and its child lists
+ * @param[out] xret    Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1       Validation OK
+ * @retval     0       Validation failed (cbret set)
+ * @retval    -1       Error
+ * @see xml_yang_validate_all
  */
-int
-xml_yang_validate_all(clixon_handle h,
-                      cxobj        *xt,
-                      cxobj       **xret)
+static int
+xml_yang_validate_all1(clixon_handle h,
+                       cxobj        *xt,
+                       int           recurse,
+                       cxobj       **xret)
 {
     int        retval = -1;
     yang_stmt *yt;  /* yang node associated with xt */
@@ -1387,8 +1380,8 @@ xml_yang_validate_all(clixon_handle h,
         }
     }
     x = NULL;
-    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
-        if ((ret = xml_yang_validate_all(h, x, xret)) < 0)
+    while (recurse && (x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+        if ((ret = xml_yang_validate_all1(h, x, 1, xret)) < 0)
             goto done;
         if (ret == 0)
             goto fail;
@@ -1416,6 +1409,34 @@ xml_yang_validate_all(clixon_handle h,
     goto done;
 }
 
+/*! Validate a single XML node with yang specification for all (not only added) entries
+ *
+ * 1. Check leafrefs. Eg you delete a leaf and a leafref references it.
+ * @param[in]  xt  XML node to be validated
+ * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1     Validation OK
+ * @retval     0     Validation failed (cbret set)
+ * @retval    -1     Error
+ * @code
+ *   cxobj *x;
+ *   cbuf *xret = NULL;
+ *   if ((ret = xml_yang_validate_all(h, x, &xret)) < 0)
+ *      err;
+ *   if (ret == 0)
+ *      fail;
+ *   xml_free(xret);
+ * @endcode
+ * @see xml_yang_validate_add
+ * @see xml_yang_validate_rpc
+ */
+int
+xml_yang_validate_all(clixon_handle h,
+                      cxobj        *xt,
+                      cxobj       **xret)
+{
+    return xml_yang_validate_all1(h, xt, 1, xret);
+}
+
 /*! Validate a single XML node with yang specification
  *
  * @param[in]  h     Clixon handle
@@ -1442,6 +1463,498 @@ xml_yang_validate_all_top(clixon_handle h,
     return 1;
 }
 
+/*! Add name of a node and its descendants to a name set
+ *
+ * @param[in]  names    Name set
+ * @param[in]  x        XML node
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+validate_names_subtree(clicon_hash_t *names,
+                       cxobj         *x)
+{
+    cxobj *xc;
+
+    if (clicon_hash_lookup(names, xml_name(x)) == NULL &&
+        clicon_hash_add(names, xml_name(x), NULL, 0) == NULL)
+        return -1;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+        if (validate_names_subtree(names, xc) < 0)
+            return -1;
+    return 0;
+}
+
+/*! Add names of a changed node, its descendants and its ancestors to a name set
+ *
+ * Ancestors are added since the string value of a node depends on its descendants
+ * @param[in]  names    Name set
+ * @param[in]  x        XML node
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+validate_names_add(clicon_hash_t *names,
+                   cxobj         *x)
+{
+    cxobj *xp;
+
+    if (validate_names_subtree(names, x) < 0)
+        return -1;
+    for (xp = xml_parent(x); xp && xml_parent(xp) != NULL; xp = xml_parent(xp))
+        if (clicon_hash_lookup(names, xml_name(xp)) == NULL &&
+            clicon_hash_add(names, xml_name(xp), NULL, 0) == NULL)
+            return -1;
+    return 0;
+}
+
+/*! Check if XPath dependency names intersect with a name set
+ *
+ * @param[in]  deps   XPath dependency names, or NULL if unknown
+ * @param[in]  names  Name set
+ * @retval     1      Intersect, or dependencies unknown
+ * @retval     0      Disjoint
+ * @see ys_populate_xpath_deps
+ */
+static int
+validate_deps_match(cvec          *deps,
+                    clicon_hash_t *names)
+{
+    cg_var *cv = NULL;
+    char   *name;
+
+    if (deps == NULL)
+        return 1;
+    while ((cv = cvec_each(deps, cv)) != NULL){
+        name = cv_name_get(cv);
+        if (strcmp(name, "*") == 0 || clicon_hash_lookup(names, name) != NULL)
+            return 1;
+    }
+    return 0;
+}
+
+/*! Check if leafrefs of a resolved type depend on a name set, also in union members
+ *
+ * @param[in]  ys        Yang leaf or leaf-list
+ * @param[in]  yrestype  Resolved type
+ * @param[in]  names     Name set
+ * @retval     1         Depends
+ * @retval     0         Does not depend
+ * @retval    -1         Error
+ */
+static int
+validate_type_deps(yang_stmt     *ys,
+                   yang_stmt     *yrestype,
+                   clicon_hash_t *names)
+{
+    yang_stmt *ytsub;
+    yang_stmt *ytype;
+    yang_stmt *ypath;
+    char      *restype;
+    int        inext;
+    int        ret;
+
+    if (yrestype == NULL)
+        return 0;
+    restype = yang_argument_get(yrestype);
+    if (strcmp(restype, "leafref") == 0){
+        if ((ypath = yang_find(yrestype, Y_PATH, NULL)) == NULL)
+            return 1;
+        return validate_deps_match(yang_cvec_get(ypath), names);
+    }
+    if (strcmp(restype, "union") == 0){
+        inext = 0;
+        while ((ytsub = yn_iter(yrestype, &inext)) != NULL){
+            if (yang_keyword_get(ytsub) != Y_TYPE)
+                continue;
+            if (yang_type_resolve(ys, ys, ytsub, &ytype, NULL, NULL, NULL, NULL, NULL) < 0)
+                return -1;
+            if ((ret = validate_type_deps(ys, ytype, names)) != 0)
+                return ret;
+        }
+    }
+    return 0;
+}
+
+/*! Check if must, when or leafref constraints of a data node depend on a name set
+ *
+ * @param[in]  ys     Yang data node
+ * @param[in]  names  Name set
+ * @retval     2      When condition depends, also parent needs validation (eg mandatory)
+ * @retval     1      Must or leafref depends
+ * @retval     0      No dependency
+ * @retval    -1      Error
+ */
+static int
+validate_yang_deps(yang_stmt     *ys,
+                   clicon_hash_t *names)
+{
+    yang_stmt *yc;
+    yang_stmt *yrestype;
+    int        inext;
+    int        must = 0;
+
+    /* Augment and uses when */
+    if ((yc = yang_when_get(NULL, ys)) != NULL &&
+        validate_deps_match(yang_cvec_get(yc), names))
+        return 2;
+    inext = 0;
+    while ((yc = yn_iter(ys, &inext)) != NULL){
+        switch (yang_keyword_get(yc)){
+        case Y_WHEN:
+            if (validate_deps_match(yang_cvec_get(yc), names))
+                return 2;
+            break;
+        case Y_MUST:
+            if (validate_deps_match(yang_cvec_get(yc), names))
+                must = 1;
+            break;
+        default:
+            break;
+        }
+    }
+    if (must)
+        return 1;
+    switch (yang_keyword_get(ys)){
+    case Y_LEAF:
+    case Y_LEAF_LIST:
+        if (yang_type_get(ys, NULL, &yrestype, NULL, NULL, NULL, NULL, NULL) < 0)
+            return -1;
+        return validate_type_deps(ys, yrestype, names);
+    default:
+        break;
+    }
+    return 0;
+}
+
+/*! Validate a node locally, ie not its descendants, unless already done
+ *
+ * @param[in]     h     Clixon handle
+ * @param[in]     x     XML node
+ * @param[in,out] vec   Vector of validated nodes, marked with XML_FLAG_MARK
+ * @param[in,out] len   Length of vec
+ * @param[out]    xret  Error XML tree (if retval=0)
+ * @retval        1     Validation OK
+ * @retval        0     Validation failed (xret set)
+ * @retval       -1     Error
+ */
+static int
+validate_local(clixon_handle h,
+               cxobj        *x,
+               cxobj      ***vec,
+               int          *len,
+               cxobj       **xret)
+{
+    if (xml_flag(x, XML_FLAG_MARK))
+        return 1;
+    xml_flag_set(x, XML_FLAG_MARK);
+    if (cxvec_append(x, vec, len) < 0)
+        return -1;
+    return xml_yang_validate_all1(h, x, 0, xret);
+}
+
+/*! Validate all instances of a yang data node given its data ancestors
+ *
+ * @param[in]     h      Clixon handle
+ * @param[in]     xp     XML parent
+ * @param[in]     ychain Yang data node chain from top-level to node
+ * @param[in]     i      Index in ychain of children of xp
+ * @param[in]     n      Length of ychain
+ * @param[in,out] vec    Vector of validated nodes
+ * @param[in,out] len    Length of vec
+ * @param[out]    xret   Error XML tree (if retval=0)
+ * @retval        1      Validation OK
+ * @retval        0      Validation failed (xret set)
+ * @retval       -1      Error
+ */
+static int
+validate_instances(clixon_handle h,
+                   cxobj        *xp,
+                   yang_stmt   **ychain,
+                   int           i,
+                   int           n,
+                   cxobj      ***vec,
+                   int          *len,
+                   cxobj       **xret)
+{
+    cxobj *x;
+    int    ret;
+
+    x = NULL;
+    while ((x = xml_child_each(xp, x, CX_ELMNT)) != NULL) {
+        if (xml_spec(x) != ychain[i])
+            continue;
+        if (i == n-1)
+            ret = validate_local(h, x, vec, len, xret);
+        else
+            ret = validate_instances(h, x, ychain, i+1, n, vec, len, xret);
+        if (ret < 1)
+            return ret;
+    }
+    return 1;
+}
+
+/*! Get data node ancestor chain of yang data node, skipping choice and case
+ *
+ * @param[in]  ys      Yang data node
+ * @param[out] ychain  Vector of data nodes from top-level to ys. Free after use
+ * @param[out] n       Length of ychain
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+validate_yang_chain(yang_stmt   *ys,
+                    yang_stmt ***ychain,
+                    int         *n)
+{
+    yang_stmt *y;
+    int        i;
+
+    *n = 0;
+    for (y = ys; y != NULL; y = yang_parent_get(y))
+        if (yang_datanode(y))
+            (*n)++;
+    if ((*ychain = calloc(*n, sizeof(yang_stmt*))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    i = *n;
+    for (y = ys; y != NULL; y = yang_parent_get(y))
+        if (yang_datanode(y))
+            (*ychain)[--i] = y;
+    return 0;
+}
+
+/*! Validate instances of yang data nodes whose constraints depend on a name set
+ *
+ * @param[in]     h      Clixon handle
+ * @param[in]     yn     Yang node: module, submodule, choice, case or data node
+ * @param[in]     xt     XML top of target tree
+ * @param[in]     names  Name set
+ * @param[in,out] vec    Vector of validated nodes
+ * @param[in,out] len    Length of vec
+ * @param[out]    xret   Error XML tree (if retval=0)
+ * @retval        1      Validation OK
+ * @retval        0      Validation failed (xret set)
+ * @retval       -1      Error
+ */
+static int
+validate_deps_yang(clixon_handle  h,
+                   yang_stmt     *yn,
+                   cxobj         *xt,
+                   clicon_hash_t *names,
+                   cxobj       ***vec,
+                   int           *len,
+                   cxobj        **xret)
+{
+    int         retval = -1;
+    yang_stmt  *yc;
+    yang_stmt **ychain = NULL;
+    int         n;
+    int         inext;
+    int         dep;
+    int         ret;
+
+    inext = 0;
+    while ((yc = yn_iter(yn, &inext)) != NULL){
+        if (yang_keyword_get(yc) == Y_CHOICE || yang_keyword_get(yc) == Y_CASE){
+            if ((ret = validate_deps_yang(h, yc, xt, names, vec, len, xret)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+            continue;
+        }
+        if (!yang_datanode(yc) || yang_config(yc) == 0)
+            continue;
+        /* Skip top-level nodes without instances */
+        if ((yang_keyword_get(yn) == Y_MODULE || yang_keyword_get(yn) == Y_SUBMODULE) &&
+            xml_find_type(xt, NULL, yang_argument_get(yc), CX_ELMNT) == NULL)
+            continue;
+        if ((dep = validate_yang_deps(yc, names)) < 0)
+            goto done;
+        if (dep){
+            if (validate_yang_chain(yc, &ychain, &n) < 0)
+                goto done;
+            /* When conditions also affect mandatory checks of the parent */
+            if (dep == 2 && n > 1){
+                if ((ret = validate_instances(h, xt, ychain, 0, n-1, vec, len, xret)) < 0)
+                    goto done;
+                if (ret == 0)
+                    goto fail;
+            }
+            if ((ret = validate_instances(h, xt, ychain, 0, n, vec, len, xret)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+            free(ychain);
+            ychain = NULL;
+        }
+        if ((ret = validate_deps_yang(h, yc, xt, names, vec, len, xret)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    retval = 1;
+ done:
+    if (ychain)
+        free(ychain);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Find target node corresponding to the parent of a deleted source node
+ *
+ * @param[in]  xt   XML top of target tree
+ * @param[in]  xs   Deleted node in source tree
+ * @param[out] xtp  Target parent, or deepest existing target ancestor
+ * @retval     1    Target parent found
+ * @retval     0    Only an ancestor found
+ * @retval    -1    Error
+ */
+static int
+validate_target_parent(cxobj  *xt,
+                       cxobj  *xs,
+                       cxobj **xtp)
+{
+    int        ret;
+    cxobj     *xp;
+    cxobj     *xc = NULL;
+    yang_stmt *yp;
+
+    *xtp = xt;
+    if ((xp = xml_parent(xs)) == NULL || xml_parent(xp) == NULL)
+        return 1;
+    if ((ret = validate_target_parent(xt, xp, xtp)) < 1)
+        return ret;
+    if ((yp = xml_spec(xp)) == NULL)
+        return 0;
+    if (match_base_child(*xtp, xp, yp, &xc) < 0)
+        return -1;
+    if (xc == NULL)
+        return 0;
+    *xtp = xc;
+    return 1;
+}
+
+/*! Validate a tree incrementally given its differences to a valid tree
+ *
+ * Only constraints that may be affected by the differences are evaluated:
+ * 1. Added and changed nodes are validated with all their descendants
+ * 2. Ancestors of added, changed and deleted nodes are validated locally, eg mandatory,
+ *    min/max-elements, unique and their own must/when
+ * 3. Nodes with must, when or leafref constraints whose XPath dependencies contain a name
+ *    of an added, changed or deleted node, or one of their ancestors, are validated locally
+ * Falls back to full validation if schema mount is enabled.
+ * @param[in]  h      Clixon handle
+ * @param[in]  xt     XML top of target tree
+ * @param[in]  dvec   Deleted nodes (in source tree)
+ * @param[in]  dlen   Length of dvec
+ * @param[in]  avec   Added nodes (in target tree)
+ * @param[in]  alen   Length of avec
+ * @param[in]  tcvec  Changed nodes (in target tree)
+ * @param[in]  clen   Length of tcvec
+ * @param[out] xret   Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1      Validation OK
+ * @retval     0      Validation failed (xret set)
+ * @retval    -1      Error
+ * @note The source tree is assumed to be valid
+ * @see xml_yang_validate_all_top  for full validation
+ */
+int
+xml_yang_validate_changes(clixon_handle h,
+                          cxobj        *xt,
+                          cxobj       **dvec,
+                          int           dlen,
+                          cxobj       **avec,
+                          int           alen,
+                          cxobj       **tcvec,
+                          int           clen,
+                          cxobj       **xret)
+{
+    int            retval = -1;
+    clicon_hash_t *names = NULL;
+    cxobj        **vec = NULL;
+    int            len = 0;
+    cxobj         *x;
+    yang_stmt     *yspec;
+    yang_stmt     *ym;
+    int            inext;
+    int            i;
+    int            ret;
+
+    if (clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT") ||
+        (yspec = clicon_dbspec_yang(h)) == NULL)
+        return xml_yang_validate_all_top(h, xt, xret);
+    if ((names = clicon_hash_init()) == NULL)
+        goto done;
+    /* 1. Added and changed nodes */
+    for (i=0; i<alen; i++){
+        if (validate_names_add(names, avec[i]) < 0)
+            goto done;
+        if ((ret = xml_yang_validate_all(h, avec[i], xret)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    for (i=0; i<clen; i++){
+        if (validate_names_add(names, tcvec[i]) < 0)
+            goto done;
+        if ((ret = xml_yang_validate_all(h, tcvec[i], xret)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    for (i=0; i<dlen; i++)
+        if (validate_names_add(names, dvec[i]) < 0)
+            goto done;
+    /* 2. Ancestors */
+    for (i=0; i<alen+clen+dlen; i++){
+        if (i < alen)
+            x = xml_parent(avec[i]);
+        else if (i < alen+clen)
+            x = xml_parent(tcvec[i-alen]);
+        else if (validate_target_parent(xt, dvec[i-alen-clen], &x) < 0)
+            goto done;
+        for (; x != NULL && x != xt && !xml_flag(x, XML_FLAG_MARK); x = xml_parent(x)){
+            if ((ret = validate_local(h, x, &vec, &len, xret)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+        }
+    }
+    /* 3. Dependent constraints */
+    if (alen+clen+dlen > 0){
+        inext = 0;
+        while ((ym = yn_iter(yspec, &inext)) != NULL){
+            if (yang_keyword_get(ym) != Y_MODULE && yang_keyword_get(ym) != Y_SUBMODULE)
+                continue;
+            if ((ret = validate_deps_yang(h, ym, xt, names, &vec, &len, xret)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+        }
+    }
+    if ((ret = xml_yang_validate_minmax(xt, 0, xret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    retval = 1;
+ done:
+    for (i=0; i<len; i++)
+        xml_flag_reset(vec[i], XML_FLAG_MARK);
+    if (vec)
+        free(vec);
+    if (names)
+        clicon_hash_free(names);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Check validity of outgoing RPC
  *
  * Rewrite return message if errors
@@ -51,6 +51,7 @@
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <stddef.h>
 #include <limits.h>
 #include <assert.h>
 
@@ -89,6 +90,24 @@
 #define XML_CHILDVEC_SIZE_START_ELMNT 16
 #define XML_CHILDVEC_SIZE_THRESHOLD 65536
 
+/* Size of inline value buffer of body and attribute nodes.
+ * Values that do not fit, including null-termination, are malloced
+ */
+#define XML_VALUE_INLINE 24
+
+/* Initial size of interned name hash table, power of 2 */
+#define XML_INTERN_SIZE_START 256
+
+#ifdef XML_SLAB
+/* Number of XML nodes allocated in each slab */
+#define XML_SLAB_NR 256
+#endif
+
+#ifdef XML_ARENA
+/* Size and alignment of arena chunks, power of 2 */
+#define XML_ARENA_CHUNK 65536
+#endif
+
 /* Intention of these macros is to guard against access of type-specific fields 
  * As debug they can contain an assert.
  */
@@ -99,6 +118,10 @@
  * Types
  */
 
+#ifdef XML_KEY_INDEX
+static int xml_key_index_notify(cxobj *x, cxobj *xc, int rm);
+#endif
+
 #ifdef XML_EXPLICIT_INDEX
 static int xml_search_index_free(cxobj *x);
 
@@ -165,9 +188,12 @@ struct search_index{
  */
 struct xml{
     enum cxobj_type   x_type;       /* type of node: element, attribute, body */
-    char             *x_name;       /* name of node */
-    char             *x_prefix;     /* namespace localname N, called prefix */
     uint16_t          x_flags;      /* Flags according to XML_FLAG_* */
+#ifdef XML_ARENA
+    uint8_t           x_arena;      /* Node, child vector and value are allocated from an arena */
+#endif
+    char             *x_name;       /* name of node, interned */
+    char             *x_prefix;     /* namespace localname N, called prefix, interned */
     struct xml       *x_up;         /* parent node in hierarchy if any */
 #ifdef XML_PARENT_CANDIDATE
     struct xml       *x_up_candidate; /* Candidate parent node for special cases (when+xpath) */
@@ -175,9 +201,6 @@ struct xml{
     int              _x_vector_i;   /* internal use: xml_child_each */
     int              _x_i;          /* internal use for stable sorting:
                                        see xml_enumerate and xml_cmp */
-    /*----- next is body/attribute only */
-    cbuf             *x_value_cb;  /* attribute and body nodes have values (XXX: this consumes 
-                                       memory) cv? */
     /*----- up to here is common to all next is element only */
     struct xml      **x_childvec;   /* vector of children nodes (XXX: use clixon_vec ) */
     int               x_childvec_len;/* Number of children */
@@ -190,16 +213,24 @@ struct xml{
 #ifdef XML_EXPLICIT_INDEX
     struct search_index *x_search_index; /* explicit search index vectors */
 #endif
+#ifdef XML_KEY_INDEX
+    void             *x_key_index;  /* Hash index of unsorted list children, see clixon_xml_sort.c */
+#endif
 };
 
 /* Variant of struct xml for use by non-elements to save space
+ *
+ * Small values are stored inline in the node, larger are malloced
  * @see struct xml  For XML elements
  */
 struct xmlbody{
     enum cxobj_type   xb_type;       /* type of node: element, attribute, body */
-    char             *xb_name;       /* name of node */
-    char             *xb_prefix;     /* namespace localname N, called prefix */
     uint16_t          xb_flags;      /* Flags according to XML_FLAG_* */
+#ifdef XML_ARENA
+    uint8_t           xb_arena;      /* Node and value are allocated from an arena */
+#endif
+    char             *xb_name;       /* name of node, interned */
+    char             *xb_prefix;     /* namespace localname N, called prefix, interned */
     struct xml       *xb_up;         /* parent node in hierarchy if any */
 #ifdef XML_PARENT_CANDIDATE
     struct xml       *xb_up_candidate; /* Candidate parent node for special cases (when+xpath) */
@@ -207,9 +238,16 @@ struct xmlbody{
     int              _xb_vector_i;   /* internal use: xml_child_each */
     int              _xb_i;          /* internal use for sorting: 
                                        see xml_enumerate and xml_cmp */
-    cbuf             *xb_value_cb;  /* attribute and body nodes have values */
+    /*----- up to here is common to all next is body/attribute only */
+    char             *xb_value;      /* Value string, points to xb_inline or malloced */
+    uint32_t          xb_value_len;  /* Length of value string */
+    uint32_t          xb_value_max;  /* Allocated length of value buffer (incl null) */
+    char              xb_inline[XML_VALUE_INLINE]; /* Inline buffer for small values */
 };
 
+/* Access body/attribute specific fields */
+#define xml_body_node(x) ((struct xmlbody *)(x))
+
 /*
  * Variables
  */
@@ -249,12 +287,448 @@ xml_stats_global(uint64_t *nr)
     return 0;
 }
 
+/*! Interned string, shared by all XML nodes with the same name or prefix
+ *
+ * Names and prefixes come from a limited vocabulary, typically YANG identifiers.
+ * Strings are reference counted and removed when the last node using it is freed.
+ */
+struct xml_intern{
+    struct xml_intern *xi_next;  /* Next in hash bucket */
+    uint32_t           xi_hash;  /* Hash value of string */
+    uint32_t           xi_refs;  /* Number of XML nodes referencing string */
+    char               xi_str[]; /* Null-terminated string */
+};
+
+/* Hash table of interned strings (too low-level to hang it on handle) */
+static struct xml_intern **_xml_intern_vec = NULL;
+static uint32_t            _xml_intern_size = 0; /* Number of buckets, power of 2 */
+static uint32_t            _xml_intern_nr = 0;   /* Number of interned strings */
+
+/*! FNV-1a hash of string
+ */
+static uint32_t
+xml_intern_hash(const char *str)
+{
+    uint32_t h = 2166136261U;
+
+    while (*str){
+        h ^= (unsigned char)*str++;
+        h *= 16777619U;
+    }
+    return h;
+}
+
+/*! Double the size of the interned string hash table
+ *
+ * @retval  0   OK
+ * @retval -1   Error
+ */
+static int
+xml_intern_grow(void)
+{
+    struct xml_intern **vec;
+    struct xml_intern  *xi;
+    uint32_t            size;
+    uint32_t            i;
+
+    size = _xml_intern_size ? _xml_intern_size*2 : XML_INTERN_SIZE_START;
+    if ((vec = calloc(size, sizeof(*vec))) == NULL){
+        clixon_err(OE_XML, errno, "calloc");
+        return -1;
+    }
+    for (i=0; i<_xml_intern_size; i++){
+        while ((xi = _xml_intern_vec[i]) != NULL){
+            _xml_intern_vec[i] = xi->xi_next;
+            xi->xi_next = vec[xi->xi_hash & (size-1)];
+            vec[xi->xi_hash & (size-1)] = xi;
+        }
+    }
+    if (_xml_intern_vec)
+        free(_xml_intern_vec);
+    _xml_intern_vec = vec;
+    _xml_intern_size = size;
+    return 0;
+}
+
+/*! Get interned copy of string, increment its reference count
+ *
+ * @param[in]  str  String
+ * @retval     istr Interned string, release with xml_unintern
+ * @retval     NULL Error
+ */
+static char *
+xml_intern(const char *str)
+{
+    struct xml_intern *xi;
+    uint32_t           h;
+    size_t             len;
+
+    h = xml_intern_hash(str);
+    if (_xml_intern_vec){
+        for (xi = _xml_intern_vec[h & (_xml_intern_size-1)]; xi; xi = xi->xi_next)
+            if (xi->xi_hash == h && strcmp(xi->xi_str, str) == 0){
+                xi->xi_refs++;
+                return xi->xi_str;
+            }
+    }
+    if (_xml_intern_nr >= _xml_intern_size && xml_intern_grow() < 0)
+        return NULL;
+    len = strlen(str);
+    if ((xi = malloc(sizeof(*xi) + len + 1)) == NULL){
+        clixon_err(OE_XML, errno, "malloc");
+        return NULL;
+    }
+    xi->xi_hash = h;
+    xi->xi_refs = 1;
+    memcpy(xi->xi_str, str, len + 1);
+    xi->xi_next = _xml_intern_vec[h & (_xml_intern_size-1)];
+    _xml_intern_vec[h & (_xml_intern_size-1)] = xi;
+    _xml_intern_nr++;
+    return xi->xi_str;
+}
+
+/*! Release interned string, free it if last reference
+ *
+ * @param[in]  str  Interned string as returned by xml_intern
+ */
+static void
+xml_unintern(char *str)
+{
+    struct xml_intern  *xi;
+    struct xml_intern **xp;
+
+    xi = (struct xml_intern *)(str - offsetof(struct xml_intern, xi_str));
+    if (--xi->xi_refs > 0)
+        return;
+    xp = &_xml_intern_vec[xi->xi_hash & (_xml_intern_size-1)];
+    while (*xp != xi)
+        xp = &(*xp)->xi_next;
+    *xp = xi->xi_next;
+    free(xi);
+    if (--_xml_intern_nr == 0){
+        free(_xml_intern_vec);
+        _xml_intern_vec = NULL;
+        _xml_intern_size = 0;
+    }
+}
+
+#ifdef XML_SLAB
+/*! Slab of XML nodes, followed by XML_SLAB_NR nodes of one size class
+ */
+struct xml_slab{
+    struct xml_slab *xs_next;    /* Next slab of this size class */
+    void            *xs_align;   /* Pad header to node alignment */
+};
+
+/* Free-list and slabs of element nodes [0] and body/attribute nodes [1] */
+static void            *_xml_slab_free[2] = {NULL, NULL};
+static struct xml_slab *_xml_slab_list[2] = {NULL, NULL};
+
+/*! Allocate XML node from slab, allocate a new slab if free-list is empty
+ *
+ * @param[in]  i    Size class: 0 for element, 1 for body/attribute
+ * @param[in]  sz   Size of node in this size class
+ * @retval     x    Uninitialized node
+ * @retval     NULL Error
+ */
+static void *
+xml_slab_alloc(int    i,
+               size_t sz)
+{
+    struct xml_slab *xs;
+    char            *p;
+    void            *x;
+    int              j;
+
+    if (_xml_slab_free[i] == NULL){
+        if ((xs = malloc(sizeof(*xs) + XML_SLAB_NR*sz)) == NULL){
+            clixon_err(OE_XML, errno, "malloc");
+            return NULL;
+        }
+        xs->xs_next = _xml_slab_list[i];
+        _xml_slab_list[i] = xs;
+        p = (char*)(xs + 1);
+        for (j=XML_SLAB_NR-1; j>=0; j--){
+            *(void**)(p + j*sz) = _xml_slab_free[i];
+            _xml_slab_free[i] = p + j*sz;
+        }
+    }
+    x = _xml_slab_free[i];
+    _xml_slab_free[i] = *(void**)x;
+    return x;
+}
+
+/*! Return XML node to free-list of its size class
+ *
+ * @param[in]  x    XML node
+ * @param[in]  i    Size class: 0 for element, 1 for body/attribute
+ */
+static void
+xml_slab_release(void *x,
+                 int   i)
+{
+    *(void**)x = _xml_slab_free[i];
+    _xml_slab_free[i] = x;
+}
+#endif /* XML_SLAB */
+
+/*! Arena for short-lived XML trees, eg a parsed request
+ *
+ * Nodes, child vectors and values of nodes created while the arena is set are allocated
+ * consecutively from large chunks. xml_free does not free them one by one, the chunks
+ * are released at once by xml_arena_free.
+ */
+struct xml_arena{
+    struct xml_arena_chunk *xa_chunks;   /* List of chunks */
+    char                   *xa_ptr;      /* Next free byte in current chunk */
+    char                   *xa_end;      /* End of current chunk */
+    uint64_t                xa_live;     /* Number of allocated but not freed nodes */
+    int                     xa_released; /* xml_arena_free called, release when xa_live is 0 */
+};
+
+/*! Arena chunk header. Chunks are aligned on XML_ARENA_CHUNK to find the arena of a node
+ */
+struct xml_arena_chunk{
+    struct xml_arena_chunk *xc_next;     /* Next chunk in arena */
+    struct xml_arena       *xc_arena;    /* Arena of this chunk */
+};
+
+/* Current arena used by xml_new, if any */
+static xml_arena *_xml_arena = NULL;
+
+/*! Create a new XML arena
+ *
+ * @retval     xa    Arena, free with xml_arena_free
+ * @retval     NULL  Error
+ * @code
+ *   xml_arena *xa = xml_arena_new();
+ *   xml_arena *xa0 = xml_arena_set(xa);
+ *   clixon_xml_parse_string(str, YB_NONE, NULL, &xt, NULL);
+ *   xml_arena_set(xa0);
+ *   ...
+ *   xml_free(xt);
+ *   xml_arena_free(xa);
+ * @endcode
+ * @note Trees of the arena are freed with xml_free as usual, which releases names and
+ *       caches of the nodes. If nodes are still in use when the arena is freed, eg a
+ *       subtree moved to another tree, the arena is kept until they are freed.
+ * @see XML_ARENA
+ */
+xml_arena *
+xml_arena_new(void)
+{
+    xml_arena *xa;
+
+    if ((xa = calloc(1, sizeof(*xa))) == NULL){
+        clixon_err(OE_XML, errno, "calloc");
+        return NULL;
+    }
+    return xa;
+}
+
+/*! Set arena used by subsequent xml_new calls
+ *
+ * @param[in]  xa    Arena, or NULL for regular allocation
+ * @retval     xa0   Previous arena (or NULL), to restore after use
+ * @note Only set the arena while creating trees that are freed when the arena is
+ */
+xml_arena *
+xml_arena_set(xml_arena *xa)
+{
+    xml_arena *xa0 = _xml_arena;
+
+    _xml_arena = xa;
+    return xa0;
+}
+
+/*! Free all chunks of an arena and the arena itself
+ */
+static void
+xml_arena_release(xml_arena *xa)
+{
+    struct xml_arena_chunk *xc;
+
+    while ((xc = xa->xa_chunks) != NULL){
+        xa->xa_chunks = xc->xc_next;
+        free(xc);
+    }
+    free(xa);
+}
+
+/*! Free an arena
+ *
+ * The memory is released at once if all nodes of the arena have been freed, otherwise when
+ * the last node is freed.
+ * @param[in]  xa    Arena
+ * @retval     0     OK
+ */
+int
+xml_arena_free(xml_arena *xa)
+{
+    if (xa == NULL)
+        return 0;
+    if (_xml_arena == xa)
+        _xml_arena = NULL;
+    if (xa->xa_live == 0)
+        xml_arena_release(xa);
+    else
+        xa->xa_released = 1;
+    return 0;
+}
+
+#ifdef XML_ARENA
+/*! Allocate memory from arena
+ *
+ * Sizes larger than a chunk are allocated in a chunk of their own
+ * @param[in]  xa    Arena
+ * @param[in]  sz    Size
+ * @retval     p     Uninitialized memory, aligned to 8 bytes
+ * @retval     NULL  Error
+ */
+static void *
+xml_arena_alloc(xml_arena *xa,
+                size_t     sz)
+{
+    struct xml_arena_chunk *xc;
+    void                   *p;
+    int                     ret;
+
+    sz = (sz + 7) & ~(size_t)7;
+    if (xa->xa_ptr == NULL || xa->xa_ptr + sz > xa->xa_end){
+        if (sizeof(*xc) + sz > XML_ARENA_CHUNK){
+            if ((ret = posix_memalign(&p, XML_ARENA_CHUNK, sizeof(*xc) + sz)) != 0){
+                clixon_err(OE_XML, ret, "posix_memalign");
+                return NULL;
+            }
+            xc = (struct xml_arena_chunk *)p;
+            xc->xc_arena = xa;
+            xc->xc_next = xa->xa_chunks;
+            xa->xa_chunks = xc;
+            return xc + 1;
+        }
+        if ((ret = posix_memalign(&p, XML_ARENA_CHUNK, XML_ARENA_CHUNK)) != 0){
+            clixon_err(OE_XML, ret, "posix_memalign");
+            return NULL;
+        }
+        xc = (struct xml_arena_chunk *)p;
+        xc->xc_arena = xa;
+        xc->xc_next = xa->xa_chunks;
+        xa->xa_chunks = xc;
+        xa->xa_ptr = (char*)(xc + 1);
+        xa->xa_end = (char*)xc + XML_ARENA_CHUNK;
+    }
+    p = xa->xa_ptr;
+    xa->xa_ptr += sz;
+    return p;
+}
+
+/*! Get arena of XML node allocated from an arena
+ */
+static xml_arena *
+xml_arena_get(cxobj *x)
+{
+    struct xml_arena_chunk *xc;
+
+    xc = (struct xml_arena_chunk *)((uintptr_t)x & ~(uintptr_t)(XML_ARENA_CHUNK-1));
+    return xc->xc_arena;
+}
+
+/*! XML node allocated from arena is freed, release arena if freed and this was the last node
+ *
+ * @param[in]  x     XML node
+ */
+static void
+xml_arena_node_free(cxobj *x)
+{
+    xml_arena *xa;
+
+    xa = xml_arena_get(x);
+    if (--xa->xa_live == 0 && xa->xa_released)
+        xml_arena_release(xa);
+}
+#endif /* XML_ARENA */
+
+/*! Reallocate child vector or value buffer of XML node
+ *
+ * Buffers of arena nodes are allocated from the arena of the node. The old buffer is
+ * then left in the arena.
+ * @param[in]  x      XML node
+ * @param[in]  p      Old buffer, or NULL
+ * @param[in]  oldsz  Bytes of old buffer to keep
+ * @param[in]  sz     New size
+ * @retval     p      New buffer
+ * @retval     NULL   Error
+ */
+static void *
+xml_buf_realloc(cxobj  *x,
+                void   *p,
+                size_t  oldsz,
+                size_t  sz)
+{
+    void *p1;
+
+#ifdef XML_ARENA
+    if (x->x_arena){
+        if ((p1 = xml_arena_alloc(xml_arena_get(x), sz)) == NULL)
+            return NULL;
+        if (p && oldsz)
+            memcpy(p1, p, oldsz < sz ? oldsz : sz);
+        return p1;
+    }
+#endif
+    if ((p1 = realloc(p, sz)) == NULL){
+        clixon_err(OE_XML, errno, "realloc");
+        return NULL;
+    }
+    return p1;
+}
+
+/*! Free child vector or value buffer of XML node, unless allocated from an arena
+ *
+ * @param[in]  x      XML node
+ * @param[in]  p      Buffer
+ */
+static void
+xml_buf_free(cxobj *x,
+             void  *p)
+{
+#ifdef XML_ARENA
+    if (x->x_arena)
+        return;
+#endif
+    free(p);
+}
+
+/*! Free global XML resources on exit
+ *
+ * Slabs are only freed if all XML nodes have been freed, otherwise they remain and will
+ * be reported by memory checkers.
+ */
+void
+xml_exit(void)
+{
+#ifdef XML_SLAB
+    struct xml_slab *xs;
+    int              i;
+
+    if (_stats_xml_nr != 0)
+        return;
+    for (i=0; i<2; i++){
+        while ((xs = _xml_slab_list[i]) != NULL){
+            _xml_slab_list[i] = xs->xs_next;
+            free(xs);
+        }
+        _xml_slab_free[i] = NULL;
+    }
+#endif
+}
+
 /*! Return the alloced memory of a single XML obj 
  *
  * @param[in]   x    XML object
  * @param[out]  szp  Size of this XML obj
  * @retval      0    OK
- * (baseline: 96 bytes per object on x86-64)
+ * Names and prefixes are interned and shared between nodes and not counted
  */
 static int
 xml_stats_one(cxobj    *x,
@@ -262,10 +736,6 @@ xml_stats_one(cxobj    *x,
 {
     size_t sz = 0;
 
-    if (x->x_name)
-        sz += strlen(x->x_name) + 1;
-    if (x->x_prefix)
-        sz += strlen(x->x_prefix) + 1;
     switch (xml_type(x)){
     case CX_ELMNT:
         sz += sizeof(struct xml);
@@ -288,8 +758,9 @@ xml_stats_one(cxobj    *x,
     case CX_BODY:
     case CX_ATTR:
         sz += sizeof(struct xmlbody);
-        if (x->x_value_cb)
-            sz += cbuf_buflen(x->x_value_cb);
+        if (xml_body_node(x)->xb_value &&
+            xml_body_node(x)->xb_value != xml_body_node(x)->xb_inline)
+            sz += xml_body_node(x)->xb_value_max;
         break;
     default:
         break;
@@ -359,21 +830,21 @@ xml_name(cxobj *xn)
  * @param[in]  name  new name, null-terminated string, copied by function
  * @retval     0     OK
  * @retval    -1     On error with clicon-err set
+ * @note name is interned, do not modify the string returned by xml_name()
  */
 int
 xml_name_set(cxobj *xn,
              char  *name)
 {
-    if (xn->x_name){
-        free(xn->x_name);
-        xn->x_name = NULL;
-    }
+    char *old = xn->x_name;
+
+    xn->x_name = NULL;
     if (name){
-        if ((xn->x_name = strdup(name)) == NULL){
-            clixon_err(OE_XML, errno, "strdup");
+        if ((xn->x_name = xml_intern(name)) == NULL)
             return -1;
-        }
     }
+    if (old)
+        xml_unintern(old);
     return 0;
 }
 
@@ -399,16 +870,15 @@ int
 xml_prefix_set(cxobj *xn,
                char  *prefix)
 {
-    if (xn->x_prefix){
-        free(xn->x_prefix);
-        xn->x_prefix = NULL;
-    }
+    char *old = xn->x_prefix;
+
+    xn->x_prefix = NULL;
     if (prefix){
-        if ((xn->x_prefix = strdup(prefix)) == NULL){
-            clixon_err(OE_XML, errno, "strdup");
+        if ((xn->x_prefix = xml_intern(prefix)) == NULL)
             return -1;
-        }
     }
+    if (old)
+        xml_unintern(old);
     return 0;
 }
 
@@ -649,7 +1119,60 @@ xml_value(cxobj *xn)
 {
     if (!is_bodyattr(xn))
         return NULL;
-    return xn->x_value_cb?cbuf_get(xn->x_value_cb):NULL;
+    return xml_body_node(xn)->xb_value;
+}
+
+/*! Ensure value buffer of body/attribute node can hold a string of given length
+ *
+ * Small values use the inline buffer of the node. Existing value is kept.
+ * @param[in]  xb    Body or attribute node
+ * @param[in]  len   String length (excluding null)
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xml_value_alloc(struct xmlbody *xb,
+                size_t          len)
+{
+    size_t max;
+    char  *v;
+
+    if (xb->xb_value == NULL){
+        if (len < XML_VALUE_INLINE){
+            xb->xb_value = xb->xb_inline;
+            xb->xb_value_max = XML_VALUE_INLINE;
+            xb->xb_value_len = 0;
+            xb->xb_value[0] = '\0';
+            return 0;
+        }
+        xb->xb_value_len = 0;
+        xb->xb_value_max = 0;
+    }
+    else if (len < xb->xb_value_max)
+        return 0;
+    if (len >= UINT32_MAX){
+        clixon_err(OE_XML, EINVAL, "value too long");
+        return -1;
+    }
+    /* Grow exponentially to make repeated appends cheap */
+    max = len + 1;
+    if (max < 2*(size_t)xb->xb_value_max)
+        max = 2*(size_t)xb->xb_value_max;
+    if (max > UINT32_MAX)
+        max = UINT32_MAX;
+    if (xb->xb_value == xb->xb_inline){
+        if ((v = xml_buf_realloc((cxobj*)xb, NULL, 0, max)) == NULL)
+            return -1;
+        memcpy(v, xb->xb_inline, xb->xb_value_len + 1);
+    }
+    else if ((v = xml_buf_realloc((cxobj*)xb, xb->xb_value,
+                                  xb->xb_value ? xb->xb_value_len + 1 : 0, max)) == NULL)
+        return -1;
+    if (xb->xb_value == NULL)
+        v[0] = '\0';
+    xb->xb_value = v;
+    xb->xb_value_max = max;
+    return 0;
 }
 
 /*! Set value of xml node, value is copied
@@ -663,8 +1186,9 @@ int
 xml_value_set(cxobj *xn,
               char  *val)
 {
-    int    retval = -1;
-    size_t sz;
+    int             retval = -1;
+    struct xmlbody *xb;
+    size_t          len;
 
     if (!is_bodyattr(xn))
         return 0;
@@ -672,16 +1196,21 @@ xml_value_set(cxobj *xn,
         clixon_err(OE_XML, EINVAL, "value is NULL");
         goto done;
     }
-    sz = strlen(val)+1;
-    if (xn->x_value_cb == NULL){
-        if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
-            clixon_err(OE_XML, errno, "cbuf_new");
-            goto done;
-        }
-    }
-    else
-        cbuf_reset(xn->x_value_cb);
-    cbuf_append_str(xn->x_value_cb, val);
+    xb = xml_body_node(xn);
+    len = strlen(val);
+    if (xb->xb_value == val) /* Setting to own value */
+        goto ok;
+    if (xb->xb_value)
+        xb->xb_value_len = 0; /* Dont copy old value when growing */
+    if (xml_value_alloc(xb, len) < 0)
+        goto done;
+    memmove(xb->xb_value, val, len + 1);
+    xb->xb_value_len = len;
+#ifdef XML_KEY_INDEX
+    if (xml_key_index_notify(xb->xb_up, xn, 0) < 0)
+        goto done;
+#endif
+ ok:
     retval = 0;
  done:
     return retval;
@@ -698,8 +1227,9 @@ int
 xml_value_append(cxobj *xn,
                  char  *val)
 {
-    int    retval = -1;
-    size_t sz;
+    int             retval = -1;
+    struct xmlbody *xb;
+    size_t          len;
 
     if (!is_bodyattr(xn))
         return 0;
@@ -707,17 +1237,16 @@ xml_value_append(cxobj *xn,
         clixon_err(OE_XML, EINVAL, "value is NULL");
         goto done;
     }
-    sz = strlen(val)+1;
-    if (xn->x_value_cb == NULL){
-        if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
-            clixon_err(OE_XML, errno, "cbuf_new");
-            goto done;
-        }
-    }
-    if (cbuf_append_str(xn->x_value_cb, val) < 0){
-        clixon_err(OE_XML, errno, "cprintf");
+    xb = xml_body_node(xn);
+    len = strlen(val);
+    if (xml_value_alloc(xb, xb->xb_value_len + len) < 0)
         goto done;
-    }
+    memcpy(xb->xb_value + xb->xb_value_len, val, len + 1);
+    xb->xb_value_len += len;
+#ifdef XML_KEY_INDEX
+    if (xml_key_index_notify(xb->xb_up, xn, 0) < 0)
+        goto done;
+#endif
     retval = 0;
  done:
     return retval;
@@ -1008,6 +1537,38 @@ xml_child_each_attr(cxobj  *xparent,
     return xn;
 }
 
+/*! Grow child vector of XML node when it is full
+ *
+ * @param[in]  xp     Parent XML node, x_childvec_len is the wanted length
+ * @param[in]  start  Initial length
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xml_childvec_grow(cxobj *xp,
+                  size_t start)
+{
+    cxobj **vec;
+    size_t  max;
+
+    max = xp->x_childvec_max;
+    if (xp->x_childvec_len < XML_CHILDVEC_SIZE_THRESHOLD
+#ifdef XML_ARENA
+        || xp->x_arena /* Old vectors are kept in the arena, grow exponentially */
+#endif
+        )
+        max = max?2*max:start;
+    else
+        max += XML_CHILDVEC_SIZE_THRESHOLD;
+    if ((vec = xml_buf_realloc(xp, xp->x_childvec,
+                               xp->x_childvec_max*sizeof(cxobj*),
+                               max*sizeof(cxobj*))) == NULL)
+        return -1;
+    xp->x_childvec = vec;
+    xp->x_childvec_max = max;
+    return 0;
+}
+
 /*! Extend child vector with one and insert xml node there
  *
  * @note does not do anything with child, you may need to set its parent, etc
@@ -1029,18 +1590,14 @@ xml_child_append(cxobj *xp,
     if (xml_type(xc) == CX_ELMNT)
         start = XML_CHILDVEC_SIZE_START_ELMNT;
     xp->x_childvec_len++;
-    if (xp->x_childvec_len > xp->x_childvec_max){
-        if (xp->x_childvec_len < XML_CHILDVEC_SIZE_THRESHOLD)
-            xp->x_childvec_max = xp->x_childvec_max?2*xp->x_childvec_max:start;
-        else
-            xp->x_childvec_max += XML_CHILDVEC_SIZE_THRESHOLD;
-        xp->x_childvec = realloc(xp->x_childvec, xp->x_childvec_max*sizeof(cxobj*));
-        if (xp->x_childvec == NULL){
-            clixon_err(OE_XML, errno, "realloc");
-            return -1;
-        }
-    }
+    if (xp->x_childvec_len > xp->x_childvec_max &&
+        xml_childvec_grow(xp, start) < 0)
+        return -1;
     xp->x_childvec[xp->x_childvec_len-1] = xc;
+#ifdef XML_KEY_INDEX
+    if (xml_key_index_notify(xp, xc, 0) < 0)
+        return -1;
+#endif
     return 0;
 }
 
@@ -1053,6 +1610,7 @@ xml_child_append(cxobj *xp,
  * @retval    -1   Error
  * @see xml_child_append
  * @note does not do anything with child, you may need to set its parent, etc
+ * @note does not update key index of xp, see xml_insert
  */
 int
 xml_child_insert_pos(cxobj *xp,
@@ -1064,17 +1622,9 @@ xml_child_insert_pos(cxobj *xp,
     if (!is_element(xp))
         return 0;
     xp->x_childvec_len++;
-    if (xp->x_childvec_len > xp->x_childvec_max){
-        if (xp->x_childvec_len < XML_CHILDVEC_SIZE_THRESHOLD)
-            xp->x_childvec_max = xp->x_childvec_max?2*xp->x_childvec_max:XML_CHILDVEC_SIZE_START;
-        else
-            xp->x_childvec_max += XML_CHILDVEC_SIZE_THRESHOLD;
-        xp->x_childvec = realloc(xp->x_childvec, xp->x_childvec_max*sizeof(cxobj*));
-        if (xp->x_childvec == NULL){
-            clixon_err(OE_XML, errno, "realloc");
-            return -1;
-        }
-    }
+    if (xp->x_childvec_len > xp->x_childvec_max &&
+        xml_childvec_grow(xp, XML_CHILDVEC_SIZE_START) < 0)
+        return -1;
     size = (xml_child_nr(xp) - pos - 1)*sizeof(cxobj *);
     memmove(&xp->x_childvec[pos+1], &xp->x_childvec[pos], size);
     xp->x_childvec[pos] = xc;
@@ -1098,7 +1648,15 @@ xml_childvec_set(cxobj *x,
     x->x_childvec_len = len;
     x->x_childvec_max = len;
     if (x->x_childvec)
-        free(x->x_childvec);
+        xml_buf_free(x, x->x_childvec);
+#ifdef XML_ARENA
+    if (x->x_arena){
+        if ((x->x_childvec = xml_arena_alloc(xml_arena_get(x), len*sizeof(cxobj*))) == NULL)
+            return -1;
+        memset(x->x_childvec, 0, len*sizeof(cxobj*));
+        return 0;
+    }
+#endif
     if ((x->x_childvec = calloc(len, sizeof(cxobj*))) == NULL){
         clixon_err(OE_XML, errno, "calloc");
         return -1;
@@ -1180,11 +1738,27 @@ xml_new(char           *name,
         return NULL;
         break;
     }
+#ifdef XML_ARENA
+    if (_xml_arena){
+        if ((x = xml_arena_alloc(_xml_arena, sz)) == NULL)
+            return NULL;
+        _xml_arena->xa_live++;
+    }
+    else
+#endif
+#ifdef XML_SLAB
+    if ((x = xml_slab_alloc(type != CX_ELMNT, sz)) == NULL)
+        return NULL;
+#else
     if ((x = malloc(sz)) == NULL){
         clixon_err(OE_XML, errno, "malloc");
         return NULL;
     }
+#endif
     memset(x, 0, sz);
+#ifdef XML_ARENA
+    x->x_arena = (_xml_arena != NULL);
+#endif
     xml_type_set(x, type);
     if (name && (xml_name_set(x, name)) < 0)
         return NULL;
@@ -1252,6 +1826,13 @@ xml_spec_set(cxobj     *x,
 {
     if (!is_element(x))
         return 0;
+#ifdef XML_KEY_INDEX
+    if (x->x_spec != spec && x->x_up){
+        x->x_spec = spec;
+        if (xml_key_index_notify(x->x_up, x, 0) < 0)
+            return -1;
+    }
+#endif
     x->x_spec = spec;
     return 0;
 }
@@ -1515,6 +2096,10 @@ xml_child_rm(cxobj *xp,
             xml_search_child_rm(xp, xc);
 
     }
+#endif
+#ifdef XML_KEY_INDEX
+    if (xml_key_index_notify(xp, xc, 1) < 0)
+        goto done;
 #endif
     retval = 0;
  done:
@@ -1950,9 +2535,9 @@ xml_free(cxobj *x)
         return 0;
     }
     if (x->x_name)
-        free(x->x_name);
+        xml_unintern(x->x_name);
     if (x->x_prefix)
-        free(x->x_prefix);
+        xml_unintern(x->x_prefix);
     switch (xml_type(x)){
     case CX_ELMNT:
         for (i=0; i<x->x_childvec_len; i++){
@@ -1962,24 +2547,37 @@ xml_free(cxobj *x)
             }
         }
         if (x->x_childvec)
-            free(x->x_childvec);
+            xml_buf_free(x, x->x_childvec);
         if (x->x_cv)
             cv_free(x->x_cv);
         if (x->x_ns_cache)
             xml_nsctx_free(x->x_ns_cache);
 #ifdef XML_EXPLICIT_INDEX
         xml_search_index_free(x);
+#endif
+#ifdef XML_KEY_INDEX
+        xml_key_index_free(x);
 #endif
         break;
     case CX_BODY:
     case CX_ATTR:
-        if (x->x_value_cb)
-            cbuf_free(x->x_value_cb);
+        if (xml_body_node(x)->xb_value &&
+            xml_body_node(x)->xb_value != xml_body_node(x)->xb_inline)
+            xml_buf_free(x, xml_body_node(x)->xb_value);
         break;
     default:
         break;
     }
+#ifdef XML_ARENA
+    if (x->x_arena)
+        xml_arena_node_free(x);
+    else
+#endif
+#ifdef XML_SLAB
+    xml_slab_release(x, xml_type(x) != CX_ELMNT);
+#else
     free(x);
+#endif
     _stats_xml_nr--;
     return 0;
 }
@@ -2003,10 +2601,10 @@ xml_copy_one(cxobj *x0,
         goto done;
     }
     xml_type_set(x1, xml_type(x0));
-    if ((s = xml_name(x0))) /* malloced string */
+    if ((s = xml_name(x0))) /* interned string */
         if ((xml_name_set(x1, s)) < 0)
             goto done;
-    if ((s = xml_prefix(x0))) /* malloced string */
+    if ((s = xml_prefix(x0))) /* interned string */
         if ((xml_prefix_set(x1, s)) < 0)
             goto done;
     switch (xml_type(x0)){
@@ -2485,6 +3083,63 @@ xml_add_attr(cxobj *xn,
     goto ret;
 }
 
+#ifdef XML_KEY_INDEX
+/*! Get key index of XML node
+ *
+ * @param[in]  x    XML node
+ * @retval     xk   Key index, see clixon_xml_sort.c
+ * @retval     NULL No key index
+ */
+void *
+xml_key_index_get(cxobj *x)
+{
+    if (!is_element(x))
+        return NULL;
+    return x->x_key_index;
+}
+
+/*! Set key index of XML node
+ *
+ * @param[in]  x    XML node
+ * @param[in]  xk   Key index, see clixon_xml_sort.c
+ * @retval     0    OK
+ */
+int
+xml_key_index_set(cxobj *x,
+                  void  *xk)
+{
+    if (!is_element(x))
+        return 0;
+    x->x_key_index = xk;
+    return 0;
+}
+
+/*! Notify key index of x or its ancestors that children of x have changed
+ *
+ * A key index of a node is affected by changes of its children, and of the keys of its
+ * children. Only if x, its parent or grandparent have an index is the change examined.
+ * @param[in]  x    XML node whose child has been added, removed or changed value
+ * @param[in]  xc   The child
+ * @param[in]  rm   If set, xc has been removed
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xml_key_index_change
+ */
+static int
+xml_key_index_notify(cxobj *x,
+                     cxobj *xc,
+                     int    rm)
+{
+    cxobj *xa;
+    int    i;
+
+    for (i=0, xa=x; i<3 && xa != NULL; i++, xa=xa->x_up)
+        if (xa->x_key_index != NULL)
+            return xml_key_index_change(x, xc, rm);
+    return 0;
+}
+#endif /* XML_KEY_INDEX */
+
 #ifdef XML_EXPLICIT_INDEX
 /*! Is this XML object a search index, ie it is registered as a yang clixon cc:search_index
  *
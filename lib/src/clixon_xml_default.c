@@ -568,6 +568,8 @@ xml_global_defaults(clixon_handle h,
  *                     2: Remove all sub-nodes that are empty non-presence container or default leaf
  *                     3: Remove all sub-nodes that are empty non-presence containers
  * @param[in] flag     If set only traverse nodes marked with flag (or CHANGE)
+ *                     If flag includes XML_FLAG_DEL, a node whose child is removed is marked
+ *                     with XML_FLAG_DEL, as in text_modify, to record the deletion in change sets
  * @retval    1        Node is an (recursive) empty non-presence container or default leaf
  * @retval    0        Other node
  * @retval   -1        Error
@@ -588,6 +590,7 @@ xml_default_nopresence(cxobj *xn,
     int           ret;
     enum rfc_6020 keyw;
     int           config = 1;
+    int           mark = flag & XML_FLAG_DEL;
 
     if (flag){
         if (xml_flag(xn, XML_FLAG_CHANGE) != 0)
@@ -629,6 +632,8 @@ xml_default_nopresence(cxobj *xn,
                 /* fall thru */
             case 2: /* purge all nodes */
             case 3:
+                if (mark)
+                    xml_flag_set(xn, XML_FLAG_DEL);
                 if (xml_purge(x) < 0)
                     goto done;
                 x = xprev;
@@ -107,8 +107,9 @@ static int xml_diff2cbuf(cbuf *cb, cxobj *x0, cxobj *x1, int level, int skiptop)
  * @retval      1    Keep it
  * @retval      0    Remove it
  * @retval     -1    Error
+ * @see clixon_json2cbuf1 also used for JSON output
  */
-static int
+int
 xml2output_wdef(cxobj            *x,
                 withdefaults_type wdef,
                 int              *tag)
@@ -530,15 +531,44 @@ xml_dump(FILE  *f,
     return xml_dump1(f, x, 0);
 }
 
+/*! Streaming state of clixon_xml2cbuf_stream
+ */
+struct xml_stream {
+    size_t                xs_chunk; /* Flush when buffer reaches this size */
+    clixon_xml_stream_fn *xs_fn;    /* Flush callback */
+    void                 *xs_arg;   /* Flush callback argument */
+};
+
+/*! Internal: hand over buffer to flush callback if it has reached the chunk size
+ *
+ * @param[in,out] cb  Cligen buffer, reset after a flush
+ * @param[in]     xs  Streaming state
+ * @retval        0   OK
+ * @retval       -1   Error
+ */
+static int
+xml2cbuf_flush(cbuf              *cb,
+               struct xml_stream *xs)
+{
+    if (xs->xs_fn == NULL || cbuf_len(cb) < xs->xs_chunk)
+        return 0;
+    if ((*xs->xs_fn)(cb, xs->xs_arg) < 0)
+        return -1;
+    cbuf_reset(cb);
+    return 0;
+}
+
 /*! Internal: print  XML tree structure to a cligen buffer and encode chars "<>&"
  *
  * @param[in,out] cb       Cligen buffer to write to
  * @param[in]     xn       Clixon xml tree
+ * @param[in]     topname  Element name printed instead of name and prefix of xn, or NULL
  * @param[in]     level    Indentation level for prettyprint
  * @param[in]     pretty   Insert \n and spaces to make the xml more readable.
  * @param[in]     prefix   Add string to beginning of each line (if pretty)
  * @param[in]     depth    Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
  * @param[in]     wdef     With-defaults parameter, default is WITHDEFAULTS_REPORT_ALL
+ * @param[in]     xs       Flush buffer when it grows beyond chunk size, or NULL
  * @retval        0        OK
  * @retval       -1        Error
  * wdef changes the output as follows:
@@ -551,11 +581,13 @@ xml_dump(FILE  *f,
 static int
 xml2cbuf_recurse(cbuf             *cb,
                  cxobj            *x,
+                 char             *topname,
                  int               level,
                  int               pretty,
                  char             *prefix,
                  int32_t           depth,
-                 withdefaults_type wdef)
+                 withdefaults_type wdef,
+                 struct xml_stream *xs)
 {
     int        retval = -1;
     cxobj     *xc;
@@ -581,8 +613,14 @@ xml2cbuf_recurse(cbuf             *cb,
     level1 = level*PRETTYPRINT_INDENT;
     if (prefix)
         level1 -= strlen(prefix);
-    name = xml_name(x);
-    namespace = xml_prefix(x);
+    if (topname){
+        name = topname;
+        namespace = NULL;
+    }
+    else {
+        name = xml_name(x);
+        namespace = xml_prefix(x);
+    }
     switch(xml_type(x)){
     case CX_BODY:
         if ((val = xml_value(x)) == NULL) /* incomplete tree */
@@ -620,7 +658,7 @@ xml2cbuf_recurse(cbuf             *cb,
         while ((xc = xml_child_each(x, xc, -1)) != NULL)
             switch (xml_type(xc)){
             case CX_ATTR:
-                if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, -1, wdef) < 0)
+                if (xml2cbuf_recurse(cb, xc, NULL, level+1, pretty, prefix, -1, wdef, NULL) < 0)
                     goto done;
                 break;
             case CX_BODY:
@@ -657,12 +695,14 @@ xml2cbuf_recurse(cbuf             *cb,
                             xa = xml_find_type(xc, IETF_NETCONF_WITH_DEFAULTS_ATTR_PREFIX, IETF_NETCONF_WITH_DEFAULTS_ATTR_NAMESPACE, CX_ATTR);
                         }
                     }
-                    if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, depth-1, wdef) < 0)
+                    if (xml2cbuf_recurse(cb, xc, NULL, level+1, pretty, prefix, depth-1, wdef, xs) < 0)
                         goto done;
                     if (xa){
                         if (xml_purge(xa) < 0)
                             goto done;
                     }
+                    if (xs && xml2cbuf_flush(cb, xs) < 0)
+                        goto done;
                 }
             if (pretty && hasbody == 0){
                 if (prefix)
@@ -728,11 +768,66 @@ clixon_xml2cbuf1(cbuf                *cb,
     if (skiptop){
         xc = NULL;
         while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL)
-            if (xml2cbuf_recurse(cb, xc, level, pretty, prefix, depth, wdef) < 0)
+            if (xml2cbuf_recurse(cb, xc, NULL, level, pretty, prefix, depth, wdef, NULL) < 0)
                 goto done;
     }
     else {
-        if (xml2cbuf_recurse(cb, xn, level, pretty, prefix, depth, wdef) < 0)
+        if (xml2cbuf_recurse(cb, xn, NULL, level, pretty, prefix, depth, wdef, NULL) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Print an XML tree structure to a cligen buffer in pieces and encode chars "<>&"
+ *
+ * Same as clixon_xml2cbuf1 without pretty-print, but whenever the buffer reaches chunk bytes
+ * after an element is printed, the buffer is handed over to a flush callback and then reset.
+ * This bounds the size of the buffer to roughly chunk plus the size of one leaf element.
+ * Any content already in cb is included in the first flush.
+ * The remainder is left in cb when the function returns.
+ * The top object may be printed with another name, eg a datastore cache as reply data,
+ * without renaming the tree.
+ * @param[in,out] cb      Cligen buffer to write to
+ * @param[in]     xn      Top-level xml object
+ * @param[in]     topname Name of top object instead of its own name, or NULL
+ * @param[in]     depth   Limit levels of child resources: -1: all, 0: none, 1: node itself
+ * @param[in]     skiptop 0: Include top object 1: Skip top-object, only children,
+ * @param[in]     wdef    With-defaults parameter, default is WITHDEFAULTS_REPORT_ALL
+ * @param[in]     chunk   Flush buffer when it reaches this size
+ * @param[in]     fn      Flush callback, consumes the buffer, or NULL for no flush
+ * @param[in]     arg     Argument to flush callback
+ * @retval        0       OK
+ * @retval       -1       Error
+ * @see  clixon_xml2cbuf1
+ */
+int
+clixon_xml2cbuf_stream(cbuf                 *cb,
+                       cxobj                *xn,
+                       char                 *topname,
+                       int32_t               depth,
+                       int                   skiptop,
+                       withdefaults_type     wdef,
+                       size_t                chunk,
+                       clixon_xml_stream_fn *fn,
+                       void                 *arg)
+{
+    int               retval = -1;
+    cxobj            *xc;
+    struct xml_stream xs = {chunk, fn, arg};
+
+    if (skiptop){
+        xc = NULL;
+        while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL){
+            if (xml2cbuf_recurse(cb, xc, NULL, 0, 0, NULL, depth, wdef, &xs) < 0)
+                goto done;
+            if (xml2cbuf_flush(cb, &xs) < 0)
+                goto done;
+        }
+    }
+    else {
+        if (xml2cbuf_recurse(cb, xn, topname, 0, 0, NULL, depth, wdef, &xs) < 0)
             goto done;
     }
     retval = 0;
@@ -94,9 +94,12 @@ typedef struct  {
 } merge_twophase;
 
 /* Forward declaration */
-static int xml_diff1(cxobj *x0, cxobj *x1, cxobj ***x0vec, int *x0veclen,
+static int xml_diff1(cxobj *x0, cxobj *x1, cxobj *xs, cxobj ***x0vec, int *x0veclen,
                      cxobj ***x1vec, int *x1veclen,
                      cxobj ***changed_x0, cxobj ***changed_x1, int *changedlen);
+static int xml_diff_changes1(cxobj *x0, cxobj *x1, cxobj *xs, cxobj ***x0vec, int *x0veclen,
+                             cxobj ***x1vec, int *x1veclen,
+                             cxobj ***changed_x0, cxobj ***changed_x1, int *changedlen);
 
 /*! Is attribute and is either of form xmlns="", or xmlns:x="" */
 int
@@ -324,6 +327,7 @@ xml_diff_ordered_by_user(cxobj     *x0,
  *
  * @param[in]  x0         First XML tree
  * @param[in]  x1         Second XML tree
+ * @param[in]  xs         Change set node, if set unchanged list entries are skipped
  * @param[out] x0vec      Pointervector to XML nodes existing in only first tree
  * @param[out] x0veclen   Length of first vector
  * @param[out] x1vec      Pointervector to XML nodes existing in only second tree
@@ -353,6 +357,7 @@ xml_diff_ordered_by_user(cxobj     *x0,
 static int
 xml_diff1(cxobj     *x0,
           cxobj     *x1,
+          cxobj     *xs,
           cxobj   ***x0vec,
           int       *x0veclen,
           cxobj   ***x1vec,
@@ -371,6 +376,7 @@ xml_diff1(cxobj     *x0,
     int        eq;
     cxobj     *xi;
     cxobj     *xj;
+    cxobj     *xsc;
     int        extflag;
 
     /* Traverse x0 and x1 in lock-step */
@@ -464,10 +470,21 @@ xml_diff1(cxobj     *x0,
             continue;
         }
         else{ /* equal */
+            /* Only compare changed list entries if restricted to a change set */
+            xsc = NULL;
+            if (xs != NULL && y1c != NULL){
+                if (match_base_child(xs, x1c, y1c, &xsc) < 0)
+                    goto done;
+                if (xsc != NULL && xml_flag(xsc, XML_FLAG_CHANGE) == 0)
+                    xsc = NULL; /* List key */
+            }
             /* xml-spec NULL could happen with anydata children for example,
              * if so, continute compare children but without yang
              */
-            if (y0c && y1c && y0c != y1c){ /* choice */
+            if (xs != NULL && xsc == NULL && y1c != NULL &&
+                (yang_keyword_get(y1c) == Y_LIST || yang_keyword_get(y1c) == Y_LEAF_LIST))
+                ; /* Not in change set */
+            else if (y0c && y1c && y0c != y1c){ /* choice */
                 if (cxvec_append(x0c, x0vec, x0veclen) < 0)
                     goto done;
                 if (cxvec_append(x1c, x1vec, x1veclen) < 0)
@@ -489,7 +506,14 @@ xml_diff1(cxobj     *x0,
                         goto done;
                 }
             }
-            else if (xml_diff1(x0c, x1c,
+            else if (xsc != NULL){
+                if (xml_diff_changes1(x0c, x1c, xsc,
+                                      x0vec, x0veclen,
+                                      x1vec, x1veclen,
+                                      changed_x0, changed_x1, changedlen) < 0)
+                    goto done;
+            }
+            else if (xml_diff1(x0c, x1c, NULL,
                                x0vec, x0veclen,
                                x1vec, x1veclen,
                                changed_x0, changed_x1, changedlen)< 0)
@@ -549,7 +573,7 @@ xml_diff(cxobj     *x0,
             goto done;
         goto ok;
     }
-    if (xml_diff1(x0, x1,
+    if (xml_diff1(x0, x1, NULL,
                   first, firstlen,
                   second, secondlen,
                   changed_x0, changed_x1, changedlen) < 0)
@@ -560,6 +584,154 @@ xml_diff(cxobj     *x0,
     return retval;
 }
 
+/*! Help function to compute differences between two xml trees restricted to a change set
+ *
+ * @param[in]  x0         First XML tree
+ * @param[in]  x1         Second XML tree
+ * @param[in]  xs         Change set node corresponding to x0 and x1
+ * @param[out] x0vec      Pointervector to XML nodes existing in only first tree
+ * @param[out] x0veclen   Length of first vector
+ * @param[out] x1vec      Pointervector to XML nodes existing in only second tree
+ * @param[out] x1veclen   Length of x1vec vector
+ * @param[out] changed_x0 Pointervector to XML nodes changed orig value
+ * @param[out] changed_x1 Pointervector to XML nodes changed wanted value
+ * @param[out] changedlen Length of changed vector
+ * @retval     0          Ok
+ * @retval    -1          Error
+ * @see xml_diff_changes
+ */
+static int
+xml_diff_changes1(cxobj     *x0,
+                  cxobj     *x1,
+                  cxobj     *xs,
+                  cxobj   ***x0vec,
+                  int       *x0veclen,
+                  cxobj   ***x1vec,
+                  int       *x1veclen,
+                  cxobj   ***changed_x0,
+                  cxobj   ***changed_x1,
+                  int       *changedlen)
+{
+    int        retval = -1;
+    cxobj     *xsc;
+    cxobj     *x0c;
+    cxobj     *x1c;
+    yang_stmt *yc;
+    char      *b0;
+    char      *b1;
+    int        extflag;
+
+    /* Complete subtree changed */
+    if (xml_flag(xs, XML_FLAG_ADD))
+        return xml_diff1(x0, x1, NULL,
+                         x0vec, x0veclen, x1vec, x1veclen,
+                         changed_x0, changed_x1, changedlen);
+    /* Children deleted: compare children in lock-step, but skip unchanged list entries */
+    if (xml_flag(xs, XML_FLAG_DEL))
+        return xml_diff1(x0, x1, xs,
+                         x0vec, x0veclen, x1vec, x1veclen,
+                         changed_x0, changed_x1, changedlen);
+    xsc = NULL;
+    while ((xsc = xml_child_each(xs, xsc, CX_ELMNT)) != NULL) {
+        if (xml_flag(xsc, XML_FLAG_CHANGE) == 0) /* List key */
+            continue;
+        if ((yc = xml_spec(xsc)) == NULL)
+            continue;
+        if (yang_extension_value(yc, "ignore-compare", CLIXON_LIB_NS, &extflag, NULL) < 0)
+            goto done;
+        if (extflag)
+            continue;
+        if (match_base_child(x0, xsc, yc, &x0c) < 0)
+            goto done;
+        if (match_base_child(x1, xsc, yc, &x1c) < 0)
+            goto done;
+        if (x0c == NULL && x1c == NULL)
+            continue;
+        if (x0c == NULL){
+            if (cxvec_append(x1c, x1vec, x1veclen) < 0)
+                goto done;
+        }
+        else if (x1c == NULL){
+            if (cxvec_append(x0c, x0vec, x0veclen) < 0)
+                goto done;
+        }
+        else if (xml_spec(x0c) != xml_spec(x1c)){ /* choice */
+            if (cxvec_append(x0c, x0vec, x0veclen) < 0)
+                goto done;
+            if (cxvec_append(x1c, x1vec, x1veclen) < 0)
+                goto done;
+        }
+        else if (yang_keyword_get(yc) == Y_LEAF){
+            b0 = xml_body(x0c);
+            b1 = xml_body(x1c);
+            if (b0 == NULL && b1 == NULL)
+                ;
+            else if (b0 == NULL || b1 == NULL || strcmp(b0, b1) != 0){
+                if (cxvec_append(x0c, changed_x0, changedlen) < 0)
+                    goto done;
+                (*changedlen)--; /* append two vectors */
+                if (cxvec_append(x1c, changed_x1, changedlen) < 0)
+                    goto done;
+            }
+        }
+        else if (xml_diff_changes1(x0c, x1c, xsc,
+                                   x0vec, x0veclen,
+                                   x1vec, x1veclen,
+                                   changed_x0, changed_x1, changedlen) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Compute differences between two xml trees restricted to a change set
+ *
+ * Same as xml_diff but only the parts of the trees in the change set xs are compared.
+ * The change set is a tree of nodes with the same yang and keys as in x0 and x1, where:
+ * - XML_FLAG_CHANGE marks a node in the change set (otherwise it is a list key)
+ * - XML_FLAG_ADD means the complete subtree may have changed
+ * - XML_FLAG_DEL means children may have been deleted
+ * Non-list children of a node with XML_FLAG_DEL are always compared.
+ * @param[in]  x0         First XML tree
+ * @param[in]  x1         Second XML tree
+ * @param[in]  xs         Change set, if NULL compare complete trees
+ * @param[out] first      Pointervector to XML nodes existing in only first tree
+ * @param[out] firstlen   Length of first vector
+ * @param[out] second     Pointervector to XML nodes existing in only second tree
+ * @param[out] secondlen  Length of second vector
+ * @param[out] changed_x0 Pointervector to XML nodes changed orig value
+ * @param[out] changed_x1 Pointervector to XML nodes changed wanted value
+ * @param[out] changedlen Length of changed vector
+ * @retval     0          OK
+ * @retval    -1          Error
+ * @see xml_diff
+ * @see xmldb_changes_get  Datastore change set
+ */
+int
+xml_diff_changes(cxobj     *x0,
+                 cxobj     *x1,
+                 cxobj     *xs,
+                 cxobj   ***first,
+                 int       *firstlen,
+                 cxobj   ***second,
+                 int       *secondlen,
+                 cxobj   ***changed_x0,
+                 cxobj   ***changed_x1,
+                 int       *changedlen)
+{
+    if (x0 == NULL || x1 == NULL || xs == NULL)
+        return xml_diff(x0, x1, first, firstlen, second, secondlen,
+                        changed_x0, changed_x1, changedlen);
+    *firstlen = 0;
+    *secondlen = 0;
+    *changedlen = 0;
+    return xml_diff_changes1(x0, x1, xs,
+                             first, firstlen,
+                             second, secondlen,
+                             changed_x0, changed_x1, changedlen);
+}
+
 /*! Compute if two XML trees are equal or not
  *
  * @param[in]  x0   First XML tree
@@ -768,6 +768,409 @@ xml_search_indexvar(cxobj   *xp,
 }
 #endif /* XML_EXPLICIT_INDEX */
 
+#ifdef XML_KEY_INDEX
+/*! Slot in key index hash table
+ */
+struct xml_key_slot{
+    uint32_t  ks_hash; /* Hash of key values of ks_x */
+    cxobj    *ks_x;    /* List or leaf-list entry, NULL if slot is empty */
+};
+
+/*! Hash index of the entries of an unsorted list (or leaf-list) among the children of a node
+ *
+ * Maps key values to entries using open addressing with linear probing.
+ * Only hash values are stored, matches are verified with xml_cmp().
+ * @see XML_KEY_INDEX
+ */
+struct xml_key_index{
+    yang_stmt           *xk_yang; /* YANG list or leaf-list of indexed children */
+    uint32_t             xk_size; /* Number of slots, power of 2 */
+    uint32_t             xk_nr;   /* Number of entries */
+    struct xml_key_slot *xk_vec;  /* Hash table */
+};
+
+/*! FNV-1a hash of string, continued from h
+ */
+static uint32_t
+xml_key_hash_str(uint32_t    h,
+                 const char *str)
+{
+    while (*str){
+        h ^= (unsigned char)*str++;
+        h *= 16777619U;
+    }
+    return h;
+}
+
+/*! Hash value of a leaf or leaf-list node, continued from h
+ *
+ * The value is hashed in canonical form so that values equal according to xml_cmp() have
+ * the same hash, eg "01" and "1" of an integer type
+ * @param[in]  x    XML leaf or leaf-list node
+ * @param[in]  h    Hash so far
+ * @param[out] hp   Hash
+ * @retval     1    OK
+ * @retval     0    Value cannot be hashed, eg it is not valid for its type
+ */
+static int
+xml_key_hash_value(cxobj    *x,
+                   uint32_t  h,
+                   uint32_t *hp)
+{
+    char    *body;
+    cg_var  *cv = NULL;
+    char     buf[128];
+
+    if ((body = xml_body(x)) == NULL)
+        h = (h ^ 2) * 16777619U;
+    else{
+        if (xml_cv_cache(x, &cv) < 0 || cv == NULL)
+            return 0;
+        switch (cv_type_get(cv)){
+        case CGV_STRING:
+        case CGV_REST:
+            h = xml_key_hash_str(h, body);
+            break;
+        default:
+            /* Truncated values only give more collisions */
+            if (cv2str(cv, buf, sizeof(buf)) < 0)
+                return 0;
+            h = xml_key_hash_str(h, buf);
+            break;
+        }
+        h = (h ^ 3) * 16777619U; /* Separator between keys */
+    }
+    *hp = h;
+    return 1;
+}
+
+/*! Hash key values of a list entry, or value of a leaf-list entry
+ *
+ * @param[in]  x     XML list or leaf-list node
+ * @param[in]  y     YANG of x
+ * @param[in]  skip1 If set, a missing key cannot be hashed, see xml_cmp
+ * @param[out] hp    Hash
+ * @retval     1     OK
+ * @retval     0     Cannot be hashed
+ */
+static int
+xml_key_hash(cxobj     *x,
+             yang_stmt *y,
+             int        skip1,
+             uint32_t  *hp)
+{
+    uint32_t h = 2166136261U;
+    cvec    *cvk;
+    cg_var  *cvi;
+    cxobj   *xk;
+
+    if (yang_keyword_get(y) == Y_LEAF_LIST)
+        return xml_key_hash_value(x, h, hp);
+    cvk = yang_cvec_get(y); /* Use Y_LIST cache, see ys_populate_list() */
+    cvi = NULL;
+    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
+        if ((xk = xml_find(x, cv_string_get(cvi))) == NULL){
+            if (skip1)
+                return 0;
+            h = (h ^ 1) * 16777619U;
+        }
+        else if (xml_key_hash_value(xk, h, &h) == 0)
+            return 0;
+    }
+    *hp = h;
+    return 1;
+}
+
+/*! Add entry to key index, grow table if needed
+ *
+ * @param[in]  xk    Key index
+ * @param[in]  x     XML list entry
+ * @param[in]  h     Hash of key values of x
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xml_key_index_put(struct xml_key_index *xk,
+                  cxobj                *x,
+                  uint32_t              h)
+{
+    struct xml_key_slot *vec;
+    uint32_t             size;
+    uint32_t             i;
+    uint32_t             j;
+
+    if (2*(xk->xk_nr + 1) > xk->xk_size){
+        size = xk->xk_size ? 2*xk->xk_size : 16;
+        if ((vec = calloc(size, sizeof(*vec))) == NULL){
+            clixon_err(OE_XML, errno, "calloc");
+            return -1;
+        }
+        for (i=0; i<xk->xk_size; i++){
+            if (xk->xk_vec[i].ks_x == NULL)
+                continue;
+            j = xk->xk_vec[i].ks_hash & (size - 1);
+            while (vec[j].ks_x != NULL)
+                j = (j + 1) & (size - 1);
+            vec[j] = xk->xk_vec[i];
+        }
+        if (xk->xk_vec)
+            free(xk->xk_vec);
+        xk->xk_vec = vec;
+        xk->xk_size = size;
+    }
+    i = h & (xk->xk_size - 1);
+    while (xk->xk_vec[i].ks_x != NULL)
+        i = (i + 1) & (xk->xk_size - 1);
+    xk->xk_vec[i].ks_hash = h;
+    xk->xk_vec[i].ks_x = x;
+    xk->xk_nr++;
+    return 0;
+}
+
+/*! Remove entry from key index
+ *
+ * Entries following the removed slot are shifted back, so no tombstones are needed
+ * @param[in]  xk    Key index
+ * @param[in]  x     XML list entry
+ * @param[in]  h     Hash of key values of x
+ */
+static void
+xml_key_index_del(struct xml_key_index *xk,
+                  cxobj                *x,
+                  uint32_t              h)
+{
+    uint32_t mask = xk->xk_size - 1;
+    uint32_t i;
+    uint32_t j;
+    uint32_t k;
+
+    i = h & mask;
+    while (xk->xk_vec[i].ks_x != x){
+        if (xk->xk_vec[i].ks_x == NULL)
+            return; /* Not found */
+        i = (i + 1) & mask;
+    }
+    j = i;
+    while (1){
+        j = (j + 1) & mask;
+        if (xk->xk_vec[j].ks_x == NULL)
+            break;
+        k = xk->xk_vec[j].ks_hash & mask;
+        /* Keep entry j if its home slot k is cyclically in (i,j] */
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+        xk->xk_vec[i] = xk->xk_vec[j];
+        i = j;
+    }
+    xk->xk_vec[i].ks_x = NULL;
+    xk->xk_nr--;
+}
+
+/*! Free key index of XML node
+ *
+ * @param[in]  xp    XML node
+ * @retval     0     OK
+ */
+int
+xml_key_index_free(cxobj *xp)
+{
+    struct xml_key_index *xk;
+
+    if ((xk = xml_key_index_get(xp)) != NULL){
+        if (xk->xk_vec)
+            free(xk->xk_vec);
+        free(xk);
+        xml_key_index_set(xp, NULL);
+    }
+    return 0;
+}
+
+/*! Build key index of children of xp with YANG y
+ *
+ * @param[in]  xp    XML parent node
+ * @param[in]  y     YANG list or leaf-list
+ * @param[out] xkp   Key index, also set in xp
+ * @retval     1     OK
+ * @retval     0     Some entry cannot be hashed, no index built
+ * @retval    -1     Error
+ */
+static int
+xml_key_index_build(cxobj                 *xp,
+                    yang_stmt             *y,
+                    struct xml_key_index **xkp)
+{
+    int                   retval = -1;
+    struct xml_key_index *xk;
+    cxobj                *xc;
+    uint32_t              h;
+
+    if ((xk = calloc(1, sizeof(*xk))) == NULL){
+        clixon_err(OE_XML, errno, "calloc");
+        goto done;
+    }
+    xk->xk_yang = y;
+    xml_key_index_set(xp, xk);
+    xc = NULL;
+    while ((xc = xml_child_each(xp, xc, CX_ELMNT)) != NULL) {
+        if (xml_spec(xc) != y)
+            continue;
+        if (xml_key_hash(xc, y, 0, &h) == 0){
+            xml_key_index_free(xp);
+            goto fail;
+        }
+        if (xml_key_index_put(xk, xc, h) < 0){
+            xml_key_index_free(xp);
+            goto done;
+        }
+    }
+    *xkp = xk;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Find XML child under xp matching x1 using key index
+ *
+ * Build index of xp if it has at least XML_KEY_INDEX children
+ * @param[in]  xp    Parent xml node
+ * @param[in]  x1    Find this object among xp:s children
+ * @param[in]  yc    Yang spec of x1, unsorted list or leaf-list
+ * @param[in]  skip1 Key matching skipped for keys not in x1
+ * @param[out] xvec  Vector of matching XML return objects (can be empty)
+ * @retval     1     OK, see xvec (may be empty)
+ * @retval     0     Index not applicable, search linearly
+ * @retval    -1     Error
+ * @note only first match, as xml_find_keys_notsorted
+ */
+static int
+xml_key_index_search(cxobj       *xp,
+                     cxobj       *x1,
+                     yang_stmt   *yc,
+                     int          skip1,
+                     clixon_xvec *xvec)
+{
+    struct xml_key_index *xk;
+    uint32_t              h;
+    uint32_t              i;
+    int                   ret;
+
+    switch (yang_keyword_get(yc)){
+    case Y_LIST:
+        if (cvec_len(yang_cvec_get(yc)) == 0)
+            return 0;
+        break;
+    case Y_LEAF_LIST:
+        break;
+    default:
+        return 0;
+    }
+    if ((xk = xml_key_index_get(xp)) == NULL || xk->xk_yang != yc){
+        if (xml_child_nr(xp) < XML_KEY_INDEX)
+            return 0;
+        xml_key_index_free(xp);
+        if ((ret = xml_key_index_build(xp, yc, &xk)) <= 0)
+            return ret;
+    }
+    if (xml_key_hash(x1, yc, skip1, &h) == 0)
+        return 0;
+    i = h & (xk->xk_size - 1);
+    while (xk->xk_vec[i].ks_x != NULL){
+        if (xk->xk_vec[i].ks_hash == h &&
+            xml_cmp(x1, xk->xk_vec[i].ks_x, 0, skip1, NULL) == 0){
+            if (clixon_xvec_append(xvec, xk->xk_vec[i].ks_x) < 0)
+                return -1;
+            break;
+        }
+        i = (i + 1) & (xk->xk_size - 1);
+    }
+    return 1;
+}
+
+/*! Add XML child to key index of its parent, if any
+ *
+ * @param[in]  xp    Parent xml node
+ * @param[in]  x     Inserted child
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xml_insert
+ */
+static int
+xml_key_index_add(cxobj *xp,
+                  cxobj *x)
+{
+    struct xml_key_index *xk;
+    uint32_t              h;
+
+    if ((xk = xml_key_index_get(xp)) == NULL ||
+        xml_spec(x) != xk->xk_yang)
+        return 0;
+    if (xml_key_hash(x, xk->xk_yang, 0, &h) == 0)
+        return xml_key_index_free(xp);
+    return xml_key_index_put(xk, x, h);
+}
+
+/*! Update key indexes after a child has been added to, or removed from, x
+ *
+ * An index of x is affected by added or removed entries, an index of the parent of x by
+ * changed keys of entry x, and an index of the grandparent by a changed value of key leaf x.
+ * Removed entries are removed from the index, other changes affecting the index removes
+ * the whole index, which is rebuilt at next search.
+ * @param[in]  x     XML node whose child has been added, removed or changed value
+ * @param[in]  xc    The child
+ * @param[in]  rm    If set, xc has been removed from x
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+xml_key_index_change(cxobj *x,
+                     cxobj *xc,
+                     int    rm)
+{
+    struct xml_key_index *xk;
+    cxobj                *xa = x;   /* Ancestor with potential index */
+    cxobj                *xe = xc;  /* Child of xa on path to change, potential entry */
+    cxobj                *xk1 = NULL; /* Child of xe on path to change, potential key */
+    cvec                 *cvk;
+    cg_var               *cvi;
+    uint32_t              h;
+    int                   i;
+
+    for (i=0; i<3 && xa != NULL; i++){
+        if ((xk = xml_key_index_get(xa)) != NULL &&
+            xml_type(xe) == CX_ELMNT &&
+            (xml_spec(xe) == xk->xk_yang || (i == 0 && xml_spec(xe) == NULL))){
+            if (i == 0 && rm){
+                if (xml_key_hash(xe, xk->xk_yang, 0, &h) == 1)
+                    xml_key_index_del(xk, xe, h);
+                else
+                    xml_key_index_free(xa);
+            }
+            else if (i > 0 && yang_keyword_get(xk->xk_yang) == Y_LIST){
+                /* Only changes of key leafs of the entry matter */
+                if (xml_type(xk1) == CX_ELMNT){
+                    cvk = yang_cvec_get(xk->xk_yang);
+                    cvi = NULL;
+                    while ((cvi = cvec_each(cvk, cvi)) != NULL)
+                        if (strcmp(xml_name(xk1), cv_string_get(cvi)) == 0)
+                            break;
+                    if (cvi != NULL)
+                        xml_key_index_free(xa);
+                }
+            }
+            else
+                xml_key_index_free(xa);
+        }
+        xk1 = xe;
+        xe = xa;
+        xa = xml_parent(xa);
+    }
+    return 0;
+}
+#endif /* XML_KEY_INDEX */
+
 /*! Find XML child under xp matching x1 using binary search
  *
  * @param[in]  xp        Parent xml node. 
@@ -875,6 +1278,9 @@ xml_search_yang(cxobj       *xp,
     int    upper = xml_child_nr(xp);
     int    sorted = 1;
     int    yangi;
+#ifdef XML_KEY_INDEX
+    int    ret;
+#endif
 
     if (xp == NULL){
         clixon_err(OE_XML, EINVAL, "xp is NULL");
@@ -896,13 +1302,43 @@ xml_search_yang(cxobj       *xp,
             sorted = (yang_find(yc, Y_ORDERED_BY, "user") == NULL);
     if ((yangi = yang_order(yc)) < -1)
         goto done;
+#ifdef XML_KEY_INDEX
+    if (!sorted && indexvar == NULL){
+        if ((ret = xml_key_index_search(xp, x1, yc, skip1, xvec)) < 0)
+            goto done;
+        if (ret == 1)
+            goto ok;
+    }
+#endif
     if (xml_search_binary(xp, x1, sorted, yangi, low, upper, skip1, indexvar, xvec) < 0)
         goto done;
+#ifdef XML_KEY_INDEX
+ ok:
+#endif
     retval = 0;
  done:
     return retval;
 }
 
+/*! Check if XML nodes of a YANG spec are inserted in user order
+ *
+ * @param[in] y    Yang stmt of xml node
+ * @retval    1    Ordered-by user, or state data
+ * @retval    0    Ordered-by system
+ */
+static int
+xml_insert_userorder_p(yang_stmt *y)
+{
+    /* Find if non-config and if ordered-by-user */
+#ifndef STATE_ORDERED_BY_SYSTEM
+    if (yang_config_ancestor(y)==0)
+        return 1;
+#endif
+    if (yang_keyword_get(y) == Y_LIST || yang_keyword_get(y) == Y_LEAF_LIST)
+        return yang_find(y, Y_ORDERED_BY, "user") != NULL;
+    return 0;
+}
+
 /*! Insert xn in xp:s sorted child list (special case of ordered-by user)
  *
  * @param[in] xp      Parent xml node. If NULL just remove from old parent.
@@ -1052,7 +1488,11 @@ xml_insert2(cxobj           *xp,
         cmp = 1;
     }
     if (yc == yn){ /* Same yang */
-        if (userorder){ /* append: increment linearly until no longer equal */
+        if (userorder && ins == INS_LAST) /* Continue binary search for end of list */
+            cmp = 1;
+        else if (userorder && ins == INS_FIRST) /* Continue binary search for start of list */
+            cmp = -1;
+        else if (userorder){ /* before/after: find the given entry */
             retval = xml_insert_userorder(xp, xn, yn, mid, ins, key_val, nsc_key);
             goto done;
         }
@@ -1133,14 +1573,7 @@ xml_insert(cxobj           *xp,
     for (low=0; low<upper; low++)
         if ((xa = xml_child_i(xp, low)) == NULL || xml_type(xa)!=CX_ATTR)
             break;
-    /* Find if non-config and if ordered-by-user */
-#ifndef STATE_ORDERED_BY_SYSTEM
-    if (yang_config_ancestor(y)==0)
-        userorder = 1;
-    else
-#endif
-        if (yang_keyword_get(y) == Y_LIST || yang_keyword_get(y) == Y_LEAF_LIST)
-            userorder = (yang_find(y, Y_ORDERED_BY, "user") != NULL);
+    userorder = xml_insert_userorder_p(y);
     if ((yi = yang_order(y)) < -1)
         goto done;
     if ((i = xml_insert2(xp, xi, y, yi,
@@ -1150,6 +1583,10 @@ xml_insert(cxobj           *xp,
     if (xml_child_insert_pos(xp, xi, i) < 0)
         goto done;
     xml_parent_set(xi, xp);
+#ifdef XML_KEY_INDEX
+    if (xml_key_index_add(xp, xi) < 0)
+        goto done;
+#endif
     /* clear namespace context cache of child */
     nscache_clear(xi);
 
@@ -1158,6 +1595,101 @@ xml_insert(cxobj           *xp,
     return retval;
 }
 
+/*! Help function to qsort for sorting a batch of new children, see xml_insert_bulk
+ */
+static int
+xml_cmp_bulk(const void *arg1,
+             const void *arg2)
+{
+    return xml_cmp(*(struct xml**)arg1, *(struct xml**)arg2, 0, 0, NULL);
+}
+
+/*! Insert a batch of children as last in xp:s sorted child list
+ *
+ * Same result as xml_insert(xp, x, INS_LAST, NULL, NULL) for each x in xvec, but the
+ * ordered-by system children are sorted once and merged with the existing children in a
+ * single pass, instead of one binary search and memmove per child.
+ * Children that are ordered-by user (or state) are inserted one by one in xvec order.
+ * @param[in] xp      Parent xml node
+ * @param[in] xvec    New YANG bound children without parent
+ * @retval    0       OK
+ * @retval   -1       Error
+ * @see xml_insert
+ */
+int
+xml_insert_bulk(cxobj       *xp,
+                clixon_xvec *xvec)
+{
+    int     retval = -1;
+    cxobj **vec = NULL;
+    cxobj **cvec;
+    cxobj  *x;
+    int     len;
+    int     n;
+    int     m = 0;
+    int     i;
+    int     j;
+    int     k;
+
+    if ((len = clixon_xvec_len(xvec)) == 0)
+        goto ok;
+    if ((vec = calloc(len, sizeof(cxobj *))) == NULL){
+        clixon_err(OE_XML, errno, "calloc");
+        goto done;
+    }
+    for (i=0; i<len; i++){
+        x = clixon_xvec_i(xvec, i);
+        if (xml_parent(x) != NULL){
+            clixon_err(OE_XML, 0, "XML node %s should not have parent", xml_name(x));
+            goto done;
+        }
+        if (xml_spec(x) == NULL){
+            clixon_err(OE_XML, 0, "No spec found %s", xml_name(x));
+            goto done;
+        }
+        if (!xml_insert_userorder_p(xml_spec(x)))
+            vec[m++] = x;
+    }
+    qsort(vec, m, sizeof(cxobj *), xml_cmp_bulk);
+    /* Extend child vector, then merge backwards from the end */
+    n = xml_child_nr(xp);
+    for (j=0; j<m; j++)
+        if (xml_child_insert_pos(xp, vec[j], n+j) < 0)
+            goto done;
+    cvec = xml_childvec_get(xp);
+    i = n - 1;
+    j = m - 1;
+    k = n + m - 1;
+    while (j >= 0){
+        if (i >= 0 && xml_cmp(cvec[i], vec[j], 0, 0, NULL) > 0)
+            cvec[k--] = cvec[i--];
+        else
+            cvec[k--] = vec[j--];
+    }
+    for (j=0; j<m; j++){
+        xml_parent_set(vec[j], xp);
+        /* clear namespace context cache of child */
+        nscache_clear(vec[j]);
+#ifdef XML_KEY_INDEX
+        if (xml_key_index_add(xp, vec[j]) < 0)
+            goto done;
+#endif
+    }
+    /* Ordered-by user */
+    for (i=0; i<len; i++){
+        x = clixon_xvec_i(xvec, i);
+        if (xml_parent(x) == NULL &&
+            xml_insert(xp, x, INS_LAST, NULL, NULL) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (vec)
+        free(vec);
+    return retval;
+}
+
 /*! Verify all children of XML node are sorted according to xml_sort()
  *
  * @param[in]   x    XML node. Check its children
@@ -99,6 +99,7 @@
 #include "clixon_xpath.h"
 #include "clixon_xpath_parse.h"
 #include "clixon_xpath_eval.h"
+#include "clixon_xpath_optimize.h"
 
 /* Use apostrophe(') in xpath literals, eg a/[x='foo'], not double-quotes(")
  * If not set, use ": a/[x="foo"]
@@ -513,6 +514,126 @@ xpath_tree_traverse(xpath_tree *xt,
     return xs;
 }
 
+/*! Add a dependency name to vector unless already present
+ *
+ * @param[in]  cvv   Vector of names
+ * @param[in]  name  Node name, or "*" for any node
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xpath_deps_add(cvec       *cvv,
+               const char *name)
+{
+    cg_var *cv;
+
+    if (cvec_find(cvv, (char*)name) != NULL)
+        return 0;
+    if ((cv = cvec_add(cvv, CGV_STRING)) == NULL){
+        clixon_err(OE_XML, errno, "cvec_add");
+        return -1;
+    }
+    if (cv_name_set(cv, (char*)name) == NULL){
+        clixon_err(OE_XML, errno, "cv_name_set");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Collect dependency names of a location step
+ *
+ * @param[in]  xs    XPath step
+ * @param[in]  last  Last step of location path: the selected nodes are used
+ * @param[in]  cvv   Vector of names
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xpath_step_deps(xpath_tree *xs,
+                int         last,
+                cvec       *cvv)
+{
+    if (xs->xs_type != XP_STEP)
+        return xpath_tree_deps(xs, cvv);
+    if (last){
+        if (xs->xs_c0 == NULL){ /* "." or ".." */
+            if (xpath_deps_add(cvv, "*") < 0)
+                return -1;
+        }
+        else if (xpath_tree_deps(xs->xs_c0, cvv) < 0)
+            return -1;
+    }
+    /* Predicates */
+    return xpath_tree_deps(xs->xs_c1, cvv);
+}
+
+/*! Collect names of nodes an XPath expression depends on
+ *
+ * The node-test name of the last step of every location path, including paths in
+ * predicates, is added to the vector. Other steps only navigate: the nodes they
+ * select can only change if nodes of the last step are added or deleted.
+ * This is an over-approximation: the XPath can only evaluate differently if a node with
+ * one of these names, or one of its descendants, is added, deleted or changed.
+ * If the XPath may depend on any node, "*" is added. This is the case for wildcards,
+ * node-type tests, the root path, paths ending with "." or "..", and for functions using
+ * the context node implicitly, or deref().
+ * @param[in]  xs   XPath parse tree
+ * @param[in]  cvv  Vector of names (cv names)
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see ys_populate_xpath_deps  where this is computed for YANG must/when/path statements
+ */
+int
+xpath_tree_deps(xpath_tree *xs,
+                cvec       *cvv)
+{
+    xpath_tree *xr;
+    int         last = 1;
+    char       *fn;
+
+    if (xs == NULL)
+        return 0;
+    switch (xs->xs_type){
+    case XP_ABSPATH: /* "/" selects root */
+        if (xs->xs_c0 == NULL)
+            return xpath_deps_add(cvv, "*");
+        break;
+    case XP_RELLOCPATH: /* Left-recursive: last step first */
+        for (xr = xs; xr && xr->xs_type == XP_RELLOCPATH; xr = xr->xs_c0)
+            if (xr->xs_c1){
+                if (xpath_step_deps(xr->xs_c1, last, cvv) < 0)
+                    return -1;
+                last = 0;
+            }
+        if (xr && xpath_step_deps(xr, last, cvv) < 0)
+            return -1;
+        return 0;
+    case XP_NODE:
+        if (xs->xs_s1 == NULL || strcmp(xs->xs_s1, "*") == 0)
+            return xpath_deps_add(cvv, "*");
+        return xpath_deps_add(cvv, xs->xs_s1);
+    case XP_NODE_FN:
+        return xpath_deps_add(cvv, "*");
+    case XP_PRIME_FN:
+        if ((fn = xs->xs_s0) != NULL &&
+            (strcmp(fn, "deref") == 0 ||
+             (xs->xs_c0 == NULL && (strcmp(fn, "string") == 0 ||
+                                    strcmp(fn, "number") == 0 ||
+                                    strcmp(fn, "string-length") == 0 ||
+                                    strcmp(fn, "normalize-space") == 0))))
+            if (xpath_deps_add(cvv, "*") < 0)
+                return -1;
+        break;
+    default:
+        break;
+    }
+    if (xpath_tree_deps(xs->xs_c0, cvv) < 0)
+        return -1;
+    if (xpath_tree_deps(xs->xs_c1, cvv) < 0)
+        return -1;
+    return 0;
+}
+
 /*! Free a xpath_tree
  *
  * @param[in]  xs  XPath tree
@@ -531,6 +652,8 @@ xpath_tree_free(xpath_tree *xs)
         xpath_tree_free(xs->xs_c0);
     if (xs->xs_c1)
         xpath_tree_free(xs->xs_c1);
+    if (xs->xs_plan)
+        xpath_optimize_plan_free(xs->xs_plan);
     free(xs);
     return 0;
 }
@@ -602,6 +725,383 @@ xpath_parse(const char  *xpath,
     return retval;
 }
 
+#ifdef XPATH_CACHE_SIZE
+/*! Cached parsed XPath tree
+ *
+ * Entries are either in the LRU list, or pinned (compiled YANG XPaths) and never evicted.
+ * An entry evicted while in use is freed when the last user releases it.
+ */
+struct xpath_cache_entry{
+    struct xpath_cache_entry *xpc_hnext;   /* Next in hash bucket / evicted list */
+    struct xpath_cache_entry *xpc_prev;    /* LRU list, towards most recently used */
+    struct xpath_cache_entry *xpc_next;    /* LRU list, towards least recently used */
+    uint32_t                  xpc_hash;    /* Hash value of XPath string */
+    int                       xpc_refs;    /* Number of ongoing evaluations using tree */
+    int                       xpc_pinned;  /* Not in LRU, never evicted */
+    xpath_tree               *xpc_tree;    /* Parsed XPath */
+    char                      xpc_xpath[]; /* XPath string (key) */
+};
+
+/* XPath cache (too low-level to hang it on handle) */
+static struct xpath_cache_entry **_xpc_vec = NULL;    /* Hash table */
+static uint32_t                   _xpc_size = 0;      /* Number of buckets, power of 2 */
+static uint32_t                   _xpc_nr = 0;        /* Number of entries in hash table */
+static uint32_t                   _xpc_lru_nr = 0;    /* Number of entries in LRU list */
+static struct xpath_cache_entry  *_xpc_lru_head = NULL; /* Most recently used */
+static struct xpath_cache_entry  *_xpc_lru_tail = NULL; /* Least recently used */
+static struct xpath_cache_entry  *_xpc_evicted = NULL;  /* Evicted but in use */
+static uint64_t                   _xpc_hits = 0;
+static uint64_t                   _xpc_misses = 0;
+
+/*! FNV-1a hash of XPath string
+ */
+static uint32_t
+xpath_cache_hash(const char *str)
+{
+    uint32_t h = 2166136261U;
+
+    while (*str){
+        h ^= (unsigned char)*str++;
+        h *= 16777619U;
+    }
+    return h;
+}
+
+/*! Unlink entry from LRU list
+ */
+static void
+xpath_cache_lru_unlink(struct xpath_cache_entry *xpc)
+{
+    if (xpc->xpc_prev)
+        xpc->xpc_prev->xpc_next = xpc->xpc_next;
+    else
+        _xpc_lru_head = xpc->xpc_next;
+    if (xpc->xpc_next)
+        xpc->xpc_next->xpc_prev = xpc->xpc_prev;
+    else
+        _xpc_lru_tail = xpc->xpc_prev;
+    xpc->xpc_prev = xpc->xpc_next = NULL;
+    _xpc_lru_nr--;
+}
+
+/*! Link entry first in LRU list (most recently used)
+ */
+static void
+xpath_cache_lru_link(struct xpath_cache_entry *xpc)
+{
+    xpc->xpc_prev = NULL;
+    xpc->xpc_next = _xpc_lru_head;
+    if (_xpc_lru_head)
+        _xpc_lru_head->xpc_prev = xpc;
+    else
+        _xpc_lru_tail = xpc;
+    _xpc_lru_head = xpc;
+    _xpc_lru_nr++;
+}
+
+/*! Free cache entry and its XPath tree
+ */
+static void
+xpath_cache_entry_free(struct xpath_cache_entry *xpc)
+{
+    if (xpc->xpc_tree)
+        xpath_tree_free(xpc->xpc_tree);
+    free(xpc);
+}
+
+/*! Remove entry from hash table
+ */
+static void
+xpath_cache_hash_unlink(struct xpath_cache_entry *xpc)
+{
+    struct xpath_cache_entry **xp;
+
+    xp = &_xpc_vec[xpc->xpc_hash & (_xpc_size-1)];
+    while (*xp != xpc)
+        xp = &(*xp)->xpc_hnext;
+    *xp = xpc->xpc_hnext;
+    xpc->xpc_hnext = NULL;
+    _xpc_nr--;
+}
+
+/*! Double size of hash table
+ */
+static int
+xpath_cache_grow(void)
+{
+    struct xpath_cache_entry **vec;
+    struct xpath_cache_entry  *xpc;
+    uint32_t                   size;
+    uint32_t                   i;
+
+    size = _xpc_size ? _xpc_size*2 : 256;
+    if ((vec = calloc(size, sizeof(*vec))) == NULL){
+        clixon_err(OE_XML, errno, "calloc");
+        return -1;
+    }
+    for (i=0; i<_xpc_size; i++){
+        while ((xpc = _xpc_vec[i]) != NULL){
+            _xpc_vec[i] = xpc->xpc_hnext;
+            xpc->xpc_hnext = vec[xpc->xpc_hash & (size-1)];
+            vec[xpc->xpc_hash & (size-1)] = xpc;
+        }
+    }
+    if (_xpc_vec)
+        free(_xpc_vec);
+    _xpc_vec = vec;
+    _xpc_size = size;
+    return 0;
+}
+
+/*! Evict least recently used entries until LRU list is within its size
+ */
+static void
+xpath_cache_evict(void)
+{
+    struct xpath_cache_entry *xpc;
+
+    while (_xpc_lru_nr > XPATH_CACHE_SIZE && (xpc = _xpc_lru_tail) != NULL){
+        xpath_cache_lru_unlink(xpc);
+        xpath_cache_hash_unlink(xpc);
+        if (xpc->xpc_refs > 0){ /* In use: free on release */
+            xpc->xpc_hnext = _xpc_evicted;
+            _xpc_evicted = xpc;
+        }
+        else
+            xpath_cache_entry_free(xpc);
+    }
+}
+
+/*! Find XPath in cache, or parse it and add it to cache
+ *
+ * @param[in]  xpath  XPath string
+ * @param[in]  pin    Pin entry, ie never evict it
+ * @param[out] xpcp   Cache entry
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xpath_cache_lookup(const char                *xpath,
+                   int                        pin,
+                   struct xpath_cache_entry **xpcp)
+{
+    struct xpath_cache_entry *xpc;
+    uint32_t                  h;
+    size_t                    len;
+
+    h = xpath_cache_hash(xpath);
+    if (_xpc_vec){
+        for (xpc = _xpc_vec[h & (_xpc_size-1)]; xpc; xpc = xpc->xpc_hnext)
+            if (xpc->xpc_hash == h && strcmp(xpc->xpc_xpath, xpath) == 0)
+                break;
+        if (xpc != NULL){
+            if (!xpc->xpc_pinned){
+                xpath_cache_lru_unlink(xpc);
+                if (pin)
+                    xpc->xpc_pinned = 1;
+                else
+                    xpath_cache_lru_link(xpc);
+            }
+            *xpcp = xpc;
+            return 0;
+        }
+    }
+    if (_xpc_nr >= _xpc_size && xpath_cache_grow() < 0)
+        return -1;
+    len = strlen(xpath);
+    if ((xpc = calloc(1, sizeof(*xpc) + len + 1)) == NULL){
+        clixon_err(OE_XML, errno, "calloc");
+        return -1;
+    }
+    memcpy(xpc->xpc_xpath, xpath, len + 1);
+    if (xpath_parse(xpath, &xpc->xpc_tree) < 0){
+        free(xpc);
+        return -1;
+    }
+    xpc->xpc_hash = h;
+    xpc->xpc_hnext = _xpc_vec[h & (_xpc_size-1)];
+    _xpc_vec[h & (_xpc_size-1)] = xpc;
+    _xpc_nr++;
+    if (pin)
+        xpc->xpc_pinned = 1;
+    else
+        xpath_cache_lru_link(xpc);
+    *xpcp = xpc;
+    return 1;
+}
+
+/*! Get parsed XPath tree from cache, parse and add it if not found
+ *
+ * @param[in]  xpath  XPath string
+ * @param[out] xpt    Parsed XPath tree, do not modify or free, release with xpath_cache_release
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @code
+ *   xpath_tree *xpt = NULL;
+ *   if (xpath_cache_get(xpath, &xpt) < 0)
+ *     err;
+ *   ... evaluate xpt
+ *   xpath_cache_release(xpath, xpt);
+ * @endcode
+ */
+int
+xpath_cache_get(const char  *xpath,
+                xpath_tree **xpt)
+{
+    struct xpath_cache_entry *xpc = NULL;
+    int                       ret;
+
+    if (xpath == NULL){
+        clixon_err(OE_XML, EINVAL, "XPath is NULL");
+        return -1;
+    }
+    if ((ret = xpath_cache_lookup(xpath, 0, &xpc)) < 0)
+        return -1;
+    if (ret == 0)
+        _xpc_hits++;
+    else{
+        _xpc_misses++;
+        xpath_cache_evict();
+    }
+    xpc->xpc_refs++;
+    *xpt = xpc->xpc_tree;
+    return 0;
+}
+
+/*! Release XPath tree gotten from xpath_cache_get
+ *
+ * @param[in]  xpath  XPath string
+ * @param[in]  xpt    Parsed XPath tree as returned by xpath_cache_get
+ * @retval     0      OK
+ */
+int
+xpath_cache_release(const char *xpath,
+                    xpath_tree *xpt)
+{
+    struct xpath_cache_entry  *xpc;
+    struct xpath_cache_entry **xp;
+    uint32_t                   h;
+
+    h = xpath_cache_hash(xpath);
+    if (_xpc_vec){
+        for (xpc = _xpc_vec[h & (_xpc_size-1)]; xpc; xpc = xpc->xpc_hnext)
+            if (xpc->xpc_tree == xpt){
+                xpc->xpc_refs--;
+                return 0;
+            }
+    }
+    for (xp = &_xpc_evicted; (xpc = *xp) != NULL; xp = &xpc->xpc_hnext)
+        if (xpc->xpc_tree == xpt){
+            if (--xpc->xpc_refs == 0){
+                *xp = xpc->xpc_hnext;
+                xpath_cache_entry_free(xpc);
+            }
+            break;
+        }
+    return 0;
+}
+
+/*! Parse and add XPath to cache permanently, eg XPaths of YANG when/must/path statements
+ *
+ * @param[in]  xpath  XPath string
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+xpath_cache_compile(const char *xpath)
+{
+    struct xpath_cache_entry *xpc = NULL;
+
+    if (xpath == NULL){
+        clixon_err(OE_XML, EINVAL, "XPath is NULL");
+        return -1;
+    }
+    if (xpath_cache_lookup(xpath, 1, &xpc) < 0)
+        return -1;
+    return 0;
+}
+
+#else /* XPATH_CACHE_SIZE */
+int
+xpath_cache_get(const char  *xpath,
+                xpath_tree **xpt)
+{
+    return xpath_parse(xpath, xpt);
+}
+
+int
+xpath_cache_release(const char *xpath,
+                    xpath_tree *xpt)
+{
+    return xpath_tree_free(xpt);
+}
+
+int
+xpath_cache_compile(const char *xpath)
+{
+    return xpath_parse(xpath, NULL);
+}
+#endif /* XPATH_CACHE_SIZE */
+
+/*! Get XPath cache statistics
+ *
+ * @param[out]  nr      Number of cached XPaths
+ * @param[out]  hits    Number of lookups found in cache
+ * @param[out]  misses  Number of lookups not found in cache, ie parsed
+ * @retval      0       OK
+ */
+int
+xpath_cache_stats(uint64_t *nr,
+                  uint64_t *hits,
+                  uint64_t *misses)
+{
+#ifdef XPATH_CACHE_SIZE
+    if (nr)
+        *nr = _xpc_nr;
+    if (hits)
+        *hits = _xpc_hits;
+    if (misses)
+        *misses = _xpc_misses;
+#else
+    if (nr)
+        *nr = 0;
+    if (hits)
+        *hits = 0;
+    if (misses)
+        *misses = 0;
+#endif
+    return 0;
+}
+
+/*! Free XPath cache
+ */
+void
+xpath_cache_exit(void)
+{
+#ifdef XPATH_CACHE_SIZE
+    struct xpath_cache_entry *xpc;
+    uint32_t                  i;
+
+    for (i=0; i<_xpc_size; i++){
+        while ((xpc = _xpc_vec[i]) != NULL){
+            _xpc_vec[i] = xpc->xpc_hnext;
+            xpath_cache_entry_free(xpc);
+        }
+    }
+    while ((xpc = _xpc_evicted) != NULL){
+        _xpc_evicted = xpc->xpc_hnext;
+        xpath_cache_entry_free(xpc);
+    }
+    if (_xpc_vec)
+        free(_xpc_vec);
+    _xpc_vec = NULL;
+    _xpc_size = 0;
+    _xpc_nr = 0;
+    _xpc_lru_nr = 0;
+    _xpc_lru_head = _xpc_lru_tail = NULL;
+#endif
+}
+
 /*! Given XML tree and xpath, parse xpath, eval it and return xpath context, 
  *
  * This is a raw form of xpath where you can do type conversion of the return
@@ -633,7 +1133,7 @@ xpath_vec_ctx(cxobj      *xcur,
     xp_ctx      xc = {0,};
     
     clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "%s", xpath);
-    if (xpath_parse(xpath, &xptree) < 0)
+    if (xpath_cache_get(xpath, &xptree) < 0)
         goto done;
     xc.xc_type = XT_NODESET;
     xc.xc_node = xcur;
@@ -649,7 +1149,7 @@ xpath_vec_ctx(cxobj      *xcur,
         xc.xc_nodeset = NULL;
     }
     if (xptree)
-        xpath_tree_free(xptree);
+        xpath_cache_release(xpath, xptree);
     return retval;
 }
 
@@ -1612,13 +2112,13 @@ xpath2xml(char       *xpath,
         goto fail;
     }
     /* Parse input xpath into an xpath-tree */
-    if (xpath_parse(xpath, &xpt) < 0)
+    if (xpath_cache_get(xpath, &xpt) < 0)
         goto done;
     if ((retval = xpath2xml_traverse(xpt, nsc, xtop, ytop, xbotp, ybotp, xerr)) < 1)
         goto done;
  done:
     if (xpt)
-        xpath_tree_free(xpt);
+        xpath_cache_release(xpath, xpt);
     if (cberr)
         cbuf_free(cberr);
     return retval;
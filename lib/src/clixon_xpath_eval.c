@@ -332,6 +332,7 @@ xp_eval_step(xp_ctx     *xc0,
     xpath_tree *nodetest = xs->xs_c0;
     xp_ctx     *xc = NULL;
     int         ret;
+    int         nopred = 0;
 
     /* Create new xc */
     if ((xc = ctx_dup(xc0)) == NULL)
@@ -356,9 +357,11 @@ xp_eval_step(xp_ctx     *xc0,
             for (i=0; i<xc->xc_size; i++){
                 xv = xc->xc_nodeset[i];
                 x = NULL;
-                if ((ret = xpath_optimize_check(xs, xv, &vec, &veclen)) < 0)
+                if ((ret = xpath_optimize_check(xs, xv, xc->xc_size, nsc, localonly, &vec, &veclen)) < 0)
                     goto done;
-                if (ret == 0){/* regular code, no optimization made */
+                if (ret == 2) /* predicates consumed by lookup */
+                    nopred = 1;
+                else if (ret == 0){/* regular code, no optimization made */
                     while ((x = xml_child_each(xv, x, CX_ELMNT)) != NULL) {
                         /* xs->xs_c0 is nodetest */
                         if (nodetest == NULL ||
@@ -436,7 +439,7 @@ xp_eval_step(xp_ctx     *xc0,
         goto done;
         break;
     }
-    if (xs->xs_c1){
+    if (xs->xs_c1 && !nopred){
         if (xp_eval(xc, xs->xs_c1, nsc, localonly, xrp) < 0)
             goto done;
     }
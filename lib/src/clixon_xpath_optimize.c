@@ -36,6 +36,7 @@
  * See XPATH_LIST_OPTIMIZE
  */
 
+
 #ifdef HAVE_CONFIG_H
 #include "clixon_config.h" /* generated by config & autoconf */
 #endif
@@ -61,6 +62,7 @@
 #include "clixon_handle.h"
 #include "clixon_yang.h"
 #include "clixon_xml.h"
+#include "clixon_xml_nsctx.h"
 #include "clixon_err.h"
 #include "clixon_log.h"
 #include "clixon_debug.h"
@@ -71,11 +73,35 @@
 #include "clixon_xpath_optimize.h"
 
 #ifdef XPATH_LIST_OPTIMIZE
-static xpath_tree *_xmtop = NULL; /* pattern match tree top */
-static xpath_tree *_xm = NULL;
-static xpath_tree *_xe = NULL;
+/*! Lookup plan of an XPath child step
+ */
+enum xpath_plan_type {
+    XPATH_PLAN_NONE,  /* No predicates, scan children */
+    XPATH_PLAN_EVAL,  /* Scan children and evaluate predicates */
+    XPATH_PLAN_KEY,   /* Binary search on list keys, eg y[k1='a'][k2='b'] */
+    XPATH_PLAN_INDEX, /* Search on explicit index, see XML_EXPLICIT_INDEX */
+    XPATH_PLAN_POS,   /* Position, eg y[3] */
+};
+
+/*! Compiled lookup plan of an XPath step, cached in the step node of the XPath tree
+ *
+ * The plan depends on the YANG spec of the context node and is compiled again if it changes.
+ * The plan only narrows the search and does not refer to YANG, so a stale plan is still correct.
+ */
+struct xpath_plan {
+    yang_stmt           *xp_yp;   /* YANG spec of context node */
+    enum xpath_plan_type xp_type; /* Type of plan */
+    char                *xp_name; /* Name of list, points into XPath tree */
+    char                *xp_ns;   /* Namespace of list, points into YANG */
+    cvec                *xp_cvk;  /* Index names and values (KEY and INDEX) */
+    uint32_t             xp_pos;  /* Position (POS) */
+};
+
 static int _optimize_enable = 1;
 static int _optimize_hits = 0;
+
+/* Number of lookups per plan type */
+static uint64_t _optimize_stats[XPATH_PLAN_POS+1] = {0,};
 #endif /* XPATH_LIST_OPTIMIZE */
 
 /* XXX development in clixon_xpath_eval */
@@ -89,6 +115,31 @@ xpath_list_optimize_stats(int *hits)
     return 0;
 }
 
+/*! Get number of XPath step lookups per plan
+ *
+ * @param[out]  keys   Number of binary searches on list keys
+ * @param[out]  index  Number of searches on explicit indexes
+ * @param[out]  pos    Number of positional lookups
+ * @param[out]  eval   Number of steps with predicates evaluated on all children
+ * @retval      0      OK
+ */
+int
+xpath_optimize_stats(uint64_t *keys,
+                     uint64_t *index,
+                     uint64_t *pos,
+                     uint64_t *eval)
+{
+#ifdef XPATH_LIST_OPTIMIZE
+    *keys = _optimize_stats[XPATH_PLAN_KEY];
+    *index = _optimize_stats[XPATH_PLAN_INDEX];
+    *pos = _optimize_stats[XPATH_PLAN_POS];
+    *eval = _optimize_stats[XPATH_PLAN_EVAL];
+#else
+    *keys = *index = *pos = *eval = 0;
+#endif
+    return 0;
+}
+
 /*! Enable xpath optimize
  *
  * Cant replace this with option since there is no handle in xpath functions,...
@@ -105,257 +156,444 @@ xpath_list_optimize_set(int enable)
 void
 xpath_optimize_exit(void)
 {
+}
+
+/*! Free compiled lookup plan of XPath step
+ *
+ * @param[in]  plan  Plan, see xs_plan
+ * @see xpath_tree_free
+ */
+void
+xpath_optimize_plan_free(void *plan)
+{
 #ifdef XPATH_LIST_OPTIMIZE
-    if (_xmtop)
-        xpath_tree_free(_xmtop);
+    struct xpath_plan *xp = (struct xpath_plan *)plan;
+
+    if (xp->xp_cvk)
+        cvec_free(xp->xp_cvk);
+    free(xp);
 #endif
 }
 
 #ifdef XPATH_LIST_OPTIMIZE
-/*! Initialize xpath module
+/*! Skip pass-through nodes of XPath expression, eg expr -> andexpr -> ... -> primaryexpr
  *
- * XXX move to clixon_xpath.c 
- * @see loop_preds
+ * @param[in]  xs   XPath tree
+ * @retval     xs   First node that is not pass-through, or NULL
  */
-int
-xpath_optimize_init(xpath_tree **xm,
-                    xpath_tree **xe)
+static xpath_tree *
+xpath_plan_unwrap(xpath_tree *xs)
+{
+    while (xs != NULL && xs->xs_c1 == NULL){
+        switch (xs->xs_type){
+        case XP_EXP:
+        case XP_AND:
+        case XP_RELEX:
+        case XP_ADD:
+        case XP_UNION:
+            if (xs->xs_int != A_NAN)
+                return xs;
+            break;
+        case XP_PATHEXPR:
+        case XP_FILTEREXPR:
+        case XP_LOCPATH:
+        case XP_RELLOCPATH:
+            break;
+        default:
+            return xs;
+        }
+        xs = xs->xs_c0;
+    }
+    return xs;
+}
+
+/*! Get name if XPath expression is a child node without predicates, eg "k"
+ *
+ * @param[in]  xs    XPath tree
+ * @retval     name  Name of child
+ * @retval     NULL  Not a child node
+ */
+static char *
+xpath_plan_child(xpath_tree *xs)
+{
+    xpath_tree *xn;
+
+    if ((xs = xpath_plan_unwrap(xs)) == NULL ||
+        xs->xs_type != XP_STEP ||
+        xs->xs_int != A_CHILD)
+        return NULL;
+    if (xs->xs_c1 != NULL && xs->xs_c1->xs_c1 != NULL) /* predicates */
+        return NULL;
+    if ((xn = xs->xs_c0) == NULL ||
+        xn->xs_type != XP_NODE ||
+        xn->xs_s1 == NULL ||
+        strcmp(xn->xs_s1, "*") == 0)
+        return NULL;
+    return xn->xs_s1;
+}
+
+/*! Get value if XPath expression is a literal or a number
+ *
+ * @param[in]  xs    XPath tree
+ * @retval     str   Value as string
+ * @retval     NULL  Not a literal or number
+ */
+static char *
+xpath_plan_literal(xpath_tree *xs)
+{
+    if ((xs = xpath_plan_unwrap(xs)) == NULL)
+        return NULL;
+    if (xs->xs_type == XP_PRIME_STR)
+        return xs->xs_s0;
+    if (xs->xs_type == XP_PRIME_NR)
+        return xs->xs_strnr;
+    return NULL;
+}
+
+/*! Check if predicate is an equality between a child and a value, eg k='a' or 'a'=k
+ *
+ * @param[in]  xe    Predicate expression
+ * @param[out] name  Child name
+ * @param[out] value Value
+ * @retval     1     Equality
+ * @retval     0     Not an equality
+ */
+static int
+xpath_plan_eq(xpath_tree *xe,
+              char      **name,
+              char      **value)
+{
+    xpath_tree *xr;
+
+    if ((xr = xpath_plan_unwrap(xe)) == NULL ||
+        xr->xs_type != XP_RELEX ||
+        xr->xs_int != XO_EQ)
+        return 0;
+    if ((*name = xpath_plan_child(xr->xs_c0)) != NULL &&
+        (*value = xpath_plan_literal(xr->xs_c1)) != NULL)
+        return 1;
+    if ((*name = xpath_plan_child(xr->xs_c1)) != NULL &&
+        (*value = xpath_plan_literal(xr->xs_c0)) != NULL)
+        return 1;
+    return 0;
+}
+
+/*! Check if predicate is a position, eg [3]
+ *
+ * @param[in]  xe    Predicate expression
+ * @param[out] pos   Position
+ * @retval     1     Position
+ * @retval     0     Not a position
+ */
+static int
+xpath_plan_pos(xpath_tree *xe,
+               uint32_t   *pos)
 {
-    int         retval = -1;
     xpath_tree *xs;
 
-    if (_xm == NULL){
-        /* Initialize xpath-tree */
-        if (xpath_parse("_x[_y='_z']", &_xmtop) < 0)
-            goto done;
-        /* Go down two steps */
-        if ((_xm = xpath_tree_traverse(_xmtop, 0, 0, -1)) == NULL)
-            goto done;
-        /* get nodetest tree (_x) */
-        if ((xs = xpath_tree_traverse(_xm, 0, -1)) == NULL)
-            goto done;
-        xs->xs_match++;
-        /* get predicates [_y=_z][z=2] */
-        if ((xs = xpath_tree_traverse(_xm, 1, -1)) == NULL)
-            goto done;
-        xs->xs_match++;
-        /* get expression [_y=_z] */
-        if ((_xe = xpath_tree_traverse(xs, 1, -1)) == NULL)
-            goto done;
-        /* get keyname (_y) */
-        if ((xs = xpath_tree_traverse(_xe, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1)) == NULL)
-            goto done;
-        xs->xs_match++; /* in loop_preds get name in xs_s1 XXX: leaf-list is different */
-        /* get keyval (_z) */
-        if ((xs = xpath_tree_traverse(_xe, 0, 0, 1, 0, 0, 0, 0, -1)) == NULL)
-            goto done;
-        xs->xs_match++; /* in loop_preds get value in xs_s0 or xs_strnr */
-    }
-    *xm = _xm;
-    *xe = _xe;
-    retval = 0;
- done:
-    return retval;
+    if ((xs = xpath_plan_unwrap(xe)) == NULL ||
+        xs->xs_type != XP_PRIME_NR)
+        return 0;
+    if (xs->xs_double < 0 || xs->xs_double > UINT32_MAX ||
+        xs->xs_double != (double)(uint32_t)xs->xs_double)
+        return 0;
+    *pos = (uint32_t)xs->xs_double;
+    return 1;
 }
 
+/*! Add name and value to index vector
+ */
+static int
+xpath_plan_cvk_add(cvec *cvk,
+                   char *name,
+                   char *value)
+{
+    cg_var *cv;
+
+    if ((cv = cvec_add(cvk, CGV_STRING)) == NULL){
+        clixon_err(OE_XML, errno, "cvec_add");
+        return -1;
+    }
+    cv_name_set(cv, name);
+    cv_string_set(cv, value);
+    return 0;
+}
 
-/*! Recursive function to loop over all EXPR and pattern match them
+/*! Find child by position among children with name
  *
- * @param[in]  xt    XPath tree of type PRED
- * @param[in]  xepat Pattern matching XPath tree of type EXPR
- * @param[out] cvk   Vector of <keyname>:<keyval> pairs
- * @retval     1     Match
- * @retval     0     No match
+ * @param[in]  xv    Parent
+ * @param[in]  name  Name of children
+ * @param[in]  pos   Position, starting at 0 as position in XPath evaluation
+ * @param[out] xvec  Found child is appended
+ * @retval     0     OK
  * @retval    -1     Error
- * @see xpath_optimize_init
+ * @see clixon_xml_find_pos  same given a YANG spec
  */
 static int
-loop_preds(xpath_tree *xt,
-           xpath_tree *xepat,
-           cvec       *cvk)
+xpath_plan_pos_find(cxobj       *xv,
+                    char        *name,
+                    uint32_t     pos,
+                    clixon_xvec *xvec)
 {
-    int          retval = -1;
-    int          ret;
-    xpath_tree  *xe;
-    xpath_tree **vec = NULL;
-    size_t       veclen = 0;
-    cg_var      *cvi;
+    cxobj   *xc = NULL;
+    uint32_t u = 0;
 
-    if (xt->xs_type == XP_PRED && xt->xs_c0){
-        if ((ret = loop_preds(xt->xs_c0, xepat, cvk)) < 0)
-            goto done;
-        if (ret == 0)
-            goto ok;
+    while ((xc = xml_child_each(xv, xc, CX_ELMNT)) != NULL) {
+        if (strcmp(name, xml_name(xc)))
+            continue;
+        if (pos == u++)
+            return clixon_xvec_append(xvec, xc);
     }
-    if ((xe = xt->xs_c1) && (xe->xs_type == XP_EXP)){
-        if ((ret = xpath_tree_eq(xepat, xe, &vec, &veclen)) < 0)
-            goto done;
-        if (ret == 0)
-            goto ok;
-        if (veclen != 2)
-            goto ok;
-        if ((cvi = cvec_add(cvk, CGV_STRING)) == NULL){
-            clixon_err(OE_XML, errno, "cvec_add");
-            goto done;
-        }
-        cv_name_set(cvi, vec[0]->xs_s1);
-        if (vec[1]->xs_type == XP_PRIME_NR)
-            cv_string_set(cvi, vec[1]->xs_strnr);
-        else
-            cv_string_set(cvi, vec[1]->xs_s0);
-    }
-    retval = 1;
- done:
-    if (vec)
-        free(vec);
-    return retval;
- ok: /* no match, not special case */
-    retval = 0;
-    goto done;
+    return 0;
 }
 
-/*! Pattern matching to find fastpath
+/*! Check if a name is unique among the data node children of a YANG node
  *
- * @param[in]  xt     XPath tree
- * @param[in]  xv     XML base node
- * @param[out] xvec   Array of found nodes
- * @param[out] xlen   Len of xvec
- * @param[out] key
- * @param[out] keyval
- * @retval     1      Match
- * @retval     0      No match - use non-optimized lookup
- * @retval    -1      Error
- *  XPath:
- *  y[k=3] # corresponds to: <name>[<keyname>=<keyval>]
+ * Modules augmenting nodes with the same name into a node are told apart by namespace
+ * @param[in]  yp    YANG spec of context node
+ * @param[in]  name  Name of data node
+ * @retval     1     Unique
+ * @retval     0     Not unique
  */
 static int
-xpath_list_optimize_fn(xpath_tree  *xt,
-                       cxobj       *xv,
-                       clixon_xvec *xvec)
+xpath_plan_unique(yang_stmt *yp,
+                  char      *name)
+{
+    yang_stmt *yc;
+    int        inext = 0;
+    int        n = 0;
+
+    while ((yc = yn_iter(yp, &inext)) != NULL)
+        if (yang_datanode(yc) && strcmp(yang_argument_get(yc), name) == 0)
+            n++;
+    return n == 1;
+}
+
+/*! Compile lookup plan of XPath child step given YANG spec of context node
+ *
+ * Look at the predicates of a step to a list, and use:
+ * - Binary search if leading predicates are equalities on the first keys (in any order)
+ * - Explicit index search if a leading predicate is an equality on an index variable
+ * - Direct lookup if the only predicate is a position
+ * Otherwise all children are evaluated.
+ * Since the lookup only narrows the children, predicates are evaluated on the result, except
+ * for position.
+ * All children are also evaluated if data nodes of several modules have the name of the list.
+ * @param[in]  xs    XPath tree of type STEP
+ * @param[in]  yp    YANG spec of context node
+ * @param[out] xp    Plan
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xpath_plan_compile(xpath_tree        *xs,
+                   yang_stmt         *yp,
+                   struct xpath_plan *xp)
 {
     int          retval = -1;
-    xpath_tree  *xm = NULL;
-    xpath_tree  *xem = NULL;
-    char        *name;
-    yang_stmt   *yp;
-    yang_stmt   *yc;
-    cvec        *cvv = NULL;
+    xpath_tree  *xn;
+    xpath_tree  *xpred;
     xpath_tree **vec = NULL;
-    size_t       veclen = 0;
-    xpath_tree  *xtp;
-    int          ret;
-    cvec        *cvk = NULL; /* vector of index keys */
+    size_t       len = 0;
+    size_t       i;
+    yang_stmt   *yc;
+    cvec        *eqs = NULL;
+    cvec        *cvk = NULL;
     cg_var      *cvi;
-    int          i;
-    yang_stmt   *ypp;
+    cg_var      *cv;
+    char        *name;
+    char        *value;
+#ifdef XML_EXPLICIT_INDEX
+    yang_stmt   *yi;
+#endif
 
-    /* revert to non-optimized if no yang */
-    if ((yp = xml_spec(xv)) == NULL)
+    if (xp->xp_cvk){
+        cvec_free(xp->xp_cvk);
+        xp->xp_cvk = NULL;
+    }
+    xp->xp_yp = yp;
+    xp->xp_type = XPATH_PLAN_NONE;
+    xp->xp_name = NULL;
+    xp->xp_ns = NULL;
+    /* Predicates, innermost is first */
+    for (xpred = xs->xs_c1; xpred != NULL && xpred->xs_c1 != NULL; xpred = xpred->xs_c0)
+        len++;
+    if (len == 0)
         goto ok;
-    /* or if not config data (state data should not be ordered) */
-    if (yang_config_ancestor(yp) == 0)
+    xp->xp_type = XPATH_PLAN_EVAL;
+    /* Not if no yang, or not config data (state data should not be ordered) */
+    if (yp == NULL || yang_config_ancestor(yp) == 0)
         goto ok;
-    /* Check that there is no "outer" list. */
-    ypp = yp;
-    do {
-        if (yang_keyword_get(ypp) == Y_LIST)
-            goto ok;
-    } while((ypp = yang_parent_get(ypp)) != NULL);
-    /* Check yang and that only a list with key as index is a special case can do bin search 
-     * That is, ONLY check optimize cases of this type:_x[_y='_z']
-     * Should we extend this simple example and have more cases (all cases?)
-     */
-    xpath_optimize_init(&xm, &xem);
-    /* Here is where pattern is checked for equality and where variable binding is made (if
-     * equal) */
-    if ((ret = xpath_tree_eq(xm, xt, &vec, &veclen)) < 0)
-        goto done;
-    if (ret == 0)
-        goto ok; /* no match */
-    if (veclen != 2)
+    if ((xn = xs->xs_c0) == NULL ||
+        xn->xs_type != XP_NODE ||
+        xn->xs_s1 == NULL)
         goto ok;
-    name = vec[0]->xs_s1;
-    /* Extract variables */
-    if ((yc = yang_find(yp, Y_LIST, name)) == NULL)
-#ifdef NOTYET /* leaf-list is not detected by xpath optimize detection */
-        if ((yc = yang_find(yp, Y_LEAF_LIST, name)) == NULL) /* XXX */
-#endif
-            goto ok;
-    /* Validate keys */
-    if ((cvv = yang_cvec_get(yc)) == NULL)
+    if ((yc = yang_find(yp, Y_LIST, xn->xs_s1)) == NULL)
         goto ok;
-    xtp = vec[1];
-    if ((cvk = cvec_new(0)) == NULL){
-        clixon_err(OE_YANG, errno, "cvec_new");
+    if (!xpath_plan_unique(yp, xn->xs_s1))
+        goto ok;
+    xp->xp_name = xn->xs_s1;
+    xp->xp_ns = yang_find_mynamespace(yc);
+    if ((vec = calloc(len, sizeof(*vec))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
         goto done;
     }
-    if ((ret = loop_preds(xtp, xem, cvk)) < 0)
+    i = len;
+    for (xpred = xs->xs_c1; xpred != NULL && xpred->xs_c1 != NULL; xpred = xpred->xs_c0)
+        vec[--i] = xpred->xs_c1;
+    if (len == 1 && xpath_plan_pos(vec[0], &xp->xp_pos)){
+        xp->xp_type = XPATH_PLAN_POS;
+        goto ok;
+    }
+    /* Leading equality predicates */
+    if ((eqs = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
         goto done;
-    if (ret == 0)
+    }
+    for (i=0; i<len; i++){
+        if (!xpath_plan_eq(vec[i], &name, &value))
+            break;
+        if (xpath_plan_cvk_add(eqs, name, value) < 0)
+            goto done;
+    }
+    if (cvec_len(eqs) == 0)
         goto ok;
-
-    if (cvec_len(cvv) != cvec_len(cvk))
+    /* Keys in key order, as long as there is an equality for each */
+    if ((cvk = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    cvi = NULL;
+    while ((cvi = cvec_each(yang_cvec_get(yc), cvi)) != NULL) {
+        if ((cv = cvec_find(eqs, cv_string_get(cvi))) == NULL)
+            break;
+        if (xpath_plan_cvk_add(cvk, cv_name_get(cv), cv_string_get(cv)) < 0)
+            goto done;
+    }
+    if (cvec_len(cvk) > 0){
+        xp->xp_type = XPATH_PLAN_KEY;
+        xp->xp_cvk = cvk;
+        cvk = NULL;
         goto ok;
-    i = 0;
+    }
+#ifdef XML_EXPLICIT_INDEX
     cvi = NULL;
-    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-        if (strcmp(cv_name_get(cvi), cv_string_get(cvec_i(cvv,i))))
-            goto ok;
-        i++;
+    while ((cvi = cvec_each(eqs, cvi)) != NULL) {
+        if ((yi = yang_find_datanode(yc, cv_name_get(cvi))) != NULL &&
+            yang_flag_get(yi, YANG_FLAG_INDEX) != 0){
+            if (xpath_plan_cvk_add(cvk, cv_name_get(cvi), cv_string_get(cvi)) < 0)
+                goto done;
+            xp->xp_type = XPATH_PLAN_INDEX;
+            xp->xp_cvk = cvk;
+            cvk = NULL;
+            break;
+        }
     }
-    /* Use 2a form since yc allready given to compute cvk */
-    if (clixon_xml_find_index(xv, yp, NULL, name, cvk, xvec) < 0)
-        goto done;
-    retval = 1; /* match */
+#endif
+ ok:
+    clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "%s plan:%d",
+                 xs->xs_c0 && xs->xs_c0->xs_s1 ? xs->xs_c0->xs_s1 : "", xp->xp_type);
+    retval = 0;
  done:
     if (vec)
         free(vec);
+    if (eqs)
+        cvec_free(eqs);
     if (cvk)
         cvec_free(cvk);
     return retval;
- ok: /* no match, not special case */
-    retval = 0;
-    goto done;
 }
 #endif /* XPATH_LIST_OPTIMIZE */
 
-/*! Identify XPath special cases and if match, use binary search.
+/*! Look up children of an XPath child step using a compiled plan, eg binary search
  *
- * @retval  1  Optimization made, special case, use x (found if != NULL)
- * @retval  0  Dont optimize: not special case, do normal processing
- * @retval -1  Error
+ * The plan is compiled on first use and cached in the XPath tree.
+ * @param[in]     xs      XPath tree of type STEP
+ * @param[in]     xv      Context node
+ * @param[in]     nr      Number of context nodes of step
+ * @param[in]     nsc     XPath namespace context
+ * @param[in]     localonly Skip prefix and namespace tests (non-standard)
+ * @param[in,out] xvec0   Found nodes are appended
+ * @param[in,out] xlen0   Length of xvec0
+ * @retval        2       Optimization made, predicates of step are consumed
+ * @retval        1       Optimization made, predicates are to be evaluated on result
+ * @retval        0       Dont optimize: not special case, do normal processing
+ * @retval       -1       Error
  * XXX Contains glue code between cxobj ** and clixon_xvec code 
  */
 int
 xpath_optimize_check(xpath_tree *xs,
                      cxobj      *xv,
+                     int         nr,
+                     cvec       *nsc,
+                     int         localonly,
                      cxobj    ***xvec0,
                      int        *xlen0)
 {
 #ifdef XPATH_LIST_OPTIMIZE
-    int          retval = -1;
-    int          ret;
-    clixon_xvec *xvec = NULL;
+    int                retval = -1;
+    clixon_xvec       *xvec = NULL;
+    struct xpath_plan *xp;
+    yang_stmt         *yp;
+    int                i;
+    char              *ns;
 
     if (!_optimize_enable)
         goto ok;
-    else if ((xvec = clixon_xvec_new()) == NULL)
-        goto done;
-    /* Glue code since xpath code uses (old) cxobj ** and search code uses (new) clixon_xvec */
-    else if ((ret = xpath_list_optimize_fn(xs, xv, xvec)) < 0)
-        goto done;
-    else if (ret == 1){
-        if (xvec0 && *xvec0){
-            free(*xvec0);
-            *xvec0 = NULL;
+    yp = xml_spec(xv);
+    if ((xp = (struct xpath_plan *)xs->xs_plan) == NULL){
+        if ((xp = malloc(sizeof(*xp))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
         }
-        if (clixon_xvec_extract(xvec, xvec0, xlen0, NULL) < 0){
+        memset(xp, 0, sizeof(*xp));
+        xs->xs_plan = xp;
+        if (xpath_plan_compile(xs, yp, xp) < 0)
+            goto done;
+    }
+    else if (xp->xp_yp != yp){
+        if (xpath_plan_compile(xs, yp, xp) < 0)
             goto done;
+    }
+    switch (xp->xp_type){
+    case XPATH_PLAN_NONE:
+        goto ok;
+    case XPATH_PLAN_EVAL:
+        _optimize_stats[XPATH_PLAN_EVAL]++;
+        goto ok;
+    case XPATH_PLAN_POS:
+        /* Position is relative to children of all context nodes */
+        if (nr != 1){
+            _optimize_stats[XPATH_PLAN_EVAL]++;
+            goto ok;
         }
-        _optimize_hits++;
-        retval = 1; /* Optimized */
+        break;
+    default:
+        break;
+    }
+    /* Step prefix of another module than the list, as in nodetest_eval_node */
+    if (!localonly && nsc != NULL && xp->xp_ns != NULL &&
+        (ns = xml_nsctx_get(nsc, xs->xs_c0->xs_s0)) != NULL &&
+        strcmp(ns, xp->xp_ns) != 0){
+        _optimize_stats[XPATH_PLAN_EVAL]++;
+        goto ok;
+    }
+    if ((xvec = clixon_xvec_new()) == NULL)
         goto done;
+    if (xp->xp_type == XPATH_PLAN_POS){
+        if (xpath_plan_pos_find(xv, xp->xp_name, xp->xp_pos, xvec) < 0)
+            goto done;
     }
+    else if (clixon_xml_find_index(xv, yp, NULL, xp->xp_name, xp->xp_cvk, xvec) < 0)
+        goto done;
+    /* Glue code since xpath code uses (old) cxobj ** and search code uses (new) clixon_xvec */
+    for (i=0; i<clixon_xvec_len(xvec); i++)
+        if (cxvec_append(clixon_xvec_i(xvec, i), xvec0, xlen0) < 0)
+            goto done;
+    _optimize_stats[xp->xp_type]++;
+    _optimize_hits++;
+    retval = xp->xp_type == XPATH_PLAN_POS ? 2 : 1; /* Optimized */
+    goto done;
  ok:
     retval = 0; /* use regular code */
  done:
@@ -366,4 +604,3 @@ xpath_optimize_check(xpath_tree *xs,
     return 0; /* use regular code */
 #endif
 }
-
@@ -492,7 +492,7 @@ yang_path_arg(yang_stmt  *ys,
         clixon_err(OE_XML, EINVAL, "path-arg is NULL");
         goto done;
     }
-    if (xpath_parse(path_arg, &xptree) < 0)
+    if (xpath_cache_get(path_arg, &xptree) < 0)
         goto done;
     if ((xy = xy_dup(NULL)) == NULL)
         goto done;
@@ -505,7 +505,7 @@ yang_path_arg(yang_stmt  *ys,
     retval = 0;
  done:
     if (xptree)
-        xpath_tree_free(xptree);
+        xpath_cache_release(path_arg, xptree);
     if (xyr)
         free(xyr);
     if (xy)
@@ -185,6 +185,9 @@ static int _yang_use_orig = 0;
 
 /* Forward static */
 static int yang_type_cache_free(yang_type_cache *ycache);
+#ifdef YANG_FIND_INDEX
+static void yang_index_free(yang_stmt *ys);
+#endif
 
 /* Access functions
  */
@@ -253,6 +256,7 @@ yang_argument_set(yang_stmt *ys,
                   char      *arg)
 {
     ys->ys_argument = arg; /* not strdup/copied */
+    yang_index_reset(ys->ys_parent);
     return 0;
 }
 
@@ -274,6 +278,7 @@ yang_argument_dup(yang_stmt *ys,
         return -1;
     }
     ys->ys_argument = dup; /* not strdup/copied */
+    yang_index_reset(ys->ys_parent);
     return 0;
 }
 
@@ -974,7 +979,8 @@ ys_new_sz(enum rfc_6020 keyw,
     }
     memset(ys, 0, sz);
     ys->ys_keyword = keyw;
-    _stats_yang_nr++;
+    /* Atomic since YANG files may be parsed in threads, see yang_parse_prefetch */
+    __atomic_add_fetch(&_stats_yang_nr, 1, __ATOMIC_RELAXED);
     return ys;
 }
 
@@ -1021,6 +1027,9 @@ ys_free1(yang_stmt *ys,
     }
     if (ys->ys_stmt)
         free(ys->ys_stmt);
+#ifdef YANG_FIND_INDEX
+    yang_index_free(ys);
+#endif
     switch (ys->ys_keyword) {     /* type-specifi union fields */
     case Y_ACTION:
         while((rc = ys->ys_action_cb) != NULL) {
@@ -1048,7 +1057,7 @@ ys_free1(yang_stmt *ys,
     }
     if (self){
         free(ys);
-        _stats_yang_nr--;
+        __atomic_sub_fetch(&_stats_yang_nr, 1, __ATOMIC_RELAXED);
     }
     return 0;
 }
@@ -1081,6 +1090,7 @@ ys_prune(yang_stmt *yp,
     }
     yp->ys_len--;
     yp->ys_stmt[yp->ys_len] = NULL;
+    yang_index_reset(yp);
  done:
     return yc;
 }
@@ -1141,6 +1151,7 @@ ys_freechildren(yang_stmt *ys)
         free(ys->ys_stmt);
         ys->ys_stmt = NULL;
     }
+    yang_index_reset(ys);
     return 0;
 }
 
@@ -1171,6 +1182,7 @@ yn_realloc(yang_stmt *yn)
         return -1;
     }
     yn->ys_stmt[yn->ys_len - 1] = NULL; /* init field */
+    yang_index_reset(yn);
     return 0;
 }
 
@@ -1256,6 +1268,9 @@ ys_cp_one(yang_stmt *ynew,
     memcpy(ynew, yold, sz);
     yang_flag_reset(ynew, YANG_FLAG_WHEN); /* Dont inherit WHENs */
     ynew->ys_parent = NULL;
+#ifdef YANG_FIND_INDEX
+    ynew->ys_index = NULL;
+#endif
     if (yold->ys_stmt)
         if ((ynew->ys_stmt = calloc(yold->ys_len, sizeof(yang_stmt *))) == NULL){
             clixon_err(OE_YANG, errno, "calloc");
@@ -1391,6 +1406,7 @@ ys_replace(yang_stmt *yorig,
     if (ys_cp(yorig, yfrom) < 0)
         goto done;
     yorig->ys_parent = yp;
+    yang_index_reset(yp);
     retval = 0;
  done:
     return retval;
@@ -1463,6 +1479,245 @@ yn_iter(yang_stmt *yparent,
     return yc;
 }
 
+#ifdef YANG_FIND_INDEX
+/*! FNV-1a hash of yang argument
+ */
+static uint32_t
+yang_index_hash(const char *str)
+{
+    uint32_t h = 2166136261U;
+
+    while (*str){
+        h ^= (unsigned char)*str++;
+        h *= 16777619U;
+    }
+    return h;
+}
+
+/*! Insert yang statement in index table unless key already exists
+ *
+ * @param[in]  vec      Index table
+ * @param[in]  size     Number of slots, power of two
+ * @param[in]  keyword  Use keyword as part of key, if 0 only argument
+ * @param[in]  ys       Yang statement
+ */
+static void
+yang_index_insert(yang_stmt **vec,
+                  uint32_t    size,
+                  int         keyword,
+                  yang_stmt  *ys)
+{
+    uint32_t   i;
+    yang_stmt *y;
+
+    i = (yang_index_hash(ys->ys_argument) + keyword) & (size - 1);
+    while ((y = vec[i]) != NULL){
+        if ((keyword == 0 || y->ys_keyword == ys->ys_keyword) &&
+            strcmp(y->ys_argument, ys->ys_argument) == 0)
+            return; /* First wins */
+        i = (i + 1) & (size - 1);
+    }
+    vec[i] = ys;
+}
+
+/*! Lookup yang statement in index table
+ *
+ * @param[in]  vec      Index table
+ * @param[in]  size     Number of slots, power of two
+ * @param[in]  keyword  Keyword, or 0 if only argument is key
+ * @param[in]  argument Argument
+ * @retval     ys       Yang statement
+ * @retval     NULL     Not found
+ */
+static yang_stmt *
+yang_index_lookup(yang_stmt **vec,
+                  uint32_t    size,
+                  int         keyword,
+                  const char *argument)
+{
+    uint32_t   i;
+    yang_stmt *y;
+
+    i = (yang_index_hash(argument) + keyword) & (size - 1);
+    while ((y = vec[i]) != NULL){
+        if ((keyword == 0 || y->ys_keyword == keyword) &&
+            strcmp(y->ys_argument, argument) == 0)
+            return y;
+        i = (i + 1) & (size - 1);
+    }
+    return NULL;
+}
+
+/*! Get index of yang statement, create if not exists
+ */
+static struct yang_index *
+yang_index_get(yang_stmt *yn)
+{
+    struct yang_index *yi;
+    int                i;
+
+    if ((yi = yn->ys_index) == NULL){
+        if ((yi = calloc(1, sizeof(*yi))) == NULL){
+            clixon_err(OE_YANG, errno, "calloc");
+            return NULL;
+        }
+        for (i=0; i<yn->ys_len; i++)
+            if (yn->ys_stmt[i] && yn->ys_stmt[i]->ys_keyword == Y_INCLUDE)
+                yi->yi_include++;
+        yn->ys_index = yi;
+    }
+    return yi;
+}
+
+/*! Allocate index table with room for nr entries
+ */
+static yang_stmt **
+yang_index_alloc(uint32_t  nr,
+                 uint32_t *size)
+{
+    yang_stmt **vec;
+
+    *size = 4;
+    while (*size < 2*nr)
+        *size <<= 1;
+    if ((vec = calloc(*size, sizeof(yang_stmt *))) == NULL)
+        clixon_err(OE_YANG, errno, "calloc");
+    return vec;
+}
+
+/*! Build index of children by keyword and argument
+ *
+ * @param[in]  yn  Yang node
+ * @retval     yi  Index with yi_stmt set
+ * @retval     NULL Error
+ */
+static struct yang_index *
+yang_index_stmt(yang_stmt *yn)
+{
+    struct yang_index *yi;
+    yang_stmt         *ys;
+    int                i;
+
+    if ((yi = yang_index_get(yn)) == NULL)
+        return NULL;
+    if (yi->yi_stmt != NULL)
+        return yi;
+    if ((yi->yi_stmt = yang_index_alloc(yn->ys_len, &yi->yi_stmt_size)) == NULL)
+        return NULL;
+    for (i=0; i<yn->ys_len; i++){
+        if ((ys = yn->ys_stmt[i]) == NULL)
+            continue;
+        if (ys->ys_argument != NULL)
+            yang_index_insert(yi->yi_stmt, yi->yi_stmt_size, ys->ys_keyword, ys);
+    }
+    return yi;
+}
+
+/*! Count or insert data nodes in the order of yang_find_datanode
+ *
+ * @param[in]  yn   Yang node
+ * @param[in]  yi   Index, if NULL only count
+ * @retval     nr   Number of data nodes
+ */
+static uint32_t
+yang_index_data_add(yang_stmt         *yn,
+                    struct yang_index *yi)
+{
+    yang_stmt *ys;
+    yang_stmt *yc;
+    uint32_t   nr = 0;
+    int        i;
+    int        j;
+
+    for (i=0; i<yn->ys_len; i++){
+        if ((ys = yn->ys_stmt[i]) == NULL)
+            continue;
+        if (ys->ys_keyword == Y_CHOICE){
+            for (j=0; j<ys->ys_len; j++){
+                if ((yc = ys->ys_stmt[j]) == NULL)
+                    continue;
+                if (yc->ys_keyword == Y_CASE)
+                    nr += yang_index_data_add(yc, yi);
+                else if (yang_datanode(yc) && yc->ys_argument){
+                    if (yi)
+                        yang_index_insert(yi->yi_data, yi->yi_data_size, 0, yc);
+                    nr++;
+                }
+            }
+        }
+        else if (ys->ys_keyword == Y_INPUT || ys->ys_keyword == Y_OUTPUT)
+            nr += yang_index_data_add(ys, yi);
+        else if (yang_datanode(ys) && ys->ys_argument){
+            if (yi)
+                yang_index_insert(yi->yi_data, yi->yi_data_size, 0, ys);
+            nr++;
+        }
+    }
+    return nr;
+}
+
+/*! Build index of data nodes by argument
+ *
+ * @param[in]  yn  Yang node
+ * @retval     yi  Index with yi_data set
+ * @retval     NULL Error
+ */
+static struct yang_index *
+yang_index_data(yang_stmt *yn)
+{
+    struct yang_index *yi;
+
+    if ((yi = yang_index_get(yn)) == NULL)
+        return NULL;
+    if (yi->yi_data != NULL)
+        return yi;
+    if ((yi->yi_data = yang_index_alloc(yang_index_data_add(yn, NULL), &yi->yi_data_size)) == NULL)
+        return NULL;
+    yang_index_data_add(yn, yi);
+    return yi;
+}
+
+/*! Free index of a yang statement
+ */
+static void
+yang_index_free(yang_stmt *ys)
+{
+    struct yang_index *yi;
+
+    if ((yi = ys->ys_index) != NULL){
+        ys->ys_index = NULL;
+        if (yi->yi_stmt)
+            free(yi->yi_stmt);
+        if (yi->yi_data)
+            free(yi->yi_data);
+        free(yi);
+    }
+}
+#endif /* YANG_FIND_INDEX */
+
+/*! Remove child index of yang statement after its children have changed
+ *
+ * Data node index of ancestors is also removed through choice, case, input and output,
+ * Call when children are added, removed or changed keyword or argument
+ * @param[in]  ys   Yang statement whose children have changed
+ * @retval     0    OK
+ * @see YANG_FIND_INDEX
+ */
+int
+yang_index_reset(yang_stmt *ys)
+{
+#ifdef YANG_FIND_INDEX
+    while (ys != NULL){
+        yang_index_free(ys);
+        if (ys->ys_keyword != Y_CHOICE && ys->ys_keyword != Y_CASE &&
+            ys->ys_keyword != Y_INPUT && ys->ys_keyword != Y_OUTPUT)
+            break;
+        ys = ys->ys_parent;
+    }
+#endif
+    return 0;
+}
+
 /*! Find first child yang_stmt with matching keyword and argument
  *
  * Find child given keyword and argument.
@@ -1494,6 +1749,19 @@ yang_find(yang_stmt  *yn,
         uses_orig_ptr(keyword)){
         return yang_find(yorig, keyword, argument);
     }
+#ifdef YANG_FIND_INDEX
+    if (keyword != 0 && argument != NULL && yn->ys_len >= YANG_FIND_INDEX){
+        struct yang_index *yi;
+
+        if ((yi = yang_index_stmt(yn)) == NULL)
+            return NULL;
+        if ((yret = yang_index_lookup(yi->yi_stmt, yi->yi_stmt_size, keyword, argument)) != NULL)
+            return yret;
+        if (keyword == Y_NAMESPACE || yi->yi_include == 0)
+            return NULL;
+        /* Not found, search submodules below */
+    }
+#endif
     for (i=0; i<yn->ys_len; i++){
         ys = yn->ys_stmt[i];
         if (keyword == 0 || ys->ys_keyword == keyword){
@@ -1544,6 +1812,18 @@ yang_find_datanode(yang_stmt *yn,
     int        inext;
     int        inext2;
 
+#ifdef YANG_FIND_INDEX
+    if (argument != NULL && yn->ys_len >= YANG_FIND_INDEX){
+        struct yang_index *yi;
+
+        if ((yi = yang_index_data(yn)) == NULL)
+            return NULL;
+        if ((ysmatch = yang_index_lookup(yi->yi_data, yi->yi_data_size, 0, argument)) != NULL ||
+            yi->yi_include == 0)
+            goto done;
+        goto submodules;
+    }
+#endif
     inext = 0;
     while ((ys = yn_iter(yn, &inext)) != NULL){
         if (yang_keyword_get(ys) == Y_CHOICE){ /* Look for its children */
@@ -1575,6 +1855,9 @@ yang_find_datanode(yang_stmt *yn,
                 goto done; // maybe break?
         }
     }
+#ifdef YANG_FIND_INDEX
+ submodules:
+#endif
     /* Special case: if not match and yang node is module or submodule, extend
      * search to include submodules */
     if (ysmatch == NULL &&
@@ -3260,6 +3543,42 @@ ys_populate_feature(clixon_handle h,
     return retval;
 }
 
+/*! Populate a must, when or path statement with the names of the nodes its XPath depends on
+ *
+ * The names are stored in the cvec of the statement. If no cvec is set, dependencies are unknown.
+ * @param[in] ys   The yang statement (must, when or path) to populate.
+ * @retval    0    OK
+ * @retval   -1    Error
+ * @see xpath_tree_deps
+ */
+static int
+ys_populate_xpath_deps(yang_stmt *ys)
+{
+    int         retval = -1;
+    char       *xpath;
+    xpath_tree *xpt = NULL;
+    cvec       *cvv = NULL;
+
+    xpath = yang_argument_get(ys);
+    if (xpath_cache_get(xpath, &xpt) < 0)
+        goto done;
+    if ((cvv = cvec_new(0)) == NULL){
+        clixon_err(OE_YANG, errno, "cvec_new");
+        goto done;
+    }
+    if (xpath_tree_deps(xpt, cvv) < 0)
+        goto done;
+    yang_cvec_set(ys, cvv);
+    cvv = NULL;
+    retval = 0;
+ done:
+    if (xpt)
+        xpath_cache_release(xpath, xpt);
+    if (cvv)
+        cvec_free(cvv);
+    return retval;
+}
+
 /*! Populate the unique statement with a cvec
  *
  * @param[in] h    Clixon handle
@@ -3476,6 +3795,21 @@ ys_populate(yang_stmt    *ys,
         if (ys_populate_unknown(h, ys) < 0)
             goto done;
         break;
+    case Y_MUST:
+    case Y_WHEN:
+        /* Compile XPath, syntax is already checked in ys_parse_sub */
+        if (xpath_cache_compile(yang_argument_get(ys)) < 0)
+            goto done;
+        if (ys_populate_xpath_deps(ys) < 0)
+            goto done;
+        break;
+    case Y_PATH:
+        /* Compile leafref path, errors are detected when the path is used */
+        if (xpath_cache_compile(yang_argument_get(ys)) < 0)
+            clixon_err_reset();
+        else if (ys_populate_xpath_deps(ys) < 0)
+            goto done;
+        break;
     default:
         break;
     }
@@ -3591,12 +3925,14 @@ yang_features(clixon_handle h,
                         ys_freechildren(ys);
                         ys->ys_len = 0;
                         yang_flag_set(ys, YANG_FLAG_DISABLED);
+                        yang_index_reset(yt);
                         break;
                     }
                     for (j=i+1; j<yt->ys_len; j++)
                         yt->ys_stmt[j-1] = yt->ys_stmt[j];
                     yt->ys_len--;
                     yt->ys_stmt[yt->ys_len] = NULL;
+                    yang_index_reset(yt);
                     ys_free(ys);
                     continue; /* Don't increment i */
                     break;
@@ -60,6 +60,23 @@ struct yang_type_cache{
 };
 typedef struct yang_type_cache yang_type_cache;
 
+#ifdef YANG_FIND_INDEX
+/*! Hash index of the children of a yang statement
+ *
+ * Open addressing with linear probing. Each table is built at first lookup and has a
+ * power of two slots, at least twice the number of entries.
+ * Only the first child with a given key is indexed, as found by a linear search.
+ * @see YANG_FIND_INDEX
+ */
+struct yang_index {
+    uint32_t            yi_stmt_size; /* Number of slots in yi_stmt */
+    uint32_t            yi_data_size; /* Number of slots in yi_data */
+    uint32_t            yi_include;   /* Number of include children (module/submodule) */
+    struct yang_stmt  **yi_stmt;      /* Children by keyword and argument */
+    struct yang_stmt  **yi_data;      /* Data nodes by argument, also in choice/case/input/output */
+};
+#endif
+
 /*! yang statement 
  *
  * This is an internal type, not exposed in the API
@@ -101,6 +118,7 @@ struct yang_stmt {
                                         Y_IDENTITY: store all derived types as <module>:<id> list
                                         Y_LENGTH: length_min, length_max
                                         Y_LIST: vector of keys
+                                        Y_MUST, Y_PATH, Y_WHEN: XPath dependency names
                                         Y_RANGE: range_min, range_max
                                         Y_SPEC: shared mount-point xpaths
                                         Y_TYPE: store all derived types as <module>:<id> list
@@ -108,6 +126,9 @@ struct yang_stmt {
                                         Y_UNKNOWN: app-dep: yang-mount-points
                                      */
     yang_stmt         *ys_orig;      /* Pointer to original (for uses/augment copies) */
+#ifdef YANG_FIND_INDEX
+    struct yang_index *ys_index;     /* Child index, built on lookup if many children */
+#endif
     union {                          /* Depends on ys_keyword */
         rpc_callback_t  *ysu_action_cb; /* Y_ACTION: Action callback list*/
         char            *ysu_filename;  /* Y_MODULE/Y_SUBMODULE: For debug/errors: filename */
@@ -120,4 +141,9 @@ struct yang_stmt {
 #define ys_filename       u.ysu_filename
 #define ys_typecache      u.ysu_typecache
 
+/*
+ * Prototypes
+ */
+int yang_index_reset(yang_stmt *ys);
+
 #endif  /* _CLIXON_YANG_INTERNAL_H_ */
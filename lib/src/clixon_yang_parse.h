@@ -57,10 +57,12 @@ struct clixon_yang_yacc {
     int                   yy_linenum;      /* Number of \n in parsed buffer */
     char                 *yy_parse_string; /* original (copy of) parse string */
     void                 *yy_lexbuf;       /* internal parse buffer from lex */
+    void                 *yy_scanner;      /* reentrant lex scanner state */
     struct ys_stack      *yy_stack;     /* Stack of levels: push/pop on () and [] */
     int                   yy_lex_state;  /* lex start condition (ESCAPE/COMMENT) */
     int                   yy_lex_string_state; /* lex start condition (STRING) */
     yang_stmt            *yy_module;       /* top-level (sub)module - return value of parser */
+    int                   yy_thread;       /* Parsed in worker thread, see yang_parse_prefetch */
 };
 typedef struct clixon_yang_yacc clixon_yang_yacc;
 
@@ -79,11 +81,6 @@ struct yang_userdata{
     char              du_vector;    /* (clicon) Possibly more than one element */
 };
 
-/*
- * Variables
- */
-extern char *clixon_yang_parsetext;
-
 /*
  * Prototypes
  */
@@ -93,9 +90,9 @@ int yang_scan_exit(clixon_yang_yacc *ya);
 int yang_parse_init(clixon_yang_yacc *ya);
 int yang_parse_exit(clixon_yang_yacc *ya);
 
-int clixon_yang_parselex(void *_ya);
-int clixon_yang_parseparse(void *);
-void clixon_yang_parseerror(void *_ya, char*);
+char *clixon_yang_parseget_text(void *scanner);
+int clixon_yang_parseparse(void *_ya, void *scanner);
+void clixon_yang_parseerror(void *_ya, void *scanner, char*);
 
 int ystack_pop(clixon_yang_yacc *ya);
 struct ys_stack *ystack_push(clixon_yang_yacc *ya, yang_stmt *yn);
@@ -158,8 +158,11 @@
 %token D_DELETE
 %token D_REPLACE
 
-%lex-param     {void *_yy} /* Add this argument to parse() and lex() function */
+/* Reentrant parser and scanner, several modules may be parsed concurrently */
+%define api.pure full
+%lex-param     {void *scanner} /* Add this argument to parse() and lex() function */
 %parse-param   {void *_yy}
+%parse-param   {void *scanner}
 
 %{
 /* Here starts user C-code */
@@ -167,7 +170,7 @@
 /* typecast macro */
 #define _YY ((clixon_yang_yacc *)_yy)
 
-#define _YYERROR(msg) {clixon_debug(CLIXON_DBG_YANG, "YYERROR %s '%s' %d", (msg), clixon_yang_parsetext, _YY->yy_linenum); YYERROR;}
+#define _YYERROR(msg) {clixon_debug(CLIXON_DBG_YANG, "YYERROR %s '%s' %d", (msg), clixon_yang_parseget_text(scanner), _YY->yy_linenum); YYERROR;}
 
 /* add _yy to error parameters */
 #define YY_(msgid) msgid
@@ -211,7 +214,7 @@
 #define _PARSE_DEBUG1(s, s1)
 #endif
 
-extern int clixon_yang_parseget_lineno  (void);
+int clixon_yang_parselex(YYSTYPE *yylval, void *scanner);
 
 /*
    clixon_yang_parseerror
@@ -219,13 +222,14 @@ extern int clixon_yang_parseget_lineno  (void);
 */
 void
 clixon_yang_parseerror(void *_yy,
+                       void *scanner,
                        char *s)
 {
     clixon_err(OE_YANG, 0, "%s on line %d: %s at or before: '%s'",
                _YY->yy_name,
                _YY->yy_linenum,
                s,
-               clixon_yang_parsetext);
+               clixon_yang_parseget_text(scanner));
   return;
 }
 
@@ -320,7 +324,12 @@ ysp_add(clixon_yang_yacc *yy,
     if (yn_insert(yn, ys) < 0) /* Insert into hierarchy */
         goto err;
     yang_linenum_set(ys, yy->yy_linenum); /* For error/debugging */
-    if (ys_parse_sub(ys, yy->yy_name, extra) < 0)     /* Check statement-specific syntax */
+    /* Sub-parsers are not reentrant, checks are made after the thread is done */
+    if (yy->yy_thread && ys_parse_sub_deferred(ys)){
+        if (extra)
+            free(extra);
+    }
+    else if (ys_parse_sub(ys, yy->yy_name, extra) < 0)     /* Check statement-specific syntax */
         goto err2; /* dont free since part of tree */
     return ys;
   err:
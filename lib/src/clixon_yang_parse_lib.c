@@ -70,6 +70,9 @@
 #include <sys/param.h>
 #include <netinet/in.h>
 #include <libgen.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -695,6 +698,7 @@ yang_expand_uses_node(clixon_handle h,
         /* Move existing elements if any */
         if (size)
             memmove(&yn->ys_stmt[i+glen+1], &yn->ys_stmt[i+1], size);
+        yang_index_reset(yn);
     }
     /* Note: yang_desc_schema_nodeid() requires ygrouping2 to be in yspec tree,
      * due to correct module prefixes etc.
@@ -766,6 +770,7 @@ yang_expand_uses_node(clixon_handle h,
         yang_flag_set(yg, YANG_FLAG_GROUPING);
         k++;
     }
+    yang_index_reset(yn);
     /* Remove the grouping copy */
     ygrouping2->ys_len = 0; /* Cant do with get access function */
     ys_free(ygrouping2);
@@ -843,22 +848,21 @@ yang_expand_grouping(clixon_handle h,
     return retval;
 }
 
-/*! Parse a string containing a YANG spec into a parse-tree
- * 
- * Syntax parsing. A string is input and a YANG syntax-tree is returned (or error). 
- * As a side-effect, Yang modules present in the text will be inserted under the global Yang 
- * specification
+/*! Parse a string containing a YANG spec into a parse-tree, also in worker threads
+ *
  * @param[in] str    String of yang statements
  * @param[in] name   Log string, typically filename
- * @param[in] yspec  Yang specification. 
+ * @param[in] yspec  Yang specification.
+ * @param[in] thread Parsed in worker thread: no logging and deferred sub-parser checks
  * @retval    ymod   Top-level yang (sub)module
  * @retval    NULL   Error encountered
- * See top of file for diagram of calling order
+ * @see yang_parse_str
  */
-yang_stmt *
-yang_parse_str(char         *str,
-               const char   *name, /* just for errs */
-               yang_stmt    *yspec)
+static yang_stmt *
+yang_parse_str1(char         *str,
+                const char   *name,
+                yang_stmt    *yspec,
+                int           thread)
 {
     clixon_yang_yacc yy = {0,};
     yang_stmt       *ymod = NULL;
@@ -873,15 +877,19 @@ yang_parse_str(char         *str,
     yy.yy_parse_string = str;
     yy.yy_stack        = NULL;
     yy.yy_module       = NULL; /* this is the return value - the module/sub-module */
+    yy.yy_thread       = thread;
     if (ystack_push(&yy, yspec) == NULL)
         goto done;
     if (strlen(str)){ /* Not empty */
-        if (yang_scan_init(&yy) < 0)
+        if (yang_scan_init(&yy) < 0){
+            clixon_err(OE_YANG, errno, "yang_scan_init");
             goto done;
+        }
         if (yang_parse_init(&yy) < 0)
             goto done;
-        if (clixon_yang_parseparse(&yy) != 0) { /* yacc returns 1 on error */
-            clixon_log(NULL, LOG_NOTICE, "Yang error: %s on line %d", name, yy.yy_linenum);
+        if (clixon_yang_parseparse(&yy, yy.yy_scanner) != 0) { /* yacc returns 1 on error */
+            if (!thread)
+                clixon_log(NULL, LOG_NOTICE, "Yang error: %s on line %d", name, yy.yy_linenum);
             if (clixon_err_category() == 0)
                 clixon_err(OE_YANG, 0, "yang parser error with no error code (should not happen)");
             yang_parse_exit(&yy);
@@ -908,6 +916,74 @@ yang_parse_str(char         *str,
     return ymod;  /* top-level (sub)module */
 }
 
+/*! Parse a string containing a YANG spec into a parse-tree
+ *
+ * Syntax parsing. A string is input and a YANG syntax-tree is returned (or error).
+ * As a side-effect, Yang modules present in the text will be inserted under the global Yang
+ * specification
+ * @param[in] str    String of yang statements
+ * @param[in] name   Log string, typically filename
+ * @param[in] yspec  Yang specification.
+ * @retval    ymod   Top-level yang (sub)module
+ * @retval    NULL   Error encountered
+ * See top of file for diagram of calling order
+ */
+yang_stmt *
+yang_parse_str(char         *str,
+               const char   *name, /* just for errs */
+               yang_stmt    *yspec)
+{
+    return yang_parse_str1(str, name, yspec, 0);
+}
+
+/*! Read an open file into a string
+ *
+ * @param[in]  fp    Open file
+ * @param[out] bufp  Malloced string with the file contents, free with free()
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+yang_file_read(FILE  *fp,
+               char **bufp)
+{
+    int     retval = -1;
+    char   *buf = NULL;
+    char   *buf1;
+    size_t  len;
+    size_t  i = 0; /* position in buf */
+    size_t  ret;
+
+    len = BUFLEN; /* any number is fine */
+    if ((buf = malloc(len)) == NULL){
+        clixon_err(OE_XML, errno, "malloc");
+        goto done;
+    }
+    while ((ret = fread(buf+i, 1, len-i-1, fp)) > 0){ /* read the whole file */
+        i += ret;
+        if (i == len-1){
+            if ((buf1 = realloc(buf, 2*len)) == NULL){
+                clixon_err(OE_XML, errno, "realloc");
+                goto done;
+            }
+            buf = buf1;
+            len *= 2;
+        }
+    }
+    if (ferror(fp)){
+        clixon_err(OE_XML, errno, "read");
+        goto done;
+    }
+    buf[i] = '\0';
+    *bufp = buf;
+    buf = NULL;
+    retval = 0;
+ done:
+    if (buf)
+        free(buf);
+    return retval;
+}
+
 /*! Parse yang spec from an open file descriptor
  *
  * @param[in] fd     File descriptor containing the YANG file as ASCII characters
@@ -923,36 +999,10 @@ yang_parse_file(FILE       *fp,
                 yang_stmt  *yspec)
 {
     char         *buf = NULL;
-    int           i;
-    char          c;
-    int           len;
     yang_stmt    *ymod = NULL;
-    int           ret;
 
-    len = BUFLEN; /* any number is fine */
-    if ((buf = malloc(len)) == NULL){
-        clixon_err(OE_XML, errno, "malloc");
+    if (yang_file_read(fp, &buf) < 0)
         goto done;
-    }
-    memset(buf, 0, len);
-    i = 0; /* position in buf */
-    while (1){ /* read the whole file */
-        if ((ret = fread(&c, 1, 1, fp)) < 0){
-            clixon_err(OE_XML, errno, "read");
-            break;
-        }
-        if (ret == 0)
-            break; /* eof */
-        if (i == len-1){
-            if ((buf = realloc(buf, 2*len)) == NULL){
-                clixon_err(OE_XML, errno, "realloc");
-                goto done;
-            }
-            memset(buf+len, 0, len);
-            len *= 2;
-        }
-        buf[i++] = (char)(c&0xff);
-    } /* read a line */
     if ((ymod = yang_parse_str(buf, name, yspec)) < 0)
         goto done;
   done:
@@ -1135,6 +1185,382 @@ done:
     goto done;
 }
 
+#ifdef HAVE_LIBPTHREAD
+/*! State of a YANG file parsed in advance, see yang_parse_prefetch
+ */
+enum yang_prefetch_state{
+    YP_QUEUED,  /* Waiting for a worker thread */
+    YP_PARSING, /* Parsed by a worker thread */
+    YP_PARSED,  /* Parsed, imports and includes not yet queued */
+    YP_SCANNED, /* Done */
+};
+
+/*! YANG file parsed in advance by a worker thread, see yang_parse_prefetch
+ */
+struct yang_prefetch{
+    qelem_t                  yp_qelem;    /* List header */
+    char                    *yp_filename; /* YANG file */
+    enum yang_prefetch_state yp_state;
+    yang_stmt               *yp_yspec;    /* Private yang spec of parsed (sub)module */
+    yang_stmt               *yp_ymod;     /* Parsed (sub)module, or NULL on error or if taken */
+};
+
+/*! Shared by main and worker threads of yang_parse_prefetch
+ */
+struct yang_prefetch_ctx{
+    pthread_mutex_t yc_mutex;  /* Protects list and states */
+    pthread_cond_t  yc_work;   /* To workers: file queued or stop */
+    pthread_cond_t  yc_parsed; /* To main: file parsed */
+    int             yc_stop;   /* Workers should exit */
+};
+
+/* Files parsed in advance, taken by yang_parse_filename */
+static struct yang_prefetch *_yang_prefetch_list = NULL;
+
+/*! Find a file parsed in advance given filename, or first file in a given state
+ *
+ * @param[in]  filename  Name of file, or NULL
+ * @param[in]  state     State, if filename is NULL
+ * @retval     yp        Found
+ * @retval     NULL      Not found
+ */
+static struct yang_prefetch *
+yang_prefetch_find(const char              *filename,
+                   enum yang_prefetch_state state)
+{
+    struct yang_prefetch *yp;
+
+    if ((yp = _yang_prefetch_list) != NULL){
+        do {
+            if (filename ? strcmp(filename, yp->yp_filename) == 0 : yp->yp_state == state)
+                return yp;
+            yp = NEXTQ(struct yang_prefetch *, yp);
+        } while (yp && yp != _yang_prefetch_list);
+    }
+    return NULL;
+}
+
+/*! Queue a file to be parsed by a worker thread, if not already queued
+ *
+ * @param[in]  filename  Name of file
+ * @retval     1         Queued
+ * @retval     0         Already queued
+ * @retval    -1         Error
+ */
+static int
+yang_prefetch_add(const char *filename)
+{
+    struct yang_prefetch *yp;
+
+    if (yang_prefetch_find(filename, 0) != NULL)
+        return 0;
+    if ((yp = malloc(sizeof(*yp))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return -1;
+    }
+    memset(yp, 0, sizeof(*yp));
+    yp->yp_state = YP_QUEUED;
+    if ((yp->yp_filename = strdup(filename)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        free(yp);
+        return -1;
+    }
+    if ((yp->yp_yspec = ys_new(Y_SPEC)) == NULL){
+        free(yp->yp_filename);
+        free(yp);
+        return -1;
+    }
+    ADDQ(yp, _yang_prefetch_list);
+    return 1;
+}
+
+/*! Free all files parsed in advance that are not taken
+ */
+static void
+yang_prefetch_free(void)
+{
+    struct yang_prefetch *yp;
+
+    while ((yp = _yang_prefetch_list) != NULL){
+        DELQ(yp, _yang_prefetch_list, struct yang_prefetch *);
+        if (yp->yp_filename)
+            free(yp->yp_filename);
+        if (yp->yp_yspec)
+            ys_free(yp->yp_yspec);
+        free(yp);
+    }
+}
+
+/*! Worker thread: parse queued files until stopped
+ *
+ * Errors are discarded. A file that fails is parsed again by the main thread, which
+ * reports the error.
+ * @param[in]  arg   Shared context
+ */
+static void *
+yang_prefetch_worker(void *arg)
+{
+    struct yang_prefetch_ctx *yc = (struct yang_prefetch_ctx *)arg;
+    struct yang_prefetch     *yp;
+    FILE                     *fp;
+    char                     *buf;
+
+    clixon_err_discard_set(1);
+    pthread_mutex_lock(&yc->yc_mutex);
+    while (!yc->yc_stop){
+        if ((yp = yang_prefetch_find(NULL, YP_QUEUED)) == NULL){
+            pthread_cond_wait(&yc->yc_work, &yc->yc_mutex);
+            continue;
+        }
+        yp->yp_state = YP_PARSING;
+        pthread_mutex_unlock(&yc->yc_mutex);
+        buf = NULL;
+        if ((fp = fopen(yp->yp_filename, "r")) != NULL){
+            if (yang_file_read(fp, &buf) == 0)
+                yp->yp_ymod = yang_parse_str1(buf, yp->yp_filename, yp->yp_yspec, 1);
+            fclose(fp);
+        }
+        if (buf)
+            free(buf);
+        pthread_mutex_lock(&yc->yc_mutex);
+        yp->yp_state = YP_PARSED;
+        pthread_cond_signal(&yc->yc_parsed);
+    }
+    pthread_mutex_unlock(&yc->yc_mutex);
+    return NULL;
+}
+
+/*! Find files imported and included by a parsed (sub)module
+ *
+ * Same lookup as yang_parse_recurse. Files that are not found are reported when parsed
+ * by the main thread.
+ * Called without the prefetch lock, the filesystem lookups do not block the workers.
+ * @param[in]  h      Clixon handle
+ * @param[in]  ymod   Parsed (sub)module
+ * @param[in]  yspec  Yang spec, modules already loaded are skipped
+ * @param[in]  files  Found filenames are added here as string cv:s
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+yang_prefetch_scan(clixon_handle h,
+                   yang_stmt    *ymod,
+                   yang_stmt    *yspec,
+                   cvec         *files)
+{
+    int           retval = -1;
+    cbuf         *fbuf = NULL;
+    yang_stmt    *yi;
+    yang_stmt    *yrev;
+    char         *subrevision;
+    enum rfc_6020 keyw;
+    int           inext;
+    int           ret;
+
+    if ((fbuf = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    inext = 0;
+    while ((yi = yn_iter(ymod, &inext)) != NULL){
+        keyw = yang_keyword_get(yi);
+        if (keyw != Y_IMPORT && keyw != Y_INCLUDE)
+            continue;
+        if (yang_find(yspec,
+                      keyw==Y_IMPORT?Y_MODULE:Y_SUBMODULE,
+                      yang_argument_get(yi)) != NULL)
+            continue;
+        if ((yrev = yang_find(yi, Y_REVISION_DATE, NULL)) != NULL)
+            subrevision = yang_argument_get(yrev);
+        else
+            subrevision = NULL;
+        cbuf_reset(fbuf);
+        if ((ret = yang_file_find_match(h, yang_argument_get(yi), subrevision, NULL, fbuf)) < 0)
+            goto done;
+        if (ret == 0)
+            continue;
+        if (cvec_add_string(files, NULL, cbuf_get(fbuf)) < 0){
+            clixon_err(OE_UNIX, errno, "cvec_add_string");
+            goto done;
+        }
+    }
+    retval = 0;
+ done:
+    if (fbuf)
+        cbuf_free(fbuf);
+    return retval;
+}
+
+/*! Check if YANG files should be parsed in advance by worker threads
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     1   Yes, see CLICON_YANG_PARSE_THREADS
+ * @retval     0   No
+ * @note Not if debug is enabled, since worker threads do not log
+ */
+static int
+yang_prefetch_p(clixon_handle h)
+{
+    return h != NULL &&
+        clixon_debug_get() == 0 &&
+        clicon_option_int(h, "CLICON_YANG_PARSE_THREADS") > 0;
+}
+
+/*! Parse YANG files and the files they import and include in worker threads
+ *
+ * Lexing and parsing of YANG files are independent of each other and are made in
+ * parallel by CLICON_YANG_PARSE_THREADS worker threads, each file into a private yang spec.
+ * The calling thread queues the files imported and included by each parsed file.
+ * The parsed (sub)modules are then taken in the usual order by yang_parse_filename, where
+ * syntax checks using (non-reentrant) sub-parsers are made, followed by the serial
+ * resolution in yang_parse_post.
+ * @param[in]  h      Clixon handle
+ * @param[in]  files  Filenames as string cv:s
+ * @param[in]  yspec  Yang spec, modules already loaded are not parsed
+ * @retval     0      OK, free with yang_prefetch_free
+ * @retval    -1      Error
+ * @see yang_parse_recurse  Serial variant
+ */
+static int
+yang_parse_prefetch(clixon_handle h,
+                    cvec         *files,
+                    yang_stmt    *yspec)
+{
+    int                      retval = -1;
+    struct yang_prefetch_ctx yc = {0,};
+    struct yang_prefetch    *yp;
+    pthread_t               *tids = NULL;
+    int                      nthreads;
+    int                      nr = 0;
+    int                      pending = 0;
+    cg_var                  *cv = NULL;
+    cvec                    *found = NULL;
+    int                      ret;
+    int                      i;
+
+    nthreads = clicon_option_int(h, "CLICON_YANG_PARSE_THREADS");
+    while ((cv = cvec_each(files, cv)) != NULL){
+        if ((ret = yang_prefetch_add(cv_string_get(cv))) < 0)
+            goto done;
+        pending += ret;
+    }
+    if (pending == 0)
+        goto ok;
+    if ((tids = calloc(nthreads, sizeof(pthread_t))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    pthread_mutex_init(&yc.yc_mutex, NULL);
+    pthread_cond_init(&yc.yc_work, NULL);
+    pthread_cond_init(&yc.yc_parsed, NULL);
+    for (nr=0; nr<nthreads; nr++)
+        if ((errno = pthread_create(&tids[nr], NULL, yang_prefetch_worker, &yc)) != 0){
+            clixon_err(OE_UNIX, errno, "pthread_create");
+            goto done;
+        }
+    pthread_mutex_lock(&yc.yc_mutex);
+    while (pending){
+        if ((yp = yang_prefetch_find(NULL, YP_PARSED)) == NULL){
+            pthread_cond_wait(&yc.yc_parsed, &yc.yc_mutex);
+            continue;
+        }
+        yp->yp_state = YP_SCANNED;
+        pending--;
+        if (yp->yp_ymod == NULL)
+            continue;
+        /* Workers do not touch a scanned file, look up its imports without the lock */
+        pthread_mutex_unlock(&yc.yc_mutex);
+        if ((found = cvec_new(0)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_new");
+            goto done;
+        }
+        if (yang_prefetch_scan(h, yp->yp_ymod, yspec, found) < 0)
+            goto done;
+        pthread_mutex_lock(&yc.yc_mutex);
+        cv = NULL;
+        while ((cv = cvec_each(found, cv)) != NULL){
+            if ((ret = yang_prefetch_add(cv_string_get(cv))) < 0){
+                pthread_mutex_unlock(&yc.yc_mutex);
+                goto done;
+            }
+            if (ret){
+                pending++;
+                pthread_cond_broadcast(&yc.yc_work);
+            }
+        }
+        cvec_free(found);
+        found = NULL;
+    }
+    pthread_mutex_unlock(&yc.yc_mutex);
+ ok:
+    retval = 0;
+ done:
+    if (tids){
+        pthread_mutex_lock(&yc.yc_mutex);
+        yc.yc_stop = 1;
+        pthread_cond_broadcast(&yc.yc_work);
+        pthread_mutex_unlock(&yc.yc_mutex);
+        for (i=0; i<nr; i++)
+            pthread_join(tids[i], NULL);
+        pthread_cond_destroy(&yc.yc_parsed);
+        pthread_cond_destroy(&yc.yc_work);
+        pthread_mutex_destroy(&yc.yc_mutex);
+        free(tids);
+    }
+    if (found)
+        cvec_free(found);
+    return retval;
+}
+
+/*! Make syntax checks of a statement deferred when parsed in a worker thread
+ */
+static int
+ys_parse_sub_deferred_fn(yang_stmt *ys,
+                         void      *arg)
+{
+    if (ys_parse_sub_deferred(ys) &&
+        ys_parse_sub(ys, (const char *)arg, NULL) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Take a (sub)module parsed in advance by a worker thread and add it to yspec
+ *
+ * Also make the syntax checks deferred when parsed
+ * @param[in]  filename  Name of file
+ * @param[in]  yspec     Yang specification
+ * @param[out] ymodp     Top-level yang (sub)module
+ * @retval     1         Taken, ymodp set
+ * @retval     0         Not parsed in advance
+ * @retval    -1         Error
+ */
+static int
+yang_prefetch_take(const char *filename,
+                   yang_stmt  *yspec,
+                   yang_stmt **ymodp)
+{
+    struct yang_prefetch *yp;
+    yang_stmt            *ymod;
+
+    if ((yp = yang_prefetch_find(filename, 0)) == NULL ||
+        (ymod = yp->yp_ymod) == NULL)
+        return 0;
+    yp->yp_ymod = NULL;
+    if (ys_prune(yp->yp_yspec, 0) != ymod){
+        clixon_err(OE_YANG, EFAULT, "Parsed module %s not found", filename);
+        return -1;
+    }
+    if (yn_insert(yspec, ymod) < 0){
+        ys_free(ymod);
+        return -1;
+    }
+    if (yang_apply(ymod, -1, ys_parse_sub_deferred_fn, 0, (void *)filename) < 0)
+        return -1;
+    *ymodp = ymod;
+    return 1;
+}
+#endif /* HAVE_LIBPTHREAD */
+
 /*! Open a file, read into a string and invoke yang parsing
  *
  * Similar to clicon_yang_str(), just read a file first
@@ -1161,12 +1587,19 @@ yang_parse_filename(clixon_handle h,
         clixon_err(OE_YANG, errno, "%s not found", filename);
         goto done;
     }
-    if ((fp = fopen(filename, "r")) == NULL){
-        clixon_err(OE_YANG, errno, "fopen(%s)", filename);
+#ifdef HAVE_LIBPTHREAD
+    /* Parsed in advance by a worker thread */
+    if (yang_prefetch_take(filename, yspec, &ymod) < 0)
         goto done;
+#endif
+    if (ymod == NULL){
+        if ((fp = fopen(filename, "r")) == NULL){
+            clixon_err(OE_YANG, errno, "fopen(%s)", filename);
+            goto done;
+        }
+        if ((ymod = yang_parse_file(fp, filename, yspec)) < 0)
+            goto done;
     }
-    if ((ymod = yang_parse_file(fp, filename, yspec)) < 0)
-        goto done;
     /* YANG patch hook */
     if (ymod && h && clixon_plugin_yang_patch_all(h, ymod) < 0)
         goto done;
@@ -1659,6 +2092,11 @@ yang_spec_parse_module(clixon_handle h,
     int         retval = -1;
     int         modmin;       /* Existing number of modules */
     char       *base = NULL;;
+#ifdef HAVE_LIBPTHREAD
+    cbuf       *fbuf = NULL;
+    cvec       *files = NULL;
+    int         ret;
+#endif
 
     if (yspec == NULL){
         clixon_err(OE_YANG, EINVAL, "yang spec is NULL");
@@ -1673,6 +2111,29 @@ yang_spec_parse_module(clixon_handle h,
     /* Do not load module if it already exists */
     if (yang_find_module_by_name_revision(yspec, name, revision) != NULL)
         goto ok;
+#ifdef HAVE_LIBPTHREAD
+    /* Parse module and its imports in advance in worker threads */
+    if (yang_prefetch_p(h)){
+        if ((fbuf = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        if ((ret = yang_file_find_match(h, name, revision, NULL, fbuf)) < 0)
+            goto done;
+        if (ret == 1){
+            if ((files = cvec_new(0)) == NULL){
+                clixon_err(OE_UNIX, errno, "cvec_new");
+                goto done;
+            }
+            if (cvec_add_string(files, NULL, cbuf_get(fbuf)) < 0){
+                clixon_err(OE_UNIX, errno, "cvec_add_string");
+                goto done;
+            }
+            if (yang_parse_prefetch(h, files, yspec) < 0)
+                goto done;
+        }
+    }
+#endif
     /* Find a yang module and parse it and all its submodules */
     if (yang_parse_module(h, name, revision, yspec, NULL, NULL) == NULL)
         goto done;
@@ -1681,6 +2142,13 @@ yang_spec_parse_module(clixon_handle h,
  ok:
     retval = 0;
  done:
+#ifdef HAVE_LIBPTHREAD
+    yang_prefetch_free();
+    if (files)
+        cvec_free(files);
+    if (fbuf)
+        cbuf_free(fbuf);
+#endif
     if (base)
         free(base);
     return retval;
@@ -1705,6 +2173,9 @@ yang_spec_parse_file(clixon_handle h,
     int         retval = -1;
     int         modmin;       /* Existing number of modules */
     char       *base = NULL;;
+#ifdef HAVE_LIBPTHREAD
+    cvec       *files = NULL;
+#endif
 
     /* Apply steps 2.. on new modules, ie ones after modmin. */
     modmin = yang_len_get(yspec);
@@ -1721,6 +2192,21 @@ yang_spec_parse_file(clixon_handle h,
         *index(base, '@') = '\0';
     if (yang_find(yspec, Y_MODULE, base) != NULL)
         goto ok;
+#ifdef HAVE_LIBPTHREAD
+    /* Parse file and its imports in advance in worker threads */
+    if (yang_prefetch_p(h)){
+        if ((files = cvec_new(0)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_new");
+            goto done;
+        }
+        if (cvec_add_string(files, NULL, filename) < 0){
+            clixon_err(OE_UNIX, errno, "cvec_add_string");
+            goto done;
+        }
+        if (yang_parse_prefetch(h, files, yspec) < 0)
+            goto done;
+    }
+#endif
     if (yang_parse_filename(h, filename, yspec) == NULL)
         goto done;
     if (yang_parse_post(h, yspec, modmin) < 0)
@@ -1728,11 +2214,80 @@ yang_spec_parse_file(clixon_handle h,
  ok:
     retval = 0;
  done:
+#ifdef HAVE_LIBPTHREAD
+    yang_prefetch_free();
+    if (files)
+        cvec_free(files);
+#endif
     if (base)
         free(base);
     return retval;
 }
 
+/*! Check if a file in a sorted yang directory listing is the one to load for its module
+ *
+ * Prefer x.yang over x@rev.yang, otherwise the newest x@rev.yang. Files of the same module
+ * are adjacent and x.yang is first.
+ * @param[in]  dp    Directory entries sorted alphabetically
+ * @param[in]  ndp   Number of entries
+ * @param[in]  i     Index of entry to check
+ * @param[out] basep Module name of entry (malloced)
+ * @param[out] revp  Revision in filename as YYYYMMDD (0 if not found)
+ * @retval     1     Load this file
+ * @retval     0     Skip, another file of the same module is loaded
+ * @retval    -1     Error
+ * @see yang_spec_load_dir
+ */
+static int
+yang_dir_select(struct dirent *dp,
+                int            ndp,
+                int            i,
+                char         **basep,
+                uint32_t      *revp)
+{
+    int   retval = -1;
+    char *other = NULL;
+    int   j;
+
+    *revp = 0;
+    if (filename2revision(dp[i].d_name, basep, revp) < 0)
+        goto done;
+    if (*revp == 0){ /* No revision: a.yang - take that */
+        retval = 1;
+        goto done;
+    }
+    /* Skip if there is a later revision */
+    if (i+1 < ndp){
+        if (filename2revision(dp[i+1].d_name, &other, NULL) < 0)
+            goto done;
+        if (strcmp(*basep, other) == 0)
+            goto skip;
+        free(other);
+        other = NULL;
+    }
+    /* Skip if there is a file without revision, first of same module */
+    for (j = i-1; j >= 0; j--){
+        uint32_t rev = 0;
+
+        if (filename2revision(dp[j].d_name, &other, &rev) < 0)
+            goto done;
+        if (strcmp(*basep, other) != 0)
+            break;
+        if (rev == 0)
+            goto skip;
+        free(other);
+        other = NULL;
+    }
+    retval = 1;
+ done:
+    if (other)
+        free(other);
+    return retval;
+ skip:
+    retval = 0;
+    goto done;
+}
+
 /*! Load all yang modules in directory
  *
  * @param[in]  h     Clicon handle
@@ -1759,6 +2314,7 @@ yang_spec_load_dir(clixon_handle h,
     struct dirent *dp = NULL;
     int            i;
     int            j;
+    int            ret;
     char           filename[MAXPATHLEN];
     char          *base = NULL; /* filename without dir */
     int            modmin;
@@ -1768,8 +2324,9 @@ yang_spec_load_dir(clixon_handle h,
     uint32_t       revf = 0; /* revision in filename */
     uint32_t       revm = 0; /* revision in parsed new module (should be same as revf) */
     uint32_t       rev0; /* revision in existing module */
-    char          *oldbase = NULL;
-    int            taken = 0;
+#ifdef HAVE_LIBPTHREAD
+    cvec          *files = NULL;
+#endif
 
     /* Get yang files names from yang module directory. Note that these
      * are sorted alphatetically:
@@ -1783,38 +2340,43 @@ yang_spec_load_dir(clixon_handle h,
         goto ok;
     /* Apply post steps on new modules, ie ones after modmin. */
     modmin = yang_len_get(yspec);
-    /* Load all yang files in dir */
-    for (i = 0; i < ndp; i++) {
-        /* base = module name [+ @rev ] + .yang */
-       if (oldbase)
-           free(oldbase);
-        oldbase = base;
-        base = NULL;
-        revf = 0;
-        if (filename2revision(dp[i].d_name, &base, &revf) < 0)
-            goto done;
-        if (oldbase && strcmp(base, oldbase)) /* new yang file basename */
-            taken = 0;
-        if (revf == 0) /* No revision: a.yang - take that */
-            taken = 1;
-        else{ /* a@xxx.yang */
-            if (taken)
-                continue; /* skip if already taken */
-            /* Look forward: is there anyone else later? (assume sorted revision dates) */
-            if (i+1 < ndp){ /* not last in list */
-                char *nextbase = NULL; /* XXX suboptimal algorithm, could combione old/next/base */
-                if (filename2revision(dp[i+1].d_name, &nextbase, NULL) < 0)
+#ifdef HAVE_LIBPTHREAD
+    /* Parse files to be loaded below and their imports in advance in worker threads */
+    if (yang_prefetch_p(h)){
+        if ((files = cvec_new(0)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_new");
+            goto done;
+        }
+        for (i = 0; i < ndp; i++) {
+            if ((ret = yang_dir_select(dp, ndp, i, &base, &revf)) < 0)
+                goto done;
+            if (ret == 1 &&
+                yang_find(yspec, Y_MODULE, base) == NULL &&
+                yang_find(yspec, Y_SUBMODULE, base) == NULL){
+                snprintf(filename, MAXPATHLEN-1, "%s/%s", dir, dp[i].d_name);
+                if (cvec_add_string(files, NULL, filename) < 0){
+                    clixon_err(OE_UNIX, errno, "cvec_add_string");
                     goto done;
-                if (nextbase && strcmp(base, nextbase) == 0){
-                    free(nextbase);
-                    nextbase = NULL;
-                    continue; /* same base: skip; */
                 }
-                if (nextbase)
-                    free(nextbase);
             }
-            taken = 1; /* last in line and not taken */
+            free(base);
+            base = NULL;
         }
+        if (yang_parse_prefetch(h, files, yspec) < 0)
+            goto done;
+    }
+#endif
+    /* Load all yang files in dir */
+    for (i = 0; i < ndp; i++) {
+        /* base = module name [+ @rev ] + .yang */
+        if (base){
+            free(base);
+            base = NULL;
+        }
+        if ((ret = yang_dir_select(dp, ndp, i, &base, &revf)) < 0)
+            goto done;
+        if (ret == 0)
+            continue;
         /* Here only a single file is reached(taken)
          * Check if module already exists -> ym0/rev0 */
         rev0 = 0;
@@ -1854,12 +2416,15 @@ yang_spec_load_dir(clixon_handle h,
  ok:
     retval = 0;
   done:
+#ifdef HAVE_LIBPTHREAD
+    yang_prefetch_free();
+    if (files)
+        cvec_free(files);
+#endif
     if (dp)
         free(dp);
     if (base)
         free(base);
-    if (oldbase)
-        free(oldbase);
     return retval;
 }
 
@@ -1942,6 +2507,31 @@ ys_parse(yang_stmt   *ys,
     return yang_cv_get(ys);
 }
 
+/*! Check if syntax checks of a statement use (non-reentrant) sub-parsers
+ *
+ * These checks are deferred when a file is parsed in a worker thread
+ * @param[in] ys   yang statement
+ * @retval    1    Yes, see ys_parse_sub
+ * @retval    0    No
+ */
+int
+ys_parse_sub_deferred(yang_stmt *ys)
+{
+    switch (yang_keyword_get(ys)){
+    case Y_BASE:
+    case Y_TYPE:
+    case Y_USES:
+    case Y_MUST:
+    case Y_WHEN:
+    case Y_IF_FEATURE:
+    case Y_AUGMENT:
+    case Y_REFINE:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
 /*! First round yang syntactic statement specific checks. No context checks.
  *
  * Specific syntax checks  and variable creation for stand-alone yang statements.
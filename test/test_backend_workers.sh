@@ -0,0 +1,128 @@
+#!/usr/bin/env bash
+# Backend read workers, see CLICON_BACKEND_READ_WORKERS
+# get and get-config are served by forked worker processes
+# Run several get-config sessions concurrently and check the replies
+# Check that replies of one session are in order when edits are interleaved with reads
+# The output queue max is small so that reading replies from workers is paused
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries
+: ${perfnr:=5000}
+
+# Number of concurrent sessions
+: ${nrsessions:=4}
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/scaling.yang
+fconfig=$dir/large.xml
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+      leaf b {
+        type int32;
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_BACKEND_READ_WORKERS>2</CLICON_BACKEND_READ_WORKERS>
+  <CLICON_BACKEND_OUTQ_MAX>4096</CLICON_BACKEND_OUTQ_MAX>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "generate config with $perfnr list entries"
+data="<x xmlns=\"urn:example:clixon\">"
+for (( i=0; i<$perfnr; i++ )); do
+    data+="<y><a>$i</a><b>$i</b></y>"
+done
+data+="</x>"
+rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$data</config></edit-config></rpc>"
+echo -n "$DEFAULTHELLO" > $fconfig
+echo "$(chunked_framing "$rpc")" >> $fconfig
+
+new "netconf write large config"
+expecteof_file "$clixon_netconf -qef $cfg" 0 "$fconfig" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>$"
+
+new "netconf commit large config"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf get-config in $nrsessions concurrent sessions"
+rpc=$(chunked_framing "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>")
+for (( i=0; i<$nrsessions; i++ )); do
+    echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qef $cfg > $dir/output$i.xml &
+done
+wait
+for (( i=0; i<$nrsessions; i++ )); do
+    match=$(grep --null -Fo "<data>$data</data>" $dir/output$i.xml)
+    if [ -z "$match" ]; then
+        err "<data>$data</data>" "$(cat $dir/output$i.xml)"
+    fi
+done
+
+new "netconf get-config, edit-config and get-config in one session"
+rpc=$(chunked_framing "<rpc $DEFAULTONLY message-id=\"1\"><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a='0']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>")
+rpc+=$(chunked_framing "<rpc $DEFAULTONLY message-id=\"2\"><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\"><y><a>0</a><b>42</b></y></x></config></edit-config></rpc>")
+rpc+=$(chunked_framing "<rpc $DEFAULTONLY message-id=\"3\"><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a='0']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>")
+ret=$(echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qef $cfg)
+match=$(echo "$ret" | tr -d '\n' | grep --null -Eo "message-id=\"1\"><data><x xmlns=\"urn:example:clixon\"><y><a>0</a><b>0</b></y></x></data></rpc-reply>.*message-id=\"2\"><ok/></rpc-reply>.*message-id=\"3\"><data><x xmlns=\"urn:example:clixon\"><y><a>0</a><b>42</b></y></x></data></rpc-reply>")
+if [ -z "$match" ]; then
+    err "Replies in order" "$ret"
+fi
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,175 @@
+#!/usr/bin/env bash
+# Datastore journal, see CLICON_XMLDB_JOURNAL
+# 1. Edits are appended to journal instead of rewriting datastore file
+# 2. Journal is compacted after CLICON_XMLDB_JOURNAL_COMPACT records and on validate
+# 3. Journal is replayed when datastore is read from file
+# 4. Stale records of a previous generation and a truncated trailing record are skipped
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_JOURNAL>true</CLICON_XMLDB_JOURNAL>
+  <CLICON_XMLDB_JOURNAL_COMPACT>3</CLICON_XMLDB_JOURNAL_COMPACT>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example {
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container table{
+        list parameter{
+            key name;
+            leaf name{
+                type string;
+            }
+            leaf value{
+                type string;
+            }
+        }
+    }
+}
+EOF
+
+# Startup is empty but has a journal with two edits
+cat <<EOF > $dir/startup_db
+<${DATASTORE_TOP}/>
+EOF
+cat <<EOF > $dir/startup_db.journal
+<edit operation="merge"><config><table xmlns="urn:example:clixon"><parameter><name>a</name><value>1</value></parameter></table></config></edit>
+<edit operation="merge" xmlns:nc="${BASENS}"><config><table xmlns="urn:example:clixon"><parameter nc:operation="replace"><name>a</name><value>2</value></parameter></table></config></edit>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "Check startup journal replayed into running"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>2</value></parameter></table></data></rpc-reply>"
+
+for i in 1 2; do
+    new "Add entry $i to candidate"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>x$i</name><value>$i</value></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+done
+
+new "Check candidate journal has two records"
+ret=$(grep -c "<edit" $dir/candidate_db.journal)
+if [ "$ret" != 2 ]; then
+    err "2" "$ret"
+fi
+
+new "Check candidate file not rewritten"
+ret=$(grep x1 $dir/candidate_db)
+if [ -n "$ret" ]; then
+    err "" "$ret"
+fi
+
+new "Validate candidate"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Check candidate journal compacted on validate"
+if [ -f $dir/candidate_db.journal ]; then
+    err "no journal" "$(cat $dir/candidate_db.journal)"
+fi
+
+for i in 3 4 5 6; do
+    new "Add entry $i to candidate"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>x$i</name><value>$i</value></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+done
+
+new "Check candidate journal compacted after three records"
+if [ -f $dir/candidate_db.journal ]; then
+    err "no journal" "$(cat $dir/candidate_db.journal)"
+fi
+
+new "Check candidate file has entries"
+ret=$(grep x6 $dir/candidate_db)
+if [ -z "$ret" ]; then
+    err "x6" "$ret"
+fi
+
+new "netconf commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Check running"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='x6']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>x6</name><value>6</value></parameter></table></data></rpc-reply>"
+
+new "Check running file has a generation"
+ret=$(grep "cl:generation=" $dir/running_db)
+if [ -z "$ret" ]; then
+    err "generation" "$(head -1 $dir/running_db)"
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    stop_backend -f $cfg
+fi
+
+# Startup of generation 42 with a journal with a stale record of the previous generation,
+# a valid record, and a truncated record as after a crash while appending
+cat <<EOF > $dir/startup_db
+<${DATASTORE_TOP} xmlns:cl="http://clicon.org/lib" cl:generation="42"><table xmlns="urn:example:clixon"><parameter><name>b</name><value>1</value></parameter></table></${DATASTORE_TOP}>
+EOF
+cat <<EOF > $dir/startup_db.journal
+<edit operation="merge" generation="41"><config><table xmlns="urn:example:clixon"><parameter><name>stale</name><value>1</value></parameter></table></config></edit>
+<edit operation="merge" generation="42"><config><table xmlns="urn:example:clixon"><parameter><name>c</name><value>1</value></parameter></table></config></edit>
+EOF
+printf '<edit operation="merge" generation="42"><config><table xmlns="urn:exa' >> $dir/startup_db.journal
+
+if [ $BE -ne 0 ]; then
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "Check stale and truncated records skipped"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>b</name><value>1</value></parameter><parameter><name>c</name><value>1</value></parameter></table></data></rpc-reply>"
+
+new "Check truncated record removed from startup journal"
+ret=$(tail -n 1 $dir/startup_db.journal | grep -c "<name>c</name>")
+if [ "$ret" != 1 ]; then
+    err "1" "$ret"
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+new "Endtest"
+endtest
+
+rm -rf $dir
@@ -221,6 +221,44 @@ expectpart "$(curl -u wilma:bar $CURLOPTS -X PUT -H "Content-Type: application/y
 new "permit-edit-config: guest fail restconf"
 expectpart "$(curl -u guest:bar $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" -d '{"nacm-example:x":2}' $RCPROTO://localhost/restconf/data/nacm-example:x)" 0 "HTTP/$HVER 403" '{"ietf-restconf:errors":{"error":{"error-type":"application","error-tag":"access-denied","error-severity":"error","error-message":"default deny"}}}'
 
+new "nacm rules are compiled and reused"
+expecteof_netconf "$clixon_netconf -qf $cfg -U andy" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"></stats></rpc>" "<nacm-cache xmlns=\"http://clicon.org/lib\"><nr>"
+
+# Compiled rules are replaced when NACM config is changed in running, also within a session
+DENYKILL="<rule-list><name>admin-acl</name><rule yang:insert=\"first\" xmlns:yang=\"urn:ietf:params:xml:ns:yang:1\"><name>deny-kill-session</name><module-name>ietf-netconf</module-name><rpc-name>kill-session</rpc-name><access-operations>exec</access-operations><action>deny</action></rule></rule-list>"
+new "admin denies itself kill-session and kill-session fails in same session"
+rpc=$(chunked_framing "<rpc $DEFAULTONLY message-id=\"1\"><kill-session><session-id>44</session-id></kill-session></rpc>")
+rpc+=$(chunked_framing "<rpc $DEFAULTONLY message-id=\"2\"><edit-config><target><candidate/></target><config><nacm xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-acm\">$DENYKILL</nacm></config></edit-config></rpc>")
+rpc+=$(chunked_framing "<rpc $DEFAULTONLY message-id=\"3\"><commit/></rpc>")
+rpc+=$(chunked_framing "<rpc $DEFAULTONLY message-id=\"4\"><kill-session><session-id>44</session-id></kill-session></rpc>")
+ret=$(echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qf $cfg -U andy)
+match=$(echo "$ret" | tr -d '\n' | grep --null -Eo "message-id=\"1\"><ok/></rpc-reply>.*message-id=\"2\"><ok/></rpc-reply>.*message-id=\"3\"><ok/></rpc-reply>.*message-id=\"4\"><rpc-error><error-type>application</error-type><error-tag>access-denied</error-tag>")
+if [ -z "$match" ]; then
+    err "kill-session denied after commit" "$ret"
+fi
+
+new "admin removes deny rule and kill-session succeeds in same session"
+rpc=$(chunked_framing "<rpc $DEFAULTONLY message-id=\"1\"><edit-config><target><candidate/></target><config><nacm xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-acm\" xmlns:nc=\"$BASENS\"><rule-list><name>admin-acl</name><rule nc:operation=\"delete\"><name>deny-kill-session</name></rule></rule-list></nacm></config></edit-config></rpc>")
+rpc+=$(chunked_framing "<rpc $DEFAULTONLY message-id=\"2\"><commit/></rpc>")
+rpc+=$(chunked_framing "<rpc $DEFAULTONLY message-id=\"3\"><kill-session><session-id>44</session-id></kill-session></rpc>")
+ret=$(echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qf $cfg -U andy)
+match=$(echo "$ret" | tr -d '\n' | grep --null -Eo "message-id=\"1\"><ok/></rpc-reply>.*message-id=\"2\"><ok/></rpc-reply>.*message-id=\"3\"><ok/></rpc-reply>")
+if [ -z "$match" ]; then
+    err "kill-session permitted after commit" "$ret"
+fi
+
+new "disable nacm"
+rpc=$(chunked_framing "<rpc $DEFAULTONLY message-id=\"1\"><edit-config><target><candidate/></target><config><nacm xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-acm\"><enable-nacm>false</enable-nacm></nacm></config></edit-config></rpc>")
+rpc+=$(chunked_framing "<rpc $DEFAULTONLY message-id=\"2\"><commit/></rpc>")
+ret=$(echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qf $cfg -U andy)
+match=$(echo "$ret" | tr -d '\n' | grep --null -Eo "message-id=\"1\"><ok/></rpc-reply>.*message-id=\"2\"><ok/></rpc-reply>")
+if [ -z "$match" ]; then
+    err "nacm disabled" "$ret"
+fi
+
+new "deny-kill-session: guest ok when nacm disabled (netconf)"
+expecteof_netconf "$clixon_netconf -qf $cfg -U guest" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><kill-session><session-id>44</session-id></kill-session></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
 if [ $RC -ne 0 ]; then
     new "Kill restconf daemon"
     stop_restconf
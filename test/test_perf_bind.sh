@@ -0,0 +1,85 @@
+#!/usr/bin/env bash
+# Performance of binding XML to YANG, ie yang_find and yang_find_datanode lookups
+# A container with many leafs and choices is bound to an XML file with perfnr nodes
+# Throughput is reported in nodes/sec
+# See YANG_FIND_INDEX in clixon_custom.h
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+: ${clixon_util_xml:="clixon_util_xml"}
+
+# Number of leafs in YANG container
+: ${perfwidth:=1000}
+
+# Number of list entries in XML file, each with perfleafs leafs
+: ${perfnr:=10000}
+
+# Number of leafs per list entry in XML file
+: ${perfleafs:=10}
+
+fyang=$dir/scaling.yang
+fxml=$dir/large.xml
+
+new "generate yang with $perfwidth leafs"
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+      list y {
+         key "a";
+         leaf a {
+            type int32;
+         }
+EOF
+for (( i=0; i<$perfwidth; i++ )); do
+    echo "         leaf b$i { type int32; }" >> $fyang
+done
+cat <<EOF >> $fyang
+         choice c {
+EOF
+for (( i=0; i<$perfwidth; i++ )); do
+    echo "            case c$i { leaf c$i { type int32; } }" >> $fyang
+done
+cat <<EOF >> $fyang
+         }
+      }
+   }
+}
+EOF
+
+new "generate xml with $perfnr entries"
+echo -n "<x xmlns=\"urn:example:clixon\">" > $fxml
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<y><a>$i</a>" >> $fxml
+    for (( j=1; j<$perfleafs; j++ )); do
+        k=$(( (i * 7 + j * 13) % $perfwidth ))
+        echo -n "<b$k>$j</b$k>" >> $fxml
+    done
+    k=$(( i % $perfwidth ))
+    echo -n "<c$k>$i</c$k></y>" >> $fxml
+done
+echo "</x>" >> $fxml
+
+# Each entry: y, a, perfleafs-1 b-leafs and one c-leaf
+nodes=$(( 1 + $perfnr * ($perfleafs + 2) ))
+
+new "xml bind and validate $nodes nodes"
+# Exit status is saved in a file since the command runs in a subshell
+t=$( { time -p $clixon_util_xml -vy $fyang -f $fxml > /dev/null 2> $dir/stderr.txt; echo $? > $dir/ret.txt; } 2>&1 | awk '/real/ {print $2}')
+ret=$(cat $dir/ret.txt)
+if [ "$ret" != 0 ]; then
+    err "0" "$ret: $(cat $dir/stderr.txt)"
+fi
+if [ -z "$t" ]; then
+    err "time" "$t"
+fi
+echo "$t s"
+echo "$nodes $t" | awk '{ if ($2 > 0) printf "%d nodes/sec\n", $1/$2; }'
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,150 @@
+#!/usr/bin/env bash
+# Edit-config throughput of large list loads, see XMLDB_BULK_MERGE
+# Load entries in reverse key order in one edit-config, then merge as many entries
+# interleaved with the existing entries. Report entries/sec of each edit-config.
+# Check that the list and a leaf-list are sorted after the merge
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries in each edit-config
+: ${perfnr:=50000}
+
+# time function (this is a mess to get right on freebsd/linux)
+: ${TIMEFN:=time -p} # portability: 2>&1 | awk '/real/ {print $2}'
+if ! $TIMEFN true; then err "A working time function" "'$TIMEFN' does not work"; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/scaling.yang
+fconfig=$dir/large.xml
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+      leaf b {
+        type string;
+      }
+    }
+    leaf-list c {
+      type int32;
+    }
+  }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+# Generate edit-config of perfnr list and leaf-list entries in reverse key order
+# Arguments:
+# 1: first key
+# 2: key step
+function genconfig(){
+    first=$1
+    step=$2
+
+    rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>"
+    rpc+="<x xmlns=\"urn:example:clixon\">"
+    for (( i=$first+($perfnr-1)*$step; i>=$first; i-=$step )); do
+        rpc+="<y><a>$i</a><b>v$i</b></y><c>$i</c>"
+    done
+    rpc+="</x></config></edit-config></rpc>"
+    echo -n "$DEFAULTHELLO" > $fconfig
+    echo "$(chunked_framing "$rpc")" >> $fconfig
+}
+
+# Send edit-config in fconfig, print time and entries/sec
+function editconfig(){
+    t=$({ $TIMEFN $clixon_netconf -qef $cfg < $fconfig > $dir/output.xml; } 2>&1 | awk '/real/ {print $2}')
+    echo "   $t s, $(echo "$perfnr $t" | awk '{ if ($2 > 0) printf "%d", $1/$2; else print "-" }') entries/sec"
+    match=$(grep --null -Fo "<ok/>" $dir/output.xml)
+    if [ -z "$match" ]; then
+        err "<ok/>" "$(cat $dir/output.xml)"
+    fi
+}
+
+new "generate config with $perfnr even entries"
+genconfig 0 2
+
+new "netconf load $perfnr entries"
+editconfig
+
+new "generate config with $perfnr odd entries"
+genconfig 1 2
+
+new "netconf merge $perfnr entries into existing list"
+editconfig
+
+new "netconf get-config check sorted"
+rpc=$(chunked_framing "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>")
+ret=$(echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qef $cfg)
+match=$(echo "$ret" | grep --null -Fo "<x xmlns=\"urn:example:clixon\"><y><a>0</a><b>v0</b></y><y><a>1</a><b>v1</b></y><y><a>2</a><b>v2</b></y><y><a>3</a><b>v3</b></y>")
+if [ -z "$match" ]; then
+    err "<y><a>0</a><b>v0</b></y><y><a>1</a>..." "$(echo "$ret" | head -c 400)"
+fi
+last=$(( 2 * $perfnr - 1 ))
+match=$(echo "$ret" | grep --null -Fo "<y><a>$last</a><b>v$last</b></y><c>0</c><c>1</c><c>2</c><c>3</c>")
+if [ -z "$match" ]; then
+    err "<y><a>$last</a><b>v$last</b></y><c>0</c><c>1</c>..." "$(echo "$ret" | grep -o "<y><a>$last</a>.\{0,300\}")"
+fi
+match=$(echo "$ret" | grep --null -Fo "<c>$(( $last - 1 ))</c><c>$last</c></x>")
+if [ -z "$match" ]; then
+    err "<c>$last</c></x>" "$(echo "$ret" | tail -c 400)"
+fi
+
+new "netconf get-config single entry"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a='$perfnr']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>$perfnr</a><b>v$perfnr</b></y></x></data></rpc-reply>"
+
+new "netconf commit"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,128 @@
+#!/usr/bin/env bash
+# Latency of NETCONF subtree vs xpath filters on a large datastore
+# Subtree filters are translated to xpath in the backend so that only the selected
+# data is sent to the client, instead of the whole datastore being filtered by the client.
+# Check that subtree and xpath filters give the same result
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries
+: ${perfnr:=50000}
+
+# Number of get-config requests in each measurement
+: ${perfreq:=20}
+
+# time function (this is a mess to get right on freebsd/linux)
+: ${TIMEFN:=time -p} # portability: 2>&1 | awk '/real/ {print $2}'
+if ! $TIMEFN true; then err "A working time function" "'$TIMEFN' does not work"; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/scaling.yang
+freq=$dir/req.xml
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+      leaf b {
+        type string;
+      }
+      leaf c {
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+</clixon-config>
+EOF
+
+new "generate config with $perfnr list entries"
+echo -n "<${DATASTORE_TOP}><x xmlns=\"urn:example:clixon\">" > $dir/startup_db
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<y><a>$i</a><b>b$i</b><c>c$i</c></y>" >> $dir/startup_db
+done
+echo "</x></${DATASTORE_TOP}>" >> $dir/startup_db
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+i=$(( $perfnr / 2 ))
+
+# Send perfreq get-config with filter in one session, print time
+# Arguments:
+# 1: filter
+function getfilter(){
+    filter=$1
+
+    echo -n "$DEFAULTHELLO" > $freq
+    for (( j=0; j<$perfreq; j++ )); do
+        echo "$(chunked_framing "<rpc $DEFAULTNS><get-config><source><running/></source>$filter</get-config></rpc>")" >> $freq
+    done
+    t=$({ $TIMEFN $clixon_netconf -qef $cfg < $freq > $dir/output.xml; } 2>&1 | awk '/real/ {print $2}')
+    echo "   $t s, $(echo "$perfreq $t" | awk '{ if ($1 > 0) printf "%.4f", $2/$1; else print "-" }') s/request"
+}
+
+new "netconf get-config $perfreq times, xpath filter"
+getfilter "<filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a='$i']\" xmlns:ex=\"urn:example:clixon\"/>"
+
+new "netconf get-config $perfreq times, subtree filter"
+getfilter "<filter type=\"subtree\"><x xmlns=\"urn:example:clixon\"><y><a>$i</a></y></x></filter>"
+
+new "netconf get-config subtree content match"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"subtree\"><x xmlns=\"urn:example:clixon\"><y><a>$i</a></y></x></filter></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>$i</a><b>b$i</b><c>c$i</c></y></x></data></rpc-reply>"
+
+new "netconf get-config subtree content match and selection"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"subtree\"><x xmlns=\"urn:example:clixon\"><y><a>$i</a><c/></y></x></filter></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>$i</a><c>c$i</c></y></x></data></rpc-reply>"
+
+new "netconf get-config subtree two content matches, no match"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"subtree\"><x xmlns=\"urn:example:clixon\"><y><a>$i</a><b>b0</b></y></x></filter></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,132 @@
+#!/usr/bin/env bash
+# NETCONF framing throughput
+# Send and receive multi-megabyte messages using both NETCONF 1.0 EOM framing and
+# NETCONF 1.1 chunked framing, and measure the time
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries in message, ~25 bytes each
+: ${perfnr:=200000}
+
+# time function (this is a mess to get right on freebsd/linux)
+: ${TIMEFN:=time -p} # portability: 2>&1 | awk '/real/ {print $2}'
+if ! $TIMEFN true; then err "A working time function" "'$TIMEFN' does not work"; fi
+
+APPNAME=example
+
+cfg=$dir/perf-framing-conf.xml
+fyang=$dir/scaling.yang
+fconfigonly=$dir/config.xml
+feom=$dir/eom.xml
+fchunked=$dir/chunked.xml
+foutput=$dir/output.xml
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+      leaf b {
+        type int32;
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "generate config with $perfnr list entries"
+echo -n "<x xmlns=\"urn:example:clixon\">" > $fconfigonly
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<y><a>$i</a><b>$i</b></y>"
+done >> $fconfigonly
+echo -n "</x>" >> $fconfigonly # No CR
+
+rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>"
+rpc+="$(cat $fconfigonly)"
+rpc+="</config></edit-config></rpc>"
+
+echo -n "$HELLONO11" > $feom
+echo -n "$rpc]]>]]>" >> $feom
+echo "message size: $(wc -c < $feom) bytes"
+
+echo -n "$DEFAULTHELLO" > $fchunked
+echo "$(chunked_framing "$rpc")" >> $fchunked
+
+new "netconf write large config EOM framing"
+expecteof_file "time -p $clixon_netconf -qef $cfg" 0 "$feom" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$" 2>&1 | awk '/real/ {print $2}'
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf write large config chunked framing"
+expecteof_file "time -p $clixon_netconf -qef $cfg" 0 "$fchunked" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>$" 2>&1 | awk '/real/ {print $2}'
+
+new "netconf get large config EOM framing"
+rpc="<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>"
+{ time -p echo "$HELLONO11$rpc]]>]]>" | $clixon_netconf -qef $cfg > $foutput; } 2>&1 | awk '/real/ {print $2}'
+
+new "check EOM reply"
+match=$(grep -c "<y><a>$((perfnr-1))</a><b>$((perfnr-1))</b></y></x></data></rpc-reply>]]>]]>" $foutput)
+if [ "$match" != 1 ]; then
+    err1 "last entry in EOM reply"
+fi
+
+new "netconf get large config chunked framing"
+{ time -p echo "$DEFAULTHELLO$(chunked_framing "$rpc")" | $clixon_netconf -qef $cfg > $foutput; } 2>&1 | awk '/real/ {print $2}'
+
+new "check chunked reply"
+match=$(grep -c "<y><a>$((perfnr-1))</a><b>$((perfnr-1))</b></y></x></data></rpc-reply>" $foutput)
+if [ "$match" != 1 ]; then
+    err1 "last entry in chunked reply"
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
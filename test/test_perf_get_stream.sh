@@ -0,0 +1,133 @@
+#!/usr/bin/env bash
+# Streaming of large get replies, see CLICON_BACKEND_REPLY_CHUNK
+# Get a large config with the reply serialized in one buffer and in chunks
+# Measure time and the backend memory high-water mark (VmHWM) of the get (Linux only)
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries
+: ${perfnr:=100000}
+
+# time function (this is a mess to get right on freebsd/linux)
+: ${TIMEFN:=time -p} # portability: 2>&1 | awk '/real/ {print $2}'
+if ! $TIMEFN true; then err "A working time function" "'$TIMEFN' does not work"; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/scaling.yang
+pidfile=$dir/pidfile
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+      leaf b {
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+new "generate config with $perfnr list entries"
+echo -n "<${DATASTORE_TOP}><x xmlns=\"urn:example:clixon\">" > $dir/startup_db
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<y><a>$i</a><b>value$i</b></y>" >> $dir/startup_db
+done
+echo "</x></${DATASTORE_TOP}>" >> $dir/startup_db
+cp $dir/startup_db $dir/startup_db.orig
+
+# Test function
+# Arguments:
+# 1: chunk  CLICON_BACKEND_REPLY_CHUNK
+function testrun(){
+    chunk=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>$pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_BACKEND_REPLY_CHUNK>$chunk</CLICON_BACKEND_REPLY_CHUNK>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+        cp $dir/startup_db.orig $dir/startup_db
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s startup -f $cfg"
+        start_backend -s startup -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    pid=$(cat $pidfile)
+    rpc=$(chunked_framing "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>")
+
+    # Warm up datastore cache
+    echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qef $cfg > /dev/null
+
+    # Reset high-water mark so that only the get is measured
+    if [ -f /proc/$pid/clear_refs ]; then
+        echo 5 | sudo tee /proc/$pid/clear_refs > /dev/null
+        rss0=$(sudo awk '/VmRSS/ {print $2}' /proc/$pid/status)
+    fi
+
+    new "netconf get large config, chunk size $chunk"
+    { $TIMEFN echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qef $cfg > $dir/output.xml; } 2>&1 | awk '/real/ {print $2}'
+
+    if [ -n "$rss0" ]; then
+        hwm=$(sudo awk '/VmHWM/ {print $2}' /proc/$pid/status)
+        echo "   VmHWM increase: $(( $hwm - $rss0 ))kB"
+    fi
+
+    new "check reply"
+    last=$(( $perfnr - 1 ))
+    match=$(grep --null -Fo "<y><a>$last</a><b>value$last</b></y></x></data></rpc-reply>" $dir/output.xml)
+    if [ -z "$match" ]; then
+        err "<y><a>$last</a>" "$(tail -c 200 $dir/output.xml)"
+    fi
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+    fi
+}
+
+# Whole reply in one buffer
+testrun 0
+
+# Reply in chunks
+testrun 65536
+
+rm -rf $dir
+
+new "endtest"
+endtest
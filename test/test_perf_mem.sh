@@ -109,6 +109,10 @@ function testrun(){
 #       cat /proc/$pid/statm
         echo -n "   /proc/$pid/statm: "
         cat /proc/$pid/statm|awk '{print $1*4/1000 "M"}'
+        if [ -n "$objects" ] && [ "$objects" -gt 0 ]; then
+            echo -n "   bytes/node (statm): "
+            cat /proc/$pid/statm|awk -v nr=$objects '{print int($2*4096/nr)}'
+        fi
     fi
     for db in running candidate startup; do
         echo "$db"
@@ -117,10 +121,13 @@ function testrun(){
         if [ "$resdb0" = "$resdb" ]; then
             err1 "nodeset:0:" "$resdb0"
         fi
-        echo -n "   objects: "
-        echo $resdb | $clixon_util_xpath -p "datastore/nr" | awk -F ">" '{print $2}' | awk -F "<" '{print $1}'
-        echo -n "   mem: "
-        echo $resdb | $clixon_util_xpath -p "datastore/size" | awk -F ">" '{print $2}' | awk -F "<" '{print $1}' | awk '{print $1/1000000 "M"}'
+        nr=$(echo $resdb | $clixon_util_xpath -p "datastore/nr" | awk -F ">" '{print $2}' | awk -F "<" '{print $1}')
+        size=$(echo $resdb | $clixon_util_xpath -p "datastore/size" | awk -F ">" '{print $2}' | awk -F "<" '{print $1}')
+        echo "   objects: $nr"
+        echo "   mem: $(echo $size | awk '{print $1/1000000 "M"}')"
+        if [ -n "$nr" ] && [ "$nr" -gt 0 ]; then
+            echo "   bytes/node: $(( $size / $nr ))"
+        fi
     done
     if [ $BE -ne 0 ]; then
         new "Kill backend"
@@ -145,6 +152,14 @@ rm -rf $dir
 unset perfnr
 
 if false; then
+# Bytes/node above are computed from the datastore statistics, which do not include
+# malloc overhead, while bytes/node from statm is the whole backend process.
+# Per-node layout on x86-64:
+# Before: element 112 + name strdup, body 64 + name strdup + cbuf struct + cbuf buffer,
+#         each a separate malloc
+# After:  element 96, body 88 with values up to 23 chars inline, names interned and
+#         nodes allocated from slabs (XML_SLAB)
+#
 # Example memory pretty-printed:
 x:
   base struct:  104
@@ -0,0 +1,155 @@
+#!/usr/bin/env bash
+# Backend request throughput and memory under sustained edit-config/get load, see XML_ARENA
+# Send many small edit-config and get-config requests in one session, then a few large
+# edit-config requests each followed by discard-changes.
+# Report requests/sec and resident memory of the backend before and after.
+# Compare with a build where XML_ARENA is undefined in clixon_custom.h
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of small requests
+: ${perfreq:=2000}
+
+# Number of list entries in each large request
+: ${perfnr:=20000}
+
+# Number of large requests
+: ${perfrep:=10}
+
+# time function (this is a mess to get right on freebsd/linux)
+: ${TIMEFN:=time -p} # portability: 2>&1 | awk '/real/ {print $2}'
+if ! $TIMEFN true; then err "A working time function" "'$TIMEFN' does not work"; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/scaling.yang
+fconfig=$dir/requests.xml
+pidfile=$dir/pidfile
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+      leaf b {
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>$pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+pid=$(cat $pidfile)
+
+# Print resident memory of backend (Linux only)
+function memory(){
+    if [ -f /proc/$pid/statm ]; then
+        echo "   resident: $(cat /proc/$pid/statm | awk '{print int($2*4096/1000) "K"}')"
+    fi
+}
+
+# Send requests in fconfig, print time and requests/sec
+# Arguments:
+# 1: number of requests
+function sendrequests(){
+    nr=$1
+
+    t=$({ $TIMEFN $clixon_netconf -qef $cfg < $fconfig > $dir/output.xml; } 2>&1 | awk '/real/ {print $2}')
+    echo "   $t s, $(echo "$nr $t" | awk '{ if ($2 > 0) printf "%d", $1/$2; else print "-" }') requests/sec"
+    match=$(grep --null -Fo "<rpc-error>" $dir/output.xml)
+    if [ -n "$match" ]; then
+        err "<ok/>" "$(grep -o "<rpc-error>.\{0,300\}" $dir/output.xml | head -1)"
+    fi
+    memory
+}
+
+new "backend memory at start"
+memory
+
+new "generate $perfreq small edit-config and get-config requests"
+echo -n "$DEFAULTHELLO" > $fconfig
+for (( i=0; i<$perfreq; i++ )); do
+    rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>"
+    rpc+="<x xmlns=\"urn:example:clixon\"><y><a>$i</a><b>v$i</b></y></x></config></edit-config></rpc>"
+    echo "$(chunked_framing "$rpc")" >> $fconfig
+    rpc="<rpc $DEFAULTNS><get-config><source><candidate/></source>"
+    rpc+="<filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a='$i']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>"
+    echo "$(chunked_framing "$rpc")" >> $fconfig
+done
+
+new "netconf $perfreq small edit-config and get-config requests"
+sendrequests $(( 2 * $perfreq ))
+
+new "netconf get-config check last entry"
+last=$(( $perfreq - 1 ))
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a='$last']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>$last</a><b>v$last</b></y></x></data></rpc-reply>"
+
+new "generate $perfrep edit-config requests with $perfnr entries and discard-changes"
+echo -n "$DEFAULTHELLO" > $fconfig
+rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>"
+rpc+="<x xmlns=\"urn:example:clixon\">"
+for (( i=0; i<$perfnr; i++ )); do
+    rpc+="<y><a>$i</a><b>value of entry number $i</b></y>"
+done
+rpc+="</x></config></edit-config></rpc>"
+edit=$(chunked_framing "$rpc")
+discard=$(chunked_framing "<rpc $DEFAULTNS><discard-changes/></rpc>")
+for (( i=0; i<$perfrep; i++ )); do
+    echo "$edit" >> $fconfig
+    echo "$discard" >> $fconfig
+done
+
+new "netconf $perfrep large edit-config requests"
+sendrequests $(( 2 * $perfrep ))
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,198 @@
+#!/usr/bin/env bash
+# Latency of RESTCONF GET of a large list encoded as JSON vs XML
+# JSON replies are encoded by the backend and forwarded by the restconf daemon
+# without parsing them into a tree, see clicon_rpc_get_json.
+# Check that JSON replies are the same as before, including not found errors
+# and with-defaults, compared with XML replies
+
+# Override default to use http/1.1
+RCPROTO=http
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Pin to http/1
+if [ ${HAVE_LIBNGHTTP2} = true -a ${HAVE_HTTP1} = true ]; then
+    HAVE_LIBNGHTTP2=false
+    CURLOPTS=${CURLOPTS/http2/http1.1}
+    HVER=1.1
+fi
+
+# Number of list entries
+: ${perfnr:=20000}
+
+# Number of get requests in each measurement
+: ${perfreq:=10}
+
+# time function (this is a mess to get right on freebsd/linux)
+: ${TIMEFN:=time -p} # portability: 2>&1 | awk '/real/ {print $2}'
+if ! $TIMEFN true; then err "A working time function" "'$TIMEFN' does not work"; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/scaling.yang
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+      leaf b {
+        type string;
+      }
+      leaf c {
+        type string;
+        default "c0";
+      }
+    }
+  }
+}
+EOF
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+new "generate config with $perfnr list entries"
+# First entry has c set to default, second entry has c set to non-default
+echo -n "<${DATASTORE_TOP}><x xmlns=\"urn:example:clixon\">" > $dir/startup_db
+echo -n "<y><a>0</a><b>b0</b><c>c0</c></y><y><a>1</a><b>b1</b><c>c1</c></y>" >> $dir/startup_db
+for (( i=2; i<$perfnr; i++ )); do
+    echo -n "<y><a>$i</a><b>b$i</b></y>" >> $dir/startup_db
+done
+echo "</x></${DATASTORE_TOP}>" >> $dir/startup_db
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+fi
+
+new "wait restconf"
+wait_restconf
+
+i=$(( $perfnr / 2 ))
+
+new "restconf get list entry json"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/scaling:x/y=$i)" 0 "HTTP/$HVER 200" "Content-Type: application/yang-data+json" "{\"scaling:y\":\[{\"a\":$i,\"b\":\"b$i\",\"c\":\"c0\"}\]}"
+
+new "restconf get leaf json"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/scaling:x/y=$i/b)" 0 "HTTP/$HVER 200" "{\"scaling:b\":\"b$i\"}"
+
+new "restconf get list entry json depth 1"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/scaling:x/y=$i?depth=1)" 0 "HTTP/$HVER 200" "{\"scaling:y\":\["
+
+new "restconf get missing list entry json"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/scaling:x/y=$perfnr)" 0 "HTTP/$HVER 404" '{"ietf-restconf:errors":{"error":{"error-type":"application","error-tag":"invalid-value","error-severity":"error","error-message":"Instance does not exist"}}}'
+
+new "restconf get large config json"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/scaling:x)" 0 "HTTP/$HVER 200" "{\"scaling:x\":{\"y\":\[{\"a\":0,\"b\":\"b0\",\"c\":\"c0\"}," "{\"a\":$i,\"b\":\"b$i\",\"c\":\"c0\"}"
+
+# Get with with-defaults as XML and JSON and compare number of c leafs
+# Arguments:
+# 1: with-defaults mode
+# 2: restconf data path
+# 3: expected number of c leafs
+function getwdef(){
+    wdef=$1
+    path=$2
+    expect=$3
+
+    new "restconf get $path with-defaults=$wdef xml"
+    ret=$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+xml" "$RCPROTO://localhost/restconf/data/$path?with-defaults=$wdef")
+    nxml=$(echo "$ret" | grep -o "<c>c[01]</c>" | wc -l)
+    if [ $nxml -ne $expect ]; then
+        err "$expect" "$nxml"
+    fi
+    new "restconf get $path with-defaults=$wdef json"
+    ret=$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" "$RCPROTO://localhost/restconf/data/$path?with-defaults=$wdef")
+    njson=$(echo "$ret" | grep -Eo "\"c\": ?\"c[01]\"" | wc -l)
+    if [ $njson -ne $nxml ]; then
+        err "$nxml" "$njson"
+    fi
+}
+
+getwdef report-all scaling:x $perfnr
+getwdef explicit scaling:x 2
+getwdef trim scaling:x 1
+getwdef explicit scaling:x/y=0 1
+getwdef trim scaling:x/y=0 0
+getwdef explicit scaling:x/y=$i 0
+getwdef trim scaling:x/y=1 1
+
+# Get large list perfreq times, print time
+# Arguments:
+# 1: media type
+function getlarge(){
+    media=$1
+
+    t=$({ $TIMEFN bash -c "for (( j=0; j<$perfreq; j++ )); do curl $CURLOPTS -X GET -H \"Accept: $media\" $RCPROTO://localhost/restconf/data/scaling:x > /dev/null; done"; } 2>&1 | awk '/real/ {print $2}')
+    echo "   $t s, $(echo "$perfreq $t" | awk '{ if ($1 > 0) printf "%.4f", $2/$1; else print "-" }') s/request"
+}
+
+new "restconf get large config $perfreq times, xml"
+getlarge application/yang-data+xml
+
+new "restconf get large config $perfreq times, json"
+getlarge application/yang-data+json
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
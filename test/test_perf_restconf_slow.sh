@@ -0,0 +1,182 @@
+#!/usr/bin/env bash
+# Latency of fast RESTCONF clients while slow clients read large replies
+# Slow clients are curl with limited read rate, over HTTP/1.1 and HTTP/2 if enabled.
+# Replies that cannot be written without blocking are queued on the connection and
+# written when the socket is writable, so a slow client does not block other clients.
+# Check that the latency of fast clients is not affected by the slow clients
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries, reply of whole list should be larger than socket buffers
+: ${perfnr:=100000}
+
+# Number of fast get requests in each measurement
+: ${perfreq:=20}
+
+# Number of slow clients of each HTTP version
+: ${slownr:=4}
+
+# Read rate of slow clients in bytes/s
+: ${slowrate:=10k}
+
+# Max latency of a fast request in s
+: ${maxlat:=1}
+
+# time function (this is a mess to get right on freebsd/linux)
+: ${TIMEFN:=time -p} # portability: 2>&1 | awk '/real/ {print $2}'
+if ! $TIMEFN true; then err "A working time function" "'$TIMEFN' does not work"; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/scaling.yang
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+      leaf b {
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+new "generate config with $perfnr list entries"
+echo -n "<${DATASTORE_TOP}><x xmlns=\"urn:example:clixon\">" > $dir/startup_db
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<y><a>$i</a><b>b$i</b></y>" >> $dir/startup_db
+done
+echo "</x></${DATASTORE_TOP}>" >> $dir/startup_db
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+fi
+
+new "wait restconf"
+wait_restconf
+
+i=$(( $perfnr / 2 ))
+
+# Get a list entry perfreq times, print time and check latency
+function fastget(){
+    t=$({ $TIMEFN bash -c "for (( j=0; j<$perfreq; j++ )); do curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/scaling:x/y=$i > /dev/null; done"; } 2>&1 | awk '/real/ {print $2}')
+    lat=$(echo "$perfreq $t" | awk '{ if ($1 > 0) printf "%.4f", $2/$1; else print "-" }')
+    echo "   $t s, $lat s/request"
+    if [ $(echo "$lat $maxlat" | awk '{ print ($1 > $2) }') -ne 0 ]; then
+        err "Latency below $maxlat s" "$lat s"
+    fi
+}
+
+new "fast get $perfreq times, no slow clients"
+fastget
+
+# Slow clients, one curl option string per HTTP version
+slowopts=()
+if ${HAVE_HTTP1}; then
+    slowopts+=("${CURLOPTS/http2-prior-knowledge/http1.1}")
+    slowopts[0]=${slowopts[0]/http2/http1.1}
+fi
+if ${HAVE_LIBNGHTTP2}; then
+    slowopts+=("${CURLOPTS/http1.1/http2}")
+fi
+
+pids=""
+for opts in "${slowopts[@]}"; do
+    new "start $slownr slow clients: $opts --limit-rate $slowrate"
+    for (( j=0; j<$slownr; j++ )); do
+        curl $opts --limit-rate $slowrate -X GET $RCPROTO://localhost/restconf/data/scaling:x > /dev/null 2>&1 &
+        pids="$pids $!"
+    done
+done
+# Let the slow clients fill socket buffers
+sleep 2
+
+new "fast get $perfreq times, with slow clients"
+fastget
+
+new "fast get list entry, with slow clients"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/scaling:x/y=$i)" 0 "HTTP/$HVER 200" "{\"scaling:y\":\[{\"a\":$i,\"b\":\"b$i\"}\]}"
+
+new "slow clients still running"
+for pid in $pids; do
+    if ! kill -0 $pid 2> /dev/null; then
+        err "slow client $pid running" "slow client done, increase perfnr or decrease slowrate"
+    fi
+done
+
+new "kill slow clients"
+kill $pids 2> /dev/null
+wait $pids 2> /dev/null
+
+new "fast get list entry, after slow clients"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/scaling:x/y=$i)" 0 "HTTP/$HVER 200" "{\"scaling:y\":\[{\"a\":$i,\"b\":\"b$i\"}\]}"
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -2,6 +2,8 @@
 # Startup performance tests for different formats and startup modes.
 # Generate file in different formats:
 # xml, xml pretty-printed, xml with prefixes, json
+# Report time per startup phase: YANG load (init mode) and datastore load (rest),
+# with YANG files parsed serially and in parallel, see CLICON_YANG_PARSE_THREADS
 
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
@@ -9,6 +11,9 @@ s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
 # Number of list/leaf-list entries in file
 : ${perfnr:=20000}
 
+# Number of YANG parse threads in parallel variant
+: ${nthreads:=4}
+
 APPNAME=example
 
 cfg=$dir/scaling-conf.xml
@@ -132,10 +137,29 @@ done
 echo "]}}}" >> $sj
 fi
 
+# Start backend once and print time
+# Arguments:
+# 1: mode     Startup mode
+# 2: threads  CLICON_YANG_PARSE_THREADS
+function startup_time(){
+    mode=$1
+    threads=$2
+
+    # Cannot use start_backend here due to expected error case
+    { time -p sudo $clixon_backend -F1 -D $DBG -s $mode -f $cfg -y $fyang -o CLICON_XMLDB_FORMAT=$format -o CLICON_YANG_PARSE_THREADS=$threads 2> /dev/null; } 2>&1 | awk '/real/ {print $2}'
+}
+
 # Loop over mode and format
 mode=startup # running
 format=xml
 sdb=$dir/${mode}_db
+
+for threads in 0 $nthreads; do
+    new "YANG load phase, $threads parse threads"
+    tyang=$(startup_time init $threads)
+    echo "   $tyang s"
+done
+
 for variant in prefix plain pretty; do
     case $variant in
         plain)
@@ -155,8 +179,8 @@ for variant in prefix plain pretty; do
     
     cp $f $sdb
     new "Startup $format $variant"
-    # Cannot use start_backend here due to expected error case
-    { time -p sudo $clixon_backend -F1 -D $DBG -s $mode -f $cfg -y $fyang -o CLICON_XMLDB_FORMAT=$format 2> /dev/null; } 2>&1 | awk '/real/ {print $2}'
+    t=$(startup_time $mode $nthreads)
+    echo "   total $t s, yang $tyang s, datastore $(echo "$t $tyang" | awk '{ printf "%.2f", $1-$2 }') s"
 done
 
 rm -rf $dir
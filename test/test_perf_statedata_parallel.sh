@@ -0,0 +1,226 @@
+#!/usr/bin/env bash
+# Latency of get with state data of several slow plugins, see ca_statedata_collect
+# Compile plugins whose state takes an artificial delay to collect, eg a hardware query.
+# With ca_statedata the plugins are called one after another, with ca_statedata_collect
+# they are collected in parallel and the latency is about that of one plugin.
+# Check that the state of all plugins is merged, and left out after the deadline
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of plugins
+: ${perfnr:=8}
+
+# Delay in ms of collecting state of each plugin
+: ${delay:=200}
+
+# Number of get requests in each measurement
+: ${perfreq:=5}
+
+# time function (this is a mess to get right on freebsd/linux)
+: ${TIMEFN:=time -p} # portability: 2>&1 | awk '/real/ {print $2}'
+if ! $TIMEFN true; then err "A working time function" "'$TIMEFN' does not work"; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/example-stats.yang
+cfile=$dir/example-stats.c
+pdir=$dir/plugin
+freq=$dir/req.xml
+
+if [ ! -d $pdir ]; then
+    mkdir $pdir
+fi
+
+cat <<EOF > $fyang
+module example-stats{
+    yang-version 1.1;
+    namespace "urn:example:stats";
+    prefix ex;
+    container stats {
+      config false;
+      list plugin {
+        key name;
+        leaf name {
+          type string;
+        }
+        leaf value {
+          type uint32;
+        }
+      }
+    }
+}
+EOF
+
+cat<<EOF > $cfile
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/param.h>
+
+/* clicon */
+#include <cligen/cligen.h>
+
+/* Clicon library functions. */
+#include <clixon/clixon.h>
+
+/* These include signatures for plugin and transaction callbacks. */
+#include <clixon/clixon_backend.h>
+
+/* Build state of this plugin from a collected value */
+static int
+stats_build(clixon_handle h,
+            cvec         *nsc,
+            char         *xpath,
+            void         *data,
+            cxobj        *xstate)
+{
+    char buf[256];
+
+    snprintf(buf, sizeof(buf), "<stats xmlns=\"urn:example:stats\"><plugin><name>p%d</name><value>%d</value></plugin></stats>",
+             PNR, *(int*)data);
+    if (clixon_xml_parse_string(buf, YB_NONE, NULL, &xstate, NULL) < 0)
+        return -1;
+    return 0;
+}
+
+#ifdef PARALLEL
+/* Collect value on worker thread, no clixon calls */
+static int
+stats_collect(clixon_handle h,
+              const char   *xpath,
+              void        **data)
+{
+    int *v;
+
+    usleep(DELAY*1000);
+    if ((v = malloc(sizeof(*v))) == NULL)
+        return -1;
+    *v = PNR*10;
+    *data = v;
+    return 0;
+}
+#else
+static int
+stats_statedata(clixon_handle h,
+                cvec         *nsc,
+                char         *xpath,
+                cxobj        *xstate)
+{
+    int v;
+
+    usleep(DELAY*1000);
+    v = PNR*10;
+    return stats_build(h, nsc, xpath, &v, xstate);
+}
+#endif
+
+clixon_plugin_api *clixon_plugin_init(clixon_handle h);
+
+static clixon_plugin_api api = {
+    "stats",            /* name */
+    clixon_plugin_init, /* init */
+#ifdef PARALLEL
+    .ca_statedata_collect = stats_collect,
+    .ca_statedata_build = stats_build,
+#else
+    .ca_statedata = stats_statedata,
+#endif
+};
+
+clixon_plugin_api *
+clixon_plugin_init(clixon_handle h)
+{
+    return &api;
+}
+EOF
+
+# Expected state of all plugins, sorted by name
+state="<stats xmlns=\"urn:example:stats\">"
+for i in $(for (( i=0; i<$perfnr; i++ )); do echo "p$i"; done | sort); do
+    state+="<plugin><name>$i</name><value>$(( ${i#p} * 10 ))</value></plugin>"
+done
+state+="</stats>"
+
+# Compile plugins, start backend, get state perfreq times and check state
+# Arguments:
+# 1: extra cflags, eg -DPARALLEL
+# 2: CLICON_BACKEND_STATE_DEADLINE in ms
+# 3: expected state
+function testrun(){
+    cflags=$1
+    deadline=$2
+    expected=$3
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>$pdir</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_BACKEND_STATE_DEADLINE>$deadline</CLICON_BACKEND_STATE_DEADLINE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+    new "compile $perfnr plugins $cflags"
+    rm -f $pdir/*.so
+    for (( i=0; i<$perfnr; i++ )); do
+        # -I /usr/local_include for eg freebsd
+        expectpart "$($CC -g -Wall -rdynamic -fPIC -shared -I/usr/local/include -DPNR=$i -DDELAY=$delay $cflags $cfile -o $pdir/stats$i.so)" 0 ""
+    done
+
+    new "test params: -s init -f $cfg"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo $clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend"
+        start_backend -s init -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "netconf get state $perfreq times"
+    echo -n "$DEFAULTHELLO" > $freq
+    for (( j=0; j<$perfreq; j++ )); do
+        echo "$(chunked_framing "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:stats\" xmlns:ex=\"urn:example:stats\"/></get></rpc>")" >> $freq
+    done
+    t=$({ $TIMEFN $clixon_netconf -qef $cfg < $freq > $dir/output.xml; } 2>&1 | awk '/real/ {print $2}')
+    echo "   $t s, $(echo "$perfreq $t" | awk '{ if ($1 > 0) printf "%.4f", $2/$1; else print "-" }') s/request"
+
+    new "netconf get state check"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:stats\" xmlns:ex=\"urn:example:stats\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS>$expected</rpc-reply>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+    fi
+}
+
+new "$perfnr plugins with $delay ms delay, serial"
+testrun "" 0 "<data>$state</data>"
+
+new "$perfnr plugins with $delay ms delay, parallel"
+testrun "-DPARALLEL" 0 "<data>$state</data>"
+
+new "$perfnr plugins with $delay ms delay, parallel, deadline $(( $delay / 2 )) ms"
+testrun "-DPARALLEL" $(( $delay / 2 )) "<data/>"
+
+rm -rf $dir
+
+new "endtest"
+endtest
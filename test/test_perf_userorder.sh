@@ -0,0 +1,155 @@
+#!/usr/bin/env bash
+# Performance of large ordered-by user lists, see XML_KEY_INDEX
+# Bulk insert entries in an ordered-by user list, then merge more entries into the
+# existing list. Each entry is looked up among existing entries by key.
+# Check that the user order is kept, and insert first and after a given entry
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries in each bulk insert
+: ${perfnr:=20000}
+
+# time function (this is a mess to get right on freebsd/linux)
+: ${TIMEFN:=time -p} # portability: 2>&1 | awk '/real/ {print $2}'
+if ! $TIMEFN true; then err "A working time function" "'$TIMEFN' does not work"; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/scaling.yang
+fconfig=$dir/large.xml
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container acl {
+    list rule {
+      ordered-by user;
+      key "name";
+      leaf name {
+        type string;
+      }
+      leaf seq {
+        type int32;
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+# Generate edit-config of perfnr entries in reverse key order
+# Arguments:
+# 1: first seq number
+function genconfig(){
+    first=$1
+
+    rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>"
+    rpc+="<acl xmlns=\"urn:example:clixon\">"
+    for (( i=$first+$perfnr-1; i>=$first; i-- )); do
+        rpc+="<rule><name>r$i</name><seq>$i</seq></rule>"
+    done
+    rpc+="</acl></config></edit-config></rpc>"
+    echo -n "$DEFAULTHELLO" > $fconfig
+    echo "$(chunked_framing "$rpc")" >> $fconfig
+}
+
+new "generate config with $perfnr ordered-by user entries"
+genconfig 0
+
+new "netconf bulk insert $perfnr entries"
+{ $TIMEFN $clixon_netconf -qef $cfg < $fconfig > $dir/output.xml; } 2>&1 | awk '/real/ {print $2}'
+match=$(grep --null -Fo "<ok/>" $dir/output.xml)
+if [ -z "$match" ]; then
+    err "<ok/>" "$(cat $dir/output.xml)"
+fi
+
+new "generate config with $perfnr more entries"
+genconfig $perfnr
+
+new "netconf bulk merge $perfnr entries into existing list"
+{ $TIMEFN $clixon_netconf -qef $cfg < $fconfig > $dir/output.xml; } 2>&1 | awk '/real/ {print $2}'
+match=$(grep --null -Fo "<ok/>" $dir/output.xml)
+if [ -z "$match" ]; then
+    err "<ok/>" "$(cat $dir/output.xml)"
+fi
+
+new "netconf merge existing entry does not change order"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><acl xmlns=\"urn:example:clixon\"><rule><name>r0</name><seq>42</seq></rule></acl></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf insert first"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><acl xmlns=\"urn:example:clixon\"><rule yang:insert=\"first\" xmlns:yang=\"urn:ietf:params:xml:ns:yang:1\"><name>first</name></rule></acl></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+last=$(( 2 * $perfnr - 1 ))
+new "netconf insert after r$last"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><acl xmlns=\"urn:example:clixon\"><rule yang:insert=\"after\" yang:key=\"[name='r$last']\" xmlns:yang=\"urn:ietf:params:xml:ns:yang:1\"><name>after</name></rule></acl></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf get-config check order"
+rpc=$(chunked_framing "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>")
+ret=$(echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qef $cfg)
+match=$(echo "$ret" | grep --null -Fo "<acl xmlns=\"urn:example:clixon\"><rule><name>first</name></rule><rule><name>r$(( $perfnr - 1 ))</name>")
+if [ -z "$match" ]; then
+    err "<rule><name>first</name></rule><rule><name>r$(( $perfnr - 1 ))</name>" "$(echo "$ret" | head -c 400)"
+fi
+match=$(echo "$ret" | grep --null -Fo "<rule><name>r0</name><seq>42</seq></rule><rule><name>r$last</name><seq>$last</seq></rule><rule><name>after</name></rule><rule><name>r$(( $last - 1 ))</name>")
+if [ -z "$match" ]; then
+    err "<rule><name>r0</name><seq>42</seq></rule><rule><name>r$last</name>..." "$(echo "$ret" | grep -o "<rule><name>r0</name>.\{0,300\}")"
+fi
+
+new "netconf get-config single entry"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:acl/ex:rule[ex:name='r$perfnr']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><acl xmlns=\"urn:example:clixon\"><rule><name>r$perfnr</name><seq>$perfnr</seq></rule></acl></data></rpc-reply>"
+
+new "netconf delete entry"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><acl xmlns=\"urn:example:clixon\"><rule nc:operation=\"delete\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><name>r$perfnr</name></rule></acl></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf get-config deleted entry"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:acl/ex:rule[ex:name='r$perfnr']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+new "netconf commit"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,175 @@
+#!/usr/bin/env bash
+# Performance of incremental validation
+# Commit a single leaf into a large list with must and leafref constraints, with and
+# without CLICON_VALIDATE_INCREMENTAL.
+# Also check that constraints depending on edited nodes are validated, also when the last
+# entry of a list in a non-presence container is deleted
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries
+: ${perfnr:=100000}
+
+APPNAME=example
+
+cfg=$dir/perf-validate-conf.xml
+fyang=$dir/scaling.yang
+fconfig=$dir/large.xml
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+      list y {
+         key "a";
+         must "not(../z[name=current()/r]/enabled = 'false')" {
+            error-message "Referenced z is not enabled";
+         }
+         leaf a {
+            type int32;
+         }
+         leaf b {
+            type int32;
+         }
+         leaf r {
+            type leafref {
+               path "../../z/name";
+            }
+         }
+         leaf s {
+            type leafref {
+               path "/ex:w/ex:v/ex:name";
+            }
+         }
+      }
+      list z {
+         key "name";
+         leaf name {
+            type string;
+         }
+         leaf enabled {
+            type boolean;
+            default true;
+         }
+      }
+   }
+   container w {
+      list v {
+         key "name";
+         leaf name {
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+</clixon-config>
+EOF
+
+new "generate config with $perfnr list entries"
+rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\">"
+rpc+="<z><name>z0</name></z><z><name>z1</name></z>"
+rpc+="<y><a>0</a><b>0</b><r>z0</r><s>v0</s></y>"
+for (( i=1; i<$perfnr; i++ )); do
+    rpc+="<y><a>$i</a><b>$i</b><r>z$(( i % 2 ))</r></y>"
+done
+rpc+="</x><w xmlns=\"urn:example:clixon\"><v><name>v0</name></v></w></config></edit-config></rpc>"
+echo -n "$DEFAULTHELLO" > $fconfig
+echo "$(chunked_framing "$rpc")" >> $fconfig
+
+# Edit and commit one leaf
+# 1: name of test
+# 2: edit-config content
+# 3: expected commit reply
+# 4: top-level container (default x)
+function commit_one()
+{
+    name=$1
+    xml=$2
+    reply=$3
+    top=${4:-x}
+
+    new "netconf edit $name"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><$top xmlns=\"urn:example:clixon\">$xml</$top></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf commit $name"
+    expecteof_netconf "time -p $clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "$reply" 2>&1 | awk '/real/ {print $2}'
+
+    new "netconf discard-changes"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+}
+
+for incr in true false; do
+    new "test params: -f $cfg -o CLICON_VALIDATE_INCREMENTAL=$incr"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        if $incr; then
+            new "start backend -s init -f $cfg"
+            start_backend -s init -f $cfg -o CLICON_VALIDATE_INCREMENTAL=$incr
+        else
+            new "start backend -s running -f $cfg"
+            start_backend -s running -f $cfg -o CLICON_VALIDATE_INCREMENTAL=$incr
+        fi
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    if $incr; then
+        new "netconf write large config"
+        expecteof_file "time -p $clixon_netconf -qef $cfg" 0 "$fconfig" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>$" 2>&1 | awk '/real/ {print $2}'
+
+        new "netconf commit large config"
+        expecteof_netconf "time -p $clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>" 2>&1 | awk '/real/ {print $2}'
+    fi
+
+    rnd=$(( ( RANDOM % $perfnr ) ))
+    commit_one "change one leaf in $perfnr entries incremental=$incr" "<y><a>$rnd</a><b>-1</b></y>" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    commit_one "add one entry in $perfnr entries incremental=$incr" "<y><a>$perfnr</a><b>0</b><r>z1</r></y>" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    # Constraints of unchanged entries depending on edited nodes
+    commit_one "delete referenced z incremental=$incr" "<z xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\" nc:operation=\"delete\"><name>z1</name></z>" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>data-missing</error-tag><error-app-tag>instance-required</error-app-tag>"
+
+    commit_one "disable referenced z incremental=$incr" "<z><name>z0</name><enabled>false</enabled></z>" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-severity>error</error-severity><error-message>Referenced z is not enabled</error-message></rpc-error></rpc-reply>"
+
+    # Non-presence container w is removed with its last entry
+    commit_one "delete last referenced v incremental=$incr" "<v xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\" nc:operation=\"delete\"><name>v0</name></v>" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>data-missing</error-tag><error-app-tag>instance-required</error-app-tag>" w
+
+    commit_one "add entry with invalid leafref incremental=$incr" "<y><a>$perfnr</a><r>z2</r></y>" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>data-missing</error-tag><error-app-tag>instance-required</error-app-tag>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+    fi
+done
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,155 @@
+#!/usr/bin/env bash
+# State data scope and cache of a backend plugin, see ca_statedata_scope and ca_statedata_ttl
+# Compile a backend plugin whose state callback counts its calls and returns the count
+# as state data. Check that the callback is not called for a get outside its scope,
+# and that its state is reused until the TTL expires.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/example-cache.yang
+cfile=$dir/example-cache.c
+pdir=$dir/plugin
+sofile=$pdir/example-cache.so
+
+# Cache TTL in ms
+ttl=2000
+
+if [ ! -d $pdir ]; then
+    mkdir $pdir
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>$pdir</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example-cache{
+    yang-version 1.1;
+    namespace "urn:example:cache";
+    prefix ex;
+    container counters {
+      config false;
+      leaf calls {
+        type uint32;
+      }
+    }
+    container other {
+      leaf x {
+        type string;
+      }
+    }
+}
+EOF
+
+cat<<EOF > $cfile
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/param.h>
+
+/* clicon */
+#include <cligen/cligen.h>
+
+/* Clicon library functions. */
+#include <clixon/clixon.h>
+
+/* These include signatures for plugin and transaction callbacks. */
+#include <clixon/clixon_backend.h>
+
+/* Number of state callback calls */
+static int _calls = 0;
+
+static int
+cache_statedata(clixon_handle h,
+                cvec         *nsc,
+                char         *xpath,
+                cxobj        *xstate)
+{
+    char buf[128];
+
+    _calls++;
+    snprintf(buf, sizeof(buf), "<counters xmlns=\"urn:example:cache\"><calls>%d</calls></counters>", _calls);
+    if (clixon_xml_parse_string(buf, YB_NONE, NULL, &xstate, NULL) < 0)
+        return -1;
+    return 0;
+}
+
+clixon_plugin_api *clixon_plugin_init(clixon_handle h);
+
+static const char *scope[] = {"/example-cache:counters", NULL};
+
+static clixon_plugin_api api = {
+    "cache",            /* name */
+    clixon_plugin_init, /* init */
+    .ca_statedata = cache_statedata,
+    .ca_statedata_scope = scope,
+    .ca_statedata_ttl = $ttl,
+};
+
+clixon_plugin_api *
+clixon_plugin_init(clixon_handle h)
+{
+    return &api;
+}
+EOF
+
+new "compile $cfile"
+# -I /usr/local_include for eg freebsd
+expectpart "$($CC -g -Wall -rdynamic -fPIC -shared -I/usr/local/include $cfile -o $sofile)" 0 ""
+
+new "test params: -s init -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo $clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "netconf get state, first call"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:counters\" xmlns:ex=\"urn:example:cache\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><counters xmlns=\"urn:example:cache\"><calls>1</calls></counters></data></rpc-reply>"
+
+new "netconf get state, cached"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:counters/ex:calls\" xmlns:ex=\"urn:example:cache\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><counters xmlns=\"urn:example:cache\"><calls>1</calls></counters></data></rpc-reply>"
+
+new "wait for cache to expire"
+sleep $(( $ttl / 1000 + 1 ))
+
+new "netconf get outside scope, callback not called"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:other\" xmlns:ex=\"urn:example:cache\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+new "netconf get state, second call"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:counters\" xmlns:ex=\"urn:example:cache\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><counters xmlns=\"urn:example:cache\"><calls>2</calls></counters></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
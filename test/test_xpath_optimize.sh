@@ -0,0 +1,201 @@
+#!/usr/bin/env bash
+# XPath list lookup plans, see XPATH_LIST_OPTIMIZE
+# Key, nested key and positional predicates are looked up directly
+# Check results against full evaluation and check xpath-optimize stats
+# A list augmented by another module with the same name is evaluated in full
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries
+: ${perfnr:=1000}
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/scaling.yang
+fyang2=$dir/aug.yang
+fconfig=$dir/large.xml
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a b";
+      leaf a {
+        type int32;
+      }
+      leaf b {
+        type string;
+      }
+      leaf c {
+        type int32;
+      }
+      list z {
+        key "k";
+        leaf k {
+          type int32;
+        }
+        leaf v {
+          type string;
+        }
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $fyang2
+module aug{
+   yang-version 1.1;
+   namespace "urn:example:aug";
+   prefix aug;
+   import scaling {
+      prefix ex;
+   }
+   augment "/ex:x/ex:y" {
+      list z {
+         key "n";
+         leaf n {
+            type int32;
+         }
+      }
+   }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_DIR>$dir</CLICON_YANG_MAIN_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "generate config with $perfnr list entries"
+rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>"
+rpc+="<x xmlns=\"urn:example:clixon\">"
+rpc+="<y><a>0</a><b>b0</b><c>0</c><z><k>0</k><v>v0</v></z><z><k>1</k><v>w0</v></z>"
+rpc+="<z xmlns=\"urn:example:aug\"><n>0</n></z><z xmlns=\"urn:example:aug\"><n>1</n></z></y>"
+for (( i=1; i<$perfnr; i++ )); do
+    rpc+="<y><a>$i</a><b>b$i</b><c>$i</c><z><k>0</k><v>v$i</v></z><z><k>1</k><v>w$i</v></z></y>"
+done
+rpc+="</x></config></edit-config></rpc>"
+echo -n "$DEFAULTHELLO" > $fconfig
+echo "$(chunked_framing "$rpc")" >> $fconfig
+
+new "netconf write large config"
+expecteof_file "$clixon_netconf -qef $cfg" 0 "$fconfig" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>$"
+
+# Test function
+# Arguments:
+# 1: xpath
+# 2: expected data
+function testxpath(){
+    xpath=$1
+    expect=$2
+
+    if [ -z "$expect" ]; then
+        data="<data/>"
+    else
+        data="<data>$expect</data>"
+    fi
+    new "netconf get-config $xpath"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"$xpath\" xmlns:ex=\"urn:example:clixon\" xmlns:aug=\"urn:example:aug\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS>$data</rpc-reply>"
+}
+
+new "netconf get stats before lookups"
+ret=$(echo "$DEFAULTHELLO$(chunked_framing "<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"/></rpc>")" | $clixon_netconf -qf $cfg)
+keys0=$(echo "$ret" | grep -Eo "<key-lookups>[0-9]+</key-lookups>" | grep -Eo "[0-9]+")
+pos0=$(echo "$ret" | grep -Eo "<position-lookups>[0-9]+</position-lookups>" | grep -Eo "[0-9]+")
+if [ -z "$keys0" -o -z "$pos0" ]; then
+    err "<xpath-optimize>" "$ret"
+fi
+
+i=$(( $perfnr / 2 ))
+y="<y><a>$i</a><b>b$i</b><c>$i</c><z><k>0</k><v>v$i</v></z><z><k>1</k><v>w$i</v></z></y>"
+
+# All keys
+testxpath "/ex:x/ex:y[ex:a='$i'][ex:b='b$i']" "<x xmlns=\"urn:example:clixon\">$y</x>"
+
+# Keys in other order
+testxpath "/ex:x/ex:y[ex:b='b$i'][ex:a='$i']" "<x xmlns=\"urn:example:clixon\">$y</x>"
+
+# First key only
+testxpath "/ex:x/ex:y[ex:a='$i']" "<x xmlns=\"urn:example:clixon\">$y</x>"
+
+# Key with trailing predicate on non-key
+testxpath "/ex:x/ex:y[ex:a='$i'][ex:c='$i']" "<x xmlns=\"urn:example:clixon\">$y</x>"
+testxpath "/ex:x/ex:y[ex:a='$i'][ex:c='0']" ""
+
+# Nested lists
+testxpath "/ex:x/ex:y[ex:a='$i'][ex:b='b$i']/ex:z[ex:k='1']" "<x xmlns=\"urn:example:clixon\"><y><a>$i</a><b>b$i</b><z><k>1</k><v>w$i</v></z></y></x>"
+
+# Several context nodes
+testxpath "/ex:x/ex:y/ex:z[ex:k='1']/ex:v[.='w$i']" "<x xmlns=\"urn:example:clixon\"><y><a>$i</a><b>b$i</b><z><k>1</k><v>w$i</v></z></y></x>"
+
+# Position (non-standard: 0-based)
+testxpath "/ex:x/ex:y[$i]" "<x xmlns=\"urn:example:clixon\">$y</x>"
+
+# Non-key predicate, full evaluation
+testxpath "/ex:x/ex:y[ex:c='$i']" "<x xmlns=\"urn:example:clixon\">$y</x>"
+
+# No match
+testxpath "/ex:x/ex:y[ex:a='$perfnr']" ""
+
+# Lists of two modules with the same name
+testxpath "/ex:x/ex:y[ex:a='0'][ex:b='b0']/aug:z[aug:n='1']" "<x xmlns=\"urn:example:clixon\"><y><a>0</a><b>b0</b><z xmlns=\"urn:example:aug\"><n>1</n></z></y></x>"
+testxpath "/ex:x/ex:y[ex:a='0'][ex:b='b0']/ex:z[ex:k='1']" "<x xmlns=\"urn:example:clixon\"><y><a>0</a><b>b0</b><z><k>1</k><v>w0</v></z></y></x>"
+
+new "netconf get stats after lookups"
+ret=$(echo "$DEFAULTHELLO$(chunked_framing "<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"/></rpc>")" | $clixon_netconf -qf $cfg)
+keys=$(echo "$ret" | grep -Eo "<key-lookups>[0-9]+</key-lookups>" | grep -Eo "[0-9]+")
+pos=$(echo "$ret" | grep -Eo "<position-lookups>[0-9]+</position-lookups>" | grep -Eo "[0-9]+")
+if [ -z "$keys" ] || [ $keys -le $keys0 ]; then
+    err "key-lookups > $keys0" "$ret"
+fi
+if [ -z "$pos" ] || [ $pos -le $pos0 ]; then
+    err "position-lookups > $pos0" "$ret"
+fi
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest